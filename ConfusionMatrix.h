@@ -1,63 +1,248 @@
 ///////////////////////////////////////////
 // An abstraction of a confusion matrix.
-//	m_Matrix[row][col] is the number of times item at row index "row" was guessed and item at column "col" was received. 
-//  Each character in string "labels" is one index label. row labels = col labels. i.e. Matrix width = matrix height.  
+//	Cell [row][col] is the number of times item at row index "row" was expected and item at column index "col" was
+//	guessed. Each character in string "labels" is one index label. row labels = col labels. i.e. Matrix width = matrix height.
+//	Cells are kept in one flat, row-major buffer. The matrix may be split into shards, each a full set of cells, so that
+//	several threads can count classifications at once, one shard each, with no locking. Every reader sums the shards
+//	as it goes; mergeShards() folds them into the first shard, and merge() adds in another matrix, in O(width^2).
+//	addScores() also records, for each row, the rank of the expected label's score among all scores, from which
+//	getMetrics() reports top-k accuracy for every k. getMetrics() computes per-label precision, recall and F1, their
+//	macro and micro averages, accuracy and top-k accuracy in a single pass over the cells, and outputMetricsCsv(),
+//	outputMetricsJson() and saveMetrics() export them.
 //See inline documentation for more
-//TODO: Impl. labels as  cellPlusOne row/col parameters 
-//		outputMatrix alignment gets bad with more than a single digit in each cell.
+//TODO: outputMatrix alignment gets bad with more than a single digit in each cell.
 //		void outputLabels(char delim);
 //
 /// Author: Dustin Fast, June 2017
 
 #pragma once
 #include <vector>
+#include <string>
 #include <iostream>
+#include <fstream>
+#include <algorithm>
 
 using namespace std;
 
+struct ConfusionMetrics											//Metrics of a confusion matrix. Labels that were never guessed have precision 0,
+{																//   and labels never expected have recall 0.
+	vector<int> vecSupport;										//Per label: times expected (row sum)
+	vector<int> vecPredicted;									//Per label: times guessed (column sum)
+	vector<int> vecCorrect;										//Per label: times expected and guessed (diagonal)
+	vector<double> vecPrecision;								//Per label: vecCorrect / vecPredicted
+	vector<double> vecRecall;									//Per label: vecCorrect / vecSupport
+	vector<double> vecF1;										//Per label: harmonic mean of precision and recall
+	int nTotal;													//Classifications counted
+	int nCorrect;												//Classifications counted that were correct
+	double dblAccuracy;											//nCorrect / nTotal
+	double dblMacroPrecision;									//Mean of vecPrecision over every label
+	double dblMacroRecall;										//Mean of vecRecall over every label
+	double dblMacroF1;											//Mean of vecF1 over every label
+	double dblMicroPrecision;									//Precision over every classification. With one label per row, micro precision,
+	double dblMicroRecall;										//   recall and F1 all equal accuracy.
+	double dblMicroF1;
+	vector<double> vecTopKAccuracy;								//vecTopKAccuracy[k - 1] is the fraction of rows added by addScores() whose expected
+																//   label scored among the k highest. Empty if none were.
+};
+
 class ConfusionMatrix
 {
 public:
 	ConfusionMatrix(int width);						//Constructor
 	ConfusionMatrix(int width, string labels);		//Constructor
-	void cellPlusOne(int row, int col);				//Does m_Matrix[row][col]++. Functions as a way to count correct/incorrect classifications,
+	ConfusionMatrix(int width, string labels, int shardcount);	//Constructor. Each of shardcount threads may count into a shard of its own at once.
+	void cellPlusOne(int row, int col);				//Does [row][col]++. Functions as a way to count correct/incorrect classifications,
+	void cellPlusOne(int row, int col, int shard);	//As above, in the given shard
+	void addClassifications(const int *expected,	//Counts count classifications: expected[i] is row i's label and guesses[i] its
+			const int *guesses, int count, int shard = 0);	//   classification
+	template <typename T>
+	void addScores(const int *expected,				//Counts count rows, each guessed as the label of its highest score in scores (count x
+			const T *scores, int count, int shard = 0);	//   width, row-major), and records the rank of its expected label's score
+	void mergeShards();								//Folds every shard into the first, leaving the others empty
+	bool merge(const ConfusionMatrix &other);		//Adds every count of other, which must be as wide. Returns false, with an error msg, otherwise.
+	void clear();									//Zeroes every count in every shard
+	int getCount(int row, int col) const;			//Returns [row][col], summed over the shards
+	int getWidth() const;							//Returns m_nWidth
+	int getShardCount() const;						//Returns m_nShardCount
+	ConfusionMetrics getMetrics() const;			//Returns every metric, computed in one pass over the cells
 	void outputAccuracy();							//Outputs matrix accuracy by column
 	void outputMatrix();							//Output entire matrix, including labels if set
+	void outputMetricsCsv(ostream &out) const;		//Outputs one CSV row per label, then macro and micro averages, then a table of top-k accuracy
+	void outputMetricsJson(ostream &out) const;		//Outputs the metrics as one JSON object
+	bool saveMetrics(const string &filename) const;	//Writes the metrics as JSON if filename ends in .json, else as CSV.
+													//   Returns false, with an error msg, on failure.
 
 private:
-	int getIndex(int row, int col);					//Returns m_Matrix[row][col]
-	void setIndex(int row, int col, int set);		//Updates m_Matrix[row][col] with given value 'set'
+	int getIndex(int row, int col, int shard) const;	//Returns the index of [row][col] of the given shard in m_vecCounts
+	string getLabel(int index) const;				//Returns the label of row/col index, or the index itself if labels aren't set
 	string m_strLabels;								//Row and Col labels. Ex: [A,B,C,D,E,...,Z]
-	vector<vector<int>> m_Matrix;
+	int m_nWidth;									//Rows (and cols)
+	int m_nShardCount;								//Shards
+	int m_nShardSize;								//Counts per shard: width^2 cells, then width ranks, padded to a whole number of cache lines
+	vector<int> m_vecCounts;						//Every shard, in turn. A shard's ranks count the rows added by addScores() whose expected
+													//   label's score was beaten by 0, 1, ... width - 1 other scores.
 };
 
-ConfusionMatrix::ConfusionMatrix(int width) : m_Matrix(width, vector<int>(width, 0))
+ConfusionMatrix::ConfusionMatrix(int width) : ConfusionMatrix(width, "", 1)
+{}
+ConfusionMatrix::ConfusionMatrix(int width, string labels) : ConfusionMatrix(width, labels, 1)
 {}
-ConfusionMatrix::ConfusionMatrix(int width, string labels) : m_Matrix(width, vector<int>(width, 0)), m_strLabels(labels)
+ConfusionMatrix::ConfusionMatrix(int width, string labels, int shardcount) : m_strLabels(labels), m_nWidth(width),
+m_nShardCount(shardcount < 1 ? 1 : shardcount), m_nShardSize((width * width + width + 15) / 16 * 16),
+m_vecCounts((size_t)m_nShardSize * m_nShardCount, 0)
 {}
 
-//Returns m_Matrix[row][col]
-int ConfusionMatrix::getIndex(int row, int col)
+//Returns the index of [row][col] in the given shard
+int ConfusionMatrix::getIndex(int row, int col, int shard) const
 {
-	return m_Matrix[row][col];
+	return shard * m_nShardSize + row * m_nWidth + col;
 }
 
-//updates m_Matrix[row][col] with given value 'set'
-void ConfusionMatrix::setIndex(int row, int col, int set)
+//Increment [row][col] by 1. This functions as a way to count correct/incorrect classifications,
+//  because a correct classification implies that row == col
+// ex: If A is expected but C is output of classifier, [0][2] is incremented by 1, counting an incorrect guess.
+//     if C is expected and C is output of classified, [2][2] is incremented, counting a correct guess.
+void ConfusionMatrix::cellPlusOne(int row, int col)
 {
-	m_Matrix[row][col] = set;
+	m_vecCounts[getIndex(row, col, 0)]++;
+}
+void ConfusionMatrix::cellPlusOne(int row, int col, int shard)
+{
+	m_vecCounts[getIndex(row, col, shard)]++;
 }
 
-//Increment m_Matrix[row][col] by 1. This functions as a way to count correct/incorrect classifications,
-//  because a correct classification implies that row == col
-// ex: If A is expected but C is output of classifier, m_Matrix[0][2] is incremented by 1, counting an incorrect guess. 
-//     if C is expected and C is output of classified, m_Matrix[2][2] is incremented, counting a correct guess.
-void ConfusionMatrix::cellPlusOne(int row, int col)
+void ConfusionMatrix::addClassifications(const int *expected, const int *guesses, int count, int shard)
 {
-	setIndex(row, col, getIndex(row, col) + 1);
+	int *pCells = m_vecCounts.data() + (size_t)shard * m_nShardSize;
+	for (int i = 0; i < count; i++)
+		pCells[expected[i] * m_nWidth + guesses[i]]++;
 }
 
-//outputs the accuracy as a percentage for each col in CSV form
+//A row's guess is its first highest score, as SigmoidClassifier::classifyBatch() chooses. Its expected label's rank is
+// the number of scores strictly higher, so ties count in the label's favour.
+template <typename T>
+void ConfusionMatrix::addScores(const int *expected, const T *scores, int count, int shard)
+{
+	int *pCells = m_vecCounts.data() + (size_t)shard * m_nShardSize;
+	int *pRanks = pCells + m_nWidth * m_nWidth;
+	for (int i = 0; i < count; i++)
+	{
+		const T *pScores = scores + (size_t)i * m_nWidth;
+		T expectedScore = pScores[expected[i]];
+		int nGuess = 0;
+		int nRank = 0;
+		for (int j = 0; j < m_nWidth; j++)
+		{
+			if (pScores[j] > pScores[nGuess])
+				nGuess = j;
+			nRank += pScores[j] > expectedScore;
+		}
+		pCells[expected[i] * m_nWidth + nGuess]++;
+		pRanks[nRank]++;
+	}
+}
+
+void ConfusionMatrix::mergeShards()
+{
+	for (int s = 1; s < m_nShardCount; s++)
+	{
+		for (int k = 0; k < m_nShardSize; k++)
+		{
+			m_vecCounts[k] += m_vecCounts[(size_t)s * m_nShardSize + k];
+			m_vecCounts[(size_t)s * m_nShardSize + k] = 0;
+		}
+	}
+}
+
+bool ConfusionMatrix::merge(const ConfusionMatrix &other)
+{
+	if (other.m_nWidth != m_nWidth)
+	{
+		cout << "ERROR: Only confusion matrices of equal width may be merged.\n";
+		return false;
+	}
+	for (int s = 0; s < other.m_nShardCount; s++)
+		for (int k = 0; k < m_nShardSize; k++)
+			m_vecCounts[k] += other.m_vecCounts[(size_t)s * m_nShardSize + k];
+	return true;
+}
+
+void ConfusionMatrix::clear()
+{
+	fill(m_vecCounts.begin(), m_vecCounts.end(), 0);
+}
+
+//Sums each row, column and the diagonal in one pass over every shard's cells, then derives each metric per label and
+// averages them
+ConfusionMetrics ConfusionMatrix::getMetrics() const
+{
+	ConfusionMetrics metrics;
+	metrics.vecSupport.assign(m_nWidth, 0);
+	metrics.vecPredicted.assign(m_nWidth, 0);
+	metrics.vecCorrect.assign(m_nWidth, 0);
+	vector<int> vecRanks(m_nWidth, 0);
+	for (int s = 0; s < m_nShardCount; s++)
+	{
+		const int *pCells = m_vecCounts.data() + (size_t)s * m_nShardSize;
+		for (int i = 0; i < m_nWidth; i++)
+		{
+			const int *pRow = pCells + i * m_nWidth;
+			for (int j = 0; j < m_nWidth; j++)
+			{
+				metrics.vecSupport[i] += pRow[j];
+				metrics.vecPredicted[j] += pRow[j];
+			}
+			metrics.vecCorrect[i] += pRow[i];
+		}
+		for (int r = 0; r < m_nWidth; r++)
+			vecRanks[r] += pCells[m_nWidth * m_nWidth + r];
+	}
+
+	metrics.vecPrecision.assign(m_nWidth, 0);
+	metrics.vecRecall.assign(m_nWidth, 0);
+	metrics.vecF1.assign(m_nWidth, 0);
+	metrics.nTotal = 0;
+	metrics.nCorrect = 0;
+	metrics.dblMacroPrecision = metrics.dblMacroRecall = metrics.dblMacroF1 = 0;
+	for (int i = 0; i < m_nWidth; i++)
+	{
+		if (metrics.vecPredicted[i] > 0)
+			metrics.vecPrecision[i] = (double)metrics.vecCorrect[i] / metrics.vecPredicted[i];
+		if (metrics.vecSupport[i] > 0)
+			metrics.vecRecall[i] = (double)metrics.vecCorrect[i] / metrics.vecSupport[i];
+		if (metrics.vecPrecision[i] + metrics.vecRecall[i] > 0)
+			metrics.vecF1[i] = 2 * metrics.vecPrecision[i] * metrics.vecRecall[i] / (metrics.vecPrecision[i] + metrics.vecRecall[i]);
+		metrics.nTotal += metrics.vecSupport[i];
+		metrics.nCorrect += metrics.vecCorrect[i];
+		metrics.dblMacroPrecision += metrics.vecPrecision[i];
+		metrics.dblMacroRecall += metrics.vecRecall[i];
+		metrics.dblMacroF1 += metrics.vecF1[i];
+	}
+	if (m_nWidth > 0)
+	{
+		metrics.dblMacroPrecision /= m_nWidth;
+		metrics.dblMacroRecall /= m_nWidth;
+		metrics.dblMacroF1 /= m_nWidth;
+	}
+	metrics.dblAccuracy = metrics.nTotal > 0 ? (double)metrics.nCorrect / metrics.nTotal : 0;
+	metrics.dblMicroPrecision = metrics.dblMicroRecall = metrics.dblMicroF1 = metrics.dblAccuracy;
+
+	int nRanked = 0;
+	for (int r = 0; r < m_nWidth; r++)
+		nRanked += vecRanks[r];
+	if (nRanked > 0)
+	{
+		int nWithinK = 0;
+		for (int k = 0; k < m_nWidth; k++)
+		{
+			nWithinK += vecRanks[k];
+			metrics.vecTopKAccuracy.push_back((double)nWithinK / nRanked);
+		}
+	}
+	return metrics;
+}
+
+//outputs the accuracy as a percentage for each col in CSV form: the share of each column's guesses that were correct
 void ConfusionMatrix::outputAccuracy()
 {
 	if (m_strLabels.size() != 0) //print col headers if set, comma delim
@@ -67,16 +252,14 @@ void ConfusionMatrix::outputAccuracy()
 		cout << endl;
 	}
 
-	for (unsigned int j = 0; j < m_Matrix.size(); j++) //iterate cols
+	ConfusionMetrics metrics = getMetrics();
+	for (int j = 0; j < m_nWidth; j++) //iterate cols
 	{
-		double nTotal = 0;
-		for (unsigned int i = 0; i < m_Matrix.size(); i++) //iterate rows
-			nTotal = nTotal + m_Matrix[i][j]; //add up entire col
-		//Compute accuracy as, ex: number of letter A instances classified correctly / (number of letter A instances classified correctly AND incorrectly) * 100
-		if (nTotal == 0)
+		//Compute accuracy as, ex: number of letter A guesses that were correct / number of letter A guesses * 100
+		if (metrics.vecPredicted[j] == 0)
 			cout << "N,";
 		else
-			cout << (m_Matrix[j][j] / nTotal * 100) << ",";
+			cout << (metrics.vecPrecision[j] * 100) << ",";
 	}
 }
 
@@ -91,13 +274,85 @@ void ConfusionMatrix::outputMatrix()
 		cout << endl;
 	}
 
-	for (unsigned int i = 0; i < m_Matrix.size(); i++) 
+	for (int i = 0; i < m_nWidth; i++)
 	{
 		if (m_strLabels.size() != 0) //print row headers, if set
 			cout << m_strLabels[i] << ",";
 
-		for (unsigned int j = 0; j < m_Matrix[0].size(); j++)
-			cout << m_Matrix[i][j] << ",";
+		for (int j = 0; j < m_nWidth; j++)
+			cout << getCount(i, j) << ",";
 		cout << endl;
 	}
-}
\ No newline at end of file
+}
+
+void ConfusionMatrix::outputMetricsCsv(ostream &out) const
+{
+	ConfusionMetrics m = getMetrics();
+	out << "Label,Support,Predicted,Correct,Precision,Recall,F1\n";
+	for (int i = 0; i < m_nWidth; i++)
+		out << getLabel(i) << "," << m.vecSupport[i] << "," << m.vecPredicted[i] << "," << m.vecCorrect[i] << "," <<
+			m.vecPrecision[i] << "," << m.vecRecall[i] << "," << m.vecF1[i] << "\n";
+	out << "Macro," << m.nTotal << "," << m.nTotal << "," << m.nCorrect << "," << m.dblMacroPrecision << "," << m.dblMacroRecall << "," << m.dblMacroF1 << "\n";
+	out << "Micro," << m.nTotal << "," << m.nTotal << "," << m.nCorrect << "," << m.dblMicroPrecision << "," << m.dblMicroRecall << "," << m.dblMicroF1 << "\n";
+	if (!m.vecTopKAccuracy.empty())
+	{
+		out << "\nK,Top-K Accuracy\n";
+		for (unsigned int k = 0; k < m.vecTopKAccuracy.size(); k++)
+			out << k + 1 << "," << m.vecTopKAccuracy[k] << "\n";
+	}
+}
+
+void ConfusionMatrix::outputMetricsJson(ostream &out) const
+{
+	ConfusionMetrics m = getMetrics();
+	out << "{\"total\": " << m.nTotal << ", \"correct\": " << m.nCorrect << ", \"accuracy\": " << m.dblAccuracy <<
+		",\n \"macro\": {\"precision\": " << m.dblMacroPrecision << ", \"recall\": " << m.dblMacroRecall << ", \"f1\": " << m.dblMacroF1 << "}" <<
+		",\n \"micro\": {\"precision\": " << m.dblMicroPrecision << ", \"recall\": " << m.dblMicroRecall << ", \"f1\": " << m.dblMicroF1 << "}" <<
+		",\n \"top_k_accuracy\": [";
+	for (unsigned int k = 0; k < m.vecTopKAccuracy.size(); k++)
+		out << (k > 0 ? ", " : "") << m.vecTopKAccuracy[k];
+	out << "],\n \"labels\": [\n";
+	for (int i = 0; i < m_nWidth; i++)
+	{
+		out << "  {\"label\": \"" << getLabel(i) << "\", \"support\": " << m.vecSupport[i] << ", \"predicted\": " << m.vecPredicted[i] <<
+			", \"correct\": " << m.vecCorrect[i] << ", \"precision\": " << m.vecPrecision[i] << ", \"recall\": " << m.vecRecall[i] <<
+			", \"f1\": " << m.vecF1[i] << "}" << (i + 1 < m_nWidth ? "," : "") << "\n";
+	}
+	out << "]}\n";
+}
+
+bool ConfusionMatrix::saveMetrics(const string &filename) const
+{
+	ofstream fsOut(filename.c_str());
+	if (filename.size() >= 5 && filename.compare(filename.size() - 5, 5, ".json") == 0)
+		outputMetricsJson(fsOut);
+	else
+		outputMetricsCsv(fsOut);
+	if (fsOut.fail())
+	{
+		cout << "ERROR: Metrics file " << filename << " could not be written.\n";
+		return false;
+	}
+	return true;
+}
+
+///Accessors
+int ConfusionMatrix::getCount(int row, int col) const
+{
+	int nCount = 0;
+	for (int s = 0; s < m_nShardCount; s++)
+		nCount += m_vecCounts[getIndex(row, col, s)];
+	return nCount;
+}
+int ConfusionMatrix::getWidth() const
+{
+	return m_nWidth;
+}
+int ConfusionMatrix::getShardCount() const
+{
+	return m_nShardCount;
+}
+string ConfusionMatrix::getLabel(int index) const
+{
+	return index < (int)m_strLabels.size() ? string(1, m_strLabels[index]) : to_string(index);
+}
@@ -0,0 +1,441 @@
+///////////////////////////////////////////
+// A nueral network of sigmoid "nuerons" whose topology is fixed at compile time, for the lowest possible per-row
+//	latency on a known production topology. FixedSigmoidNetwork<double, 16, 14, 26> is the equivalent of a SigmoidNetwork
+//	built with NETWORK_LAYERS = {16, 14, 26}.
+//	Every layer size is a compile-time constant, so each layer's loops have constant trip counts the compiler unrolls
+//	and vectorizes, and every weight, activation and delta lives in a std::array inside the network object: nothing is
+//	allocated on the heap, and the network's memory footprint is sizeof(FixedSigmoidNetwork).
+//	Each layer's weights are stored transposed (one row per input, one column per neuron) and each row is padded with
+//	zero weights to a multiple of LANE_COUNT neurons (64 bytes), so the forward pass and the weight updates run over
+//	whole vectors of contiguous neurons, with no horizontal sums and no remainder loops. The forward pass is compiled
+//	for SSE2, AVX2 and AVX-512 and the variant matching SigmoidSimd::getKernelIsa() runs, so no special compiler flags
+//	are needed. getParams() and setParams() convert to and from SigmoidNetwork's layout, so weights move freely between
+//	the two through SigmoidClassifier::copyParams().
+//	Training learns from one row at a time on the calling thread, by plain SGD at a constant learning rate, as
+//	SigmoidNetwork does with a batch size of 1 and its default optimizer, and matches it up to rounding.
+//	Classification only reads weights and works on the caller's stack, so any number of threads may classify with one
+//	network at once, as long as none of them is training it.
+// See inline documentation for more info.
+//
+//	T is the scalar type of every weight, activation and feature: float or double. Layers are the neuron counts of each
+//	layer, input layer first.
+//
+
+#pragma once
+#include <array>
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include "SigmoidClassifier.h"
+#include "SigmoidKernels.h"
+
+using namespace std;
+
+namespace FixedTopology
+{
+	//Returns n rounded up to a multiple of lanes
+	constexpr int padToLanes(int n, int lanes)
+	{
+		return (n + lanes - 1) / lanes * lanes;
+	}
+
+	//Returns the index of layer layerindex's first weight in a parameter buffer whose layers have their neuron counts
+	// padded to a multiple of lanes. getParamOffset(networklayers, layercount, lanes) is the size of the buffer.
+	constexpr int getParamOffset(const int *networklayers, int layerindex, int lanes)
+	{
+		int nOffset = 0;
+		for (int i = 1; i < layerindex; i++)
+			nOffset += (networklayers[i - 1] + 1) * padToLanes(networklayers[i], lanes);
+		return nOffset;
+	}
+
+	//Returns the index of layer layerindex's first output among the outputs of every layer but the input layer, each
+	// padded to a multiple of lanes
+	constexpr int getNeuronOffset(const int *networklayers, int layerindex, int lanes)
+	{
+		int nOffset = 0;
+		for (int i = 1; i < layerindex; i++)
+			nOffset += padToLanes(networklayers[i], lanes);
+		return nOffset;
+	}
+}
+
+template <typename T, int... Layers>
+class FixedSigmoidNetwork : public SigmoidClassifier<T>
+{
+	static_assert(sizeof...(Layers) >= 2, "A network needs at least an input and an output layer");
+
+public:
+	static constexpr int LAYER_COUNT = sizeof...(Layers);									//Number of layers, including the input layer
+	static constexpr int NETWORK_LAYERS[LAYER_COUNT] = { Layers... };						//Neuron count of each layer
+	static constexpr int INPUT_COUNT = NETWORK_LAYERS[0];										//Number of inputs
+	static constexpr int OUTPUT_COUNT = NETWORK_LAYERS[LAYER_COUNT - 1];						//Number of output neurons
+	static constexpr int PARAM_COUNT =															//Number of weights, including bias weights
+			FixedTopology::getParamOffset(NETWORK_LAYERS, LAYER_COUNT, 1);
+	static constexpr int LANE_COUNT = 64 / sizeof(T);											//Layers are padded to a multiple of this many neurons
+
+	FixedSigmoidNetwork(double learningrate, double bias, double biaswt, bool verbose);		//Constructor
+
+	void doTraining(const SigmoidDataSet<T> &trainingset, int iterationcount);				//Learns from every row of trainingset, iterationcount times
+	int getClassification(const T *params) const;												//Returns the index of the output neuron having the highest output, given input params
+	void classifyBatch(const T *features, int rowcount,										//Classifies rowcount rows of features. See SigmoidClassifier.
+			int *classifications, T *scores) const;
+	int getLayerCount() const;																	//Returns LAYER_COUNT
+	const int *getNetworkLayers() const;														//Returns NETWORK_LAYERS
+	int getParamCount() const;																	//Returns PARAM_COUNT
+	double getBias() const;																		//Returns m_dblBias
+	SigmoidActivation getActivation() const;													//Returns m_Activation
+	void setActivation(SigmoidActivation activation);											//Sets the sigmoid implementation every layer uses. Default exact.
+	void getParams(T *params) const;															//Copies every weight to params, in SigmoidNetwork's layout
+	void setParams(const T *params);															//Sets every weight from params, in SigmoidNetwork's layout
+
+private:
+	static constexpr int PADDED_PARAM_COUNT =													//Size of m_Params
+			FixedTopology::getParamOffset(NETWORK_LAYERS, LAYER_COUNT, LANE_COUNT);
+	static constexpr int PADDED_NEURON_COUNT =													//Size of m_Outputs and m_Deltas
+			FixedTopology::getNeuronOffset(NETWORK_LAYERS, LAYER_COUNT, LANE_COUNT);
+	static constexpr int OUTPUT_OFFSET =														//Index of the output layer's first output in m_Outputs
+			FixedTopology::getNeuronOffset(NETWORK_LAYERS, LAYER_COUNT - 1, LANE_COUNT);
+
+	template <int L> void propagateForward(const T *inputs, T *outputs) const					//Runs inputs through layers L onward. outputs holds PADDED_NEURON_COUNT
+			__attribute__((always_inline));														//   outputs. Inlined into each ISA's forward pass.
+	void propagateForwardSse2(const T *inputs, T *outputs) const;								//propagateForward<1>(), compiled for each ISA
+	void propagateForwardAvx2(const T *inputs, T *outputs) const;
+	void propagateForwardAvx512(const T *inputs, T *outputs) const;
+	void propagateForwardIsa(const T *inputs, T *outputs) const;								//Runs the propagateForward<1>() of the kernels' ISA
+	template <int L> void propagateDeltas();													//Sets the deltas of layers L - 1 down to 1 from those of layer L
+	template <int L> void updateWeights(const T *params);										//Corrects the weights of layers L down to 1 by their deltas
+	double doLearn(int expectedresult, const T *params);										//Trains the network, given input params and expected result
+	static int getHighestOutput(const T *outputs);												//Returns the index of the highest of OUTPUT_COUNT outputs
+
+	double m_dblLearningRate;
+	double m_dblBias;																			//Bias of every neuron
+	SigmoidActivation m_Activation;																//Sigmoid implementation
+	int m_nEpochCount;																			//Training epochs done
+	bool m_bVerbose;																			//Verbose mode outputs the error per iteration to the console
+	alignas(64) array<T, PADDED_PARAM_COUNT> m_Params;											//Every weight. Each layer is an input-major weight matrix, then bias weights,
+																							//   with each row padded by zero weights to a multiple of LANE_COUNT.
+	alignas(64) array<T, PADDED_NEURON_COUNT> m_Outputs;										//Outputs of every neuron, layer by layer, while training
+	alignas(64) array<T, PADDED_NEURON_COUNT> m_Deltas;											//Deltas of every neuron, laid out as m_Outputs. Padding stays 0.
+
+	static constexpr double OUTPUT_HIGH = .9;													//Expected output of the output neuron matching a row's label
+	static constexpr double OUTPUT_LOW = .1;													//Expected output of every other output neuron
+};
+
+//Constructor. Weights are initialized as SigmoidNetwork initializes them, drawing from rand() in the same order, so
+// both networks start from the same weights for the same seed.
+template <typename T, int... Layers>
+FixedSigmoidNetwork<T, Layers...>::FixedSigmoidNetwork(double learningrate, double bias, double biaswt, bool verbose) :
+m_dblLearningRate(learningrate), m_dblBias(bias), m_Activation(ACTIVATION_EXACT), m_nEpochCount(0), m_bVerbose(verbose)
+{
+	m_Params.fill(0);
+	m_Outputs.fill(0);
+	m_Deltas.fill(0);
+	for (int i = 0; i < INPUT_COUNT * INPUT_COUNT; i++)	//the input layer's unused weights (see SigmoidNetwork's constructor)
+		rand();
+	for (int i = 1; i < LAYER_COUNT; i++)
+	{
+		int nInputs = NETWORK_LAYERS[i - 1];
+		int nNeurons = NETWORK_LAYERS[i];
+		int nStride = FixedTopology::padToLanes(nNeurons, LANE_COUNT);
+		T *pWeights = m_Params.data() + FixedTopology::getParamOffset(NETWORK_LAYERS, i, LANE_COUNT);
+		for (int j = 0; j < nNeurons; j++)
+		{
+			for (int k = 0; k < nInputs; k++)
+			{
+				T &weight = pWeights[k * nStride + j];
+				weight = (T)(((double)(rand() % 10) + 1) / 10);
+				if (weight > 0.5)
+					weight *= -1;
+			}
+		}
+		for (int j = 0; j < nNeurons; j++)
+			pWeights[nInputs * nStride + j] = (T)biaswt;
+	}
+}
+
+//Calls doLearn() for every row in the data set, in order. It does this iterationcount times.
+template <typename T, int... Layers>
+void FixedSigmoidNetwork<T, Layers...>::doTraining(const SigmoidDataSet<T> &trainingset, int iterationcount)
+{
+	if (iterationcount < 1 || trainingset.getRowCount() < 1)
+		cout << "ERROR: Invalid iteration count or data set size.\n";
+	else if (trainingset.getParamCount() != INPUT_COUNT)
+		cout << "ERROR: Training set parameter count does not match the network's input count.\n";
+	else
+	{
+		double nError = 0;
+		for (int i = 0; i < iterationcount; i++)
+		{
+			for (int j = 0; j < trainingset.getRowCount(); j++)
+				nError = doLearn(trainingset.getLabel(j), trainingset.getParams(j));
+			m_nEpochCount++;
+			if (m_bVerbose)
+				cout << i + 1 << "," << nError << endl; //output epoch number and delta from the doLearn function.
+		}
+	}
+}
+
+//Adjust weights via back propogation, as SigmoidNetwork::doLearn() does: every delta is found from the current weights
+// before any weight is corrected. Returns the output layer error as it was calculated before weight adjustments.
+template <typename T, int... Layers>
+double FixedSigmoidNetwork<T, Layers...>::doLearn(int expectedresult, const T *params)
+{
+	double errorTotal = 0;
+	propagateForwardIsa(params, m_Outputs.data());
+
+	//Determine deltas for output layer neurons, then hidden layers r to l, then correct weights r to l
+	const T *pOutputs = m_Outputs.data() + OUTPUT_OFFSET;
+	T *pDeltas = m_Deltas.data() + OUTPUT_OFFSET;
+	for (int i = 0; i < OUTPUT_COUNT; i++)
+	{
+		T expOutput = (T)((i == expectedresult) ? OUTPUT_HIGH : OUTPUT_LOW);
+		T actOutput = pOutputs[i];
+		pDeltas[i] = -(expOutput - actOutput) * actOutput * (1 - actOutput);
+		errorTotal += fabs(pDeltas[i]);
+	}
+	propagateDeltas<LAYER_COUNT - 1>();
+	updateWeights<LAYER_COUNT - 1>(params);
+	return errorTotal;
+}
+
+//Calculates the outputs of layer L from inputs (the outputs of layer L - 1), then passes them on to layer L + 1.
+// Each input's weights are scaled into the outputs in turn, so the inner loop runs over whole vectors of neurons.
+// Padding neurons have zero weights, so their outputs are sigmoid(0) and are never read.
+template <typename T, int... Layers>
+template <int L>
+inline void FixedSigmoidNetwork<T, Layers...>::propagateForward(const T *inputs, T *outputs) const
+{
+	constexpr int IN = NETWORK_LAYERS[L - 1];
+	constexpr int OUT = FixedTopology::padToLanes(NETWORK_LAYERS[L], LANE_COUNT);
+	const T *pWeights = m_Params.data() + FixedTopology::getParamOffset(NETWORK_LAYERS, L, LANE_COUNT);
+	const T *pBiasWeights = pWeights + IN * OUT;
+	T *pOutputs = outputs + FixedTopology::getNeuronOffset(NETWORK_LAYERS, L, LANE_COUNT);
+	T bias = (T)m_dblBias;
+
+	alignas(64) array<T, OUT> sums;	//Local, so the compiler can keep the sums in registers
+	for (int j = 0; j < OUT; j++)
+		sums[j] = bias * pBiasWeights[j];
+	for (int k = 0; k < IN; k++)
+	{
+		T input = inputs[k];
+		const T *pRow = pWeights + k * OUT;
+		for (int j = 0; j < OUT; j++)
+			sums[j] += pRow[j] * input;
+	}
+	copy(sums.begin(), sums.end(), pOutputs);
+	SigmoidKernels::calculateSigmoid(pOutputs, OUT, m_Activation);
+	if constexpr (L + 1 < LAYER_COUNT)
+		propagateForward<L + 1>(pOutputs, outputs);
+}
+
+template <typename T, int... Layers>
+void FixedSigmoidNetwork<T, Layers...>::propagateForwardSse2(const T *inputs, T *outputs) const
+{
+	propagateForward<1>(inputs, outputs);
+}
+
+#ifdef SIGMOID_SIMD_X86
+template <typename T, int... Layers>
+__attribute__((target("avx2,fma"))) void FixedSigmoidNetwork<T, Layers...>::propagateForwardAvx2(const T *inputs, T *outputs) const
+{
+	propagateForward<1>(inputs, outputs);
+}
+
+template <typename T, int... Layers>
+__attribute__((target("avx512f"))) void FixedSigmoidNetwork<T, Layers...>::propagateForwardAvx512(const T *inputs, T *outputs) const
+{
+	propagateForward<1>(inputs, outputs);
+}
+#else
+template <typename T, int... Layers>
+void FixedSigmoidNetwork<T, Layers...>::propagateForwardAvx2(const T *inputs, T *outputs) const
+{
+	propagateForward<1>(inputs, outputs);
+}
+
+template <typename T, int... Layers>
+void FixedSigmoidNetwork<T, Layers...>::propagateForwardAvx512(const T *inputs, T *outputs) const
+{
+	propagateForward<1>(inputs, outputs);
+}
+#endif
+
+//The kernels' ISA is only ever one the CPU supports (see SigmoidSimd::setKernelIsa()), so the variant chosen can run
+template <typename T, int... Layers>
+void FixedSigmoidNetwork<T, Layers...>::propagateForwardIsa(const T *inputs, T *outputs) const
+{
+	switch (SigmoidSimd::g_Kernels.isa)
+	{
+	case SigmoidSimd::ISA_AVX512:
+		propagateForwardAvx512(inputs, outputs);
+		break;
+	case SigmoidSimd::ISA_AVX2:
+		propagateForwardAvx2(inputs, outputs);
+		break;
+	default:
+		propagateForwardSse2(inputs, outputs);
+	}
+}
+
+//Back propagates layer L's deltas to layer L - 1, scaled by the sigmoid derivative of its outputs, down to layer 1
+template <typename T, int... Layers>
+template <int L>
+void FixedSigmoidNetwork<T, Layers...>::propagateDeltas()
+{
+	if constexpr (L > 1)
+	{
+		constexpr int IN = NETWORK_LAYERS[L - 1];
+		constexpr int OUT = FixedTopology::padToLanes(NETWORK_LAYERS[L], LANE_COUNT);
+		const T *pWeights = m_Params.data() + FixedTopology::getParamOffset(NETWORK_LAYERS, L, LANE_COUNT);
+		const T *pDeltas = m_Deltas.data() + FixedTopology::getNeuronOffset(NETWORK_LAYERS, L, LANE_COUNT);
+		const T *pPrvOutputs = m_Outputs.data() + FixedTopology::getNeuronOffset(NETWORK_LAYERS, L - 1, LANE_COUNT);
+		T *pPrvDeltas = m_Deltas.data() + FixedTopology::getNeuronOffset(NETWORK_LAYERS, L - 1, LANE_COUNT);
+		for (int k = 0; k < IN; k++)
+		{
+			const T *pRow = pWeights + k * OUT;
+			T sum = 0;
+			for (int j = 0; j < OUT; j++)
+				sum += pRow[j] * pDeltas[j];
+			pPrvDeltas[k] = sum * pPrvOutputs[k] * (1 - pPrvOutputs[k]);
+		}
+		propagateDeltas<L - 1>();
+	}
+}
+
+//Does W[k][j] -= learningrate * deltas[j] * inputs[k] for layer L, and the same for bias weights, then for layer L - 1.
+// Padding deltas are 0, so padding weights stay 0.
+template <typename T, int... Layers>
+template <int L>
+void FixedSigmoidNetwork<T, Layers...>::updateWeights(const T *params)
+{
+	constexpr int IN = NETWORK_LAYERS[L - 1];
+	constexpr int OUT = FixedTopology::padToLanes(NETWORK_LAYERS[L], LANE_COUNT);
+	T *pWeights = m_Params.data() + FixedTopology::getParamOffset(NETWORK_LAYERS, L, LANE_COUNT);
+	T *pBiasWeights = pWeights + IN * OUT;
+	const T *pDeltas = m_Deltas.data() + FixedTopology::getNeuronOffset(NETWORK_LAYERS, L, LANE_COUNT);
+	const T *pInputs = (L == 1) ? params : m_Outputs.data() + FixedTopology::getNeuronOffset(NETWORK_LAYERS, L - 1, LANE_COUNT);
+
+	alignas(64) array<T, OUT> scaledDeltas;
+	for (int j = 0; j < OUT; j++)
+	{
+		scaledDeltas[j] = (T)-(m_dblLearningRate * pDeltas[j]);
+		pBiasWeights[j] -= (T)(m_dblLearningRate * pDeltas[j]);	//bias weight correction
+	}
+	for (int k = 0; k < IN; k++)
+	{
+		T input = pInputs[k];
+		T *pRow = pWeights + k * OUT;
+		for (int j = 0; j < OUT; j++)
+			pRow[j] += scaledDeltas[j] * input;
+	}
+	if constexpr (L > 1)
+		updateWeights<L - 1>(params);
+}
+
+//Runs params through the network in a buffer on the caller's stack and returns the index of the highest output
+template <typename T, int... Layers>
+int FixedSigmoidNetwork<T, Layers...>::getClassification(const T *params) const
+{
+	alignas(64) array<T, PADDED_NEURON_COUNT> outputs;
+	propagateForwardIsa(params, outputs.data());
+	return getHighestOutput(outputs.data() + OUTPUT_OFFSET);
+}
+
+//Classifies rowcount rows of features, one row at a time, in a buffer on the caller's stack
+template <typename T, int... Layers>
+void FixedSigmoidNetwork<T, Layers...>::classifyBatch(const T *features, int rowcount, int *classifications, T *scores) const
+{
+	alignas(64) array<T, PADDED_NEURON_COUNT> outputs;
+	for (int b = 0; b < rowcount; b++)
+	{
+		propagateForwardIsa(features + (size_t)b * INPUT_COUNT, outputs.data());
+		classifications[b] = getHighestOutput(outputs.data() + OUTPUT_OFFSET);
+		if (scores != NULL)
+			copy(outputs.begin() + OUTPUT_OFFSET, outputs.begin() + OUTPUT_OFFSET + OUTPUT_COUNT, scores + (size_t)b * OUTPUT_COUNT);
+	}
+}
+
+//cycle through output-layer neurons and find the one with the highest output.
+// The index of the highest-value neuron is the index of our classification.
+template <typename T, int... Layers>
+int FixedSigmoidNetwork<T, Layers...>::getHighestOutput(const T *outputs)
+{
+	double dblHigh = -1;
+	int nResult = -1;
+	for (int i = 0; i < OUTPUT_COUNT; i++)
+	{
+		if (outputs[i] > dblHigh)
+		{
+			nResult = i;
+			dblHigh = outputs[i];
+		}
+	}
+	return nResult;
+}
+
+///Accessors
+template <typename T, int... Layers>
+int FixedSigmoidNetwork<T, Layers...>::getLayerCount() const
+{
+	return LAYER_COUNT;
+}
+template <typename T, int... Layers>
+const int *FixedSigmoidNetwork<T, Layers...>::getNetworkLayers() const
+{
+	return NETWORK_LAYERS;
+}
+template <typename T, int... Layers>
+int FixedSigmoidNetwork<T, Layers...>::getParamCount() const
+{
+	return PARAM_COUNT;
+}
+template <typename T, int... Layers>
+double FixedSigmoidNetwork<T, Layers...>::getBias() const
+{
+	return m_dblBias;
+}
+template <typename T, int... Layers>
+SigmoidActivation FixedSigmoidNetwork<T, Layers...>::getActivation() const
+{
+	return m_Activation;
+}
+template <typename T, int... Layers>
+void FixedSigmoidNetwork<T, Layers...>::setActivation(SigmoidActivation activation)
+{
+	m_Activation = activation;
+}
+//Each layer's weight matrix is transposed to neuron-major order, without padding
+template <typename T, int... Layers>
+void FixedSigmoidNetwork<T, Layers...>::getParams(T *params) const
+{
+	for (int i = 1; i < LAYER_COUNT; i++)
+	{
+		int nInputs = NETWORK_LAYERS[i - 1];
+		int nNeurons = NETWORK_LAYERS[i];
+		int nStride = FixedTopology::padToLanes(nNeurons, LANE_COUNT);
+		const T *pWeights = m_Params.data() + FixedTopology::getParamOffset(NETWORK_LAYERS, i, LANE_COUNT);
+		T *pLayerParams = params + FixedTopology::getParamOffset(NETWORK_LAYERS, i, 1);
+		for (int j = 0; j < nNeurons; j++)
+			for (int k = 0; k < nInputs; k++)
+				pLayerParams[j * nInputs + k] = pWeights[k * nStride + j];
+		copy(pWeights + nInputs * nStride, pWeights + nInputs * nStride + nNeurons, pLayerParams + nInputs * nNeurons);
+	}
+}
+//Each layer's weight matrix is transposed to input-major order. Padding weights are left at 0.
+template <typename T, int... Layers>
+void FixedSigmoidNetwork<T, Layers...>::setParams(const T *params)
+{
+	for (int i = 1; i < LAYER_COUNT; i++)
+	{
+		int nInputs = NETWORK_LAYERS[i - 1];
+		int nNeurons = NETWORK_LAYERS[i];
+		int nStride = FixedTopology::padToLanes(nNeurons, LANE_COUNT);
+		T *pWeights = m_Params.data() + FixedTopology::getParamOffset(NETWORK_LAYERS, i, LANE_COUNT);
+		const T *pLayerParams = params + FixedTopology::getParamOffset(NETWORK_LAYERS, i, 1);
+		for (int j = 0; j < nNeurons; j++)
+			for (int k = 0; k < nInputs; k++)
+				pWeights[k * nStride + j] = pLayerParams[j * nInputs + k];
+		copy(pLayerParams + nInputs * nNeurons, pLayerParams + (nInputs + 1) * nNeurons, pWeights + nInputs * nStride);
+	}
+}
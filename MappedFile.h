@@ -0,0 +1,122 @@
+///////////////////////////////////////////
+// A read-only view of a whole file, memory-mapped where the platform supports it (POSIX mmap), and otherwise read
+//	into a private buffer. Mapped pages are copy-on-write, so the contents may be modified in memory without ever
+//	changing the file.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPEDFILE_POSIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+class MappedFile
+{
+public:
+	MappedFile();															//Constructor
+	~MappedFile();															//Unmaps the file, if open
+	bool open(const string &filename);										//Maps filename. Returns false, with an error msg, if it cannot be opened
+	void close();															//Unmaps the file
+	char *getData();														//Returns the file's contents, or NULL if no file is open
+	const char *getData() const;
+	size_t getSize() const;													//Returns the file's size in bytes
+	bool isMapped() const;													//Returns true if the contents are memory-mapped rather than read into a buffer
+
+private:
+	MappedFile(const MappedFile &);											//Not copyable
+	MappedFile &operator=(const MappedFile &);
+
+	char *m_pData;															//Start of the file's contents
+	size_t m_nSize;															//Size of the file in bytes
+	bool m_bMapped;															//True = m_pData is a mapping. False = m_pData points into m_vecBuffer.
+	vector<char> m_vecBuffer;												//File contents, when the file could not be mapped
+};
+
+//Constructor
+MappedFile::MappedFile() : m_pData(NULL), m_nSize(0), m_bMapped(false)
+{}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+//Maps the whole of filename into memory. Falls back to reading it into a buffer when mmap is not available, or when
+// the file is empty (which cannot be mapped).
+bool MappedFile::open(const string &filename)
+{
+	close();
+#ifdef MAPPEDFILE_POSIX
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		cout << "ERROR: File " << filename << " could not be opened.\n";
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void *p = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED)
+		{
+			m_pData = (char *)p;
+			m_nSize = (size_t)st.st_size;
+			m_bMapped = true;
+		}
+	}
+	::close(fd);
+	if (m_bMapped)
+		return true;
+#endif
+	ifstream fsIn(filename.c_str(), ios::binary);
+	if (fsIn.fail())
+	{
+		cout << "ERROR: File " << filename << " could not be opened.\n";
+		return false;
+	}
+	m_vecBuffer.assign(istreambuf_iterator<char>(fsIn), istreambuf_iterator<char>());
+	m_pData = m_vecBuffer.data();
+	m_nSize = m_vecBuffer.size();
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef MAPPEDFILE_POSIX
+	if (m_bMapped)
+		munmap(m_pData, m_nSize);
+#endif
+	m_vecBuffer.clear();
+	m_pData = NULL;
+	m_nSize = 0;
+	m_bMapped = false;
+}
+
+///Accessors
+char *MappedFile::getData()
+{
+	return m_pData;
+}
+const char *MappedFile::getData() const
+{
+	return m_pData;
+}
+size_t MappedFile::getSize() const
+{
+	return m_nSize;
+}
+bool MappedFile::isMapped() const
+{
+	return m_bMapped;
+}
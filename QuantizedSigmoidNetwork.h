@@ -0,0 +1,394 @@
+///////////////////////////////////////////
+// An inference-only version of a trained sigmoid network, with int8 weights and uint8 activations.
+//	quantize() converts any SigmoidClassifier (a SigmoidNetwork or FixedSigmoidNetwork). Each neuron's weights are
+//	scaled so the largest of them maps to +/-127 and rounded to int8, and that scale is kept as a float alongside the
+//	neuron's bias term (bias * bias weight). Activations are in [0, 1] and are stored as uint8 in units of 1/255, so
+//	input features must be rescaled to [0, 1] first, as main.cpp does; values outside it are clamped.
+//	A neuron's output is then an exact 32-bit integer dot product of its weights and its inputs (see
+//	SigmoidKernels::multiplyMatrixVector()), scaled once and offset by its bias term, and run through a SIGMOID_LUT_SIZE
+//	entry lookup table that maps it straight to the uint8 activation of the next layer. The sigmoid is monotonic, so
+//	the output layer is classified by its highest pre-sigmoid sum and needs no lookup at all.
+//	Weights take a quarter of the memory of float weights and an eighth of that of doubles (plus 8 bytes per neuron).
+//	save() writes them to a quantized model file (see SigmoidModelFile.h) and load() reads one back, optionally
+//	memory-mapping it so the weights are used in place.
+//	Classification is const and runs in buffers local to the calling thread, so any number of threads may classify with
+//	one network at once. tools/quantize_model.cpp reports the accuracy lost to quantization on a validation set.
+// See inline documentation for more info.
+//
+//	T is the scalar type of the features classified: float or double.
+//
+
+#pragma once
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unistd.h>
+#include "SigmoidClassifier.h"
+#include "SigmoidKernels.h"
+#include "MappedFile.h"
+#include "SigmoidModelFile.h"
+
+using namespace std;
+
+template <typename T>
+class QuantizedSigmoidNetwork
+{
+public:
+	QuantizedSigmoidNetwork();																//Constructor. Empty until quantize() is called.
+
+	void quantize(const SigmoidClassifier<T> &network);									//Replaces this network with an int8 copy of network
+	int getClassification(const T *params) const;											//Returns the index of the output neuron having the highest output. Thread-safe.
+	void classifyBatch(const T *features, int rowcount,									//Classifies rowcount rows of features (rowcount x input count, row-major), writing
+			int *classifications, T *scores) const;											//   class indices to classifications and, if not NULL, outputs to scores. Thread-safe.
+	bool save(const string &filename) const;												//Writes the network to filename. Returns false, with an error msg, on failure.
+	static unique_ptr<QuantizedSigmoidNetwork<T>> load(const string &filename, bool mapped);	//Reads a network written by save(). If mapped, the file is memory-mapped and its
+																							//   weights used in place. Returns NULL, with an error msg, on failure.
+	int getLayerCount() const;																//Returns m_nLayerCount
+	const int *getNetworkLayers() const;													//Returns m_vecNetworkLayers
+	size_t getModelSize() const;															//Returns the bytes taken by weights, scales and bias terms
+
+	static const int SIGMOID_LUT_SIZE;														//Entries in the sigmoid lookup table
+	static const double SIGMOID_LUT_RANGE;													//The table covers sums from -SIGMOID_LUT_RANGE to +SIGMOID_LUT_RANGE
+	static const int ACTIVATION_MAX;														//uint8 activation of an output of 1
+
+private:
+	void buildLayers(const int *networklayers, int layercount);							//Sets the topology and the size of every buffer, with no weights
+	void bindParams(const float *scales, const int8_t *weights);							//Points m_pScales, m_pBiasTerms and m_pWeights at the given buffers
+	int getRowStride(int layerindex) const;													//Returns the padded number of weights per neuron in layer layerindex
+	int propagateForward(const T *params, float *outputs) const;							//Runs params through the network, leaving the output layer's sums in outputs.
+																							//   Returns the index of the highest.
+
+	int m_nLayerCount;																		//Number of layers in network, including input layer
+	vector<int> m_vecNetworkLayers;															//Neuron count of each layer
+	int m_nNeuronCount;																		//Neurons in every layer but the input layer
+	size_t m_nWeightCount;																	//int8 weights in every layer, including row padding
+	int m_nMaxRowStride;																	//Widest padded row of any layer
+	const float *m_pScales;																	//Per neuron: the real value of a weight of 1 times an activation of 1
+	const float *m_pBiasTerms;																//Per neuron: bias * bias weight. Follows m_pScales.
+	const int8_t *m_pWeights;																//Every layer's rows of weights, padded to getRowStride()
+	vector<float> m_vecScales;																//Storage for m_pScales and m_pBiasTerms, unless the network is mapped
+	vector<int8_t> m_vecWeights;															//Storage for m_pWeights, unless the network is mapped
+	shared_ptr<MappedFile> m_pModelFile;													//The file a mapped network's weights live in
+	vector<uint8_t> m_vecSigmoidLut;														//Entry i is the activation of a sum of
+																							//   (i + .5) * 2 * SIGMOID_LUT_RANGE / SIGMOID_LUT_SIZE - SIGMOID_LUT_RANGE
+};
+
+template <typename T>
+const int QuantizedSigmoidNetwork<T>::SIGMOID_LUT_SIZE = 4096;
+template <typename T>
+const double QuantizedSigmoidNetwork<T>::SIGMOID_LUT_RANGE = 8;	//sigmoid(8) rounds to ACTIVATION_MAX
+template <typename T>
+const int QuantizedSigmoidNetwork<T>::ACTIVATION_MAX = 255;
+
+//Constructor. Builds the sigmoid lookup table.
+template <typename T>
+QuantizedSigmoidNetwork<T>::QuantizedSigmoidNetwork() : m_nLayerCount(0), m_nNeuronCount(0), m_nWeightCount(0),
+m_nMaxRowStride(0), m_pScales(NULL), m_pBiasTerms(NULL), m_pWeights(NULL)
+{
+	double dblStep = 2 * SIGMOID_LUT_RANGE / SIGMOID_LUT_SIZE;
+	m_vecSigmoidLut.resize(SIGMOID_LUT_SIZE);
+	for (int i = 0; i < SIGMOID_LUT_SIZE; i++)
+	{
+		double dblSum = (i + .5) * dblStep - SIGMOID_LUT_RANGE;
+		m_vecSigmoidLut[i] = (uint8_t)lround(ACTIVATION_MAX / (1 + exp(-dblSum)));
+	}
+}
+
+template <typename T>
+void QuantizedSigmoidNetwork<T>::buildLayers(const int *networklayers, int layercount)
+{
+	m_nLayerCount = layercount;
+	m_vecNetworkLayers.assign(networklayers, networklayers + layercount);
+	m_nNeuronCount = 0;
+	m_nWeightCount = 0;
+	m_nMaxRowStride = 0;
+	for (int i = 1; i < m_nLayerCount; i++)
+	{
+		m_nNeuronCount += networklayers[i];
+		m_nWeightCount += (size_t)networklayers[i] * getRowStride(i);
+		m_nMaxRowStride = max(m_nMaxRowStride, getRowStride(i));
+	}
+	m_nMaxRowStride = max(m_nMaxRowStride, getRowStride(m_nLayerCount));
+}
+
+template <typename T>
+void QuantizedSigmoidNetwork<T>::bindParams(const float *scales, const int8_t *weights)
+{
+	m_pScales = scales;
+	m_pBiasTerms = scales + m_nNeuronCount;
+	m_pWeights = weights;
+}
+
+//Rows are padded with zero weights so the vector kernels never need a scalar remainder. layerindex may be
+// m_nLayerCount, for the width of the output layer's activations.
+template <typename T>
+int QuantizedSigmoidNetwork<T>::getRowStride(int layerindex) const
+{
+	return (m_vecNetworkLayers[layerindex - 1] + QUANTIZED_ROW_ALIGNMENT - 1) / QUANTIZED_ROW_ALIGNMENT * QUANTIZED_ROW_ALIGNMENT;
+}
+
+//Quantizes every layer of network, one neuron at a time: the neuron's largest absolute weight becomes +/-127, and its
+// scale is chosen so that scale * (weight row . activations) is its sum, less its bias term.
+template <typename T>
+void QuantizedSigmoidNetwork<T>::quantize(const SigmoidClassifier<T> &network)
+{
+	vector<T> vecParams(network.getParamCount());
+	network.getParams(vecParams.data());
+	m_pModelFile.reset();
+	buildLayers(network.getNetworkLayers(), network.getLayerCount());
+	m_vecScales.assign(2 * m_nNeuronCount, 0);
+	m_vecWeights.assign(m_nWeightCount, 0);
+
+	const T *pLayerParams = vecParams.data();
+	int nNeuron = 0;
+	int8_t *pWeights = m_vecWeights.data();
+	for (int i = 1; i < m_nLayerCount; i++)
+	{
+		int nInputs = m_vecNetworkLayers[i - 1];
+		int nNeurons = m_vecNetworkLayers[i];
+		int nStride = getRowStride(i);
+		const T *pBiasWeights = pLayerParams + nInputs * nNeurons;
+		for (int j = 0; j < nNeurons; j++, nNeuron++)
+		{
+			const T *pRow = pLayerParams + j * nInputs;
+			double dblMax = 0;
+			for (int k = 0; k < nInputs; k++)
+				dblMax = max(dblMax, fabs((double)pRow[k]));
+			double dblScale = (dblMax > 0) ? dblMax / 127 : 1;
+			for (int k = 0; k < nInputs; k++)
+				pWeights[j * nStride + k] = (int8_t)lround(pRow[k] / dblScale);
+			m_vecScales[nNeuron] = (float)(dblScale / ACTIVATION_MAX);
+			m_vecScales[m_nNeuronCount + nNeuron] = (float)(network.getBias() * pBiasWeights[j]);
+		}
+		pLayerParams += (nInputs + 1) * nNeurons;
+		pWeights += (size_t)nNeurons * nStride;
+	}
+	bindParams(m_vecScales.data(), m_vecWeights.data());
+}
+
+//Quantizes params into the first activation buffer, then runs each layer's integer matrix-vector product, scales each
+// sum and looks up its sigmoid as the next layer's activation. Buffers are local to the calling thread, and are only
+// reallocated when they are used with a wider network.
+template <typename T>
+int QuantizedSigmoidNetwork<T>::propagateForward(const T *params, float *outputs) const
+{
+	static thread_local vector<uint8_t> vecActivations[2];
+	static thread_local vector<int32_t> vecSums;
+	for (int a = 0; a < 2; a++)
+		if (vecActivations[a].size() < (size_t)m_nMaxRowStride)
+			vecActivations[a].resize(m_nMaxRowStride);
+	if (vecSums.size() < (size_t)m_nMaxRowStride)
+		vecSums.resize(m_nMaxRowStride);
+
+	uint8_t *pInputs = vecActivations[0].data();
+	for (int k = 0; k < m_vecNetworkLayers[0]; k++)
+		pInputs[k] = (uint8_t)(min(max(params[k], (T)0), (T)1) * ACTIVATION_MAX + (T).5);
+	fill(pInputs + m_vecNetworkLayers[0], pInputs + getRowStride(1), (uint8_t)0);
+
+	const double LUT_STEPS_PER_UNIT = SIGMOID_LUT_SIZE / (2 * SIGMOID_LUT_RANGE);
+	const int8_t *pWeights = m_pWeights;
+	int nNeuron = 0;
+	for (int i = 1; i < m_nLayerCount; i++)
+	{
+		int nNeurons = m_vecNetworkLayers[i];
+		int nStride = getRowStride(i);
+		SigmoidKernels::multiplyMatrixVector(pWeights, pInputs, vecSums.data(), nNeurons, nStride);
+		if (i == m_nLayerCount - 1)
+		{
+			for (int j = 0; j < nNeurons; j++)
+				outputs[j] = vecSums[j] * m_pScales[nNeuron + j] + m_pBiasTerms[nNeuron + j];
+			break;
+		}
+
+		uint8_t *pOutputs = vecActivations[i % 2].data();
+		for (int j = 0; j < nNeurons; j++)
+		{
+			float fSum = vecSums[j] * m_pScales[nNeuron + j] + m_pBiasTerms[nNeuron + j];
+			int nIndex = (int)((fSum + SIGMOID_LUT_RANGE) * LUT_STEPS_PER_UNIT);
+			pOutputs[j] = m_vecSigmoidLut[min(max(nIndex, 0), SIGMOID_LUT_SIZE - 1)];
+		}
+		fill(pOutputs + nNeurons, pOutputs + getRowStride(i + 1), (uint8_t)0);
+		pInputs = pOutputs;
+		pWeights += (size_t)nNeurons * nStride;
+		nNeuron += nNeurons;
+	}
+
+	int nResult = 0;
+	for (int j = 1; j < m_vecNetworkLayers[m_nLayerCount - 1]; j++)
+		if (outputs[j] > outputs[nResult])
+			nResult = j;
+	return nResult;
+}
+
+template <typename T>
+int QuantizedSigmoidNetwork<T>::getClassification(const T *params) const
+{
+	static thread_local vector<float> vecOutputs;
+	vecOutputs.resize(m_vecNetworkLayers[m_nLayerCount - 1]);
+	return propagateForward(params, vecOutputs.data());
+}
+
+//Classifies rowcount rows of features. Scores, when wanted, are the sigmoid of each output's sum, calculated exactly.
+template <typename T>
+void QuantizedSigmoidNetwork<T>::classifyBatch(const T *features, int rowcount, int *classifications, T *scores) const
+{
+	static thread_local vector<float> vecOutputs;
+	int nInputs = m_vecNetworkLayers[0];
+	int nOutputs = m_vecNetworkLayers[m_nLayerCount - 1];
+	vecOutputs.resize(nOutputs);
+	for (int b = 0; b < rowcount; b++)
+	{
+		classifications[b] = propagateForward(features + (size_t)b * nInputs, vecOutputs.data());
+		if (scores != NULL)
+		{
+			T *pScores = scores + (size_t)b * nOutputs;
+			copy(vecOutputs.begin(), vecOutputs.end(), pScores);
+			SigmoidKernels::calculateSigmoid(pScores, nOutputs);
+		}
+	}
+}
+
+//Writes the header, topology, scales, bias terms and weights described in SigmoidModelFile.h to filename.tmp, flushes
+// it to disk, then renames it over filename, as SigmoidNetwork::save() does, so a process serving the old file mapped
+// keeps its pages.
+template <typename T>
+bool QuantizedSigmoidNetwork<T>::save(const string &filename) const
+{
+	SigmoidQuantizedModelHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, QUANTIZED_MODEL_MAGIC, sizeof(header.magic));
+	header.version = QUANTIZED_MODEL_VERSION;
+	header.layerCount = m_nLayerCount;
+	header.neuronCount = m_nNeuronCount;
+	header.rowAlignment = QUANTIZED_ROW_ALIGNMENT;
+	header.weightCount = m_nWeightCount;
+	size_t nTopologyEnd = sizeof(header) + m_nLayerCount * sizeof(int32_t);
+	header.scaleOffset = (nTopologyEnd + MODEL_PARAM_ALIGNMENT - 1) / MODEL_PARAM_ALIGNMENT * MODEL_PARAM_ALIGNMENT;
+	size_t nScalesEnd = header.scaleOffset + 2 * m_nNeuronCount * sizeof(float);
+	header.weightOffset = (nScalesEnd + MODEL_PARAM_ALIGNMENT - 1) / MODEL_PARAM_ALIGNMENT * MODEL_PARAM_ALIGNMENT;
+
+	string strTempFile = filename + ".tmp";
+	FILE *pFile = fopen(strTempFile.c_str(), "wb");
+	if (!pFile)
+	{
+		cout << "ERROR: Model file " << strTempFile << " could not be opened for writing.\n";
+		return false;
+	}
+	vector<int32_t> vTopology(m_vecNetworkLayers.begin(), m_vecNetworkLayers.end());
+	vector<char> vPadding(MODEL_PARAM_ALIGNMENT, 0);
+	size_t nScalePadding = (size_t)header.scaleOffset - nTopologyEnd;
+	size_t nWeightPadding = (size_t)header.weightOffset - nScalesEnd;
+	bool bWritten = fwrite(&header, sizeof(header), 1, pFile) == 1 &&
+		fwrite(vTopology.data(), sizeof(int32_t), vTopology.size(), pFile) == vTopology.size() &&
+		fwrite(vPadding.data(), 1, nScalePadding, pFile) == nScalePadding &&
+		fwrite(m_pScales, sizeof(float), m_nNeuronCount, pFile) == (size_t)m_nNeuronCount &&
+		fwrite(m_pBiasTerms, sizeof(float), m_nNeuronCount, pFile) == (size_t)m_nNeuronCount &&
+		fwrite(vPadding.data(), 1, nWeightPadding, pFile) == nWeightPadding &&
+		fwrite(m_pWeights, 1, m_nWeightCount, pFile) == m_nWeightCount &&
+		fflush(pFile) == 0 && fsync(fileno(pFile)) == 0;
+	bWritten = fclose(pFile) == 0 && bWritten;
+	if (!bWritten || rename(strTempFile.c_str(), filename.c_str()) != 0)
+	{
+		cout << "ERROR: Model file " << filename << " could not be written.\n";
+		remove(strTempFile.c_str());
+		return false;
+	}
+	return true;
+}
+
+//Reads a quantized model file written by save(). When mapped is true the file is memory-mapped and the network's
+// scales and weights point straight into the mapping. Otherwise they are copied into the network's own buffers.
+template <typename T>
+unique_ptr<QuantizedSigmoidNetwork<T>> QuantizedSigmoidNetwork<T>::load(const string &filename, bool mapped)
+{
+	shared_ptr<MappedFile> pFile(new MappedFile());
+	if (!pFile->open(filename))
+		return unique_ptr<QuantizedSigmoidNetwork<T>>();
+
+	//validate the header and topology against the file size
+	SigmoidQuantizedModelHeader header;
+	const char *pData = pFile->getData();
+	bool bValid = pFile->getSize() >= sizeof(header);
+	if (bValid)
+	{
+		memcpy(&header, pData, sizeof(header));
+		bValid = memcmp(header.magic, QUANTIZED_MODEL_MAGIC, sizeof(header.magic)) == 0 && header.layerCount >= 2 &&
+			(pFile->getSize() - sizeof(header)) / sizeof(int32_t) >= header.layerCount;
+	}
+	if (!bValid)
+	{
+		cout << "ERROR: " << filename << " is not a quantized model file.\n";
+		return unique_ptr<QuantizedSigmoidNetwork<T>>();
+	}
+	if (header.version != QUANTIZED_MODEL_VERSION || header.rowAlignment != QUANTIZED_ROW_ALIGNMENT)
+	{
+		cout << "ERROR: " << filename << " has an unsupported quantized model version.\n";
+		return unique_ptr<QuantizedSigmoidNetwork<T>>();
+	}
+	//the counts are summed in 64 bits and given up on once they pass what the file can hold, so a corrupt topology
+	// can neither overflow them nor have layers built for it
+	vector<int> vTopology;
+	uint64_t nTopologyEnd = sizeof(header) + header.layerCount * sizeof(int32_t);
+	bValid = readModelTopology(pData + sizeof(header), header.layerCount, vTopology) &&
+		header.scaleOffset >= nTopologyEnd && header.scaleOffset <= pFile->getSize() && header.scaleOffset % sizeof(float) == 0 &&
+		header.neuronCount <= (pFile->getSize() - header.scaleOffset) / (2 * sizeof(float)) &&
+		header.weightOffset >= nTopologyEnd && header.weightOffset <= pFile->getSize() &&
+		header.weightCount <= pFile->getSize() - header.weightOffset &&
+		header.neuronCount <= (uint32_t)(numeric_limits<int>::max() - QUANTIZED_ROW_ALIGNMENT) &&
+		vTopology[0] <= (int)(numeric_limits<int>::max() - QUANTIZED_ROW_ALIGNMENT);	//so getRowStride() cannot overflow
+	uint64_t nNeuronCount = 0, nWeightCount = 0;
+	for (unsigned int i = 1; bValid && i < header.layerCount; i++)
+	{
+		uint64_t nRowStride = ((uint64_t)vTopology[i - 1] + QUANTIZED_ROW_ALIGNMENT - 1) / QUANTIZED_ROW_ALIGNMENT * QUANTIZED_ROW_ALIGNMENT;
+		nNeuronCount += vTopology[i];
+		nWeightCount += (uint64_t)vTopology[i] * nRowStride;
+		bValid = nNeuronCount <= header.neuronCount && nWeightCount <= header.weightCount;
+	}
+	if (!bValid || nNeuronCount != header.neuronCount || nWeightCount != header.weightCount)
+	{
+		cout << "ERROR: " << filename << " is truncated or does not match its topology.\n";
+		return unique_ptr<QuantizedSigmoidNetwork<T>>();
+	}
+
+	unique_ptr<QuantizedSigmoidNetwork<T>> pNetwork(new QuantizedSigmoidNetwork<T>());
+	pNetwork->buildLayers(vTopology.data(), (int)vTopology.size());
+	const float *pFileScales = (const float *)(pData + header.scaleOffset);
+	const int8_t *pFileWeights = (const int8_t *)(pData + header.weightOffset);
+	if (mapped && pFile->isMapped())
+	{
+		pNetwork->m_pModelFile = pFile;
+		pNetwork->bindParams(pFileScales, pFileWeights);
+	}
+	else
+	{
+		pNetwork->m_vecScales.assign(pFileScales, pFileScales + 2 * header.neuronCount);
+		pNetwork->m_vecWeights.assign(pFileWeights, pFileWeights + header.weightCount);
+		pNetwork->bindParams(pNetwork->m_vecScales.data(), pNetwork->m_vecWeights.data());
+	}
+	return pNetwork;
+}
+
+///Accessors
+template <typename T>
+int QuantizedSigmoidNetwork<T>::getLayerCount() const
+{
+	return m_nLayerCount;
+}
+template <typename T>
+const int *QuantizedSigmoidNetwork<T>::getNetworkLayers() const
+{
+	return m_vecNetworkLayers.data();
+}
+template <typename T>
+size_t QuantizedSigmoidNetwork<T>::getModelSize() const
+{
+	return m_nWeightCount + 2 * m_nNeuronCount * sizeof(float);
+}
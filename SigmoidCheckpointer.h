@@ -0,0 +1,348 @@
+///////////////////////////////////////////
+// Checkpoints a SigmoidNetwork while it trains, so an interrupted run can be resumed exactly where it stopped.
+//	Every getInterval() epochs, onEpoch() copies the network's training state (see SigmoidTrainingState) into a
+//	snapshot and hands it to a background thread, which writes it to the checkpoint file while training goes on. The
+//	snapshot being written and the one being filled are separate buffers, swapped under the lock, so training only
+//	waits for a copy in memory, never for the disk. If the thread is still writing when the next snapshot is taken, the
+//	newer snapshot replaces the one waiting, so checkpoints are just written less often.
+//	Each checkpoint is written to filename.tmp, flushed to disk, then renamed over filename, so the file always holds
+//	the last checkpoint written in full, even if the process is killed mid-write.
+//	resume() restores the checkpoint's weights, epoch count and optimizer state into the network, and, given the
+//	training stream, its shuffle seed and pass count, which are the only randomness in training. So a resumed run
+//	trains on exactly as the interrupted one would have, to the bit, as long as it is configured the same way and does
+//	not train with PARALLEL_HOGWILD, whose updates race.
+//	Connect a checkpointer to its network with setEpochCallback(checkpointer.getCallback()), or call onEpoch() from a
+//	callback of your own. The network must not be resized while the checkpointer exists.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include "SigmoidNetwork.h"
+#include "SigmoidModelFile.h"
+
+using namespace std;
+
+template <typename T>
+class SigmoidCheckpointer
+{
+public:
+	SigmoidCheckpointer(SigmoidNetwork<T> &network, const string &filename,		//Constructor. Checkpoints network to filename every interval epochs. network
+			int interval);															//   must outlive the checkpointer.
+	~SigmoidCheckpointer();															//Calls finish(), then stops the writer thread
+	void setDataStream(const SigmoidDataStream<T> *stream);						//Checkpoints stream's shuffle order along with the network. Default none.
+	void onEpoch(const SigmoidEpochMetrics &metrics);								//Takes a snapshot, if metrics.nEpoch is due one. Call on the training thread.
+	SigmoidEpochCallback getCallback();												//Returns a callback that calls onEpoch(), for SigmoidNetwork::setEpochCallback()
+	bool finish();																	//Waits for the snapshot being written, and any waiting, to be written. Returns
+																					//   false if any write failed.
+	bool resume(SigmoidDataStream<T> *stream = NULL);								//Restores the network, and stream if given, from the checkpoint file. Returns false
+																					//   if there is none, or, with an error msg, if it is unreadable or was taken with a
+																					//   different network, precision, learning rate, batch size or optimizer.
+	int getLastEpoch() const;														//Returns the epoch of the last checkpoint written or resumed from, or 0 if none
+	int getWriteCount() const;														//Returns m_nWriteCount
+	bool hasFailed() const;															//Returns m_bFailed
+	int getInterval() const;														//Returns m_nInterval
+	static bool save(const string &filename, const SigmoidTrainingState<T> &state);	//Writes state to a checkpoint file, replacing it atomically. Returns false, with an
+																					//   error msg, on failure.
+	static bool load(const string &filename, SigmoidTrainingState<T> &state);		//Reads state from a checkpoint file. Returns false, with an error msg, on failure.
+
+private:
+	SigmoidNetwork<T> &m_Network;													//The network being trained
+	string m_strFilename;															//Checkpoint file
+	int m_nInterval;																//Epochs between snapshots
+	const SigmoidDataStream<T> *m_pStream;											//Training stream whose shuffle order is checkpointed, or NULL
+	SigmoidTrainingState<T> m_PendingState;											//Snapshot waiting to be written
+	SigmoidTrainingState<T> m_WritingState;											//Snapshot being written. Swapped with m_PendingState, so neither reallocates.
+	int m_nPendingEpoch;															//Epoch of the waiting snapshot. 0 = none waiting.
+	int m_nLastEpoch;																//Epoch of the last checkpoint written or resumed from
+	int m_nWriteCount;																//Checkpoints written
+	bool m_bBusy;																	//True while the writer thread is writing a snapshot
+	bool m_bFailed;																	//True once a write has failed
+	bool m_bStopping;																//True once the writer thread should exit
+	thread m_Worker;																//Writer thread
+	mutable mutex m_Mutex;															//Guards every member the writer thread touches, but m_WritingState
+	condition_variable m_SnapshotReady;												//Signalled when a snapshot is waiting, or the thread should exit
+	condition_variable m_SnapshotDone;												//Signalled when the thread finishes a snapshot
+
+	void runWorker();																//Writer thread loop. Writes snapshots until m_bStopping.
+	static uint64_t hashBytes(const void *data, size_t size, uint64_t hash);		//Continues a 64-bit FNV-1a hash of data
+};
+
+const uint64_t CHECKPOINT_HASH_SEED = 14695981039346656037ULL;						//FNV-1a offset basis
+const uint64_t CHECKPOINT_HASH_PRIME = 1099511628211ULL;							//FNV-1a prime
+
+//Constructor. Starts the writer thread.
+template <typename T>
+SigmoidCheckpointer<T>::SigmoidCheckpointer(SigmoidNetwork<T> &network, const string &filename, int interval) : m_Network(network),
+	m_strFilename(filename), m_nInterval(interval < 1 ? 1 : interval), m_pStream(NULL), m_nPendingEpoch(0), m_nLastEpoch(0),
+	m_nWriteCount(0), m_bBusy(false), m_bFailed(false), m_bStopping(false)
+{
+	m_Worker = thread(&SigmoidCheckpointer<T>::runWorker, this);
+}
+
+//The last snapshot is the one a resumed run would most want, so it is written rather than abandoned
+template <typename T>
+SigmoidCheckpointer<T>::~SigmoidCheckpointer()
+{
+	finish();
+	{
+		lock_guard<mutex> lock(m_Mutex);
+		m_bStopping = true;
+	}
+	m_SnapshotReady.notify_all();
+	m_Worker.join();
+}
+
+template <typename T>
+void SigmoidCheckpointer<T>::setDataStream(const SigmoidDataStream<T> *stream)
+{
+	m_pStream = stream;
+}
+
+//Copies the network's training state into the waiting snapshot, replacing any snapshot still waiting from an earlier
+// epoch. The stream has started exactly one pass per epoch trained, so its pass count matches the network's state.
+template <typename T>
+void SigmoidCheckpointer<T>::onEpoch(const SigmoidEpochMetrics &metrics)
+{
+	if (metrics.nEpoch % m_nInterval != 0)
+		return;
+	{
+		lock_guard<mutex> lock(m_Mutex);
+		m_Network.getTrainingState(m_PendingState);
+		m_PendingState.bShuffle = m_pStream ? m_pStream->getShuffle() : false;
+		m_PendingState.nShuffleSeed = m_pStream ? m_pStream->getShuffleSeed() : 0;
+		m_PendingState.nPassCount = m_pStream ? m_pStream->getPassCount() : 0;
+		m_nPendingEpoch = metrics.nEpoch;
+	}
+	m_SnapshotReady.notify_one();
+}
+
+template <typename T>
+SigmoidEpochCallback SigmoidCheckpointer<T>::getCallback()
+{
+	return [this](const SigmoidEpochMetrics &metrics) { onEpoch(metrics); };
+}
+
+template <typename T>
+bool SigmoidCheckpointer<T>::finish()
+{
+	unique_lock<mutex> lock(m_Mutex);
+	m_SnapshotDone.wait(lock, [this] { return m_nPendingEpoch == 0 && !m_bBusy; });
+	return !m_bFailed;
+}
+
+//The checkpoint must have been taken with the network's current configuration, or the resumed run would silently
+// train differently from the interrupted one. Topology and bias are checked by setTrainingState().
+template <typename T>
+bool SigmoidCheckpointer<T>::resume(SigmoidDataStream<T> *stream)
+{
+	if (!ifstream(m_strFilename.c_str(), ios::binary).is_open())
+		return false;
+	SigmoidTrainingState<T> state;
+	if (!load(m_strFilename, state))
+		return false;
+	const SigmoidOptimizer<T> &optimizer = m_Network.getOptimizer();
+	if (state.dblLearningRate != m_Network.getLearningRate() || state.nBatchSize != m_Network.getBatchSize() ||
+		state.optimizerType != optimizer.getType() || state.dblMomentum != optimizer.getMomentum() || state.dblBeta2 != optimizer.getBeta2())
+	{
+		cout << "ERROR: Checkpoint " << m_strFilename << " was taken with a different learning rate, batch size or optimizer.\n";
+		return false;
+	}
+	if (!m_Network.setTrainingState(state))
+		return false;
+	if (stream)
+	{
+		stream->setShuffle(state.bShuffle, state.nShuffleSeed);
+		stream->setPassCount(state.nPassCount);
+	}
+	lock_guard<mutex> lock(m_Mutex);
+	m_nLastEpoch = state.nEpochCount;
+	return true;
+}
+
+//Writes the header, topology, weights and optimizer state described in SigmoidModelFile.h to filename.tmp, then
+// renames it over filename once it is safely on disk, so a crash leaves either the old checkpoint or the new one
+template <typename T>
+bool SigmoidCheckpointer<T>::save(const string &filename, const SigmoidTrainingState<T> &state)
+{
+	vector<int32_t> vTopology(state.vecLayers.begin(), state.vecLayers.end());
+	SigmoidCheckpointHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+	header.version = CHECKPOINT_VERSION;
+	header.scalarSize = sizeof(T);
+	header.layerCount = (uint32_t)vTopology.size();
+	header.epochCount = state.nEpochCount;
+	header.learningRate = state.dblLearningRate;
+	header.bias = state.dblBias;
+	header.batchSize = state.nBatchSize;
+	header.optimizerType = state.optimizerType;
+	header.momentum = state.dblMomentum;
+	header.beta2 = state.dblBeta2;
+	header.optimizerSteps = state.nOptimizerSteps;
+	header.shuffle = state.bShuffle ? 1 : 0;
+	header.shuffleSeed = state.nShuffleSeed;
+	header.passCount = state.nPassCount;
+	header.paramCount = state.vecParams.size();
+	header.velocityCount = state.vecVelocity.size();
+	header.secondMomentCount = state.vecSecondMoment.size();
+	header.checksum = hashBytes(vTopology.data(), vTopology.size() * sizeof(int32_t), CHECKPOINT_HASH_SEED);
+	header.checksum = hashBytes(state.vecParams.data(), state.vecParams.size() * sizeof(T), header.checksum);
+	header.checksum = hashBytes(state.vecVelocity.data(), state.vecVelocity.size() * sizeof(T), header.checksum);
+	header.checksum = hashBytes(state.vecSecondMoment.data(), state.vecSecondMoment.size() * sizeof(T), header.checksum);
+
+	string strTempFile = filename + ".tmp";
+	FILE *pFile = fopen(strTempFile.c_str(), "wb");
+	if (!pFile)
+	{
+		cout << "ERROR: Checkpoint file " << strTempFile << " could not be opened for writing.\n";
+		return false;
+	}
+	bool bWritten = fwrite(&header, sizeof(header), 1, pFile) == 1 &&
+		fwrite(vTopology.data(), sizeof(int32_t), vTopology.size(), pFile) == vTopology.size() &&
+		fwrite(state.vecParams.data(), sizeof(T), state.vecParams.size(), pFile) == state.vecParams.size() &&
+		fwrite(state.vecVelocity.data(), sizeof(T), state.vecVelocity.size(), pFile) == state.vecVelocity.size() &&
+		fwrite(state.vecSecondMoment.data(), sizeof(T), state.vecSecondMoment.size(), pFile) == state.vecSecondMoment.size() &&
+		fflush(pFile) == 0 && fsync(fileno(pFile)) == 0;
+	bWritten = fclose(pFile) == 0 && bWritten;
+	if (!bWritten || rename(strTempFile.c_str(), filename.c_str()) != 0)
+	{
+		cout << "ERROR: Checkpoint file " << filename << " could not be written.\n";
+		remove(strTempFile.c_str());
+		return false;
+	}
+	return true;
+}
+
+template <typename T>
+bool SigmoidCheckpointer<T>::load(const string &filename, SigmoidTrainingState<T> &state)
+{
+	ifstream fsIn(filename.c_str(), ios::binary);
+	if (fsIn.fail())
+	{
+		cout << "ERROR: Checkpoint file " << filename << " could not be opened.\n";
+		return false;
+	}
+	vector<char> vData((istreambuf_iterator<char>(fsIn)), istreambuf_iterator<char>());
+
+	//validate the header, then the payload's size and checksum
+	SigmoidCheckpointHeader header;
+	bool bValid = vData.size() >= sizeof(header);
+	if (bValid)
+	{
+		memcpy(&header, vData.data(), sizeof(header));
+		bValid = memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0;
+	}
+	if (!bValid)
+	{
+		cout << "ERROR: " << filename << " is not a checkpoint file.\n";
+		return false;
+	}
+	if (header.version != CHECKPOINT_VERSION || header.scalarSize != sizeof(T))
+	{
+		cout << "ERROR: " << filename << " has an unsupported checkpoint version or was taken at a different precision.\n";
+		return false;
+	}
+	uint64_t nPayloadSize = header.layerCount * sizeof(int32_t) +
+		(header.paramCount + header.velocityCount + header.secondMomentCount) * sizeof(T);
+	const char *pPayload = vData.data() + sizeof(header);
+	if (vData.size() - sizeof(header) != nPayloadSize || hashBytes(pPayload, nPayloadSize, CHECKPOINT_HASH_SEED) != header.checksum)
+	{
+		cout << "ERROR: " << filename << " is truncated or corrupt.\n";
+		return false;
+	}
+
+	const int32_t *pTopology = (const int32_t *)pPayload;
+	const T *pParams = (const T *)(pPayload + header.layerCount * sizeof(int32_t));
+	state.vecLayers.assign(pTopology, pTopology + header.layerCount);
+	state.vecParams.assign(pParams, pParams + header.paramCount);
+	state.vecVelocity.assign(pParams + header.paramCount, pParams + header.paramCount + header.velocityCount);
+	state.vecSecondMoment.assign(pParams + header.paramCount + header.velocityCount,
+		pParams + header.paramCount + header.velocityCount + header.secondMomentCount);
+	state.dblLearningRate = header.learningRate;
+	state.dblBias = header.bias;
+	state.nBatchSize = header.batchSize;
+	state.nEpochCount = header.epochCount;
+	state.optimizerType = (OptimizerType)header.optimizerType;
+	state.dblMomentum = header.momentum;
+	state.dblBeta2 = header.beta2;
+	state.nOptimizerSteps = header.optimizerSteps;
+	state.bShuffle = header.shuffle != 0;
+	state.nShuffleSeed = header.shuffleSeed;
+	state.nPassCount = header.passCount;
+	return true;
+}
+
+//Takes each waiting snapshot in turn, by swapping it into m_WritingState, and writes it outside the lock, so onEpoch()
+// can fill the next meanwhile
+template <typename T>
+void SigmoidCheckpointer<T>::runWorker()
+{
+	unique_lock<mutex> lock(m_Mutex);
+	while (true)
+	{
+		m_SnapshotReady.wait(lock, [this] { return m_nPendingEpoch != 0 || m_bStopping; });
+		if (m_nPendingEpoch == 0)
+			return;
+		int nEpoch = m_nPendingEpoch;
+		swap(m_PendingState, m_WritingState);
+		m_nPendingEpoch = 0;
+		m_bBusy = true;
+		lock.unlock();
+
+		bool bWritten = save(m_strFilename, m_WritingState);
+
+		lock.lock();
+		if (bWritten)
+		{
+			m_nLastEpoch = nEpoch;
+			m_nWriteCount++;
+		}
+		else
+			m_bFailed = true;
+		m_bBusy = false;
+		m_SnapshotDone.notify_all();
+	}
+}
+
+template <typename T>
+uint64_t SigmoidCheckpointer<T>::hashBytes(const void *data, size_t size, uint64_t hash)
+{
+	const unsigned char *pData = (const unsigned char *)data;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ pData[i]) * CHECKPOINT_HASH_PRIME;
+	return hash;
+}
+
+///Accessors
+template <typename T>
+int SigmoidCheckpointer<T>::getLastEpoch() const
+{
+	lock_guard<mutex> lock(m_Mutex);
+	return m_nLastEpoch;
+}
+template <typename T>
+int SigmoidCheckpointer<T>::getWriteCount() const
+{
+	lock_guard<mutex> lock(m_Mutex);
+	return m_nWriteCount;
+}
+template <typename T>
+bool SigmoidCheckpointer<T>::hasFailed() const
+{
+	lock_guard<mutex> lock(m_Mutex);
+	return m_bFailed;
+}
+template <typename T>
+int SigmoidCheckpointer<T>::getInterval() const
+{
+	return m_nInterval;
+}
@@ -0,0 +1,56 @@
+///////////////////////////////////////////
+// The interface common to every sigmoid network: SigmoidNetwork, whose topology is set at runtime, and
+//	FixedSigmoidNetwork, whose topology is fixed at compile time. Code that only trains, classifies or moves weights
+//	between networks can take a SigmoidClassifier and work with either.
+//	Weights are exchanged in the layout of SigmoidNetwork's parameter buffer: layer by layer, each a row-major weight
+//	matrix (one row per neuron) followed by its bias weights. See SigmoidLayer.h.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include "SigmoidDataSet.h"
+#include "SigmoidKernels.h"
+
+using namespace std;
+
+template <typename T>
+class SigmoidClassifier
+{
+public:
+	virtual ~SigmoidClassifier() {}
+	virtual void doTraining(const SigmoidDataSet<T> &trainingset, int iterationcount) = 0;	//Learns from every row of trainingset, iterationcount times
+	virtual int getClassification(const T *params) const = 0;								//Returns the index of the highest output, given one row of input params. Thread-safe.
+	virtual void classifyBatch(const T *features, int rowcount,							//Classifies rowcount rows of features (rowcount x input count, row-major), writing
+			int *classifications, T *scores) const = 0;										//   class indices to classifications and, if not NULL, outputs to scores. Thread-safe.
+	virtual int getLayerCount() const = 0;													//Returns the number of layers, including the input layer
+	virtual const int *getNetworkLayers() const = 0;										//Returns the neuron count of each layer. Ex: {16, 14, 26}
+	virtual int getParamCount() const = 0;													//Returns the number of weights, including bias weights
+	virtual double getBias() const = 0;														//Returns the bias of every neuron
+	virtual void getParams(T *params) const = 0;											//Copies every weight to params, which holds getParamCount() values
+	virtual void setParams(const T *params) = 0;											//Sets every weight from params, which holds getParamCount() values
+	virtual SigmoidActivation getActivation() const = 0;									//Returns the sigmoid implementation every layer uses
+	virtual void setActivation(SigmoidActivation activation) = 0;							//Sets the sigmoid implementation every layer uses. Default exact.
+	bool copyParams(const SigmoidClassifier<T> &source);									//Copies source's weights and activation. Returns false, with an error msg, if
+																							//   topologies differ.
+};
+
+//Copies every weight of source, which must have the same topology and bias as this network, and its activation, so
+// both networks classify alike
+template <typename T>
+bool SigmoidClassifier<T>::copyParams(const SigmoidClassifier<T> &source)
+{
+	if (source.getLayerCount() != getLayerCount() || source.getBias() != getBias() ||
+		!equal(getNetworkLayers(), getNetworkLayers() + getLayerCount(), source.getNetworkLayers()))
+	{
+		cout << "ERROR: Weights can only be copied between networks of the same topology and bias.\n";
+		return false;
+	}
+	vector<T> vecParams(getParamCount());
+	source.getParams(vecParams.data());
+	setParams(vecParams.data());
+	setActivation(source.getActivation());
+	return true;
+}
@@ -0,0 +1,59 @@
+///////////////////////////////////////////
+// The binary file format SigmoidDataSet::saveBinary() writes and SigmoidDataSet::loadBinary() reads.
+//	A file is a SigmoidDataHeader, then at rangeOffset the per-column min and max the features were rescaled with
+//	(paramCount doubles each), then at labelOffset one 32-bit class index per row, then at featureOffset the rescaled
+//	features as one contiguous row-major rowCount x paramCount matrix of floats or doubles (see scalarSize).
+//	The feature matrix starts on a DATA_FEATURE_ALIGNMENT boundary so a memory-mapped file can be used in place.
+//	All values are stored in the byte order of the machine that wrote them.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+const char DATA_MAGIC[8] = { 'S', 'I', 'G', 'D', 'A', 'T', 'A', '\0' };	//First 8 bytes of every data file
+const uint32_t DATA_VERSION = 1;											//Bumped whenever the layout changes
+const uint32_t DATA_FEATURE_ALIGNMENT = 64;									//Features start on a multiple of this many bytes
+
+struct SigmoidDataHeader
+{
+	char magic[8];															//DATA_MAGIC
+	uint32_t version;														//DATA_VERSION
+	uint32_t scalarSize;													//Bytes per feature: 4 (float) or 8 (double)
+	uint64_t rowCount;														//Number of rows
+	uint32_t paramCount;													//Features per row
+	uint32_t reserved;
+	uint64_t rangeOffset;													//Byte offset of the column mins, followed by the column maxes
+	uint64_t labelOffset;													//Byte offset of the labels
+	uint64_t featureOffset;													//Byte offset of the feature matrix
+};
+
+//Returns true if header is a supported data file header whose ranges, labels and features all lie within filesize
+// bytes, with rowCount and paramCount within an int. Each offset is checked against filesize before any count is
+// compared with the bytes after it, by division, so no corrupt value can overflow.
+inline bool isValidDataHeader(const SigmoidDataHeader &header, uint64_t filesize)
+{
+	return memcmp(header.magic, DATA_MAGIC, sizeof(header.magic)) == 0 && header.version == DATA_VERSION &&
+		(header.scalarSize == sizeof(float) || header.scalarSize == sizeof(double)) &&
+		header.rowCount <= (uint64_t)numeric_limits<int>::max() && header.paramCount <= (uint64_t)numeric_limits<int>::max() &&
+		header.rangeOffset >= sizeof(header) && header.rangeOffset <= filesize &&
+		header.paramCount <= (filesize - header.rangeOffset) / (2 * sizeof(double)) &&
+		header.labelOffset >= sizeof(header) && header.labelOffset <= filesize && header.labelOffset % sizeof(int32_t) == 0 &&
+		header.rowCount <= (filesize - header.labelOffset) / sizeof(int32_t) &&
+		header.featureOffset >= sizeof(header) && header.featureOffset <= filesize &&
+		header.featureOffset % DATA_FEATURE_ALIGNMENT == 0 &&
+		(header.paramCount == 0 || header.rowCount <= (filesize - header.featureOffset) / header.scalarSize / header.paramCount);
+}
+
+//Returns the index of the first of count labels outside [0, classcount), or -1 if every one is a valid class index
+inline int64_t findInvalidLabel(const int32_t *labels, uint64_t count, size_t classcount)
+{
+	for (uint64_t i = 0; i < count; i++)
+		if (labels[i] < 0 || (size_t)labels[i] >= classcount)
+			return (int64_t)i;
+	return -1;
+}
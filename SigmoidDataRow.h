@@ -1,6 +1,6 @@
 ///////////////////////////////////////////
 // A data "row" of input for Sigmoid.h, in the form [label, (param_1, param_2, ... , param_n)]
-//TODO: Templatize
+//	T is the scalar type of the params: float or double.
 //
 /// Author: Dustin Fast, June 2017
 
@@ -9,30 +9,48 @@
 
 using namespace std;
 
+template <typename T>
 class SigmoidDataRow
 {
 public:
-	SigmoidDataRow(double expectedoutput, const vector<double> &params);	// Constructor
+	SigmoidDataRow(double expectedoutput, const vector<T> &params);			// Constructor
 
 	double getExpectedResult();												// Returns the label
-	vector<double>& getParams();											// Returns a ptr to the feature vector/params
+	vector<T>& getParams();													// Returns a ptr to the feature vector/params
+	double getExpectedResult() const;
+	const vector<T>& getParams() const;
 
 private:
 	double m_dblExpectedOutput;												// The correct classification.
-	vector<double> m_vecParams;												// Input params
+	vector<T> m_vecParams;													// Input params
 };
 
 //Constructor
-SigmoidDataRow::SigmoidDataRow(double expectedoutput, const vector<double> &params) : m_dblExpectedOutput(expectedoutput), m_vecParams(params)
+template <typename T>
+SigmoidDataRow<T>::SigmoidDataRow(double expectedoutput, const vector<T> &params) : m_dblExpectedOutput(expectedoutput), m_vecParams(params)
 {}
 
 //Accessors
-double SigmoidDataRow::getExpectedResult()
+template <typename T>
+double SigmoidDataRow<T>::getExpectedResult()
 {
 	return m_dblExpectedOutput;
 }
 
-vector<double>& SigmoidDataRow::getParams()
+template <typename T>
+vector<T>& SigmoidDataRow<T>::getParams()
+{
+	return m_vecParams;
+}
+
+template <typename T>
+double SigmoidDataRow<T>::getExpectedResult() const
+{
+	return m_dblExpectedOutput;
+}
+
+template <typename T>
+const vector<T>& SigmoidDataRow<T>::getParams() const
 {
 	return m_vecParams;
 }
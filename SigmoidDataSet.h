@@ -0,0 +1,708 @@
+///////////////////////////////////////////
+// A set of labeled rows for SigmoidNetwork, stored as one contiguous row-major feature matrix plus a label column.
+//	A data set either owns its storage (rows parsed from CSV, in parallel, or added with addRow()) or is a zero-copy view of a
+//	memory-mapped binary data file (see SigmoidDataFile.h), in which case loading costs no parsing and no copying.
+//	Labels are class indexes, i.e. the index of the output neuron expected to be high. T is the scalar type of the
+//	features: float or double. A binary data file whose features are of another type is converted as it is loaded.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <limits>
+#include <charconv>
+#include <thread>
+#include <unistd.h>
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "SigmoidDataFile.h"
+#include "SigmoidDataRow.h"
+
+using namespace std;
+
+const size_t CSV_MIN_CHUNK_BYTES = 1 << 20;											//Smallest share of a CSV file worth a parse thread
+const char CSV_LABEL_ERROR[] = "has an invalid label";								//Parse errors, reported as "ERROR: Data file <name> <error> on line <n>."
+const char CSV_TYPE_ERROR[] = "contains an invalid data type";
+const char CSV_COUNT_ERROR[] = "has a differing parameter count";
+const string LETTER_LABELS = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";							//Labels of the letter recognition data. Each is stored as its index here.
+
+template <typename T>
+class SigmoidDataSet
+{
+public:
+	SigmoidDataSet();																//Constructor. Empty, with no columns.
+	SigmoidDataSet(const vector<SigmoidDataRow<T>> &rows);							//Constructor. Copies rows into contiguous storage.
+	void addRow(int label, const T *params, int paramcount);						//Appends a row. Every row must have the same paramcount.
+	void resize(int rowcount, int paramcount);										//Sizes owned storage for rowcount rows, to be filled via getWritable*()
+	bool loadCsv(const string &filename, const string &labels);						//Reads a CSV file of label, param_1, ..., param_n rows. Each label is
+																					//   converted to its index in labels. Returns false, with an error msg, on failure.
+	bool loadCsv(const char *text, size_t length, const string &labels,			//As above, parsing CSV text already in memory. Error msgs name sourcename
+			const string &sourcename, int firstline);								//   and number text's first line firstline.
+	bool loadBinary(const string &filename, const string &labels);					//Maps a binary data file and views it in place. Every label must index labels.
+																					//   Returns false, with an error msg, on failure.
+	bool saveBinary(const string &filename, bool singleprecision) const;			//Writes a binary data file, with float or double features
+	static bool isBinaryFile(const string &filename);								//Returns true if filename starts with DATA_MAGIC
+	bool load(const string &filename, const string &labels);						//Reads a binary data file with loadBinary(), or a CSV file with loadCsv()
+	static bool loadPair(SigmoidDataSet<T> &trainingset,							//Loads a training and a validation set, and rescales them onto one scale (see
+			SigmoidDataSet<T> &validationset, const string &trainingfile,			//   rescaleSets()). Returns false, with an error msg, on failure.
+			const string &validationfile, const string &labels);
+	void setParseThreads(int threadcount);											//Sets the number of threads loadCsv() parses with. Defaults to one per core.
+	void getColumnRanges(vector<double> &minx, vector<double> &maxx) const;			//Widens minx/maxx to cover every column. Size them to getParamCount() first.
+	void rescale(const vector<double> &minx, const vector<double> &maxx);			//Rescales every feature as x' = (x-min(x))/(max(x)-min(x))
+	static bool rescaleSets(const vector<SigmoidDataSet<T> *> &sets);				//Rescales every set not yet rescaled onto one scale with the rest. Returns false,
+																					//   with an error msg, if their parameter counts differ.
+	void selectRows(int firstrow, int rowcount);									//Keeps only rowcount rows, starting at firstrow
+	int getRowCount() const;														//Returns the number of rows
+	int getParamCount() const;														//Returns the number of features per row
+	const T *getFeatures() const;													//Returns the feature matrix, getRowCount() x getParamCount()
+	T *getWritableFeatures();														//As above, writable. Only valid for a set that owns its storage.
+	const T *getParams(int row) const;												//Returns row's features
+	const int32_t *getLabels() const;												//Returns the label column
+	int32_t *getWritableLabels();													//As above, writable. Only valid for a set that owns its storage.
+	int getLabel(int row) const;													//Returns row's label
+	const vector<double> &getRangeMin() const;										//Returns the column mins the features were rescaled with (empty if not rescaled)
+	const vector<double> &getRangeMax() const;										//Returns the column maxes the features were rescaled with (empty if not rescaled)
+
+private:
+	int m_nRowCount;																//Number of rows
+	int m_nParamCount;																//Number of features per row
+	const T *m_pFeatures;															//Row-major feature matrix. Points into m_vecFeatures or m_pFile.
+	const int32_t *m_pLabels;														//Label column. Points into m_vecLabels or m_pFile.
+	vector<T> m_vecFeatures;														//Storage for m_pFeatures, unless the set is a mapped view
+	vector<int32_t> m_vecLabels;													//Storage for m_pLabels, unless the set is a mapped view
+	vector<double> m_vecRangeMin;													//Column mins used by rescale()
+	vector<double> m_vecRangeMax;													//Column maxes used by rescale()
+	vector<double> m_vecColumnMin;													//Column mins found by loadCsv(). Emptied once the features change.
+	vector<double> m_vecColumnMax;													//Column maxes found by loadCsv()
+	int m_nParseThreads;															//Threads loadCsv() parses with
+	unique_ptr<ThreadPool> m_pParsePool;											//Parse threads, started by the first loadCsv() that splits its text and
+																					//   kept for later calls
+	shared_ptr<MappedFile> m_pFile;													//The binary data file a view points into
+
+	struct CsvChunk																	//One thread's share of a CSV file
+	{
+		const char *pBegin;															//First line of the chunk
+		const char *pEnd;															//One past the chunk's last line
+		int nFirstRow;																//Index of the chunk's first row in the set
+		int nFirstLine;																//Line number of pBegin, for error msgs
+		vector<double> vecMin;														//Column mins of the chunk's rows
+		vector<double> vecMax;														//Column maxes of the chunk's rows
+		const char *pError;															//First parse error, or NULL
+		int nErrorLine;																//Line number of pError
+		CsvChunk() : pBegin(NULL), pEnd(NULL), nFirstRow(0), nFirstLine(0), pError(NULL), nErrorLine(0) {}
+	};
+
+	void parseCsvChunk(CsvChunk &chunk, const char *fileend, const string &labels);	//Parses one chunk of CSV text into the set's storage
+	static const char *getLineEnd(const char *line, const char *fileend);			//Returns the end of line, excluding its newline and any '\r'
+	static const char *getNextLine(const char *p, const char *fileend);			//Returns the start of the line after the one containing p
+	void clear();																	//Drops all rows and storage
+	void bindStorage();																//Points m_pFeatures and m_pLabels at the owned vectors
+	double rescaleFeature(double x, double minx, double maxx) const;				//Returns x rescaled to [0, 1] given its column's range
+};
+
+//Constructor
+template <typename T>
+SigmoidDataSet<T>::SigmoidDataSet() : m_nRowCount(0), m_nParamCount(0), m_pFeatures(NULL), m_pLabels(NULL),
+	m_nParseThreads(max(1, (int)thread::hardware_concurrency()))
+{}
+
+//Constructor. Row labels are truncated to ints.
+template <typename T>
+SigmoidDataSet<T>::SigmoidDataSet(const vector<SigmoidDataRow<T>> &rows) : m_nRowCount(0), m_nParamCount(0), m_pFeatures(NULL), m_pLabels(NULL),
+	m_nParseThreads(1)
+{
+	if (rows.size() > 0)
+	{
+		m_nParamCount = (int)rows[0].getParams().size();
+		m_vecFeatures.reserve(rows.size() * m_nParamCount);
+		m_vecLabels.reserve(rows.size());
+	}
+	for (unsigned int i = 0; i < rows.size(); i++)
+		addRow((int)rows[i].getExpectedResult(), rows[i].getParams().data(), (int)rows[i].getParams().size());
+}
+
+template <typename T>
+void SigmoidDataSet<T>::addRow(int label, const T *params, int paramcount)
+{
+	if (m_pFile)
+	{
+		cout << "ERROR: Rows cannot be added to a mapped data set.\n";
+		return;
+	}
+	if (m_nRowCount == 0 && m_nParamCount == 0)
+		m_nParamCount = paramcount;
+	if (paramcount != m_nParamCount)
+	{
+		cout << "ERROR: Differing parameter counts within a data set.\n";
+		return;
+	}
+	m_vecFeatures.insert(m_vecFeatures.end(), params, params + paramcount);
+	m_vecLabels.push_back(label);
+	m_nRowCount++;
+	m_vecColumnMin.clear();
+	m_vecColumnMax.clear();
+	bindStorage();
+}
+
+//Drops any rows and sizes owned storage for rowcount rows of paramcount features, leaving their contents unset
+template <typename T>
+void SigmoidDataSet<T>::resize(int rowcount, int paramcount)
+{
+	clear();
+	m_nRowCount = rowcount;
+	m_nParamCount = paramcount;
+	m_vecFeatures.resize((size_t)rowcount * paramcount);
+	m_vecLabels.resize(rowcount);
+	bindStorage();
+}
+
+//Maps filename and parses it, as below
+template <typename T>
+bool SigmoidDataSet<T>::loadCsv(const string &filename, const string &labels)
+{
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		clear();
+		return false;
+	}
+	return loadCsv(file.getData(), file.getSize(), labels, filename, 1);
+}
+
+//Parses length bytes of CSV text in a single pass, in parallel. The text is split on line boundaries into one chunk
+// per thread. A memchr-only scan counts each chunk's rows, so every chunk knows where its rows start, then each thread
+// parses its chunk with from_chars straight into the feature matrix, tracking its own column mins/maxes, which are
+// then reduced. No per-field or per-row allocations are made. Error msgs name sourcename, with text's first line
+// numbered firstline. A single chunk is parsed inline on the calling thread, so a caller parsing block after block
+// with one parse thread (see SigmoidDataStream) starts no threads at all.
+template <typename T>
+bool SigmoidDataSet<T>::loadCsv(const char *text, size_t length, const string &labels, const string &sourcename, int firstline)
+{
+	clear();
+	const char *pBegin = text;
+	const char *pEnd = text + length;
+
+	//The first non-blank line sets the parameter count: one per field after the label
+	const char *pLine = pBegin;
+	const char *pLineEnd = pBegin;
+	while (pLine < pEnd && (pLineEnd = getLineEnd(pLine, pEnd)) == pLine)
+		pLine = getNextLine(pLine, pEnd);
+	m_nParamCount = (int)count(pLine, pLineEnd, ',');
+
+	//Split the file into chunks that each start at the beginning of a line
+	int nChunks = (int)min((size_t)m_nParseThreads, length / CSV_MIN_CHUNK_BYTES + 1);
+	vector<const char *> vecChunkStarts(nChunks + 1, pEnd);
+	vecChunkStarts[0] = pBegin;
+	for (int c = 1; c < nChunks; c++)
+	{
+		const char *pSplit = max(pBegin + length / nChunks * c, vecChunkStarts[c - 1]);
+		vecChunkStarts[c] = getNextLine(pSplit, pEnd);
+	}
+
+	//Chunks run on the calling thread if there is only one, else on the parse pool
+	if (nChunks > 1 && (!m_pParsePool || m_pParsePool->getThreadCount() != m_nParseThreads))
+		m_pParsePool.reset(new ThreadPool(m_nParseThreads));
+	auto forEachChunk = [&](const auto &task)
+	{
+		if (nChunks == 1)
+			task(0);
+		else
+			m_pParsePool->parallelFor(nChunks, task);
+	};
+
+	//Count each chunk's rows and lines, then place the chunks' rows one after another
+	vector<int> vecRowStarts(nChunks + 1, 0);
+	vector<int> vecLineStarts(nChunks + 1, 0);
+	vecLineStarts[0] = firstline;
+	forEachChunk([&](int c)
+	{
+		int nRows = 0, nLines = 0;
+		for (const char *p = vecChunkStarts[c]; p < vecChunkStarts[c + 1]; p = getNextLine(p, pEnd), nLines++)
+			if (getLineEnd(p, pEnd) != p)
+				nRows++;
+		vecRowStarts[c + 1] = nRows;
+		vecLineStarts[c + 1] = nLines;
+	});
+	for (int c = 0; c < nChunks; c++)
+	{
+		vecRowStarts[c + 1] += vecRowStarts[c];
+		vecLineStarts[c + 1] += vecLineStarts[c];
+	}
+	m_nRowCount = vecRowStarts[nChunks];
+	m_vecFeatures.resize((size_t)m_nRowCount * m_nParamCount);
+	m_vecLabels.resize(m_nRowCount);
+
+	//Parse every chunk, then reduce the chunks' column ranges
+	vector<CsvChunk> vecChunks(nChunks);
+	for (int c = 0; c < nChunks; c++)
+	{
+		vecChunks[c].pBegin = vecChunkStarts[c];
+		vecChunks[c].pEnd = vecChunkStarts[c + 1];
+		vecChunks[c].nFirstRow = vecRowStarts[c];
+		vecChunks[c].nFirstLine = vecLineStarts[c];
+	}
+	forEachChunk([&](int c)
+	{
+		parseCsvChunk(vecChunks[c], pEnd, labels);
+	});
+	m_vecColumnMin.assign(m_nParamCount, numeric_limits<double>::max());
+	m_vecColumnMax.assign(m_nParamCount, -numeric_limits<double>::max());
+	for (int c = 0; c < nChunks; c++)
+	{
+		if (vecChunks[c].pError)
+		{
+			cout << "ERROR: Data file " << sourcename << " " << vecChunks[c].pError << " on line " << vecChunks[c].nErrorLine << ".\n";
+			clear();
+			return false;
+		}
+		for (int j = 0; j < m_nParamCount; j++)
+		{
+			m_vecColumnMin[j] = min(m_vecColumnMin[j], vecChunks[c].vecMin[j]);
+			m_vecColumnMax[j] = max(m_vecColumnMax[j], vecChunks[c].vecMax[j]);
+		}
+	}
+	bindStorage();
+
+	//validate file size
+	if (m_nRowCount <= 0)
+	{
+		cout << "ERROR: File contained no data.\n\n";
+		clear();
+	}
+	return m_nRowCount > 0;
+}
+
+//Parses the rows of one chunk of CSV text into the feature matrix and label column, starting at the chunk's
+// first row, and records the chunk's column ranges. Stops at the first malformed line, recording it in chunk.
+template <typename T>
+void SigmoidDataSet<T>::parseCsvChunk(CsvChunk &chunk, const char *fileend, const string &labels)
+{
+	chunk.vecMin.assign(m_nParamCount, numeric_limits<double>::max());
+	chunk.vecMax.assign(m_nParamCount, -numeric_limits<double>::max());
+	T *pRow = m_vecFeatures.data() + (size_t)chunk.nFirstRow * m_nParamCount;
+	int32_t *pLabel = m_vecLabels.data() + chunk.nFirstRow;
+	int nLine = chunk.nFirstLine;
+	for (const char *pLine = chunk.pBegin; pLine < chunk.pEnd; pLine = getNextLine(pLine, fileend), nLine++)
+	{
+		const char *pLineEnd = getLineEnd(pLine, fileend);
+		if (pLineEnd == pLine)
+			continue;
+
+		//First field is the label, converted to its index in labels
+		const char *pComma = (const char *)memchr(pLine, ',', pLineEnd - pLine);
+		size_t nLabel = (pComma == NULL || pComma == pLine) ? string::npos : labels.find(pLine, 0, pComma - pLine);
+		if (nLabel == string::npos)
+		{
+			chunk.pError = CSV_LABEL_ERROR;
+			chunk.nErrorLine = nLine;
+			return;
+		}
+		*pLabel++ = (int32_t)nLabel;
+
+		//Remaining fields are params
+		const char *pError = NULL;
+		const char *p = pComma + 1;
+		for (int j = 0; j < m_nParamCount && !pError; j++)
+		{
+			while (p < pLineEnd && *p == ' ')
+				p++;
+			from_chars_result result = from_chars(p, pLineEnd, pRow[j]);
+			if (result.ec != errc() || result.ptr == p)
+			{
+				pError = (p == pLineEnd) ? CSV_COUNT_ERROR : CSV_TYPE_ERROR;
+				break;
+			}
+			p = result.ptr;
+			while (p < pLineEnd && *p == ' ')
+				p++;
+			chunk.vecMin[j] = min(chunk.vecMin[j], (double)pRow[j]);
+			chunk.vecMax[j] = max(chunk.vecMax[j], (double)pRow[j]);
+			if (j < m_nParamCount - 1)
+			{
+				if (p == pLineEnd || *p != ',')
+					pError = (p == pLineEnd) ? CSV_COUNT_ERROR : CSV_TYPE_ERROR;
+				p++;
+			}
+		}
+		if (!pError && p != pLineEnd)
+			pError = (*p == ',') ? CSV_COUNT_ERROR : CSV_TYPE_ERROR;
+		if (pError)
+		{
+			chunk.pError = pError;
+			chunk.nErrorLine = nLine;
+			return;
+		}
+		pRow += m_nParamCount;
+	}
+}
+
+//Returns the end of the line starting at line, excluding any '\r' before the newline
+template <typename T>
+const char *SigmoidDataSet<T>::getLineEnd(const char *line, const char *fileend)
+{
+	const char *pNewline = (const char *)memchr(line, '\n', fileend - line);
+	const char *pLineEnd = pNewline ? pNewline : fileend;
+	if (pLineEnd > line && pLineEnd[-1] == '\r')
+		pLineEnd--;
+	return pLineEnd;
+}
+
+//Returns the start of the line after the one containing p
+template <typename T>
+const char *SigmoidDataSet<T>::getNextLine(const char *p, const char *fileend)
+{
+	const char *pNewline = (const char *)memchr(p, '\n', fileend - p);
+	return pNewline ? pNewline + 1 : fileend;
+}
+
+//Maps filename and points the feature matrix and label column straight into it. Double precision features are used
+// in place; single precision features are widened into owned storage. The header is checked against the file size,
+// and every label against labels, before anything is read through them.
+template <typename T>
+bool SigmoidDataSet<T>::loadBinary(const string &filename, const string &labels)
+{
+	clear();
+	shared_ptr<MappedFile> pFile(new MappedFile());
+	if (!pFile->open(filename))
+		return false;
+
+	SigmoidDataHeader header;
+	const char *pData = pFile->getData();
+	bool bValid = pFile->getSize() >= sizeof(header);
+	if (bValid)
+	{
+		memcpy(&header, pData, sizeof(header));
+		bValid = isValidDataHeader(header, pFile->getSize());
+	}
+	if (!bValid)
+	{
+		cout << "ERROR: " << filename << " is not a valid data file.\n";
+		return false;
+	}
+	int64_t nBadRow = findInvalidLabel((const int32_t *)(pData + header.labelOffset), header.rowCount, labels.size());
+	if (nBadRow >= 0)
+	{
+		cout << "ERROR: Data file " << filename << " " << CSV_LABEL_ERROR << " in row " << nBadRow + 1 << ".\n";
+		return false;
+	}
+
+	m_nRowCount = (int)header.rowCount;
+	m_nParamCount = (int)header.paramCount;
+	m_vecRangeMin.resize(m_nParamCount);
+	m_vecRangeMax.resize(m_nParamCount);
+	memcpy(m_vecRangeMin.data(), pData + header.rangeOffset, m_nParamCount * sizeof(double));
+	memcpy(m_vecRangeMax.data(), pData + header.rangeOffset + m_nParamCount * sizeof(double), m_nParamCount * sizeof(double));
+	if (header.scalarSize == sizeof(T))
+	{
+		m_pFile = pFile;
+		m_pFeatures = (const T *)(pData + header.featureOffset);
+		m_pLabels = (const int32_t *)(pData + header.labelOffset);
+	}
+	else
+	{
+		const int32_t *pLabels = (const int32_t *)(pData + header.labelOffset);
+		size_t nValues = (size_t)m_nRowCount * m_nParamCount;
+		if (header.scalarSize == sizeof(float))
+			m_vecFeatures.assign((const float *)(pData + header.featureOffset), (const float *)(pData + header.featureOffset) + nValues);
+		else
+			m_vecFeatures.assign((const double *)(pData + header.featureOffset), (const double *)(pData + header.featureOffset) + nValues);
+		m_vecLabels.assign(pLabels, pLabels + m_nRowCount);
+		bindStorage();
+	}
+	return true;
+}
+
+//Writes the header, column ranges, labels and feature matrix described in SigmoidDataFile.h to filename.tmp, flushes
+// it to disk, then renames it over filename, so a process that has the old file mapped (see loadBinary()) keeps its
+// pages.
+template <typename T>
+bool SigmoidDataSet<T>::saveBinary(const string &filename, bool singleprecision) const
+{
+	SigmoidDataHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, DATA_MAGIC, sizeof(header.magic));
+	header.version = DATA_VERSION;
+	header.scalarSize = singleprecision ? sizeof(float) : sizeof(double);
+	header.rowCount = m_nRowCount;
+	header.paramCount = m_nParamCount;
+	header.rangeOffset = sizeof(header);
+	header.labelOffset = header.rangeOffset + 2 * m_nParamCount * sizeof(double);
+	size_t nLabelEnd = (size_t)header.labelOffset + m_nRowCount * sizeof(int32_t);
+	header.featureOffset = (nLabelEnd + DATA_FEATURE_ALIGNMENT - 1) / DATA_FEATURE_ALIGNMENT * DATA_FEATURE_ALIGNMENT;
+
+	string strTempFile = filename + ".tmp";
+	FILE *pFile = fopen(strTempFile.c_str(), "wb");
+	if (!pFile)
+	{
+		cout << "ERROR: Data file " << strTempFile << " could not be opened for writing.\n";
+		return false;
+	}
+	vector<double> vRangeMin(m_vecRangeMin), vRangeMax(m_vecRangeMax);
+	if (vRangeMin.size() != (size_t)m_nParamCount) //not rescaled. Record the identity range.
+	{
+		vRangeMin.assign(m_nParamCount, 0);
+		vRangeMax.assign(m_nParamCount, 1);
+	}
+	vector<char> vPadding((size_t)header.featureOffset - nLabelEnd, 0);
+	size_t nValues = (size_t)m_nRowCount * m_nParamCount;
+	bool bWritten = fwrite(&header, sizeof(header), 1, pFile) == 1 &&
+		fwrite(vRangeMin.data(), sizeof(double), m_nParamCount, pFile) == (size_t)m_nParamCount &&
+		fwrite(vRangeMax.data(), sizeof(double), m_nParamCount, pFile) == (size_t)m_nParamCount &&
+		fwrite(m_pLabels, sizeof(int32_t), m_nRowCount, pFile) == (size_t)m_nRowCount &&
+		(vPadding.empty() || fwrite(vPadding.data(), 1, vPadding.size(), pFile) == vPadding.size());
+	if (bWritten && header.scalarSize == sizeof(T))
+		bWritten = fwrite(m_pFeatures, sizeof(T), nValues, pFile) == nValues;
+	else if (bWritten && singleprecision)
+	{
+		vector<float> vFeatures(m_pFeatures, m_pFeatures + nValues);
+		bWritten = fwrite(vFeatures.data(), sizeof(float), nValues, pFile) == nValues;
+	}
+	else if (bWritten)
+	{
+		vector<double> vFeatures(m_pFeatures, m_pFeatures + nValues);
+		bWritten = fwrite(vFeatures.data(), sizeof(double), nValues, pFile) == nValues;
+	}
+	bWritten = bWritten && fflush(pFile) == 0 && fsync(fileno(pFile)) == 0;
+	bWritten = fclose(pFile) == 0 && bWritten;
+	if (!bWritten || rename(strTempFile.c_str(), filename.c_str()) != 0)
+	{
+		cout << "ERROR: Data file " << filename << " could not be written.\n";
+		remove(strTempFile.c_str());
+		return false;
+	}
+	return true;
+}
+
+template <typename T>
+bool SigmoidDataSet<T>::isBinaryFile(const string &filename)
+{
+	char magic[sizeof(DATA_MAGIC)];
+	ifstream fsIn(filename.c_str(), ios::binary);
+	return fsIn.read(magic, sizeof(magic)) && memcmp(magic, DATA_MAGIC, sizeof(magic)) == 0;
+}
+
+template <typename T>
+bool SigmoidDataSet<T>::load(const string &filename, const string &labels)
+{
+	if (isBinaryFile(filename))
+		return loadBinary(filename, labels);
+	return loadCsv(filename, labels);
+}
+
+template <typename T>
+bool SigmoidDataSet<T>::loadPair(SigmoidDataSet<T> &trainingset, SigmoidDataSet<T> &validationset, const string &trainingfile,
+	const string &validationfile, const string &labels)
+{
+	if (!trainingset.load(trainingfile, labels) || !validationset.load(validationfile, labels))
+		return false;
+	if (trainingset.getParamCount() != validationset.getParamCount())
+	{
+		cout << "ERROR: Differing parameter counts between training and validation sets.\n";
+		return false;
+	}
+	return rescaleSets({ &trainingset, &validationset });
+}
+
+template <typename T>
+void SigmoidDataSet<T>::setParseThreads(int threadcount)
+{
+	m_nParseThreads = max(1, threadcount);
+}
+
+//Widens minx/maxx to cover every column, using the ranges loadCsv() found while parsing, if still valid
+template <typename T>
+void SigmoidDataSet<T>::getColumnRanges(vector<double> &minx, vector<double> &maxx) const
+{
+	if (!m_vecColumnMin.empty())
+	{
+		for (int j = 0; j < m_nParamCount; j++)
+		{
+			maxx[j] = max(maxx[j], m_vecColumnMax[j]);
+			minx[j] = min(minx[j], m_vecColumnMin[j]);
+		}
+		return;
+	}
+	for (int i = 0; i < m_nRowCount; i++) //iterate each row
+	{
+		const T *pRow = getParams(i);
+		for (int j = 0; j < m_nParamCount; j++) //iterate parameter
+		{
+			if (pRow[j] > maxx[j])
+				maxx[j] = pRow[j];
+			if (pRow[j] < minx[j])
+				minx[j] = pRow[j];
+		}
+	}
+}
+
+//Rescales every feature to [0, 1] given per-column ranges. A mapped set is copied into owned storage first.
+template <typename T>
+void SigmoidDataSet<T>::rescale(const vector<double> &minx, const vector<double> &maxx)
+{
+	if (m_pFile)
+	{
+		m_vecFeatures.assign(m_pFeatures, m_pFeatures + (size_t)m_nRowCount * m_nParamCount);
+		m_vecLabels.assign(m_pLabels, m_pLabels + m_nRowCount);
+		m_pFile.reset();
+		bindStorage();
+	}
+	for (int i = 0; i < m_nRowCount; i++)
+		for (int j = 0; j < m_nParamCount; j++)
+			m_vecFeatures[(size_t)i * m_nParamCount + j] = (T)rescaleFeature(m_vecFeatures[(size_t)i * m_nParamCount + j], minx[j], maxx[j]);
+	m_vecRangeMin = minx;
+	m_vecRangeMax = maxx;
+	m_vecColumnMin.clear();
+	m_vecColumnMax.clear();
+}
+
+//A set with stored ranges, e.g. loaded from a binary data file, which is rescaled as it is written, must not be
+// rescaled again, so the first such set's ranges are used for every set without. Only when no set has ranges are they
+// found from the rows of every set.
+template <typename T>
+bool SigmoidDataSet<T>::rescaleSets(const vector<SigmoidDataSet<T> *> &sets)
+{
+	if (sets.empty())
+		return true;
+	int nParamCount = sets[0]->getParamCount();
+	vector<double> vMinx, vMaxx;
+	for (size_t i = 0; i < sets.size(); i++)
+	{
+		if (sets[i]->getParamCount() != nParamCount)
+		{
+			cout << "ERROR: Differing parameter counts between data sets.\n";
+			return false;
+		}
+		if (vMinx.empty() && !sets[i]->getRangeMin().empty())
+		{
+			vMinx = sets[i]->getRangeMin();
+			vMaxx = sets[i]->getRangeMax();
+		}
+	}
+	if (vMinx.empty())
+	{
+		vMinx.assign(nParamCount, numeric_limits<double>::max());
+		vMaxx.assign(nParamCount, numeric_limits<double>::lowest());
+		for (size_t i = 0; i < sets.size(); i++)
+			sets[i]->getColumnRanges(vMinx, vMaxx);
+	}
+	for (size_t i = 0; i < sets.size(); i++)
+		if (sets[i]->getRangeMin().empty())
+			sets[i]->rescale(vMinx, vMaxx);
+	return true;
+}
+
+//A mapped set just narrows its view, so e.g. one training process's shard of a binary data file is never copied.
+// A set that owns its storage drops the other rows.
+template <typename T>
+void SigmoidDataSet<T>::selectRows(int firstrow, int rowcount)
+{
+	firstrow = min(max(firstrow, 0), m_nRowCount);
+	rowcount = min(max(rowcount, 0), m_nRowCount - firstrow);
+	if (m_pFile)
+	{
+		m_pFeatures += (size_t)firstrow * m_nParamCount;
+		m_pLabels += firstrow;
+	}
+	else
+	{
+		m_vecFeatures.erase(m_vecFeatures.begin() + (size_t)(firstrow + rowcount) * m_nParamCount, m_vecFeatures.end());
+		m_vecFeatures.erase(m_vecFeatures.begin(), m_vecFeatures.begin() + (size_t)firstrow * m_nParamCount);
+		m_vecLabels.erase(m_vecLabels.begin() + firstrow + rowcount, m_vecLabels.end());
+		m_vecLabels.erase(m_vecLabels.begin(), m_vecLabels.begin() + firstrow);
+		bindStorage();
+	}
+	m_nRowCount = rowcount;
+	m_vecColumnMin.clear();
+	m_vecColumnMax.clear();
+}
+
+//Utility function to rescale a feature variable x as x' = (x-min(x))/max(x)-min(x)
+template <typename T>
+double SigmoidDataSet<T>::rescaleFeature(double x, double minx, double maxx) const
+{
+	if (maxx == minx) //if there is only one data row
+		return x;
+	else
+		return (x - minx) / (maxx - minx);
+}
+
+template <typename T>
+void SigmoidDataSet<T>::clear()
+{
+	m_nRowCount = 0;
+	m_nParamCount = 0;
+	m_vecFeatures.clear();
+	m_vecLabels.clear();
+	m_vecRangeMin.clear();
+	m_vecRangeMax.clear();
+	m_vecColumnMin.clear();
+	m_vecColumnMax.clear();
+	m_pFile.reset();
+	bindStorage();
+}
+
+template <typename T>
+void SigmoidDataSet<T>::bindStorage()
+{
+	m_pFeatures = m_vecFeatures.data();
+	m_pLabels = m_vecLabels.data();
+}
+
+///Accessors
+template <typename T>
+int SigmoidDataSet<T>::getRowCount() const
+{
+	return m_nRowCount;
+}
+template <typename T>
+int SigmoidDataSet<T>::getParamCount() const
+{
+	return m_nParamCount;
+}
+template <typename T>
+const T *SigmoidDataSet<T>::getFeatures() const
+{
+	return m_pFeatures;
+}
+template <typename T>
+T *SigmoidDataSet<T>::getWritableFeatures()
+{
+	return m_vecFeatures.data();
+}
+template <typename T>
+const T *SigmoidDataSet<T>::getParams(int row) const
+{
+	return m_pFeatures + (size_t)row * m_nParamCount;
+}
+template <typename T>
+const int32_t *SigmoidDataSet<T>::getLabels() const
+{
+	return m_pLabels;
+}
+template <typename T>
+int32_t *SigmoidDataSet<T>::getWritableLabels()
+{
+	return m_vecLabels.data();
+}
+template <typename T>
+int SigmoidDataSet<T>::getLabel(int row) const
+{
+	return m_pLabels[row];
+}
+template <typename T>
+const vector<double> &SigmoidDataSet<T>::getRangeMin() const
+{
+	return m_vecRangeMin;
+}
+template <typename T>
+const vector<double> &SigmoidDataSet<T>::getRangeMax() const
+{
+	return m_vecRangeMax;
+}
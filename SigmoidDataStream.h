@@ -0,0 +1,618 @@
+///////////////////////////////////////////
+// Streams a data file (CSV or binary, see SigmoidDataSet) in fixed-size chunks of rows, for training on data sets
+//	larger than memory, or to start training before a whole file is read.
+//	Each pass is a three-stage pipeline: a reader thread reads the file in blocks of about STREAM_READ_BYTES, a parser
+//	thread parses, converts, rescales and shuffles each block's rows into chunks, and the caller trains on each chunk
+//	as next() returns it. The stages are connected by bounded lock-free queues (see SpscQueue.h) that pass block and
+//	chunk indices forward, and back again once a stage is done with them, so buffers are recycled rather than
+//	allocated, and only getQueueDepth() chunks and STREAM_BLOCK_COUNT blocks are ever held in memory. Training starts
+//	as soon as the first chunk is ready, and reading and parsing go on while it trains. getStats() tells which stage
+//	the others waited on.
+//	Each pass over the file starts with rewind(); next() then returns chunk after chunk until the pass is done.
+//	Optionally, rows are shuffled within each chunk (a window of getChunkRows() rows), differently on every pass, and
+//	CSV rows are rescaled as they are parsed (binary data files are rescaled when written). T is the scalar type of the
+//	chunks' features: float or double.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include "SigmoidDataFile.h"
+#include "SigmoidDataSet.h"
+#include "SpscQueue.h"
+
+using namespace std;
+
+const size_t STREAM_READ_BYTES = 1 << 20;											//Bytes read from the file per block
+const int STREAM_BLOCK_COUNT = 4;													//Blocks in flight between the reader and parser threads
+
+struct SigmoidStreamBlock															//Bytes read from a data file, not yet parsed
+{
+	vector<char> vecBytes;															//CSV: whole lines of text. Binary: labels, then features, of nRows rows.
+	int nRows;																		//Binary: rows in the block
+	uint64_t nFirstRow;																//Binary: index of the block's first row, for error msgs
+	size_t nFeatureOffset;															//Binary: offset of the features in vecBytes
+	int nFirstLine;																	//CSV: line number of the block's first line
+};
+
+struct SigmoidStreamStats															//Where the stages of one pass waited. Valid once next() has returned NULL.
+{
+	int nChunks;																	//Chunks next() returned
+	double dblFirstChunkSeconds;													//From rewind() until the first chunk was ready, i.e. the wait for the first update
+	double dblTrainerWaitSeconds;													//Time next() waited for chunks, including the first. Near 0 = reading and parsing
+																					//   are hidden behind training.
+	double dblParserWaitSeconds;													//Time the parser waited for the reader. High = reading is the slowest stage.
+	double dblParserBlockedSeconds;													//Time the parser waited for a free chunk. High = training is the slowest stage.
+	double dblReaderBlockedSeconds;													//Time the reader waited for a free block
+};
+
+template <typename T>
+class SigmoidDataStream
+{
+public:
+	SigmoidDataStream();															//Constructor. Call open() before use.
+	~SigmoidDataStream();															//Stops the pipeline threads
+	bool open(const string &filename, const string &labels, int chunkrows);		//Opens a binary or CSV data file, to be read chunkrows rows at a time. CSV labels
+																					//   are converted to their index in labels; binary labels must index labels.
+																					//   Returns false, with an error msg, on failure.
+	void setShuffle(bool shuffle, unsigned int seed);								//Shuffle rows within each chunk, in a different order each pass. Off by default.
+	void setRescale(const vector<double> &minx, const vector<double> &maxx);		//Rescale CSV rows as x' = (x-min(x))/(max(x)-min(x)) as they are parsed
+	void setQueueDepth(int chunkcount);												//Sets the chunks held at once: one being trained on, the rest parsed ahead of it.
+																					//   Default (and minimum) 2. Takes effect at the next rewind().
+	bool getColumnRanges(vector<double> &minx, vector<double> &maxx);				//Widens minx/maxx to cover every column, with one pass over the file.
+																					//   Size them to getParamCount() first. Returns false on a read error.
+	void rewind();																	//Starts a new pass from the first row
+	const SigmoidDataSet<T> *next();												//Returns the pass's next chunk, valid until the next call, or NULL at the end
+																					//   of the pass (or on a read error, see hasFailed())
+	bool hasFailed() const;															//Returns true if the last pass stopped on a read or parse error
+	SigmoidStreamStats getStats() const;											//Returns where the last pass's stages waited
+	int getParamCount() const;														//Returns the number of features per row
+	int getChunkRows() const;														//Returns the number of rows per chunk
+	int getQueueDepth() const;														//Returns m_nQueueDepth
+	bool isBinary() const;															//Returns true if the file is a binary data file (already rescaled)
+	const vector<double> &getRangeMin() const;										//Returns the column mins rows are rescaled with: a binary file's stored ones, or
+																					//   those given to setRescale() (empty if neither)
+	const vector<double> &getRangeMax() const;										//Returns the column maxes, as above
+	bool getShuffle() const;														//Returns m_bShuffle
+	unsigned int getShuffleSeed() const;											//Returns m_nSeed
+	int getPassCount() const;														//Returns the number of passes started, which with the seed sets the next pass's order
+	void setPassCount(int passcount);												//Sets it, e.g. so a resumed run shuffles its next pass as the interrupted run would
+
+private:
+	SigmoidDataStream(const SigmoidDataStream &);									//Not copyable
+	SigmoidDataStream &operator=(const SigmoidDataStream &);
+
+	string m_strFilename;															//File being streamed
+	string m_strLabels;																//Valid labels
+	int m_nChunkRows;																//Rows per chunk
+	int m_nParamCount;																//Features per row
+	bool m_bBinary;																	//True = binary data file. False = CSV.
+	SigmoidDataHeader m_Header;														//Header of a binary data file
+	bool m_bShuffle;																//True = shuffle rows within each chunk
+	unsigned int m_nSeed;															//Shuffle seed. Each pass adds its pass number.
+	int m_nPass;																	//Passes started
+	vector<double> m_vecRescaleMin;													//Column mins CSV rows are rescaled with (empty = don't rescale)
+	vector<double> m_vecRescaleMax;													//Column maxes CSV rows are rescaled with
+	vector<double> m_vecFileRangeMin;												//Column mins a binary data file was rescaled with, when written
+	vector<double> m_vecFileRangeMax;												//Column maxes a binary data file was rescaled with
+	int m_nQueueDepth;																//Chunks held at once
+
+	vector<SigmoidStreamBlock> m_vecBlocks;											//Blocks passed from the reader to the parser
+	unique_ptr<SigmoidDataSet<T>[]> m_pChunks;										//m_nQueueDepth chunks passed from the parser to next()
+	int m_nChunkCount;																//Chunks allocated in m_pChunks
+	SigmoidDataSet<T> m_Parsed;														//Parser's rows of the CSV block in hand, before they are copied into chunks
+	SpscQueue<int> m_FullBlocks;													//Reader to parser: blocks read. -1 = end of pass.
+	SpscQueue<int> m_FreeBlocks;													//Parser to reader: blocks parsed, to be read into again
+	SpscQueue<int> m_FullChunks;													//Parser to next(): chunks filled. -1 = end of pass.
+	SpscQueue<int> m_FreeChunks;													//next() to parser: chunks trained on, to be filled again
+	int m_nHeldChunk;																//Chunk last returned by next(), or -1
+	bool m_bPassDone;																//True once next() has seen the end of the pass
+	atomic<bool> m_bFailed;															//True if a stage stopped on an error
+	atomic<bool> m_bStopping;														//True when the stages should stop early
+	thread m_Reader;																//Reader thread for the current pass
+	thread m_Parser;																//Parser thread for the current pass
+	chrono::steady_clock::time_point m_tPassStart;									//When the current pass started
+	SigmoidStreamStats m_Stats;														//The current pass's waits. Each field is written by one stage.
+
+	void runReader();																//Reader loop. Reads blocks in turn until the end of the file.
+	void runParser(unsigned int seed);												//Parser loop. Parses blocks into chunks until the reader's end of pass.
+	bool readBinaryBlock(ifstream &fsIn, SigmoidStreamBlock &block, uint64_t firstrow);	//Reads up to a block of rows from firstrow into block
+	bool readCsvBlock(ifstream &fsIn, SigmoidStreamBlock &block, vector<char> &carry,	//Reads whole lines into block, numbering them from linenumber. carry holds
+			int &linenumber);														//   text read past them.
+	bool parseBlock(SigmoidStreamBlock &block, int &chunk, int &chunkrows,			//Copies block's rows into chunks, filling chunk from row chunkrows and passing
+			mt19937 &random);														//   on each chunk it fills. Returns false, with an error msg, on failure.
+	template <typename S>
+	bool appendRows(const S *features, const int32_t *labels, int rowcount,			//Copies rowcount rows into chunks, as above, converting features to T.
+			int &chunk, int &chunkrows, mt19937 &random);							//   Returns false if the pass is stopping.
+	void passChunk(int chunk, int rowcount, mt19937 &random);						//Trims chunk to rowcount rows, shuffles it if set, and passes it to next()
+	bool waitPop(SpscQueue<int> &queue, int &element, double &waitseconds);		//Pops from queue, waiting until it holds an element, adding the wait to
+																					//   waitseconds. Returns false if the pass is stopping.
+	void shuffleRows(SigmoidDataSet<T> &chunk, mt19937 &random);					//Shuffles chunk's rows in place
+	void stopPipeline();															//Stops and joins the pipeline threads, if running
+};
+
+//Constructor
+template <typename T>
+SigmoidDataStream<T>::SigmoidDataStream() : m_nChunkRows(0), m_nParamCount(0), m_bBinary(false), m_bShuffle(false), m_nSeed(0),
+	m_nPass(0), m_nQueueDepth(2), m_vecBlocks(STREAM_BLOCK_COUNT), m_nChunkCount(0), m_nHeldChunk(-1), m_bPassDone(true),
+	m_bFailed(false), m_bStopping(false)
+{
+	memset(&m_Header, 0, sizeof(m_Header));
+	memset(&m_Stats, 0, sizeof(m_Stats));
+	m_Parsed.setParseThreads(1);
+}
+
+template <typename T>
+SigmoidDataStream<T>::~SigmoidDataStream()
+{
+	stopPipeline();
+}
+
+//Opens filename and reads its parameter count: from the header of a binary data file, or by counting the fields of
+// the first non-blank line of a CSV file. A binary header is checked against the file size as SigmoidDataSet::
+// loadBinary() checks it. Nothing else is read until rewind().
+template <typename T>
+bool SigmoidDataStream<T>::open(const string &filename, const string &labels, int chunkrows)
+{
+	stopPipeline();
+	m_strFilename = filename;
+	m_strLabels = labels;
+	m_nChunkRows = max(1, chunkrows);
+	m_nParamCount = 0;
+	m_bBinary = SigmoidDataSet<T>::isBinaryFile(filename);
+	m_vecFileRangeMin.clear();
+	m_vecFileRangeMax.clear();
+	m_bPassDone = true;
+	m_bFailed = false;
+	ifstream fsIn(filename.c_str(), ios::binary);
+	if (fsIn.fail())
+	{
+		cout << "ERROR: File " << filename << " could not be opened.\n";
+		return false;
+	}
+	if (m_bBinary)
+	{
+		fsIn.seekg(0, ios::end);
+		uint64_t nFileSize = (uint64_t)fsIn.tellg();
+		fsIn.seekg(0);
+		bool bValid = (bool)fsIn.read((char *)&m_Header, sizeof(m_Header)) && isValidDataHeader(m_Header, nFileSize);
+		if (bValid)
+		{
+			m_vecFileRangeMin.resize(m_Header.paramCount);
+			m_vecFileRangeMax.resize(m_Header.paramCount);
+			fsIn.seekg(m_Header.rangeOffset);
+			bValid = fsIn.read((char *)m_vecFileRangeMin.data(), m_Header.paramCount * sizeof(double)) &&
+				fsIn.read((char *)m_vecFileRangeMax.data(), m_Header.paramCount * sizeof(double));
+		}
+		if (!bValid)
+		{
+			cout << "ERROR: " << filename << " is not a supported data file.\n";
+			return false;
+		}
+		m_nParamCount = (int)m_Header.paramCount;
+		return true;
+	}
+	string strLine;
+	while (getline(fsIn, strLine) && strLine.find_first_not_of("\r") == string::npos)
+		;
+	m_nParamCount = (int)count(strLine.begin(), strLine.end(), ',');
+	if (m_nParamCount == 0)
+	{
+		cout << "ERROR: File contained no data.\n\n";
+		return false;
+	}
+	return true;
+}
+
+template <typename T>
+void SigmoidDataStream<T>::setShuffle(bool shuffle, unsigned int seed)
+{
+	m_bShuffle = shuffle;
+	m_nSeed = seed;
+}
+
+template <typename T>
+void SigmoidDataStream<T>::setRescale(const vector<double> &minx, const vector<double> &maxx)
+{
+	m_vecRescaleMin = minx;
+	m_vecRescaleMax = maxx;
+}
+
+template <typename T>
+void SigmoidDataStream<T>::setQueueDepth(int chunkcount)
+{
+	m_nQueueDepth = max(2, chunkcount);
+}
+
+//Reads the whole file, a chunk at a time, without rescaling. Does not count as a pass, so shuffling is unaffected.
+template <typename T>
+bool SigmoidDataStream<T>::getColumnRanges(vector<double> &minx, vector<double> &maxx)
+{
+	int nPass = m_nPass;
+	vector<double> vecRescaleMin, vecRescaleMax;
+	vecRescaleMin.swap(m_vecRescaleMin);
+	vecRescaleMax.swap(m_vecRescaleMax);
+	rewind();
+	for (const SigmoidDataSet<T> *pChunk = next(); pChunk; pChunk = next())
+		pChunk->getColumnRanges(minx, maxx);
+	m_vecRescaleMin.swap(vecRescaleMin);
+	m_vecRescaleMax.swap(vecRescaleMax);
+	m_nPass = nPass;
+	return !m_bFailed;
+}
+
+//Stops any pass in progress, hands every block and chunk back to the stage that fills it, and starts the reader and
+// parser threads for a new pass. Each queue has room for every index plus the end of pass marker, so no push fails.
+template <typename T>
+void SigmoidDataStream<T>::rewind()
+{
+	stopPipeline();
+	if (m_nChunkCount != m_nQueueDepth)
+	{
+		m_pChunks.reset(new SigmoidDataSet<T>[m_nQueueDepth]);
+		m_nChunkCount = m_nQueueDepth;
+	}
+	m_FullBlocks.reset(STREAM_BLOCK_COUNT + 1);
+	m_FreeBlocks.reset(STREAM_BLOCK_COUNT + 1);
+	m_FullChunks.reset(m_nChunkCount + 1);
+	m_FreeChunks.reset(m_nChunkCount + 1);
+	for (int i = 0; i < STREAM_BLOCK_COUNT; i++)
+		m_FreeBlocks.push(i);
+	for (int i = 0; i < m_nChunkCount; i++)
+		m_FreeChunks.push(i);
+	m_nHeldChunk = -1;
+	m_bPassDone = false;
+	m_bFailed = false;
+	m_bStopping = false;
+	memset(&m_Stats, 0, sizeof(m_Stats));
+	m_tPassStart = chrono::steady_clock::now();
+	m_Reader = thread(&SigmoidDataStream<T>::runReader, this);
+	m_Parser = thread(&SigmoidDataStream<T>::runParser, this, m_nSeed + m_nPass++);
+}
+
+//Hands the last chunk back to the parser, then waits for the next one. At the end of the pass, the pipeline threads
+// have finished, so they are joined, which also makes their stats visible.
+template <typename T>
+const SigmoidDataSet<T> *SigmoidDataStream<T>::next()
+{
+	if (m_nHeldChunk >= 0)
+	{
+		m_FreeChunks.push(m_nHeldChunk);
+		m_nHeldChunk = -1;
+	}
+	if (m_bPassDone)
+		return NULL;
+	int nChunk = -1;
+	if (!waitPop(m_FullChunks, nChunk, m_Stats.dblTrainerWaitSeconds) || nChunk < 0)
+	{
+		m_bPassDone = true;
+		m_Reader.join();
+		m_Parser.join();
+		return NULL;
+	}
+	if (m_Stats.nChunks++ == 0)
+		m_Stats.dblFirstChunkSeconds = chrono::duration<double>(chrono::steady_clock::now() - m_tPassStart).count();
+	m_nHeldChunk = nChunk;
+	return &m_pChunks[nChunk];
+}
+
+//Reads blocks in turn, waiting whenever the parser still holds every one, and ends the pass with -1
+template <typename T>
+void SigmoidDataStream<T>::runReader()
+{
+	ifstream fsIn(m_strFilename.c_str(), ios::binary);
+	vector<char> vecCarry;
+	uint64_t nRow = 0;
+	int nLine = 1;
+	bool bOk = !fsIn.fail();
+	if (!bOk)
+		cout << "ERROR: File " << m_strFilename << " could not be opened.\n";
+	while (bOk && !m_bFailed)
+	{
+		if (m_bBinary && nRow >= m_Header.rowCount)
+			break;
+		int nBlock;
+		if (!waitPop(m_FreeBlocks, nBlock, m_Stats.dblReaderBlockedSeconds))
+			return;
+		SigmoidStreamBlock &block = m_vecBlocks[nBlock];
+		if (m_bBinary)
+		{
+			bOk = readBinaryBlock(fsIn, block, nRow);
+			nRow += block.nRows;
+		}
+		else
+		{
+			bOk = readCsvBlock(fsIn, block, vecCarry, nLine);
+			if (bOk && block.vecBytes.empty())
+				break;
+		}
+		if (bOk)
+			m_FullBlocks.push(nBlock);
+	}
+	if (!bOk)
+		m_bFailed = true;
+	m_FullBlocks.push(-1);
+}
+
+//Parses each block into chunks, handing each block back to the reader once its rows are copied. After an error, the
+// rest of the pass's blocks are handed back unparsed, so the reader never waits on a parser that has given up.
+template <typename T>
+void SigmoidDataStream<T>::runParser(unsigned int seed)
+{
+	mt19937 random(seed);
+	int nChunk = -1;
+	int nChunkRows = 0;
+	bool bOk = true;
+	while (true)
+	{
+		int nBlock;
+		if (!waitPop(m_FullBlocks, nBlock, m_Stats.dblParserWaitSeconds))
+			return;
+		if (nBlock < 0)
+			break;
+		if (bOk && !parseBlock(m_vecBlocks[nBlock], nChunk, nChunkRows, random))
+		{
+			if (m_bStopping)
+				return;
+			bOk = false;
+			m_bFailed = true;
+		}
+		m_FreeBlocks.push(nBlock);
+	}
+	if (bOk && nChunk >= 0 && nChunkRows > 0)
+		passChunk(nChunk, nChunkRows, random);
+	m_FullChunks.push(-1);
+}
+
+//Reads labels and features of up to a block of rows, in the file's precision. The features start on an 8 byte
+// boundary, so they can be read in place whatever the row count.
+template <typename T>
+bool SigmoidDataStream<T>::readBinaryBlock(ifstream &fsIn, SigmoidStreamBlock &block, uint64_t firstrow)
+{
+	size_t nRowBytes = sizeof(int32_t) + (size_t)m_nParamCount * m_Header.scalarSize;
+	block.nRows = (int)min((uint64_t)max((size_t)1, STREAM_READ_BYTES / nRowBytes), m_Header.rowCount - firstrow);
+	block.nFirstRow = firstrow;
+	block.nFeatureOffset = (block.nRows * sizeof(int32_t) + 7) / 8 * 8;
+	block.vecBytes.resize(block.nFeatureOffset + (size_t)block.nRows * m_nParamCount * m_Header.scalarSize);
+	fsIn.seekg(m_Header.labelOffset + firstrow * sizeof(int32_t));
+	fsIn.read(block.vecBytes.data(), block.nRows * sizeof(int32_t));
+	fsIn.seekg(m_Header.featureOffset + firstrow * m_nParamCount * m_Header.scalarSize);
+	fsIn.read(block.vecBytes.data() + block.nFeatureOffset, block.vecBytes.size() - block.nFeatureOffset);
+	if (fsIn.fail())
+	{
+		cout << "ERROR: Data file " << m_strFilename << " is truncated.\n";
+		return false;
+	}
+	return true;
+}
+
+//Reads about STREAM_READ_BYTES after the text carried from the last block, more if no line has ended yet, and carries
+// whatever follows the last newline to the next block. At the end of the file, the block takes the rest, so its last
+// line may have no newline; an empty block ends the pass.
+template <typename T>
+bool SigmoidDataStream<T>::readCsvBlock(ifstream &fsIn, SigmoidStreamBlock &block, vector<char> &carry, int &linenumber)
+{
+	block.vecBytes.swap(carry);
+	carry.clear();
+	size_t nLineEnd = 0;
+	while (fsIn)
+	{
+		size_t nSize = block.vecBytes.size();
+		block.vecBytes.resize(nSize + STREAM_READ_BYTES);
+		fsIn.read(block.vecBytes.data() + nSize, STREAM_READ_BYTES);
+		block.vecBytes.resize(nSize + (size_t)fsIn.gcount());
+		for (size_t i = block.vecBytes.size(); i > nSize && nLineEnd == 0; i--)
+			if (block.vecBytes[i - 1] == '\n')
+				nLineEnd = i;
+		if (nLineEnd > 0)
+			break;
+	}
+	if (fsIn.bad())
+	{
+		cout << "ERROR: Data file " << m_strFilename << " could not be read.\n";
+		return false;
+	}
+	if (fsIn)
+	{
+		carry.assign(block.vecBytes.begin() + nLineEnd, block.vecBytes.end());
+		block.vecBytes.resize(nLineEnd);
+	}
+	block.nFirstLine = linenumber;
+	linenumber += (int)count(block.vecBytes.begin(), block.vecBytes.end(), '\n');
+	return true;
+}
+
+//CSV text is parsed into m_Parsed, on this thread alone, and rescaled there before its rows are copied. Binary rows
+// are copied straight from the block, converted to T, once every label is checked against the valid labels.
+template <typename T>
+bool SigmoidDataStream<T>::parseBlock(SigmoidStreamBlock &block, int &chunk, int &chunkrows, mt19937 &random)
+{
+	if (m_bBinary)
+	{
+		const int32_t *pLabels = (const int32_t *)block.vecBytes.data();
+		const char *pFeatures = block.vecBytes.data() + block.nFeatureOffset;
+		int64_t nBadRow = findInvalidLabel(pLabels, block.nRows, m_strLabels.size());
+		if (nBadRow >= 0)
+		{
+			cout << "ERROR: Data file " << m_strFilename << " " << CSV_LABEL_ERROR << " in row " << block.nFirstRow + nBadRow + 1 << ".\n";
+			return false;
+		}
+		if (m_Header.scalarSize == sizeof(float))
+			return appendRows((const float *)pFeatures, pLabels, block.nRows, chunk, chunkrows, random);
+		return appendRows((const double *)pFeatures, pLabels, block.nRows, chunk, chunkrows, random);
+	}
+	int nFirstLine = block.nFirstLine;
+	const char *pText = block.vecBytes.data();
+	size_t nLength = block.vecBytes.size();
+	if (find_if(pText, pText + nLength, [](char c) { return c != '\n' && c != '\r'; }) == pText + nLength)
+		return true;	//only blank lines
+	if (!m_Parsed.loadCsv(pText, nLength, m_strLabels, m_strFilename, nFirstLine))
+		return false;
+	if (m_Parsed.getParamCount() != m_nParamCount)
+	{
+		cout << "ERROR: Data file " << m_strFilename << " has a differing parameter count near line " << nFirstLine << ".\n";
+		return false;
+	}
+	if (!m_vecRescaleMin.empty())
+		m_Parsed.rescale(m_vecRescaleMin, m_vecRescaleMax);
+	return appendRows(m_Parsed.getFeatures(), m_Parsed.getLabels(), m_Parsed.getRowCount(), chunk, chunkrows, random);
+}
+
+//Fills chunks in turn, taking a free one from next() whenever the last is full
+template <typename T>
+template <typename S>
+bool SigmoidDataStream<T>::appendRows(const S *features, const int32_t *labels, int rowcount, int &chunk, int &chunkrows, mt19937 &random)
+{
+	while (rowcount > 0)
+	{
+		if (chunk < 0)
+		{
+			if (!waitPop(m_FreeChunks, chunk, m_Stats.dblParserBlockedSeconds))
+				return false;
+			m_pChunks[chunk].resize(m_nChunkRows, m_nParamCount);
+			chunkrows = 0;
+		}
+		SigmoidDataSet<T> &dsChunk = m_pChunks[chunk];
+		int nRows = min(rowcount, m_nChunkRows - chunkrows);
+		copy(features, features + (size_t)nRows * m_nParamCount, dsChunk.getWritableFeatures() + (size_t)chunkrows * m_nParamCount);
+		copy(labels, labels + nRows, dsChunk.getWritableLabels() + chunkrows);
+		features += (size_t)nRows * m_nParamCount;
+		labels += nRows;
+		rowcount -= nRows;
+		chunkrows += nRows;
+		if (chunkrows == m_nChunkRows)
+		{
+			passChunk(chunk, chunkrows, random);
+			chunk = -1;
+		}
+	}
+	return true;
+}
+
+template <typename T>
+void SigmoidDataStream<T>::passChunk(int chunk, int rowcount, mt19937 &random)
+{
+	if (rowcount < m_nChunkRows)
+		m_pChunks[chunk].selectRows(0, rowcount);
+	if (m_bShuffle)
+		shuffleRows(m_pChunks[chunk], random);
+	m_FullChunks.push(chunk);
+}
+
+//Spins briefly, since the other stage is often about to push, then yields, then sleeps, so a stage waiting on a
+// slow one (e.g. the reader on a cold disk) costs the others almost no CPU
+template <typename T>
+bool SigmoidDataStream<T>::waitPop(SpscQueue<int> &queue, int &element, double &waitseconds)
+{
+	if (queue.pop(element))
+		return true;
+	chrono::steady_clock::time_point tStart = chrono::steady_clock::now();
+	for (int nTries = 0; !queue.pop(element); nTries++)
+	{
+		if (m_bStopping)
+			return false;
+		if (nTries < 1000)
+			this_thread::yield();
+		else
+			this_thread::sleep_for(chrono::microseconds(50));
+	}
+	waitseconds += chrono::duration<double>(chrono::steady_clock::now() - tStart).count();
+	return true;
+}
+
+//Fisher-Yates shuffle of whole rows (features and label together)
+template <typename T>
+void SigmoidDataStream<T>::shuffleRows(SigmoidDataSet<T> &chunk, mt19937 &random)
+{
+	T *pFeatures = chunk.getWritableFeatures();
+	int32_t *pLabels = chunk.getWritableLabels();
+	for (int i = chunk.getRowCount() - 1; i > 0; i--)
+	{
+		int j = uniform_int_distribution<int>(0, i)(random);
+		swap_ranges(pFeatures + (size_t)i * m_nParamCount, pFeatures + (size_t)(i + 1) * m_nParamCount, pFeatures + (size_t)j * m_nParamCount);
+		swap(pLabels[i], pLabels[j]);
+	}
+}
+
+template <typename T>
+void SigmoidDataStream<T>::stopPipeline()
+{
+	m_bStopping = true;
+	if (m_Reader.joinable())
+		m_Reader.join();
+	if (m_Parser.joinable())
+		m_Parser.join();
+	m_bPassDone = true;
+}
+
+///Accessors
+template <typename T>
+bool SigmoidDataStream<T>::hasFailed() const
+{
+	return m_bFailed;
+}
+template <typename T>
+SigmoidStreamStats SigmoidDataStream<T>::getStats() const
+{
+	return m_Stats;
+}
+template <typename T>
+int SigmoidDataStream<T>::getParamCount() const
+{
+	return m_nParamCount;
+}
+template <typename T>
+int SigmoidDataStream<T>::getChunkRows() const
+{
+	return m_nChunkRows;
+}
+template <typename T>
+int SigmoidDataStream<T>::getQueueDepth() const
+{
+	return m_nQueueDepth;
+}
+template <typename T>
+bool SigmoidDataStream<T>::isBinary() const
+{
+	return m_bBinary;
+}
+template <typename T>
+const vector<double> &SigmoidDataStream<T>::getRangeMin() const
+{
+	return m_bBinary ? m_vecFileRangeMin : m_vecRescaleMin;
+}
+template <typename T>
+const vector<double> &SigmoidDataStream<T>::getRangeMax() const
+{
+	return m_bBinary ? m_vecFileRangeMax : m_vecRescaleMax;
+}
+template <typename T>
+bool SigmoidDataStream<T>::getShuffle() const
+{
+	return m_bShuffle;
+}
+template <typename T>
+unsigned int SigmoidDataStream<T>::getShuffleSeed() const
+{
+	return m_nSeed;
+}
+template <typename T>
+int SigmoidDataStream<T>::getPassCount() const
+{
+	return m_nPass;
+}
+template <typename T>
+void SigmoidDataStream<T>::setPassCount(int passcount)
+{
+	m_nPass = passcount;
+}
@@ -0,0 +1,479 @@
+///////////////////////////////////////////
+// A local inference server for a trained sigmoid network, with dynamic batching, and a client for it.
+//	The server listens on a Unix domain socket or a localhost TCP port (see SigmoidSocket.h), and reads requests from
+//	each connection on a thread of that connection's own. Every request is queued. Worker threads take requests from
+//	the queue as batches, in arrival order, up to maxbatchrows rows (a larger request is taken alone). A worker starts
+//	a batch at once if no other worker is busy; otherwise it waits until the queued requests hold maxbatchrows rows,
+//	the oldest has waited maxdelay microseconds, or the other workers go idle. So a lone request is never held back,
+//	while under load requests gather into batches, each classified with one call to the network's const
+//	classifyBatch(), and no request waits much more than maxdelay for its batch to start.
+//	Protocol: every value is in the byte order of the machine, since client and server share it. A request is a
+//	SigmoidInferenceRequest, then rowCount x featureCount float features, row-major. The response is a
+//	SigmoidInferenceResponse with the same requestId, then rowCount int32 classifications. A client may send further
+//	requests before earlier responses arrive; responses on one connection may then arrive in any order. A request whose
+//	featureCount does not match the network's inputs, or whose rowCount is 0 or above MAX_INFERENCE_ROWS, is answered
+//	with status INFERENCE_BAD_REQUEST and no classifications, and its connection is closed.
+//	Backpressure: a connection's reader stops reading while MAX_CONNECTION_QUEUED_ROWS of its rows, or MAX_QUEUED_ROWS
+//	rows in all, are queued, so a client that sends faster than it is served backs up in its own socket, not in the
+//	server's memory. A response that cannot be sent within INFERENCE_SEND_TIMEOUT_MS, to a client that is not reading
+//	them, drops its connection, so no worker is held up for longer than that.
+//	The network must outlive the server, and must not be trained while the server is running. POSIX only.
+//	tools/inference_server.cpp serves a model file; tools/inference_client.cpp generates load and reports latency.
+// See inline documentation for more info.
+//
+//	T is the scalar type of the network. Features are sent as floats whatever T is.
+//
+
+#pragma once
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <sys/time.h>
+#include "SigmoidClassifier.h"
+#include "SigmoidSocket.h"
+
+using namespace std;
+
+const uint32_t INFERENCE_REQUEST_MAGIC = 0x51524953;						//"SIRQ"
+const uint32_t INFERENCE_RESPONSE_MAGIC = 0x50524953;						//"SIRP"
+const uint32_t MAX_INFERENCE_ROWS = 65536;									//Most rows in one request
+const int MAX_CONNECTION_QUEUED_ROWS = MAX_INFERENCE_ROWS;					//Most rows queued from one connection. Its reads pause beyond this.
+const int MAX_QUEUED_ROWS = 8 * MAX_INFERENCE_ROWS;							//Most rows queued from every connection. All reads pause beyond this.
+const int INFERENCE_SEND_TIMEOUT_MS = 1000;									//A response not sent within this drops its connection
+
+enum InferenceStatus
+{
+	INFERENCE_OK,															//Classifications follow
+	INFERENCE_BAD_REQUEST													//Wrong feature count or row count. The connection is closed.
+};
+
+struct SigmoidInferenceRequest
+{
+	uint32_t magic;															//INFERENCE_REQUEST_MAGIC
+	uint32_t requestId;														//Any value. Returned in the response.
+	uint32_t rowCount;														//Rows of features that follow
+	uint32_t featureCount;													//Features per row. Must equal the network's inputs.
+};
+
+struct SigmoidInferenceResponse
+{
+	uint32_t magic;															//INFERENCE_RESPONSE_MAGIC
+	uint32_t requestId;														//requestId of the request answered
+	uint32_t status;														//An InferenceStatus
+	uint32_t rowCount;														//Classifications that follow
+};
+
+struct SigmoidServerStats
+{
+	long long nRequests;													//Requests classified
+	long long nRows;														//Rows classified
+	long long nBatches;														//Calls to classifyBatch()
+	int nConnections;														//Connections open now
+	long long nDroppedConnections;											//Connections dropped because a response could not be sent
+};
+
+template <typename T>
+class SigmoidInferenceServer
+{
+public:
+	SigmoidInferenceServer(const SigmoidClassifier<T> &network, int workercount,	//Constructor. Batches of up to maxbatchrows rows, started once full or once
+			int maxbatchrows, int maxdelay);										//   their first request has waited maxdelay microseconds
+	~SigmoidInferenceServer();														//Calls stop()
+	bool start(const string &address);												//Listens on address and starts serving. Returns false, with an error msg, on failure.
+	void stop();																	//Stops accepting, closes every connection and stops the workers. Requests not yet
+																					//   classified are dropped.
+	SigmoidServerStats getStats() const;											//Returns the totals so far
+
+private:
+	struct Connection																//One client connection. Closed when the last reference is dropped.
+	{
+		int nSocket;																//Socket
+		mutex writeMutex;															//Serializes responses, which workers write concurrently
+		int nQueuedRows;															//Rows of this connection's requests in m_Queue. Guarded by m_Mutex.
+		atomic<bool> bDropped;														//True once a response could not be sent. Set under m_Mutex.
+		Connection(int socket) : nSocket(socket), nQueuedRows(0), bDropped(false) {}
+		~Connection() { close(nSocket); }
+	};
+	struct PendingRequest															//A request waiting in the queue
+	{
+		shared_ptr<Connection> pConnection;											//Connection to respond on
+		uint32_t nRequestId;														//requestId to respond with
+		int nRowCount;																//Rows in vecFeatures
+		vector<T> vecFeatures;														//nRowCount x input count, row-major
+		chrono::steady_clock::time_point tQueued;									//When the request was queued
+	};
+
+	const SigmoidClassifier<T> &m_Network;											//Network classified with
+	int m_nInputCount;																//Network inputs
+	int m_nWorkerCount;																//Worker threads
+	int m_nMaxBatchRows;															//Most rows per batch, but for a single larger request
+	chrono::microseconds m_MaxDelay;												//Longest a request waits for its batch to fill
+	int m_nListenSocket;															//Listening socket, or -1
+	string m_strUnixPath;															//Path of the Unix domain socket, removed on stop(), or blank
+	thread m_Listener;																//Accepts connections
+	vector<thread> m_vecWorkers;													//Classify batches
+	mutable mutex m_Mutex;															//Guards everything below
+	condition_variable m_QueueChanged;												//Signalled when a request is queued, or the server is stopping
+	condition_variable m_ReadersDone;												//Signalled when the last reader thread exits
+	condition_variable m_RowsFreed;													//Signalled when workers take queued rows, a connection is dropped, or the
+																					//   server is stopping
+	deque<PendingRequest> m_Queue;													//Requests waiting for a worker, oldest first
+	int m_nQueuedRows;																//Rows in m_Queue
+	int m_nBusyWorkers;																//Workers classifying a batch
+	map<int, shared_ptr<Connection>> m_mapConnections;								//Open connections, by socket
+	int m_nReaderCount;																//Reader threads running
+	bool m_bRunning;																//True between start() and stop()
+	bool m_bStopping;																//True once the workers should exit
+	SigmoidServerStats m_Stats;														//Totals so far
+
+	void runListener();																//Accepts connections until stopping, starting a reader for each
+	void runReader(shared_ptr<Connection> pConnection);								//Queues a connection's requests until it closes
+	void runWorker();																//Takes and classifies batches until stopping
+	bool canQueue(const Connection &connection, int rowcount) const;				//Returns true if rowcount more rows from connection fit under the caps
+	void respond(Connection &connection, uint32_t requestid,						//Writes one response. If it cannot be sent in time, drops the connection,
+			InferenceStatus status, const int *classifications, int rowcount);		//   which ends its reader.
+};
+
+class SigmoidInferenceClient
+{
+public:
+	SigmoidInferenceClient();														//Constructor. Not connected.
+	~SigmoidInferenceClient();														//Closes the connection, if open
+	bool connect(const string &address);											//Connects to a server. Returns false, with an error msg, on failure.
+	void disconnect();																//Closes the connection
+	bool classify(const float *features, int rowcount, int featurecount,			//Sends rowcount rows of features and waits for their classifications. Returns
+			int *classifications);													//   false, with an error msg, on failure.
+
+private:
+	int m_nSocket;																	//Connected socket, or -1
+	uint32_t m_nNextRequestId;														//requestId of the next request
+	vector<char> m_vecMessage;														//The request being sent, header and features together
+};
+
+//Constructor
+template <typename T>
+SigmoidInferenceServer<T>::SigmoidInferenceServer(const SigmoidClassifier<T> &network, int workercount, int maxbatchrows, int maxdelay) :
+m_Network(network), m_nInputCount(network.getNetworkLayers()[0]), m_nWorkerCount(workercount < 1 ? 1 : workercount),
+m_nMaxBatchRows(maxbatchrows < 1 ? 1 : maxbatchrows), m_MaxDelay(maxdelay < 0 ? 0 : maxdelay), m_nListenSocket(-1), m_nQueuedRows(0), m_nBusyWorkers(0),
+m_nReaderCount(0), m_bRunning(false), m_bStopping(false)
+{
+	m_Stats.nRequests = m_Stats.nRows = m_Stats.nBatches = m_Stats.nDroppedConnections = 0;
+	m_Stats.nConnections = 0;
+}
+
+template <typename T>
+SigmoidInferenceServer<T>::~SigmoidInferenceServer()
+{
+	stop();
+}
+
+template <typename T>
+bool SigmoidInferenceServer<T>::start(const string &address)
+{
+	if (m_bRunning)
+	{
+		cout << "ERROR: The server is already running.\n";
+		return false;
+	}
+	m_nListenSocket = openLocalSocket(address, true, true);
+	if (m_nListenSocket < 0)
+		return false;
+	m_strUnixPath = isTcpAddress(address) ? "" : address;
+	m_bRunning = true;
+	m_bStopping = false;
+	for (int i = 0; i < m_nWorkerCount; i++)
+		m_vecWorkers.push_back(thread(&SigmoidInferenceServer<T>::runWorker, this));
+	m_Listener = thread(&SigmoidInferenceServer<T>::runListener, this);
+	return true;
+}
+
+//Stops the listener first, so no connection is added, then shuts down every connection, which ends its reader, and
+// finally stops the workers
+template <typename T>
+void SigmoidInferenceServer<T>::stop()
+{
+	if (!m_bRunning)
+		return;
+	{
+		lock_guard<mutex> lock(m_Mutex);
+		m_bStopping = true;
+	}
+	m_RowsFreed.notify_all();
+	m_Listener.join();
+	close(m_nListenSocket);
+	m_nListenSocket = -1;
+	if (m_strUnixPath != "")
+		unlink(m_strUnixPath.c_str());
+
+	unique_lock<mutex> lock(m_Mutex);
+	for (auto it = m_mapConnections.begin(); it != m_mapConnections.end(); ++it)
+		shutdown(it->first, SHUT_RDWR);
+	m_ReadersDone.wait(lock, [this] { return m_nReaderCount == 0; });
+	m_Queue.clear();
+	m_nQueuedRows = 0;
+	lock.unlock();
+	m_QueueChanged.notify_all();
+	for (unsigned int i = 0; i < m_vecWorkers.size(); i++)
+		m_vecWorkers[i].join();
+	m_vecWorkers.clear();
+	m_bRunning = false;
+}
+
+//Polls, rather than blocking in accept(), so stop() is noticed within POLL_MS
+template <typename T>
+void SigmoidInferenceServer<T>::runListener()
+{
+	const int POLL_MS = 100;
+	while (true)
+	{
+		{
+			lock_guard<mutex> lock(m_Mutex);
+			if (m_bStopping)
+				return;
+		}
+		pollfd pfd;
+		pfd.fd = m_nListenSocket;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, POLL_MS) <= 0)
+			continue;
+		int nSocket = accept(m_nListenSocket, NULL, NULL);
+		if (nSocket < 0)
+			continue;
+		int nFlag = 1;
+		setsockopt(nSocket, IPPROTO_TCP, TCP_NODELAY, &nFlag, sizeof(nFlag));	//fails harmlessly on Unix domain sockets
+		timeval tvTimeout;
+		tvTimeout.tv_sec = INFERENCE_SEND_TIMEOUT_MS / 1000;
+		tvTimeout.tv_usec = INFERENCE_SEND_TIMEOUT_MS % 1000 * 1000;
+		setsockopt(nSocket, SOL_SOCKET, SO_SNDTIMEO, &tvTimeout, sizeof(tvTimeout));
+		shared_ptr<Connection> pConnection(new Connection(nSocket));
+		{
+			lock_guard<mutex> lock(m_Mutex);
+			m_mapConnections[nSocket] = pConnection;
+			m_nReaderCount++;
+			m_Stats.nConnections++;
+		}
+		thread(&SigmoidInferenceServer<T>::runReader, this, pConnection).detach();
+	}
+}
+
+//Reads each request whole, converting its features to T, before queuing it, so workers never wait on a socket. Once a
+// request's header is read, reading pauses until its rows fit under the queue caps, leaving the rest of what the client
+// sends in the socket. A request is always let in once nothing is queued, so every valid request fits eventually.
+template <typename T>
+void SigmoidInferenceServer<T>::runReader(shared_ptr<Connection> pConnection)
+{
+	SigmoidInferenceRequest request;
+	vector<float> vecFeatures;
+	while (readFully(pConnection->nSocket, &request, sizeof(request)) && request.magic == INFERENCE_REQUEST_MAGIC)
+	{
+		if ((int)request.featureCount != m_nInputCount || request.rowCount == 0 || request.rowCount > MAX_INFERENCE_ROWS)
+		{
+			respond(*pConnection, request.requestId, INFERENCE_BAD_REQUEST, NULL, 0);
+			break;
+		}
+		{
+			unique_lock<mutex> lock(m_Mutex);
+			m_RowsFreed.wait(lock, [&] { return m_bStopping || pConnection->bDropped || canQueue(*pConnection, (int)request.rowCount); });
+			if (m_bStopping || pConnection->bDropped)
+				break;
+		}
+		PendingRequest pending;
+		pending.nRowCount = (int)request.rowCount;
+		vecFeatures.resize((size_t)request.rowCount * request.featureCount);
+		if (!readFully(pConnection->nSocket, vecFeatures.data(), vecFeatures.size() * sizeof(float)))
+			break;
+		pending.pConnection = pConnection;
+		pending.nRequestId = request.requestId;
+		pending.vecFeatures.assign(vecFeatures.begin(), vecFeatures.end());
+		pending.tQueued = chrono::steady_clock::now();
+		{
+			lock_guard<mutex> lock(m_Mutex);
+			m_nQueuedRows += pending.nRowCount;
+			pConnection->nQueuedRows += pending.nRowCount;
+			m_Queue.push_back(move(pending));
+		}
+		m_QueueChanged.notify_one();
+	}
+
+	lock_guard<mutex> lock(m_Mutex);
+	m_mapConnections.erase(pConnection->nSocket);
+	m_Stats.nConnections--;
+	if (--m_nReaderCount == 0)
+		m_ReadersDone.notify_all();
+}
+
+//Waits for a request. If no other worker is classifying, there is nothing to wait behind, so the batch starts at once.
+// Otherwise, the worker waits for the batch to fill or its deadline to pass, whichever is first, or for the other
+// workers to go idle. Other workers may take the batch meanwhile, in which case this one starts over.
+template <typename T>
+void SigmoidInferenceServer<T>::runWorker()
+{
+	vector<PendingRequest> vecBatch;
+	vector<T> vecFeatures((size_t)m_nMaxBatchRows * m_nInputCount);
+	vector<int> vecClassifications(m_nMaxBatchRows);
+	unique_lock<mutex> lock(m_Mutex);
+	while (true)
+	{
+		m_QueueChanged.wait(lock, [this] { return m_bStopping || !m_Queue.empty(); });
+		if (m_bStopping)
+			return;
+		chrono::steady_clock::time_point tDeadline = m_Queue.front().tQueued + m_MaxDelay;
+		while (!m_bStopping && !m_Queue.empty() && m_nQueuedRows < m_nMaxBatchRows && m_nBusyWorkers > 0 && chrono::steady_clock::now() < tDeadline)
+			m_QueueChanged.wait_until(lock, tDeadline);
+		if (m_bStopping)
+			return;
+		if (m_Queue.empty())
+			continue;
+
+		int nRows = 0;
+		while (!m_Queue.empty() && (nRows == 0 || nRows + m_Queue.front().nRowCount <= m_nMaxBatchRows))
+		{
+			nRows += m_Queue.front().nRowCount;
+			m_Queue.front().pConnection->nQueuedRows -= m_Queue.front().nRowCount;
+			vecBatch.push_back(move(m_Queue.front()));
+			m_Queue.pop_front();
+		}
+		m_nQueuedRows -= nRows;
+		m_nBusyWorkers++;
+		bool bMore = !m_Queue.empty();
+		lock.unlock();
+		m_RowsFreed.notify_all();
+		if (bMore)
+			m_QueueChanged.notify_one();
+
+		//gather the batch's rows, classify them together, and answer each request from its share
+		if (vecFeatures.size() < (size_t)nRows * m_nInputCount)
+		{
+			vecFeatures.resize((size_t)nRows * m_nInputCount);
+			vecClassifications.resize(nRows);
+		}
+		T *pFeatures = vecFeatures.data();
+		for (unsigned int i = 0; i < vecBatch.size(); i++)
+			pFeatures = copy(vecBatch[i].vecFeatures.begin(), vecBatch[i].vecFeatures.end(), pFeatures);
+		m_Network.classifyBatch(vecFeatures.data(), nRows, vecClassifications.data(), NULL);
+		int nRow = 0;
+		for (unsigned int i = 0; i < vecBatch.size(); i++)
+		{
+			respond(*vecBatch[i].pConnection, vecBatch[i].nRequestId, INFERENCE_OK, vecClassifications.data() + nRow, vecBatch[i].nRowCount);
+			nRow += vecBatch[i].nRowCount;
+		}
+
+		lock.lock();
+		m_Stats.nRequests += vecBatch.size();
+		m_Stats.nRows += nRows;
+		m_Stats.nBatches++;
+		vecBatch.clear();
+		if (--m_nBusyWorkers == 0 && !m_Queue.empty())
+			m_QueueChanged.notify_all();
+	}
+}
+
+//A request larger than a cap is let in alone
+template <typename T>
+bool SigmoidInferenceServer<T>::canQueue(const Connection &connection, int rowcount) const
+{
+	return (connection.nQueuedRows == 0 || connection.nQueuedRows + rowcount <= MAX_CONNECTION_QUEUED_ROWS) &&
+		(m_nQueuedRows == 0 || m_nQueuedRows + rowcount <= MAX_QUEUED_ROWS);
+}
+
+//Header and classifications go out in one write, under the connection's lock, so concurrent responses never interleave.
+// The socket's send timeout (see runListener()) bounds the write. A write that fails or times out may have sent part of
+// a response, so the connection is dropped: shut down, which ends its reader, and never written to again.
+template <typename T>
+void SigmoidInferenceServer<T>::respond(Connection &connection, uint32_t requestid, InferenceStatus status, const int *classifications, int rowcount)
+{
+	static thread_local vector<char> vecMessage;
+	SigmoidInferenceResponse response;
+	response.magic = INFERENCE_RESPONSE_MAGIC;
+	response.requestId = requestid;
+	response.status = status;
+	response.rowCount = rowcount;
+	vecMessage.resize(sizeof(response) + rowcount * sizeof(int32_t));
+	memcpy(vecMessage.data(), &response, sizeof(response));
+	for (int i = 0; i < rowcount; i++)
+	{
+		int32_t nClassification = classifications[i];
+		memcpy(vecMessage.data() + sizeof(response) + i * sizeof(int32_t), &nClassification, sizeof(int32_t));
+	}
+	lock_guard<mutex> lock(connection.writeMutex);
+	if (connection.bDropped || writeFully(connection.nSocket, vecMessage.data(), vecMessage.size()))
+		return;
+	{
+		lock_guard<mutex> lockServer(m_Mutex);
+		connection.bDropped = true;
+		m_Stats.nDroppedConnections++;
+	}
+	shutdown(connection.nSocket, SHUT_RDWR);
+	m_RowsFreed.notify_all();
+}
+
+template <typename T>
+SigmoidServerStats SigmoidInferenceServer<T>::getStats() const
+{
+	lock_guard<mutex> lock(m_Mutex);
+	return m_Stats;
+}
+
+//Constructor
+SigmoidInferenceClient::SigmoidInferenceClient() : m_nSocket(-1), m_nNextRequestId(1)
+{}
+
+SigmoidInferenceClient::~SigmoidInferenceClient()
+{
+	disconnect();
+}
+
+bool SigmoidInferenceClient::connect(const string &address)
+{
+	disconnect();
+	m_nSocket = openLocalSocket(address, false, true);
+	return m_nSocket >= 0;
+}
+
+void SigmoidInferenceClient::disconnect()
+{
+	if (m_nSocket >= 0)
+		close(m_nSocket);
+	m_nSocket = -1;
+}
+
+bool SigmoidInferenceClient::classify(const float *features, int rowcount, int featurecount, int *classifications)
+{
+	SigmoidInferenceRequest request;
+	request.magic = INFERENCE_REQUEST_MAGIC;
+	request.requestId = m_nNextRequestId++;
+	request.rowCount = rowcount;
+	request.featureCount = featurecount;
+	m_vecMessage.resize(sizeof(request) + (size_t)rowcount * featurecount * sizeof(float));
+	memcpy(m_vecMessage.data(), &request, sizeof(request));
+	memcpy(m_vecMessage.data() + sizeof(request), features, (size_t)rowcount * featurecount * sizeof(float));
+	SigmoidInferenceResponse response;
+	if (m_nSocket < 0 || !writeFully(m_nSocket, m_vecMessage.data(), m_vecMessage.size()) || !readFully(m_nSocket, &response, sizeof(response)))
+	{
+		cout << "ERROR: Lost the connection to the inference server.\n";
+		return false;
+	}
+	if (response.magic != INFERENCE_RESPONSE_MAGIC || response.requestId != request.requestId || response.status != INFERENCE_OK ||
+		response.rowCount != (uint32_t)rowcount)
+	{
+		cout << "ERROR: The inference server rejected the request.\n";
+		return false;
+	}
+	if (!readFully(m_nSocket, classifications, rowcount * sizeof(int32_t)))
+	{
+		cout << "ERROR: Lost the connection to the inference server.\n";
+		return false;
+	}
+	return true;
+}
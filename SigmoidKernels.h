@@ -0,0 +1,229 @@
+///////////////////////////////////////////
+// Dense linear algebra kernels used by SigmoidLayer.
+//	All matrices are row-major and contiguous. The matrix-matrix kernels are cache-blocked: the operands are walked in
+//	KERNEL_BLOCK_ROWS x KERNEL_BLOCK_COLS tiles, KERNEL_BLOCK_DEPTH elements deep, so each tile of the weight matrix is
+//	reused across a whole block of samples while it is still in cache.
+//	The innermost loops (dot products, scaled vector sums and the sigmoid function) run on the vectorized kernels in
+//	SigmoidSimd.h, selected at runtime for the CPU. Every kernel is available for both float and double, and
+//	multiplyMatrixVector() for the int8 weights of a QuantizedSigmoidNetwork.
+//	The sigmoid comes in three implementations, chosen per network (see SigmoidActivation): exact, a lookup table with
+//	linear interpolation, and a rational approximation. Each approximation's maximum absolute error against the exact
+//	sigmoid is given below, measured over the whole float/double range on every ISA (tools/activation_check.cpp).
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <algorithm>
+#include <vector>
+#include "SigmoidSimd.h"
+
+using namespace std;
+
+enum SigmoidActivation																//Implementation of the sigmoid function
+{
+	ACTIVATION_EXACT,																//1 / (1 + e^-x), with a vectorized exp()
+	ACTIVATION_TABLE,																//Lookup table with linear interpolation. Scalar, no exp() or division.
+	ACTIVATION_RATIONAL																//0.5 + 0.5 * tanh(x / 2), with a vectorized rational tanh(). No exp().
+};
+
+namespace SigmoidKernels
+{
+	const int KERNEL_BLOCK_ROWS = 32;										//Rows of the result matrix per tile
+	const int KERNEL_BLOCK_COLS = 64;										//Columns of the result matrix per tile
+	const int KERNEL_BLOCK_DEPTH = 256;										//Length of the summed dimension per tile
+	const int SIGMOID_TABLE_RANGE = 16;										//The table covers -16 <= x <= 16. Outside, it returns sigmoid(+/-16).
+	const int SIGMOID_TABLE_STEPS = 32;										//Table entries per unit of x
+	const int SIGMOID_TABLE_SIZE = 2 * SIGMOID_TABLE_RANGE * SIGMOID_TABLE_STEPS + 1;
+	const double SIGMOID_TABLE_MAX_ERROR = 1.2e-5;							//Max absolute error of ACTIVATION_TABLE, double or float
+	const double SIGMOID_RATIONAL_MAX_ERROR = 2e-7;							//Max absolute error of ACTIVATION_RATIONAL, for doubles
+	const double SIGMOID_RATIONAL_MAX_ERROR_FLOAT = 4e-7;					//As above, for floats
+
+	double getVectorDotProduct(const double *v1, const double *v2, int n);	//Returns v1 . v2
+	float getVectorDotProduct(const float *v1, const float *v2, int n);
+	void addScaledVector(double *y, double a, const double *x, int n);		//Does y += a * x
+	void addScaledVector(float *y, float a, const float *x, int n);
+	void calculateSigmoid(double *v, int n);								//Does v[i] = 1 / (1 + e^-v[i]) for each element
+	void calculateSigmoid(float *v, int n);
+	template <typename T>
+	void calculateSigmoid(T *v, int n, SigmoidActivation activation);		//As above, with the given implementation
+	template <typename T>
+	void calculateSigmoidTable(T *v, int n);								//As above, by table lookup
+	void calculateSigmoidRational(double *v, int n);						//As above, by rational approximation
+	void calculateSigmoidRational(float *v, int n);
+	template <typename T>
+	double getSigmoidMaxError(SigmoidActivation activation);				//Returns the max absolute error of activation, for T
+	const char *getActivationName(SigmoidActivation activation);			//Returns "exact", "table" or "rational"
+	void multiplyMatrixVector(const int8_t *a, const uint8_t *x,			//Does y = A * x with 32-bit sums, where A is m x n int8 weights
+			int32_t *y, int m, int n);
+	template <typename T>
+	void multiplyMatrixTransposed(const T *a, const T *b,					//Does C = A * B^T, where A is m x k, B is n x k and C is m x n
+			T *c, int m, int n, int k);
+	template <typename T>
+	void multiplyMatrix(const T *a, const T *b,								//Does C = A * B, where A is m x k, B is k x n and C is m x n
+			T *c, int m, int n, int k);
+	template <typename T>
+	void addTransposedMatrixProduct(const T *a, const T *b,					//Does C += A^T * B, where A is k x m, B is k x n and C is m x n
+			T *c, int m, int n, int k);
+}
+
+//Returns dot product of vectors v1 and v2, each of length n.
+double SigmoidKernels::getVectorDotProduct(const double *v1, const double *v2, int n)
+{
+	return SigmoidSimd::g_Kernels.dot(v1, v2, n);
+}
+float SigmoidKernels::getVectorDotProduct(const float *v1, const float *v2, int n)
+{
+	return SigmoidSimd::g_Kernels.dotFloat(v1, v2, n);
+}
+
+//Adds a * x to y, elementwise. Both vectors are of length n.
+void SigmoidKernels::addScaledVector(double *y, double a, const double *x, int n)
+{
+	SigmoidSimd::g_Kernels.axpy(y, a, x, n);
+}
+void SigmoidKernels::addScaledVector(float *y, float a, const float *x, int n)
+{
+	SigmoidSimd::g_Kernels.axpyFloat(y, a, x, n);
+}
+
+//Applies the sigmoid function to each of the n elements of v, in place.
+void SigmoidKernels::calculateSigmoid(double *v, int n)
+{
+	SigmoidSimd::g_Kernels.sigmoid(v, n);
+}
+void SigmoidKernels::calculateSigmoid(float *v, int n)
+{
+	SigmoidSimd::g_Kernels.sigmoidFloat(v, n);
+}
+
+template <typename T>
+void SigmoidKernels::calculateSigmoid(T *v, int n, SigmoidActivation activation)
+{
+	if (activation == ACTIVATION_TABLE)
+		calculateSigmoidTable(v, n);
+	else if (activation == ACTIVATION_RATIONAL)
+		calculateSigmoidRational(v, n);
+	else
+		calculateSigmoid(v, n);
+}
+
+//The table holds sigmoid(x) every 1 / SIGMOID_TABLE_STEPS from -SIGMOID_TABLE_RANGE to SIGMOID_TABLE_RANGE, 8KB of
+// doubles, so it stays in L1 cache. Linear interpolation between entries h apart is off by at most h^2 / 8 times the
+// sigmoid's largest second derivative (0.0962), i.e. 1.2e-5. Beyond the table, the sigmoid is within 1.2e-7 of 0 or 1.
+template <typename T>
+void SigmoidKernels::calculateSigmoidTable(T *v, int n)
+{
+	static const vector<T> vecTable = []
+	{
+		vector<T> vecEntries(SIGMOID_TABLE_SIZE);
+		for (int k = 0; k < SIGMOID_TABLE_SIZE; k++)
+			vecEntries[k] = (T)(1 / (1 + exp(SIGMOID_TABLE_RANGE - (double)k / SIGMOID_TABLE_STEPS)));
+		return vecEntries;
+	}();
+	const T *pTable = vecTable.data();
+	for (int i = 0; i < n; i++)
+	{
+		T x = (min(max(v[i], (T)-SIGMOID_TABLE_RANGE), (T)SIGMOID_TABLE_RANGE) + SIGMOID_TABLE_RANGE) * SIGMOID_TABLE_STEPS;
+		int k = min((int)x, SIGMOID_TABLE_SIZE - 2);
+		v[i] = pTable[k] + (x - k) * (pTable[k + 1] - pTable[k]);
+	}
+}
+
+void SigmoidKernels::calculateSigmoidRational(double *v, int n)
+{
+	SigmoidSimd::g_Kernels.sigmoidRational(v, n);
+}
+void SigmoidKernels::calculateSigmoidRational(float *v, int n)
+{
+	SigmoidSimd::g_Kernels.sigmoidRationalFloat(v, n);
+}
+
+template <typename T>
+double SigmoidKernels::getSigmoidMaxError(SigmoidActivation activation)
+{
+	if (activation == ACTIVATION_TABLE)
+		return SIGMOID_TABLE_MAX_ERROR;
+	if (activation == ACTIVATION_RATIONAL)
+		return sizeof(T) == sizeof(float) ? SIGMOID_RATIONAL_MAX_ERROR_FLOAT : SIGMOID_RATIONAL_MAX_ERROR;
+	return sizeof(T) == sizeof(float) ? SigmoidSimd::SIMD_SIGMOID_TOLERANCE_FLOAT : SigmoidSimd::SIMD_SIGMOID_TOLERANCE;
+}
+
+const char *SigmoidKernels::getActivationName(SigmoidActivation activation)
+{
+	const char *NAMES[] = { "exact", "table", "rational" };
+	return NAMES[activation];
+}
+
+//y = A * x, for int8 weights A (m rows of n) and uint8 activations x. Exact: every ISA gives the same sums.
+void SigmoidKernels::multiplyMatrixVector(const int8_t *a, const uint8_t *x, int32_t *y, int m, int n)
+{
+	SigmoidSimd::g_Kernels.dotRowsInt8(a, x, y, m, n);
+}
+
+//C = A * B^T. Every element of C is the dot product of a row of A and a row of B, so both operands are read sequentially.
+// Used for the forward pass, where A holds one sample per row and B is a layer's weight matrix.
+template <typename T>
+void SigmoidKernels::multiplyMatrixTransposed(const T *a, const T *b, T *c, int m, int n, int k)
+{
+	fill(c, c + m * n, (T)0);
+	for (int kk = 0; kk < k; kk += KERNEL_BLOCK_DEPTH)
+	{
+		int nDepth = min(KERNEL_BLOCK_DEPTH, k - kk);
+		for (int ii = 0; ii < m; ii += KERNEL_BLOCK_ROWS)
+		{
+			int nRowEnd = min(ii + KERNEL_BLOCK_ROWS, m);
+			for (int jj = 0; jj < n; jj += KERNEL_BLOCK_COLS)
+			{
+				int nColEnd = min(jj + KERNEL_BLOCK_COLS, n);
+				for (int i = ii; i < nRowEnd; i++)
+					for (int j = jj; j < nColEnd; j++)
+						c[i * n + j] += getVectorDotProduct(a + i * k + kk, b + j * k + kk, nDepth);
+			}
+		}
+	}
+}
+
+//C = A * B. Each row of C is built up as a sum of rows of B scaled by the elements of the matching row of A.
+// Used to back propagate deltas, where A holds one sample's deltas per row and B is a layer's weight matrix.
+template <typename T>
+void SigmoidKernels::multiplyMatrix(const T *a, const T *b, T *c, int m, int n, int k)
+{
+	fill(c, c + m * n, (T)0);
+	for (int pp = 0; pp < k; pp += KERNEL_BLOCK_DEPTH)
+	{
+		int nDepthEnd = min(pp + KERNEL_BLOCK_DEPTH, k);
+		for (int jj = 0; jj < n; jj += KERNEL_BLOCK_COLS)
+		{
+			int nCols = min(KERNEL_BLOCK_COLS, n - jj);
+			for (int ii = 0; ii < m; ii += KERNEL_BLOCK_ROWS)
+			{
+				int nRowEnd = min(ii + KERNEL_BLOCK_ROWS, m);
+				for (int i = ii; i < nRowEnd; i++)
+					for (int p = pp; p < nDepthEnd; p++)
+						addScaledVector(c + i * n + jj, a[i * k + p], b + p * n + jj, nCols);
+			}
+		}
+	}
+}
+
+//C += A^T * B. Each row of A and B is one sample, so C accumulates the sum of the outer products of every sample.
+// Used to accumulate weight gradients, where A holds deltas and B holds the layer inputs, one sample per row.
+template <typename T>
+void SigmoidKernels::addTransposedMatrixProduct(const T *a, const T *b, T *c, int m, int n, int k)
+{
+	for (int ii = 0; ii < m; ii += KERNEL_BLOCK_ROWS)
+	{
+		int nRowEnd = min(ii + KERNEL_BLOCK_ROWS, m);
+		for (int jj = 0; jj < n; jj += KERNEL_BLOCK_COLS)
+		{
+			int nCols = min(KERNEL_BLOCK_COLS, n - jj);
+			for (int pp = 0; pp < k; pp += KERNEL_BLOCK_DEPTH)
+			{
+				int nDepthEnd = min(pp + KERNEL_BLOCK_DEPTH, k);
+				for (int p = pp; p < nDepthEnd; p++)
+					for (int i = ii; i < nRowEnd; i++)
+						addScaledVector(c + i * n + jj, a[p * m + i], b + p * n + jj, nCols);
+			}
+		}
+	}
+}
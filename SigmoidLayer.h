@@ -0,0 +1,182 @@
+///////////////////////////////////////////
+// A fully-connected layer of sigmoid neurons.
+//	Weights are stored as one contiguous row-major matrix (one row per neuron, one column per input) followed by a
+//	vector of bias weights, one per neuron. A layer does not own its weights: SigmoidNetwork allocates a single parameter
+//	buffer for all layers and binds each layer to its slice of that buffer with bindParams().
+//	Activations and deltas are likewise passed in by the caller, so one layer may be evaluated against any buffers.
+//	Batched functions take batchsize samples at once, stored one sample per row, and run on the kernels in SigmoidKernels.h.
+//	T is the scalar type of weights, inputs, outputs and deltas: float or double.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include "SigmoidKernels.h"
+
+using namespace std;
+
+template <typename T>
+class SigmoidLayer
+{
+public:
+	SigmoidLayer(int inputcount, int neuroncount, double bias);						//Constructor
+	void bindParams(T *params);														//Points the layer at its weights. params must hold getParamCount() weights
+	void initParams(double biaswt);													//Randomizes input weights and sets every bias weight to biaswt
+	void propagateForward(const T *inputs, T *outputs, int batchsize) const;		//outputs[b][j] = sigmoid(W[j] . inputs[b] + bias * biaswt[j]), for each sample b and neuron j
+	void propagateDeltas(const T *deltas, const T *prvoutputs,				//Back propagates this layer's deltas to the previous layer,
+			T *prvdeltas, int batchsize) const;										//   given the previous layer's outputs.
+	void updateWeights(const T *deltas, const T *inputs, double learningrate);		//Does W[j][k] -= learningrate * deltas[j] * inputs[k], and the same for bias weights
+	void accumulateGradients(const T *deltas, const T *inputs,				//Adds the weight gradients of batchsize samples to gradients, which is laid out
+			T *gradients, int batchsize) const;										//   as this layer's params
+	void applyGradients(const T *gradients, double learningrate);					//Does params[i] -= learningrate * gradients[i]
+	int getInputCount() const;														//Returns the number of inputs to each neuron (i.e. the row length of the weight matrix)
+	int getNeuronCount() const;														//Returns the number of neurons in the layer
+	int getParamCount() const;														//Returns the number of weights in the layer, including bias weights
+	double getBias() const;															//Returns m_dblBias
+	SigmoidActivation getActivation() const;										//Returns m_Activation
+	void setActivation(SigmoidActivation activation);								//Sets the sigmoid implementation propagateForward() uses. Default exact.
+	T *getWeights();																//Returns the weight matrix. Row j holds the weights of neuron j
+	const T *getWeights() const;
+	T *getBiasWeights();															//Returns the bias weight vector
+	const T *getBiasWeights() const;
+
+private:
+	int m_nInputCount;																//Number of inputs to each neuron
+	int m_nNeuronCount;																//Number of neurons in the layer
+	double m_dblBias;																//Bias of every neuron in the layer
+	SigmoidActivation m_Activation;													//Sigmoid implementation
+	T *m_pWeights;																	//Row-major m_nNeuronCount x m_nInputCount weight matrix. Bias weights follow it.
+};
+
+//Constructor. The layer has no weights until bindParams() is called.
+template <typename T>
+SigmoidLayer<T>::SigmoidLayer(int inputcount, int neuroncount, double bias) : m_nInputCount(inputcount),
+m_nNeuronCount(neuroncount), m_dblBias(bias), m_Activation(ACTIVATION_EXACT), m_pWeights(NULL)
+{}
+
+template <typename T>
+void SigmoidLayer<T>::bindParams(T *params)
+{
+	m_pWeights = params;
+}
+
+//Randomizes input weights to one of {-1.0, -0.9, ..., -0.6, 0.1, ..., 0.5} and sets bias weights to biaswt.
+template <typename T>
+void SigmoidLayer<T>::initParams(double biaswt)
+{
+	for (int i = 0; i < m_nInputCount * m_nNeuronCount; i++)
+	{
+		m_pWeights[i] = (T)(((double)(rand() % 10) + 1) / 10);
+		if (m_pWeights[i] > 0.5)
+			m_pWeights[i] *= -1;
+	}
+	T *pBiasWeights = getBiasWeights();
+	for (int j = 0; j < m_nNeuronCount; j++)
+		pBiasWeights[j] = (T)biaswt;
+}
+
+//Calculates the output of every neuron in the layer for each of batchsize samples, given the layer's inputs (i.e. the
+// outputs of the previous layer). inputs is batchsize x getInputCount() and outputs is batchsize x getNeuronCount().
+template <typename T>
+void SigmoidLayer<T>::propagateForward(const T *inputs, T *outputs, int batchsize) const
+{
+	const T *pBiasWeights = getBiasWeights();
+	SigmoidKernels::multiplyMatrixTransposed(inputs, m_pWeights, outputs, batchsize, m_nNeuronCount, m_nInputCount);
+	for (int b = 0; b < batchsize; b++)	//Summation of all params (including bias)
+		SigmoidKernels::addScaledVector(outputs + b * m_nNeuronCount, (T)m_dblBias, pBiasWeights, m_nNeuronCount);
+	SigmoidKernels::calculateSigmoid(outputs, batchsize * m_nNeuronCount, m_Activation);	//Sigmoid function, for the whole batch at once
+}
+
+//Sets prvdeltas[k] to the sum of this layer's deltas multiplied by the weights connecting them to input k, scaled by the
+// sigmoid derivative of the previous layer's output k. Done for each of batchsize samples, one sample per row.
+template <typename T>
+void SigmoidLayer<T>::propagateDeltas(const T *deltas, const T *prvoutputs, T *prvdeltas, int batchsize) const
+{
+	SigmoidKernels::multiplyMatrix(deltas, m_pWeights, prvdeltas, batchsize, m_nInputCount, m_nNeuronCount);
+	for (int k = 0; k < batchsize * m_nInputCount; k++)
+		prvdeltas[k] *= prvoutputs[k] * (1 - prvoutputs[k]);
+}
+
+//Adjusts weights by the given deltas of a single sample. inputs are the inputs the deltas were calculated from.
+template <typename T>
+void SigmoidLayer<T>::updateWeights(const T *deltas, const T *inputs, double learningrate)
+{
+	T *pBiasWeights = getBiasWeights();
+	for (int j = 0; j < m_nNeuronCount; j++)
+	{
+		SigmoidKernels::addScaledVector(m_pWeights + j * m_nInputCount, (T)-(learningrate * deltas[j]), inputs, m_nInputCount);
+		pBiasWeights[j] -= (T)(learningrate * deltas[j]);	//bias weight correction
+	}
+}
+
+//Adds the sum, over batchsize samples, of each weight's gradient (deltas[b][j] * inputs[b][k]) to gradients.
+template <typename T>
+void SigmoidLayer<T>::accumulateGradients(const T *deltas, const T *inputs, T *gradients, int batchsize) const
+{
+	T *pBiasGradients = gradients + m_nInputCount * m_nNeuronCount;
+	SigmoidKernels::addTransposedMatrixProduct(deltas, inputs, gradients, m_nNeuronCount, m_nInputCount, batchsize);
+	for (int b = 0; b < batchsize; b++)
+		for (int j = 0; j < m_nNeuronCount; j++)
+			pBiasGradients[j] += deltas[b * m_nNeuronCount + j];
+}
+
+//Adjusts weights by gradients accumulated with accumulateGradients()
+template <typename T>
+void SigmoidLayer<T>::applyGradients(const T *gradients, double learningrate)
+{
+	SigmoidKernels::addScaledVector(m_pWeights, (T)-learningrate, gradients, getParamCount());
+}
+
+///Accessors
+template <typename T>
+int SigmoidLayer<T>::getInputCount() const
+{
+	return m_nInputCount;
+}
+template <typename T>
+int SigmoidLayer<T>::getNeuronCount() const
+{
+	return m_nNeuronCount;
+}
+template <typename T>
+int SigmoidLayer<T>::getParamCount() const
+{
+	return (m_nInputCount + 1) * m_nNeuronCount;
+}
+template <typename T>
+double SigmoidLayer<T>::getBias() const
+{
+	return m_dblBias;
+}
+template <typename T>
+SigmoidActivation SigmoidLayer<T>::getActivation() const
+{
+	return m_Activation;
+}
+template <typename T>
+void SigmoidLayer<T>::setActivation(SigmoidActivation activation)
+{
+	m_Activation = activation;
+}
+template <typename T>
+T *SigmoidLayer<T>::getWeights()
+{
+	return m_pWeights;
+}
+template <typename T>
+const T *SigmoidLayer<T>::getWeights() const
+{
+	return m_pWeights;
+}
+template <typename T>
+T *SigmoidLayer<T>::getBiasWeights()
+{
+	return m_pWeights + m_nInputCount * m_nNeuronCount;
+}
+template <typename T>
+const T *SigmoidLayer<T>::getBiasWeights() const
+{
+	return m_pWeights + m_nInputCount * m_nNeuronCount;
+}
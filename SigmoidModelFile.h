@@ -0,0 +1,98 @@
+///////////////////////////////////////////
+// The binary file formats SigmoidNetwork::save() and QuantizedSigmoidNetwork::save() write, and their load()s read.
+//	A file is a SigmoidModelHeader, then the network topology (layerCount 32-bit layer sizes), then zero padding
+//	up to paramOffset, then every weight in the network, exactly as laid out in SigmoidNetwork's parameter buffer
+//	(for each layer: a row-major neuron x input weight matrix, followed by one bias weight per neuron).
+//	The weights start on a MODEL_PARAM_ALIGNMENT boundary so a memory-mapped file can be used in place.
+//	A quantized model file is a SigmoidQuantizedModelHeader, then the topology, then zero padding up to scaleOffset,
+//	then one float scale per neuron and one float bias term per neuron (every layer but the input layer, in order),
+//	then zero padding up to weightOffset, then every int8 weight: for each layer, one row per neuron, each row padded
+//	with zeros to a multiple of QUANTIZED_ROW_ALIGNMENT inputs. See QuantizedSigmoidNetwork.h.
+//	A checkpoint file (see SigmoidCheckpointer.h) is a SigmoidCheckpointHeader, then the topology, then paramCount
+//	weights, velocityCount optimizer velocities and secondMomentCount Adam second moments, each of scalarSize bytes.
+//	Its checksum covers everything after the header, so a torn or corrupted checkpoint is never resumed from.
+//	All values are stored in the byte order of the machine that wrote them.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+const char MODEL_MAGIC[8] = { 'S', 'I', 'G', 'N', 'E', 'T', '\0', '\0' };	//First 8 bytes of every model file
+const uint32_t MODEL_VERSION = 1;											//Bumped whenever the layout changes
+const uint32_t MODEL_PARAM_ALIGNMENT = 64;									//Weights start on a multiple of this many bytes
+const char QUANTIZED_MODEL_MAGIC[8] = { 'S', 'I', 'G', 'Q', 'N', 'E', 'T', '\0' };	//First 8 bytes of every quantized model file
+const uint32_t QUANTIZED_MODEL_VERSION = 1;									//Bumped whenever the quantized layout changes
+const uint32_t QUANTIZED_ROW_ALIGNMENT = 16;								//Each neuron's weights are padded to a multiple of this many
+const char CHECKPOINT_MAGIC[8] = { 'S', 'I', 'G', 'C', 'K', 'P', 'T', '\0' };	//First 8 bytes of every checkpoint file
+const uint32_t CHECKPOINT_VERSION = 1;										//Bumped whenever the checkpoint layout changes
+
+struct SigmoidModelHeader
+{
+	char magic[8];															//MODEL_MAGIC
+	uint32_t version;														//MODEL_VERSION
+	uint32_t scalarSize;													//Bytes per weight: 4 (float) or 8 (double)
+	uint32_t layerCount;													//Number of layers, including the input layer
+	uint32_t epochCount;													//Training epochs the weights have been through
+	double learningRate;													//Learning rate the network was trained with
+	double bias;															//Bias of every neuron
+	uint32_t batchSize;														//Batch size the network was trained with
+	uint32_t reserved;
+	uint64_t paramCount;													//Number of weights, including bias weights
+	uint64_t paramOffset;													//Byte offset of the first weight from the start of the file
+};
+
+struct SigmoidQuantizedModelHeader
+{
+	char magic[8];															//QUANTIZED_MODEL_MAGIC
+	uint32_t version;														//QUANTIZED_MODEL_VERSION
+	uint32_t layerCount;													//Number of layers, including the input layer
+	uint32_t neuronCount;													//Number of neurons, excluding the input layer
+	uint32_t rowAlignment;													//QUANTIZED_ROW_ALIGNMENT
+	uint64_t weightCount;													//Number of int8 weights, including row padding
+	uint64_t scaleOffset;													//Byte offset of the first scale from the start of the file
+	uint64_t weightOffset;													//Byte offset of the first weight from the start of the file
+};
+
+struct SigmoidCheckpointHeader
+{
+	char magic[8];															//CHECKPOINT_MAGIC
+	uint32_t version;														//CHECKPOINT_VERSION
+	uint32_t scalarSize;													//Bytes per weight and optimizer value: 4 (float) or 8 (double)
+	uint32_t layerCount;													//Number of layers, including the input layer
+	uint32_t epochCount;													//Training epochs done when the checkpoint was taken
+	double learningRate;													//Base learning rate
+	double bias;															//Bias of every neuron
+	uint32_t batchSize;														//Rows per weight update
+	uint32_t optimizerType;													//OptimizerType
+	double momentum;														//Optimizer momentum, or Adam's beta1
+	double beta2;															//Adam's second moment decay
+	uint64_t optimizerSteps;												//Adam steps taken
+	uint32_t shuffle;														//1 = the training stream shuffles its rows
+	uint32_t shuffleSeed;													//The training stream's shuffle seed
+	uint32_t passCount;														//Passes the training stream has started
+	uint32_t reserved;
+	uint64_t paramCount;													//Number of weights, including bias weights
+	uint64_t velocityCount;													//Number of optimizer velocities. 0 for SGD.
+	uint64_t secondMomentCount;												//Number of Adam second moments. 0 unless Adam.
+	uint64_t checksum;														//64-bit FNV-1a hash of every byte after the header
+};
+
+//Reads layercount 32-bit layer sizes from the topology following a file's header. Returns false if any is not positive.
+inline bool readModelTopology(const char *topology, uint32_t layercount, vector<int> &layers)
+{
+	layers.resize(layercount);
+	for (uint32_t i = 0; i < layercount; i++)
+	{
+		int32_t n;
+		memcpy(&n, topology + i * sizeof(int32_t), sizeof(n));
+		if (n <= 0)
+			return false;
+		layers[i] = n;
+	}
+	return true;
+}
@@ -1,10 +1,37 @@
 ///////////////////////////////////////////
 // An abstraction of a nueral network of sigmoid "nuerons".
-//	Network topology is described with m_pNetworkLayers and m_nLayerCount and implemented as a matrix
+//	Network topology is described with m_pNetworkLayers and m_nLayerCount and implemented as a list of SigmoidLayers.
+//	All weights live in one contiguous parameter buffer (layer by layer, each a row-major weight matrix followed by its
+//	bias weights). Neuron outputs and deltas live in a SigmoidWorkspace, one per thread.
+//	With a batch size above 1 (see setBatchSize()), doTraining() runs forward and backward passes over a whole batch of
+//	rows as matrix-matrix products and applies the summed weight gradients once per batch.
+//	With more than one training thread (see setTrainingThreads()), doTraining() spreads rows across a thread pool, either
+//	synchronously (each batch is split across threads and their gradients summed in thread order before one update, so
+//	results are deterministic for a given thread count) or Hogwild-style (each thread learns from its own shard of the
+//	training set and updates the shared weights without locking). Hogwild's unsynchronized reads and writes of plain T
+//	weights are a data race, which C++ leaves undefined. It relies on aligned scalar loads and stores not tearing, which
+//	holds for GCC and Clang on x86-64 and AArch64, and is never used unless asked for.
+//	classifyBatch() is a const inference path: it only reads weights and runs in a caller-supplied (or thread-local)
+//	workspace, so any number of threads may classify with one network at once, as long as none of them is training it.
+//	save() writes the network to a versioned binary file (see SigmoidModelFile.h) and load() reads one back, optionally
+//	memory-mapping it so the weights are used in place, without being copied or parsed.
+//	After every training epoch, the callback given to setEpochCallback() receives the epoch's metrics: its wall time,
+//	samples/sec and mean loss and, when built with SIGMOID_TELEMETRY, its time by phase and layer (see SigmoidTelemetry.h).
+//	stopTraining() asks doTraining() to return at the end of the current epoch, e.g. when SigmoidValidator sees
+//	validation accuracy stop improving.
+//	Weight updates go through a SigmoidOptimizer (see SigmoidOptimizer.h): plain SGD by default, or SGD with momentum,
+//	Nesterov momentum or Adam via setOptimizer(), at a learning rate setLearningRateSchedule() may vary by epoch.
+//	Once its workspaces are sized, training on a SigmoidDataSet and classifying make no heap allocations.
+//	With a gradient reducer (see setGradientReducer()), every batch's gradients are passed to it before they are
+//	applied, so replicas of the network in several processes, each training on its own shard, can sum their gradients
+//	(see SigmoidRing.h) and make identical updates.
+//	getTrainingState() and setTrainingState() copy out and restore everything training depends on (weights, epoch count
+//	and optimizer state), so SigmoidCheckpointer can checkpoint a run and resume it exactly.
 // See inline documentation for more info.
 //
+//	T is the scalar type of every weight, activation and feature: float or double. float halves the size of the weight,
+//	workspace and data buffers and doubles the number of elements per SIMD op.
 //TODO: Allow randomized or pre-specified param weights. 
-//		templatize  
 //
 /// Author: Dustin Fast, June 2017
 
@@ -12,220 +39,1049 @@
 #include <vector>
 #include <numeric>
 #include <iostream>
-#include "Sigmoid.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <chrono>
+#include <atomic>
+#include <limits>
+#include <unistd.h>
+#include "SigmoidLayer.h"
+#include "SigmoidWorkspace.h"
+#include "ThreadPool.h"
+#include "MappedFile.h"
+#include "SigmoidModelFile.h"
 #include "SigmoidDataRow.h"
+#include "SigmoidDataSet.h"
+#include "SigmoidDataStream.h"
+#include "SigmoidClassifier.h"
+#include "SigmoidTelemetry.h"
+#include "SigmoidOptimizer.h"
 
 using namespace std;
 
-class SigmoidNetwork
+enum ParallelMode
+{
+	PARALLEL_SYNCHRONOUS,																	//Threads share each batch. Gradients are summed, then applied once.
+	PARALLEL_HOGWILD																		//Threads learn from their own shard and update weights without locking.
+																							//   A data race, so undefined behaviour in C++: opt-in only, never the default.
+};
+
+template <typename T>
+using SigmoidGradientReducer = function<bool(T *gradients, int count)>;					//Combines a batch's gradients with other replicas', in place. Returns false on failure.
+
+template <typename T>
+struct SigmoidTrainingState																	//Everything training needs to carry on exactly where it stopped (see SigmoidCheckpointer.h)
+{
+	vector<int> vecLayers;																	//Topology, including the input layer
+	double dblLearningRate;																	//Base learning rate, before any schedule
+	double dblBias;																			//Bias of every neuron
+	int nBatchSize;																			//Rows per weight update
+	int nEpochCount;																		//Epochs trained
+	OptimizerType optimizerType;															//Weight update rule
+	double dblMomentum;																		//Optimizer momentum, or Adam's beta1
+	double dblBeta2;																		//Adam's second moment decay
+	long long nOptimizerSteps;																//Adam steps taken
+	vector<T> vecParams;																	//Every weight and bias weight, in parameter buffer order
+	vector<T> vecVelocity;																	//Optimizer velocity, or Adam's first moment. Empty for SGD.
+	vector<T> vecSecondMoment;																//Adam's second moment. Empty unless Adam.
+	bool bShuffle;																			//The rest is the training stream's row order, if any, kept by SigmoidCheckpointer:
+	unsigned int nShuffleSeed;																//   whether it shuffles, its seed and its passes started. Ignored by the network.
+	int nPassCount;
+};
+
+template <typename T>
+class SigmoidNetwork : public SigmoidClassifier<T>
 {
 public:
 	SigmoidNetwork(const int *networklayers, int layercount,								//Constructor
 			double learningrate, double bias, double biaswt, bool verbose);								   
 
-	void doTraining(const vector<SigmoidDataRow> &trainingset, int iterationcount);			//It does this iterationcount times.
-	void propagateForward(const vector<double> &params);									//Start the process of the neuron firings, given input params, through hidden layers, to output layer.
-	int getClassification(const vector<double> &params);									//Returns the neural network's output, given input params. The result is the index 
+	void doTraining(const vector<SigmoidDataRow<T>> &trainingset, int iterationcount);		//It does this iterationcount times.
+	void doTraining(const SigmoidDataSet<T> &trainingset, int iterationcount);				//As above, reading rows in place from a data set
+	void doTraining(SigmoidDataStream<T> &trainingstream, int iterationcount);				//As above, streaming rows from a data file a chunk at a time
+	void propagateForward(const vector<T> &params);											//Start the process of the neuron firings, given input params, through hidden layers, to output layer.
+	int getClassification(const vector<T> &params);											//Returns the neural network's output, given input params. The result is the index 
 																							//   of the output neuron having the highest numeric result, from top to bottom.
+	int getClassification(const T *params) const;											//As above, without touching the network. Thread-safe.
+	void classifyBatch(const T *features, int rowcount,								//Classifies rowcount rows of features (rowcount x input count, row-major), writing
+			int *classifications, T *scores, SigmoidWorkspace<T> &ws) const;				//   each row's class index to classifications and, if scores is not NULL, its
+																							//   output layer values to scores (rowcount x output count). Thread-safe.
+	void classifyBatch(const T *features, int rowcount,								//As above, using a workspace local to the calling thread
+			int *classifications, T *scores) const;
+	void classifyBatch(const SigmoidDataRow<T> *rows, int rowcount,							//As above, for rowcount SigmoidDataRows
+			int *classifications, T *scores) const;
+	SigmoidWorkspace<T> createWorkspace(int rowcapacity) const;								//Returns a workspace for classifying up to rowcapacity rows at a time
+	bool save(const string &filename) const;												//Writes the network to filename. Returns false, with an error msg, on failure.
+	static unique_ptr<SigmoidNetwork<T>> load(const string &filename, bool mapped,				//Reads a network written by save(). If mapped, the file is memory-mapped and its
+			bool verbose);																	//   weights used in place. Returns NULL, with an error msg, on failure.
+	unique_ptr<SigmoidNetwork<T>> clone() const;											//Returns a copy of the network's topology, bias, learning rate and weights, not
+																							//   mapped, with a batch size of 1 and one training thread
+	void stopTraining();																	//Asks doTraining() to return after the current epoch. Safe to call from any thread.
 	void printNeuronWeights();																//Outputs Neuron Weights
+	int getLayerCount() const;																//Returns m_nLayerCount
+	const int *getNetworkLayers() const;													//Returns m_pNetworkLayers
+	int getParamCount() const;																//Returns m_nParamCount
+	double getBias() const;																	//Returns m_dblBias
+	int getEpochCount() const;																//Returns m_nEpochCount
+	double getLearningRate() const;															//Returns m_dblLearningRate, the base rate before any schedule
+	int getBatchSize() const;																//Returns m_nBatchSize
+	SigmoidActivation getActivation() const;												//Returns the sigmoid implementation every layer uses
+	void setActivation(SigmoidActivation activation);										//Sets the sigmoid implementation every layer uses. Default exact. Not saved.
+	void getParams(T *params) const;														//Copies every weight to params, in parameter buffer order
+	void setParams(const T *params);														//Sets every weight from params, in parameter buffer order
+	void setBatchSize(int batchsize);														//Sets the number of rows doTraining() learns from per weight update. Default 1.
+	void setTrainingThreads(int threadcount, ParallelMode mode);							//Sets the number of threads doTraining() runs on, and how they share work. Default 1.
+	void setEpochCallback(const SigmoidEpochCallback &callback);							//Sets the function doTraining() passes each epoch's metrics to. Default none.
+	void setOptimizer(OptimizerType type, double momentum, double beta2);					//Sets the weight update rule (see SigmoidOptimizer.h) and zeroes its state.
+																							//   Default OPTIMIZER_SGD. Not saved or cloned.
+	void setLearningRateSchedule(const LearningRateSchedule &schedule);						//Sets the function giving each epoch's learning rate. Default none (constant).
+	void setGradientReducer(const SigmoidGradientReducer<T> &reducer);						//Sets the function every batch's summed gradients pass through before they are
+																							//   applied. Default none. Not saved or cloned.
+	const SigmoidOptimizer<T> &getOptimizer() const;										//Returns m_Optimizer
+	void getTrainingState(SigmoidTrainingState<T> &state) const;							//Copies the weights, epoch count and optimizer state into state, reusing its buffers
+	bool setTrainingState(const SigmoidTrainingState<T> &state);							//Restores them, and the batch size and optimizer, from state. Returns false, with
+																							//   an error msg, if state's topology or bias differ from the network's.
 
 private:
+	SigmoidNetwork();																		//Constructor for load(). Leaves the network empty.
+	void buildLayers(const int *networklayers, int layercount, double bias);				//Sets the topology and creates the layers, with no weights
+	void bindParams(T *params);																//Points m_pParams, and each layer, at params
+
 	int m_nInputCount;																		//Number of inputs to each neuron.
 	int m_nOutputCount;																		//Number of output layers in the network. 
 	int m_nLayerCount;																		//Number of layers in network, including input layer. Should be m_pNetworkLayers.size()
 	double m_dblLearningRate;
+	double m_dblEpochLearningRate;															//Learning rate of the epoch in progress, per m_LearningRateSchedule
+	double m_dblBias;																		//Bias of every neuron
+	int m_nEpochCount;																		//Training epochs done, including those done before the network was saved
 	bool m_bVerbose;																		//Verbose mode outputs the error per iteration to the console
-	const int *m_pNetworkLayers;															//Array representation of the network layers.
+	const int *m_pNetworkLayers;															//Array representation of the network layers. Points into m_vecNetworkLayers.
 																							//   Ex: {3, 4, 2} denotes 3 inputs, 1 hidden layer of 4 neuerons, and 2 output neurons
-	double doLearn(double expectedresult, const vector<double> &params);					//Trains the sigmoid network, given input params and expected result
-	void updateLayerInputs(int layerindex, const vector<double> &params);					//Function to set the neuron inputs to params in layer at index layerindex
-	vector<double> getExpectedOutputVector(int expectedclassification);						//Returns a vector to be used to compare expected outputs per output neuron. 
-	
-	vector<vector<Sigmoid>> m_Network;														//A matrix representation of the neural network.
-																							//   Ex: Given m_pNetwork = {3, 4, 2}, m_Network looks like:
-																							//		I I I X
-																							//      S S S S
-																							//		S S X X
-																							//   (Note that the I's are just placeholder objects used for convenience in indexing with m_pNetworkLayers. 
-																							//		they are not actually referenced anywhere.
+	vector<int> m_vecNetworkLayers;															//The network's own copy of the topology it was built with
+	int m_nBatchSize;																		//Rows per weight update in doTraining(). 1 = update after every row.
+	int m_nThreadCount;																		//Threads doTraining() runs on
+	ParallelMode m_ParallelMode;															//How training threads share work, when m_nThreadCount > 1
+	double doLearn(SigmoidWorkspace<T> &ws, int expectedresult, const T *params);			//Trains the sigmoid network, given input params and expected result
+	double doLearnBatch(SigmoidWorkspace<T> &ws, const T *features,						//Trains the sigmoid network on rowcount rows at once, with a single weight update
+			const int32_t *labels, int rowcount);
+	double computeGradients(SigmoidWorkspace<T> &ws, const T *features,					//Sums the weight gradients of rowcount rows into ws, without updating weights.
+			const int32_t *labels, int rowcount);											//   Returns the summed output layer error.
+	void applyGradients(T *gradients);														//Passes gradients through m_GradientReducer, if set, then updates the weights
+	double doTrainingPass(const SigmoidDataSet<T> &trainingset, double &losstotal);		//One pass over the training set, per the thread count and parallel mode.
+																							//   Adds every row's output layer error to losstotal.
+	double doTrainingEpoch(const SigmoidDataSet<T> &trainingset, double &losstotal);		//One pass over the training set on the calling thread
+	double doTrainingEpochSynchronous(const SigmoidDataSet<T> &trainingset,				//One pass over the training set, each batch split across the thread pool
+			double &losstotal);
+	double doTrainingEpochHogwild(const SigmoidDataSet<T> &trainingset,					//One pass over the training set, one shard per thread, with lock-free updates
+			double &losstotal);
+	void reportEpoch(int rowcount, chrono::steady_clock::time_point start,					//Passes the metrics of the epoch just done to m_EpochCallback, if set, and
+			double losstotal, double lasterror);											//   resets every workspace's training times
+	void propagateForward(SigmoidWorkspace<T> &ws, const T *inputs, int rowcount) const;	//Runs rowcount rows of inputs through the network, leaving outputs in ws
+	int getHighestOutput(const T *outputs) const;											//Returns the index of the highest of m_nOutputCount outputs
+	SigmoidWorkspace<T> &getThreadWorkspace() const;										//Returns the calling thread's inference workspace, sized for this network
+	double setOutputDeltas(SigmoidWorkspace<T> &ws, const int32_t *expectedresults,			//Sets output layer deltas for rowcount rows and returns their summed error
+			int rowcount);
+	void allocateWorkspace(SigmoidWorkspace<T> &ws, bool gradients);						//Sizes ws for m_nBatchSize rows of this network
+	bool needsGradients() const;															//Returns true if m_Workspace must hold a gradient buffer
+	void beginEpoch();																		//Sets m_dblEpochLearningRate for the epoch about to start
 
+	vector<SigmoidLayer<T>> m_vecLayers;													//The network's layers, excluding the input layer. i.e. m_vecLayers[i - 1] is layer i.
+	T *m_pParams;																			//Every weight in the network. Each layer is bound to its slice of it.
+																							//   Points into m_vecParams, or into m_pModelFile for a mapped network.
+	int m_nParamCount;																		//Number of weights in m_pParams
+	vector<T> m_vecParams;																	//Storage for m_pParams, unless the network is mapped
+	shared_ptr<MappedFile> m_pModelFile;													//The file a mapped network's weights live in
+	SigmoidWorkspace<T> m_Workspace;														//Scratch buffers for the calling thread
+	vector<SigmoidWorkspace<T>> m_vecThreadWorkspaces;										//Scratch buffers for each training thread
+	vector<double> m_vecShardErrors;														//Each training thread's shard error (synchronous) or last row (or batch) error
+	vector<double> m_vecShardLosses;														//Summed error of each training thread's shard
+	unique_ptr<ThreadPool> m_pThreadPool;													//Training threads. Only created when m_nThreadCount > 1.
+	SigmoidEpochCallback m_EpochCallback;													//Receives each epoch's metrics. May be empty.
+	SigmoidEpochMetrics m_EpochMetrics;														//Metrics passed to m_EpochCallback, kept so their buffers are reused
+	atomic<bool> m_bStopRequested;															//Set by stopTraining(). Cleared when doTraining() starts.
+	SigmoidOptimizer<T> m_Optimizer;														//Turns gradients into weight updates. Its state is sized to m_nParamCount.
+	LearningRateSchedule m_LearningRateSchedule;											//Gives each epoch's learning rate. May be empty.
+	SigmoidGradientReducer<T> m_GradientReducer;											//Combines each batch's gradients across replicas. May be empty.
+
+	static const double OUTPUT_HIGH;														//Expected output of the output neuron matching a row's label
+	static const double OUTPUT_LOW;															//Expected output of every other output neuron
+	static const int INFERENCE_BATCH_ROWS;													//Rows per forward pass in thread-local inference workspaces
 };
 
+template <typename T>
+const double SigmoidNetwork<T>::OUTPUT_HIGH = .9;	//.9 is the "pulled up" output
+template <typename T>
+const double SigmoidNetwork<T>::OUTPUT_LOW = .1;	//.1 is the "pulled down" sigmoid output
+template <typename T>
+const int SigmoidNetwork<T>::INFERENCE_BATCH_ROWS = 256;
+
 //Constructor
-SigmoidNetwork::SigmoidNetwork(const int *networklayers, int layercount, double learningrate, double bias, double biaswt, bool verbose)
+template <typename T>
+SigmoidNetwork<T>::SigmoidNetwork(const int *networklayers, int layercount, double learningrate, double bias, double biaswt, bool verbose)
 {
 	//Ini vars
+	m_dblLearningRate = learningrate;
+	m_dblEpochLearningRate = learningrate;
+	m_bVerbose = verbose;
+	m_nBatchSize = 1;
+	m_nThreadCount = 1;
+	m_ParallelMode = PARALLEL_SYNCHRONOUS;
+	m_nEpochCount = 0;
+	m_bStopRequested = false;
+
+	//build layers, then size the parameter buffer to fit them and initialize each layer's weights. The original network
+	// gave each input neuron networklayers[0] unused weights, drawn from rand() before any other layer's, so they are
+	// drawn and discarded here to keep the initial weights of a given seed unchanged.
+	buildLayers(networklayers, layercount, bias);
+	m_vecParams.assign(m_nParamCount, 0);
+	bindParams(m_vecParams.data());
+	for (int i = 0; i < networklayers[0] * networklayers[0]; i++)
+		rand();
+	for (unsigned int i = 0; i < m_vecLayers.size(); i++)
+		m_vecLayers[i].initParams(biaswt);
+	allocateWorkspace(m_Workspace, false);
+}
+
+template <typename T>
+SigmoidNetwork<T>::SigmoidNetwork() : m_nInputCount(0), m_nOutputCount(0), m_nLayerCount(0), m_dblLearningRate(0), m_dblEpochLearningRate(0), m_dblBias(0),
+m_nEpochCount(0), m_bVerbose(false), m_pNetworkLayers(NULL), m_nBatchSize(1), m_nThreadCount(1), m_ParallelMode(PARALLEL_SYNCHRONOUS),
+m_pParams(NULL), m_nParamCount(0), m_bStopRequested(false)
+{}
+
+template <typename T>
+void SigmoidNetwork<T>::buildLayers(const int *networklayers, int layercount, double bias)
+{
+	m_vecNetworkLayers.assign(networklayers, networklayers + layercount);
+	m_pNetworkLayers = m_vecNetworkLayers.data();
 	m_nInputCount = networklayers[0];
 	m_nOutputCount = networklayers[layercount - 1];
 	m_nLayerCount = layercount;
-	m_pNetworkLayers = networklayers;
-	m_dblLearningRate = learningrate;
-	m_bVerbose = verbose;
-	//build network matrix representation
-	vector<vector<Sigmoid>> t(m_nLayerCount);
-	for (int i = 0; i < m_nLayerCount; i++)
+	m_dblBias = bias;
+	m_nParamCount = 0;
+	m_vecLayers.clear();
+	for (int i = 1; i < m_nLayerCount; i++)
 	{
-		for (int j = 0; j < m_pNetworkLayers[i]; j++)
-		{
-			int n = 0;
-			if (i != 0)
-				n = i - 1;
-			Sigmoid s(networklayers[n], bias, biaswt);
-			t[i].push_back(s);
-		}
+		m_vecLayers.push_back(SigmoidLayer<T>(m_pNetworkLayers[i - 1], m_pNetworkLayers[i], bias));
+		m_nParamCount += m_vecLayers.back().getParamCount();
+	}
+}
+
+//Binds each layer to its slice of params, in order
+template <typename T>
+void SigmoidNetwork<T>::bindParams(T *params)
+{
+	m_pParams = params;
+	for (unsigned int i = 0; i < m_vecLayers.size(); i++)
+	{
+		m_vecLayers[i].bindParams(params);
+		params += m_vecLayers[i].getParamCount();
 	}
-	m_Network = t;
 }
 
 // Helper function for doLearn()
 // Calls private doLearn(expectedresult, paramvector) for every row in data set. It does this iterationcount times
 // outputs the RMS as calculated just before the last learning epoch
-void SigmoidNetwork::doTraining(const vector<SigmoidDataRow> & trainingset, int iterationcount)
+template <typename T>
+void SigmoidNetwork<T>::doTraining(const vector<SigmoidDataRow<T>> & trainingset, int iterationcount)
+{
+	doTraining(SigmoidDataSet<T>(trainingset), iterationcount);
+}
+
+//As above, for a SigmoidDataSet<T>. Rows are read straight from the set's feature matrix, so a set mapped from a binary
+// data file is trained on without ever being copied.
+template <typename T>
+void SigmoidNetwork<T>::doTraining(const SigmoidDataSet<T> &trainingset, int iterationcount)
 {
-	if (iterationcount < 1 || trainingset.size() < 1)
+	if (iterationcount < 1 || trainingset.getRowCount() < 1)
 		cout << "ERROR: Invalid iteration count or data set size.\n";
+	else if (trainingset.getParamCount() != m_nInputCount)
+		cout << "ERROR: Training set parameter count does not match the network's input count.\n";
 	else
 	{
 		double nError = 0;
-		for (int i = 0; i < iterationcount; i++)
+		m_bStopRequested = false;
+		for (int i = 0; i < iterationcount && !m_bStopRequested; i++)
 		{
-			for (auto row : trainingset)
+			chrono::steady_clock::time_point tStart = chrono::steady_clock::now();
+			double dblLossTotal = 0;
+			beginEpoch();
+			nError = doTrainingPass(trainingset, dblLossTotal);
+			m_nEpochCount++;
+			reportEpoch(trainingset.getRowCount(), tStart, dblLossTotal, nError);
+			if (m_bVerbose)
+				cout << i + 1 << "," << nError << endl; //output epoch number and delta from the doLearn function.
+		}
+	}
+}
+
+//As above, streaming the training set from trainingstream a chunk at a time, so the whole set is never in memory.
+// Each chunk is learned from as if it were a whole training set; batches do not span chunks.
+template <typename T>
+void SigmoidNetwork<T>::doTraining(SigmoidDataStream<T> &trainingstream, int iterationcount)
+{
+	if (iterationcount < 1)
+		cout << "ERROR: Invalid iteration count.\n";
+	else if (trainingstream.getParamCount() != m_nInputCount)
+		cout << "ERROR: Training set parameter count does not match the network's input count.\n";
+	else
+	{
+		m_bStopRequested = false;
+		for (int i = 0; i < iterationcount && !m_bStopRequested; i++)
+		{
+			double nError = 0;
+			chrono::steady_clock::time_point tStart = chrono::steady_clock::now();
+			double dblLossTotal = 0;
+			int nRows = 0;
+			beginEpoch();
+			trainingstream.rewind();
+			for (const SigmoidDataSet<T> *pChunk = trainingstream.next(); pChunk; pChunk = trainingstream.next())
 			{
-				nError = doLearn(row.getExpectedResult(), row.getParams());
-				if (nError == 0)
-					cout << "Here";
+				nError = doTrainingPass(*pChunk, dblLossTotal);
+				nRows += pChunk->getRowCount();
 			}
+			if (trainingstream.hasFailed())
+				return;
+			m_nEpochCount++;
+			reportEpoch(nRows, tStart, dblLossTotal, nError);
 			if (m_bVerbose)
 				cout << i + 1 << "," << nError << endl; //output epoch number and delta from the doLearn function.
 		}
 	}
 }
 
-//Adjust input weights via back propogation. The execution of this function constitutes one training epoch.
-//Called from doTraining(). Returns output layer RMS error as it was calculated before weight adjustments.
-double SigmoidNetwork::doLearn(double expectedresult, const vector<double> &params)
+//Learns from every row of trainingset once, on the calling thread or the thread pool. Returns the error of the last
+// row (or batch), and adds the error of every row to losstotal. With a gradient reducer, threads always share batches
+// synchronously, since every update must pass through it.
+template <typename T>
+double SigmoidNetwork<T>::doTrainingPass(const SigmoidDataSet<T> &trainingset, double &losstotal)
 {
-	double errorTotal = 0;	//RMS Error
-
-	propagateForward(params);	//Start the process by doing a propagateForward through the network
+	if (m_nThreadCount == 1)
+		return doTrainingEpoch(trainingset, losstotal);
+	else if (m_ParallelMode == PARALLEL_SYNCHRONOUS || m_GradientReducer)
+		return doTrainingEpochSynchronous(trainingset, losstotal);
+	else
+		return doTrainingEpochHogwild(trainingset, losstotal);
+}
 
-	//Determine deltas for output layer neurons. 
-	for (int i = 0; i < m_pNetworkLayers[m_nLayerCount - 1]; i++)  //iterate output layer neurons
+//Learns from every row of the training set, in order, on the calling thread. Returns the error of the last row (or batch).
+template <typename T>
+double SigmoidNetwork<T>::doTrainingEpoch(const SigmoidDataSet<T> &trainingset, double &losstotal)
+{
+	double nError = 0;
+	int nRowCount = trainingset.getRowCount();
+	if (m_nBatchSize == 1)
 	{
-		double expOutput = getExpectedOutputVector((int)expectedresult)[i];
-		double actOutput = m_Network[m_nLayerCount - 1][i].getOutput();
-		m_Network[m_nLayerCount - 1][i].setNueronDelta(-(expOutput - actOutput) * actOutput * (1-actOutput));
-		//errorTotal += sqrt((expOutput - actOutput) * (expOutput - actOutput));
-		errorTotal += sqrt(m_Network[m_nLayerCount - 1][i].getNueronDelta() * m_Network[m_nLayerCount - 1][i].getNueronDelta());
+		for (int j = 0; j < nRowCount; j++)
+		{
+			nError = doLearn(m_Workspace, trainingset.getLabel(j), trainingset.getParams(j));
+			losstotal += nError;
+		}
 	}
-	
-	//Determine deltas for hidden layer neurons, starting at rightmost hidden layer
-	for (int i = m_nLayerCount - 2; i > 0; i--) //iterate hidden layers, r to l
+	else
 	{
-		for (int j = 0; j < m_pNetworkLayers[i]; j++) //iterate neurons
+		for (int j = 0; j < nRowCount; j += m_nBatchSize)
 		{
-			double deltaSum = 0.0;
-			for (int k = 0; k < m_pNetworkLayers[i + 1]; k++) //iterate next layer's (to the right) neurons and sum the delta's multiplied by the param weight corresponding to the current neurons output
+			int nRows = min(m_nBatchSize, nRowCount - j);
+			nError = doLearnBatch(m_Workspace, trainingset.getParams(j), trainingset.getLabels() + j, nRows);
+			losstotal += nError * nRows;
+		}
+	}
+	return nError;
+}
+
+//Learns from the training set a batch at a time. Each batch is split into one contiguous shard per thread, each thread
+// sums its shard's gradients into its own workspace, and the shards' gradients are then summed in thread order and
+// applied once. The update is the same as a single-threaded batch, up to rounding, and is deterministic for a given
+// thread count. Batches smaller than the thread count leave threads idle. Returns the error of the last batch.
+template <typename T>
+double SigmoidNetwork<T>::doTrainingEpochSynchronous(const SigmoidDataSet<T> &trainingset, double &losstotal)
+{
+	double nError = 0;
+	int nRowCount = trainingset.getRowCount();
+	for (int j = 0; j < nRowCount; j += m_nBatchSize)
+	{
+		int nRows = min(m_nBatchSize, nRowCount - j);
+		int nShardSize = (nRows + m_nThreadCount - 1) / m_nThreadCount;
+		int nShards = (nRows + nShardSize - 1) / nShardSize;
+		m_pThreadPool->parallelFor(nShards, [&](int t)
+		{
+			int nFirst = j + t * nShardSize;
+			m_vecShardErrors[t] = computeGradients(m_vecThreadWorkspaces[t], trainingset.getParams(nFirst), trainingset.getLabels() + nFirst,
+				min(nShardSize, j + nRows - nFirst));
+		});
+
+		//reduce into the first shard's gradients, in thread order, then update weights once
+		{
+			SIGMOID_TIMED_SCOPE(m_Workspace.getTrainingTimes().dblUpdateSeconds);
+			T *pGradients = m_vecThreadWorkspaces[0].getGradients();
+			nError = m_vecShardErrors[0];
+			for (int t = 1; t < nShards; t++)
 			{
-				deltaSum += m_Network[i + 1][k].getNueronDelta() * m_Network[i + 1][k].getParamWeight(j);
+				SigmoidKernels::addScaledVector(pGradients, (T)1, m_vecThreadWorkspaces[t].getGradients(), m_nParamCount);
+				nError += m_vecShardErrors[t];
 			}
-			double out = m_Network[i][j].getOutput();
-			m_Network[i][j].setNueronDelta(deltaSum * out * (1-out));
+			applyGradients(pGradients);
+		}
+		losstotal += nError;
+		nError /= nRows;
+	}
+	return nError;
+}
+
+//Splits the training set into one contiguous shard per thread. Each thread learns from its shard, a row (or batch) at a
+// time, and updates the shared weights directly, without locking. Threads may read weights another thread is part way
+// through updating; as with Hogwild! SGD, this costs a little accuracy per update in exchange for never waiting.
+// The weights are plain T, read and written by the vector kernels, so these accesses are a data race and formally
+// undefined behaviour (ThreadSanitizer reports them). Making them atomic would take the kernels off SIMD for every
+// mode, so Hogwild instead relies on aligned scalar loads and stores not tearing, which holds for GCC and Clang on the
+// CPUs SigmoidSimd.h targets. Results are not deterministic. Optimizer state is shared the same way. Returns the error
+// of the last row (or batch) of the first shard.
+template <typename T>
+double SigmoidNetwork<T>::doTrainingEpochHogwild(const SigmoidDataSet<T> &trainingset, double &losstotal)
+{
+	fill(m_vecShardErrors.begin(), m_vecShardErrors.end(), 0.0);
+	fill(m_vecShardLosses.begin(), m_vecShardLosses.end(), 0.0);
+	int nRowCount = trainingset.getRowCount();
+	int nShardSize = (nRowCount + m_nThreadCount - 1) / m_nThreadCount;
+	m_pThreadPool->parallelFor(m_nThreadCount, [&](int t)
+	{
+		int nFirst = t * nShardSize;
+		int nLast = min(nFirst + nShardSize, nRowCount);
+		SigmoidWorkspace<T> &ws = m_vecThreadWorkspaces[t];
+		for (int j = nFirst; j < nLast; j += m_nBatchSize)
+		{
+			int nRows = min(m_nBatchSize, nLast - j);
+			if (m_nBatchSize == 1)
+				m_vecShardErrors[t] = doLearn(ws, trainingset.getLabel(j), trainingset.getParams(j));
+			else
+				m_vecShardErrors[t] = doLearnBatch(ws, trainingset.getParams(j), trainingset.getLabels() + j, nRows);
+			m_vecShardLosses[t] += m_vecShardErrors[t] * nRows;
+		}
+	});
+	for (int t = 0; t < m_nThreadCount; t++)
+		losstotal += m_vecShardLosses[t];
+	return m_vecShardErrors[0];
+}
+
+//Adjust input weights via back propogation. The execution of this function constitutes one training epoch.
+//Called from doTraining(). Returns output layer RMS error as it was calculated before weight adjustments.
+//Plain SGD updates each layer's weights as soon as its deltas are known; other optimizers, and a gradient reducer, need
+// the whole gradient, so learn from the row as a batch of one.
+template <typename T>
+double SigmoidNetwork<T>::doLearn(SigmoidWorkspace<T> &ws, int expectedresult, const T *params)
+{
+	if (m_Optimizer.hasState() || m_GradientReducer)
+	{
+		int32_t nLabel = expectedresult;
+		return doLearnBatch(ws, params, &nLabel, 1);
+	}
+
+	double errorTotal = 0;	//RMS Error
+	{
+		SIGMOID_TIMED_SCOPE(ws.getTrainingTimes().dblForwardSeconds);
+		propagateForward(ws, params, 1);	//Start the process by doing a propagateForward through the network
+	}
+
+	{
+		SIGMOID_TIMED_SCOPE(ws.getTrainingTimes().dblBackwardSeconds);
+
+		//Determine deltas for output layer neurons. 
+		errorTotal = setOutputDeltas(ws, &expectedresult, 1);
+
+		//Determine deltas for hidden layer neurons, starting at rightmost hidden layer
+		for (int i = m_nLayerCount - 2; i > 0; i--) //iterate hidden layers, r to l
+		{
+			SIGMOID_TIMED_LAYER_SCOPE(ws.getTrainingTimes().vecLayerBackwardSeconds[i]);
+			m_vecLayers[i].propagateDeltas(ws.getLayerDeltas(i + 1), ws.getLayerOutputs(i), ws.getLayerDeltas(i), 1);
 		}
 	}
 
 	//Do weight corrections, excluding input layer
-	for (int i = m_nLayerCount - 1; i > 0; i--) //iterate all layers r to l, excluding input layer
 	{
-		for (int j = 0; j < m_pNetworkLayers[i]; j++) // iterate neurons in layer
+		SIGMOID_TIMED_SCOPE(ws.getTrainingTimes().dblUpdateSeconds);
+		for (int i = m_nLayerCount - 1; i > 0; i--) //iterate all layers r to l, excluding input layer
 		{
-			for (unsigned int k = 0; k < m_Network[i][j].getInputCount(); k++) //iterate inputs to the current layer and adjust their weight
-				m_Network[i][j].updateParamWeight(k, m_dblLearningRate * m_Network[i][j].getNueronDelta() * m_Network[i][j].getParam(k));
-		//bias weight correction
-		m_Network[i][j].updateBiasWeight(m_dblLearningRate* m_Network[i][j].getNueronDelta());
+			const T *pInputs = (i == 1) ? params : ws.getLayerOutputs(i - 1);
+			m_vecLayers[i - 1].updateWeights(ws.getLayerDeltas(i), pInputs, m_dblEpochLearningRate);
 		}
 	}
 	return errorTotal;
 }
 
-//Start the propogation of neuron outputs from Input layer to output layer
-void SigmoidNetwork::propagateForward(const vector<double> &params)
+//Adjust input weights via back propogation over rowcount rows at once. Gradients are summed over the batch, so a batch
+// of 1 row makes the same weight update as doLearn(). Returns the output layer error averaged over the batch.
+template <typename T>
+double SigmoidNetwork<T>::doLearnBatch(SigmoidWorkspace<T> &ws, const T *features, const int32_t *labels, int rowcount)
+{
+	double errorTotal = computeGradients(ws, features, labels, rowcount);
+	SIGMOID_TIMED_SCOPE(ws.getTrainingTimes().dblUpdateSeconds);
+	applyGradients(ws.getGradients());
+	return errorTotal / rowcount;
+}
+
+template <typename T>
+void SigmoidNetwork<T>::applyGradients(T *gradients)
+{
+	if (m_GradientReducer && !m_GradientReducer(gradients, m_nParamCount))
+	{
+		m_bStopRequested = true;
+		return;
+	}
+	m_Optimizer.step(m_pParams, gradients, m_nParamCount, m_dblEpochLearningRate);
+}
+
+//Runs rowcount rows (a contiguous rowcount x input count feature matrix) forward and backward through the network and
+// sets ws's gradient buffer to the sum of their weight gradients. Weights are only read. Returns the output layer
+// error summed over the rows.
+template <typename T>
+double SigmoidNetwork<T>::computeGradients(SigmoidWorkspace<T> &ws, const T *features, const int32_t *labels, int rowcount)
 {
-	//send the input layer values to the first hidden layer
-	updateLayerInputs(1, params); //Note layer 1, as in m_pNetworks[1], which is the first hidden layer.
+	//forward pass, then deltas for the output layer, then hidden layers r to l
+	{
+		SIGMOID_TIMED_SCOPE(ws.getTrainingTimes().dblForwardSeconds);
+		propagateForward(ws, features, rowcount);
+	}
+	SIGMOID_TIMED_SCOPE(ws.getTrainingTimes().dblBackwardSeconds);
+	double errorTotal = setOutputDeltas(ws, labels, rowcount);
+	for (int i = m_nLayerCount - 2; i > 0; i--)
+	{
+		SIGMOID_TIMED_LAYER_SCOPE(ws.getTrainingTimes().vecLayerBackwardSeconds[i]);
+		m_vecLayers[i].propagateDeltas(ws.getLayerDeltas(i + 1), ws.getLayerOutputs(i), ws.getLayerDeltas(i), rowcount);
+	}
 
-	//for each layer (excluding the input layer) iterate through each neuron and calculate the result,
-	// then set the inputs of each neuron in the next layer to the results
+	//sum the batch's gradients, layer by layer
+	T *pGradients = ws.getGradients();
+	fill(pGradients, pGradients + m_nParamCount, (T)0);
 	for (int i = 1; i < m_nLayerCount; i++)
 	{
-		vector<double> vDblResults(m_pNetworkLayers[i], 0);
+		SIGMOID_TIMED_LAYER_SCOPE(ws.getTrainingTimes().vecLayerBackwardSeconds[i]);
+		const T *pLayerInputs = (i == 1) ? features : ws.getLayerOutputs(i - 1);
+		m_vecLayers[i - 1].accumulateGradients(ws.getLayerDeltas(i), pLayerInputs, pGradients, rowcount);
+		pGradients += m_vecLayers[i - 1].getParamCount();
+	}
+	return errorTotal;
+}
 
-		for (int j = 0; j < m_pNetworkLayers[i]; j++)
-			vDblResults[j] = m_Network[i][j].calculateResult();
-		if (i + 1 < m_nLayerCount)
-			updateLayerInputs(i + 1, vDblResults);
+//Sets the output layer deltas of rowcount rows, given each row's expected result (i.e. the index of the output neuron
+// expected to be high). Returns the sum of the absolute deltas.
+template <typename T>
+double SigmoidNetwork<T>::setOutputDeltas(SigmoidWorkspace<T> &ws, const int32_t *expectedresults, int rowcount)
+{
+	double errorTotal = 0;
+	const T *pOutputs = ws.getLayerOutputs(m_nLayerCount - 1);
+	T *pDeltas = ws.getLayerDeltas(m_nLayerCount - 1);
+	for (int b = 0; b < rowcount; b++)
+	{
+		for (int i = 0; i < m_nOutputCount; i++)  //iterate output layer neurons
+		{
+			T expOutput = (T)((i == expectedresults[b]) ? OUTPUT_HIGH : OUTPUT_LOW);
+			T actOutput = pOutputs[b * m_nOutputCount + i];
+			T &delta = pDeltas[b * m_nOutputCount + i];
+			delta = -(expOutput - actOutput) * actOutput * (1 - actOutput);
+			errorTotal += fabs(delta);
+		}
 	}
+	return errorTotal;
+}
+
+//Start the propogation of neuron outputs from Input layer to output layer
+template <typename T>
+void SigmoidNetwork<T>::propagateForward(const vector<T> &params)
+{
+	propagateForward(m_Workspace, params.data(), 1);
 }
 
-//For given layer at index layer index, iterate through each neuron in that layer and set the input params for it. 
-// When called from propagateForward, params is either the input params, or the results of a previous layer.
-void SigmoidNetwork::updateLayerInputs(int layerindex, const vector<double> &params)
+//For each layer (excluding the input layer) calculate the outputs of every neuron from the outputs of the previous
+// layer, for rowcount rows at once. The input params are the outputs of the input layer.
+template <typename T>
+void SigmoidNetwork<T>::propagateForward(SigmoidWorkspace<T> &ws, const T *inputs, int rowcount) const
 {
-	for (int j = 0; j < m_pNetworkLayers[layerindex]; j++)
-		m_Network[layerindex][j].setParams(params);
+	const T *pInputs = inputs;
+	for (int i = 1; i < m_nLayerCount; i++)
+	{
+		SIGMOID_TIMED_LAYER_SCOPE(ws.getTrainingTimes().vecLayerForwardSeconds[i]);
+		m_vecLayers[i - 1].propagateForward(pInputs, ws.getLayerOutputs(i), rowcount);
+		pInputs = ws.getLayerOutputs(i);
+	}
 }
 
 //Starts the process of getting a classification then returns the classifier's estimate
-int SigmoidNetwork::getClassification(const vector<double> &params)
+template <typename T>
+int SigmoidNetwork<T>::getClassification(const vector<T> &params)
 {
 	propagateForward(params);
+	return getHighestOutput(m_Workspace.getLayerOutputs(m_nLayerCount - 1));
+}
+
+//cycle through output-layer neurons and find the one with the highest output.
+// The index of the highest-value neuron is the index of our classification.
+// Ex: an nResult of 3 denotes a classification of D, because D's index in the alphabet is 3.
+template <typename T>
+int SigmoidNetwork<T>::getHighestOutput(const T *outputs) const
+{
 	double dblHigh = -1;
 	int nResult = -1;
-	//cycle through output-layer neurons and find the one with the highest output.
-	// The index of the highest-value neuron is the index of our classification.
-	// Ex: an nResult of 3 denotes a classification of D, because D's index in the alphabet is 3.
-	for (int i = 0; i < m_pNetworkLayers[m_nLayerCount - 1]; i++)
+	for (int i = 0; i < m_nOutputCount; i++)
 	{
-		double d = m_Network[m_nLayerCount - 1][i].getOutput();
-		if (d > dblHigh)
+		if (outputs[i] > dblHigh)
 		{
 			nResult = i;
-			dblHigh = d;
+			dblHigh = outputs[i];
 		}
 	}
 	return nResult;
 }
 
-//Returns a vector containing the expected oututs of the output layer, given an
-// expected classification. We do it this way because we know, based on the 
-// expected classification, that only one of the output neurons should be high.
-// Thus, expectedclassification is the index of the output neuron we expect to be high.
-vector<double> SigmoidNetwork::getExpectedOutputVector(int expectedclassification)
+//Classifies a single row of params in the calling thread's inference workspace
+template <typename T>
+int SigmoidNetwork<T>::getClassification(const T *params) const
 {
-	vector<double> vDblResults(m_pNetworkLayers[m_nLayerCount - 1], .1); //.1 is the "pulled down" sigmoid output
-	vDblResults[expectedclassification] = .9;	//.9 is the "pulled up" output
+	int nResult;
+	classifyBatch(params, 1, &nResult, NULL);
+	return nResult;
+}
 
-	return vDblResults;
+//Classifies rowcount rows of features, ws.getRowCapacity() rows per forward pass. Weights are only read, and all
+// intermediate results are kept in ws, so concurrent calls are safe as long as each thread passes its own workspace.
+template <typename T>
+void SigmoidNetwork<T>::classifyBatch(const T *features, int rowcount, int *classifications, T *scores, SigmoidWorkspace<T> &ws) const
+{
+	for (int j = 0; j < rowcount; j += ws.getRowCapacity())
+	{
+		int nRows = min(ws.getRowCapacity(), rowcount - j);
+		propagateForward(ws, features + (size_t)j * m_nInputCount, nRows);
+		const T *pOutputs = ws.getLayerOutputs(m_nLayerCount - 1);
+		for (int b = 0; b < nRows; b++)
+			classifications[j + b] = getHighestOutput(pOutputs + b * m_nOutputCount);
+		if (scores != NULL)
+			copy(pOutputs, pOutputs + nRows * m_nOutputCount, scores + (size_t)j * m_nOutputCount);
+	}
 }
 
-//Output layer weights.
-void SigmoidNetwork::printNeuronWeights()
+template <typename T>
+void SigmoidNetwork<T>::classifyBatch(const T *features, int rowcount, int *classifications, T *scores) const
 {
-	cout << "\nLayer Weights:\n";
-	//for (int i = 0; i < m_nLayerCount; i++) //iterate all layers l to r, excluding input layer
-	for (int i = m_nLayerCount -1; i < m_nLayerCount; i++) //iterate all layers l to r, excluding input layer
+	classifyBatch(features, rowcount, classifications, scores, getThreadWorkspace());
+}
+
+//Classifies rowcount SigmoidDataRows. Rows are gathered into the workspace's input buffer a forward pass at a time.
+template <typename T>
+void SigmoidNetwork<T>::classifyBatch(const SigmoidDataRow<T> *rows, int rowcount, int *classifications, T *scores) const
+{
+	SigmoidWorkspace<T> &ws = getThreadWorkspace();
+	for (int j = 0; j < rowcount; j += ws.getRowCapacity())
 	{
-		for (int j = 0; j < m_pNetworkLayers[i]; j++) // iterate neurons in layer
+		int nRows = min(ws.getRowCapacity(), rowcount - j);
+		for (int b = 0; b < nRows; b++)
 		{
-			cout << "  Neuron " << j << ": ";
-			for (unsigned int k = 0; k < m_Network[i][j].getInputCount(); k++) //iterate inputs to the current layer and output weight
-				cout << m_Network[i][j].getParamWeight(k) << ", ";
-			//output bias weight
-			m_Network[i][j].updateBiasWeight(m_dblLearningRate* m_Network[i][j].getNueronDelta());
-			cout << endl;
+			const vector<T> &params = rows[j + b].getParams();
+			copy(params.begin(), params.end(), ws.getInputs() + b * m_nInputCount);
 		}
+		classifyBatch(ws.getInputs(), nRows, classifications + j, scores == NULL ? NULL : scores + (size_t)j * m_nOutputCount, ws);
+	}
+}
+
+template <typename T>
+SigmoidWorkspace<T> SigmoidNetwork<T>::createWorkspace(int rowcapacity) const
+{
+	SigmoidWorkspace<T> ws;
+	ws.allocate(m_pNetworkLayers, m_nLayerCount, 0, max(rowcapacity, 1));
+	return ws;
+}
+
+//Each thread keeps one inference workspace, reallocated only when it is used with a network of a different topology.
+template <typename T>
+SigmoidWorkspace<T> &SigmoidNetwork<T>::getThreadWorkspace() const
+{
+	static thread_local SigmoidWorkspace<T> ws;
+	if (!ws.isAllocatedFor(m_pNetworkLayers, m_nLayerCount))
+		ws.allocate(m_pNetworkLayers, m_nLayerCount, 0, INFERENCE_BATCH_ROWS);
+	return ws;
+}
+
+template <typename T>
+void SigmoidNetwork<T>::allocateWorkspace(SigmoidWorkspace<T> &ws, bool gradients)
+{
+	ws.allocate(m_pNetworkLayers, m_nLayerCount, gradients ? m_nParamCount : 0, m_nBatchSize);
+}
+
+//The calling thread's workspace only needs gradients when it learns a batch at a time, which it also does, a row at a
+// time, for any optimizer but plain SGD, or with a gradient reducer
+template <typename T>
+bool SigmoidNetwork<T>::needsGradients() const
+{
+	return m_nBatchSize > 1 || m_Optimizer.hasState() || m_GradientReducer;
+}
+
+//Sets the number of rows learned from per weight update. Gradients are summed, not averaged, over a batch, so
+// the learning rate keeps its per-row meaning.
+template <typename T>
+void SigmoidNetwork<T>::setBatchSize(int batchsize)
+{
+	if (batchsize < 1)
+	{
+		cout << "ERROR: Invalid batch size.\n";
+		return;
+	}
+	m_nBatchSize = batchsize;
+	allocateWorkspace(m_Workspace, needsGradients());
+	for (unsigned int t = 0; t < m_vecThreadWorkspaces.size(); t++)
+		allocateWorkspace(m_vecThreadWorkspaces[t], true);
+}
+
+//Sets the number of threads doTraining() runs on. With PARALLEL_SYNCHRONOUS, each batch is split across the threads,
+// so the batch size should be at least threadcount (and ideally a good deal larger). With PARALLEL_HOGWILD, each thread
+// learns from its own shard of the training set at the current batch size, racing the others for the weights (see
+// doTrainingEpochHogwild()).
+template <typename T>
+void SigmoidNetwork<T>::setTrainingThreads(int threadcount, ParallelMode mode)
+{
+	if (threadcount < 1)
+	{
+		cout << "ERROR: Invalid thread count.\n";
+		return;
+	}
+	m_nThreadCount = threadcount;
+	m_ParallelMode = mode;
+	m_pThreadPool.reset(threadcount > 1 ? new ThreadPool(threadcount) : NULL);
+	m_vecThreadWorkspaces.assign(threadcount > 1 ? threadcount : 0, SigmoidWorkspace<T>());
+	m_vecShardErrors.assign(threadcount, 0);
+	m_vecShardLosses.assign(threadcount, 0);
+	for (unsigned int t = 0; t < m_vecThreadWorkspaces.size(); t++)
+		allocateWorkspace(m_vecThreadWorkspaces[t], true);
+}
+
+//Asks doTraining() to stop. The epoch in progress is finished, and reported, first.
+template <typename T>
+void SigmoidNetwork<T>::stopTraining()
+{
+	m_bStopRequested = true;
+}
+
+//momentum is the velocity decay of OPTIMIZER_MOMENTUM and OPTIMIZER_NESTEROV, and Adam's beta1; beta2 is only used by Adam.
+// Typical values are 0.9 and 0.999, with a learning rate around 0.001 for Adam. The state starts at 0 for every weight.
+template <typename T>
+void SigmoidNetwork<T>::setOptimizer(OptimizerType type, double momentum, double beta2)
+{
+	m_Optimizer.configure(type, momentum, beta2);
+	m_Optimizer.allocate(m_nParamCount);
+	allocateWorkspace(m_Workspace, needsGradients());
+}
+
+//The schedule is called with the network's epoch count, so a loaded network resumes its schedule where it left off.
+// An empty schedule trains every epoch at the network's learning rate.
+template <typename T>
+void SigmoidNetwork<T>::setLearningRateSchedule(const LearningRateSchedule &schedule)
+{
+	m_LearningRateSchedule = schedule;
+}
+
+//Every replica must make the same sequence of updates: train each on the same number of batches, and only stop them
+// all together. If the reducer fails, the update is skipped and training stops at the end of the epoch.
+template <typename T>
+void SigmoidNetwork<T>::setGradientReducer(const SigmoidGradientReducer<T> &reducer)
+{
+	m_GradientReducer = reducer;
+	allocateWorkspace(m_Workspace, needsGradients());
+}
+
+template <typename T>
+void SigmoidNetwork<T>::beginEpoch()
+{
+	m_dblEpochLearningRate = m_LearningRateSchedule ? m_LearningRateSchedule(m_nEpochCount, m_dblLearningRate) : m_dblLearningRate;
+}
+
+//Sets the function doTraining() calls, on the calling thread, after every epoch. An empty callback stops the calls.
+template <typename T>
+void SigmoidNetwork<T>::setEpochCallback(const SigmoidEpochCallback &callback)
+{
+	m_EpochCallback = callback;
+}
+
+//Gathers the metrics of the epoch just done, which started at start and learned from rowcount rows, and resets the
+// training times of every workspace for the next epoch. The metrics are gathered into the same buffers every epoch.
+template <typename T>
+void SigmoidNetwork<T>::reportEpoch(int rowcount, chrono::steady_clock::time_point start, double losstotal, double lasterror)
+{
+	if (m_EpochCallback)
+	{
+		SigmoidEpochMetrics &metrics = m_EpochMetrics;
+		metrics.nEpoch = m_nEpochCount;
+		metrics.nRows = rowcount;
+		metrics.dblSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		metrics.dblSamplesPerSecond = metrics.dblSeconds > 0 ? rowcount / metrics.dblSeconds : 0;
+		metrics.dblLoss = rowcount > 0 ? losstotal / rowcount : 0;
+		metrics.dblLastError = lasterror;
+		metrics.dblLearningRate = m_dblEpochLearningRate;
+		metrics.times = m_Workspace.getTrainingTimes();
+		for (unsigned int t = 0; t < m_vecThreadWorkspaces.size(); t++)
+			metrics.times.add(m_vecThreadWorkspaces[t].getTrainingTimes());
+		m_EpochCallback(metrics);
 	}
+	m_Workspace.getTrainingTimes().reset(m_nLayerCount);
+	for (unsigned int t = 0; t < m_vecThreadWorkspaces.size(); t++)
+		m_vecThreadWorkspaces[t].getTrainingTimes().reset(m_nLayerCount);
+}
 
+//The copy owns its weights, so it may be classified with while this network goes on training
+template <typename T>
+unique_ptr<SigmoidNetwork<T>> SigmoidNetwork<T>::clone() const
+{
+	unique_ptr<SigmoidNetwork<T>> pNetwork(new SigmoidNetwork<T>());
+	pNetwork->buildLayers(m_pNetworkLayers, m_nLayerCount, m_dblBias);
+	pNetwork->m_vecParams.assign(m_pParams, m_pParams + m_nParamCount);
+	pNetwork->bindParams(pNetwork->m_vecParams.data());
+	pNetwork->m_dblLearningRate = m_dblLearningRate;
+	pNetwork->m_dblEpochLearningRate = m_dblLearningRate;
+	pNetwork->m_nEpochCount = m_nEpochCount;
+	pNetwork->setActivation(getActivation());
+	pNetwork->allocateWorkspace(pNetwork->m_Workspace, false);
+	return pNetwork;
 }
 
+//Writes the header, topology and weights described in SigmoidModelFile.h to filename.tmp, flushes it to disk, then
+// renames it over filename, so a process that has the old file mapped (see load()) keeps its pages and a crash
+// leaves either the old model or the new one.
+template <typename T>
+bool SigmoidNetwork<T>::save(const string &filename) const
+{
+	SigmoidModelHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MODEL_MAGIC, sizeof(header.magic));
+	header.version = MODEL_VERSION;
+	header.scalarSize = sizeof(T);
+	header.layerCount = m_nLayerCount;
+	header.epochCount = m_nEpochCount;
+	header.learningRate = m_dblLearningRate;
+	header.bias = m_dblBias;
+	header.batchSize = m_nBatchSize;
+	header.paramCount = m_nParamCount;
+	size_t nTopologyEnd = sizeof(header) + m_nLayerCount * sizeof(int32_t);
+	header.paramOffset = (nTopologyEnd + MODEL_PARAM_ALIGNMENT - 1) / MODEL_PARAM_ALIGNMENT * MODEL_PARAM_ALIGNMENT;
+
+	string strTempFile = filename + ".tmp";
+	FILE *pFile = fopen(strTempFile.c_str(), "wb");
+	if (!pFile)
+	{
+		cout << "ERROR: Model file " << strTempFile << " could not be opened for writing.\n";
+		return false;
+	}
+	vector<int32_t> vTopology(m_pNetworkLayers, m_pNetworkLayers + m_nLayerCount);
+	vector<char> vPadding((size_t)header.paramOffset - nTopologyEnd, 0);
+	bool bWritten = fwrite(&header, sizeof(header), 1, pFile) == 1 &&
+		fwrite(vTopology.data(), sizeof(int32_t), vTopology.size(), pFile) == vTopology.size() &&
+		(vPadding.empty() || fwrite(vPadding.data(), 1, vPadding.size(), pFile) == vPadding.size()) &&
+		fwrite(m_pParams, sizeof(T), m_nParamCount, pFile) == (size_t)m_nParamCount &&
+		fflush(pFile) == 0 && fsync(fileno(pFile)) == 0;
+	bWritten = fclose(pFile) == 0 && bWritten;
+	if (!bWritten || rename(strTempFile.c_str(), filename.c_str()) != 0)
+	{
+		cout << "ERROR: Model file " << filename << " could not be written.\n";
+		remove(strTempFile.c_str());
+		return false;
+	}
+	return true;
+}
+
+//Reads a model file written by save(). When mapped is true the file is memory-mapped (copy-on-write) and the network's
+// weights point straight into the mapping, so loading costs only the page faults of the weights actually touched.
+// Otherwise, or if the file's weights are of a different precision than T, the weights are copied (and converted) into
+// the network's own buffer.
+template <typename T>
+unique_ptr<SigmoidNetwork<T>> SigmoidNetwork<T>::load(const string &filename, bool mapped, bool verbose)
+{
+	shared_ptr<MappedFile> pFile(new MappedFile());
+	if (!pFile->open(filename))
+		return unique_ptr<SigmoidNetwork<T>>();
 
+	//validate the header and topology against the file size
+	SigmoidModelHeader header;
+	const char *pData = pFile->getData();
+	bool bValid = pFile->getSize() >= sizeof(header);
+	if (bValid)
+	{
+		memcpy(&header, pData, sizeof(header));
+		bValid = memcmp(header.magic, MODEL_MAGIC, sizeof(header.magic)) == 0 && header.layerCount >= 2 &&
+			(pFile->getSize() - sizeof(header)) / sizeof(int32_t) >= header.layerCount;
+	}
+	if (!bValid)
+	{
+		cout << "ERROR: " << filename << " is not a model file.\n";
+		return unique_ptr<SigmoidNetwork<T>>();
+	}
+	if (header.version != MODEL_VERSION || (header.scalarSize != sizeof(float) && header.scalarSize != sizeof(double)))
+	{
+		cout << "ERROR: " << filename << " has an unsupported model version or weight size.\n";
+		return unique_ptr<SigmoidNetwork<T>>();
+	}
+	//the weight count is summed in 64 bits and given up on once it passes what the file can hold, so a corrupt
+	// topology can neither overflow it nor have layers built for it
+	vector<int> vTopology;
+	bValid = readModelTopology(pData + sizeof(header), header.layerCount, vTopology) &&
+		header.paramOffset >= sizeof(header) + header.layerCount * sizeof(int32_t) && header.paramOffset <= pFile->getSize() &&
+		header.paramOffset % header.scalarSize == 0 && header.paramCount <= (pFile->getSize() - header.paramOffset) / header.scalarSize &&
+		header.paramCount <= (uint64_t)numeric_limits<int>::max();
+	uint64_t nParamCount = 0;
+	for (unsigned int i = 1; bValid && i < header.layerCount; i++)
+	{
+		nParamCount += ((uint64_t)vTopology[i - 1] + 1) * (uint64_t)vTopology[i];
+		bValid = nParamCount <= header.paramCount;
+	}
+	if (!bValid || nParamCount != header.paramCount)
+	{
+		cout << "ERROR: " << filename << " is truncated or does not match its topology.\n";
+		return unique_ptr<SigmoidNetwork<T>>();
+	}
+
+	unique_ptr<SigmoidNetwork<T>> pNetwork(new SigmoidNetwork<T>());
+	pNetwork->buildLayers(vTopology.data(), (int)vTopology.size(), header.bias);
+	char *pFileParams = pFile->getData() + header.paramOffset;
+	if (mapped && pFile->isMapped() && header.scalarSize == sizeof(T))
+	{
+		pNetwork->m_pModelFile = pFile;
+		pNetwork->bindParams((T *)pFileParams);
+	}
+	else
+	{
+		if (header.scalarSize == sizeof(float))
+			pNetwork->m_vecParams.assign((float *)pFileParams, (float *)pFileParams + header.paramCount);
+		else
+			pNetwork->m_vecParams.assign((double *)pFileParams, (double *)pFileParams + header.paramCount);
+		pNetwork->bindParams(pNetwork->m_vecParams.data());
+	}
+	pNetwork->m_dblLearningRate = header.learningRate;
+	pNetwork->m_dblEpochLearningRate = header.learningRate;
+	pNetwork->m_nEpochCount = header.epochCount;
+	pNetwork->m_bVerbose = verbose;
+	pNetwork->setBatchSize(header.batchSize > 0 ? header.batchSize : 1);
+	return pNetwork;
+}
+
+//Output layer weights.
+template <typename T>
+void SigmoidNetwork<T>::printNeuronWeights()
+{
+	cout << "\nLayer Weights:\n";
+	const SigmoidLayer<T> &layer = m_vecLayers[m_nLayerCount - 2]; //output layer
+	for (int j = 0; j < layer.getNeuronCount(); j++) // iterate neurons in layer
+	{
+		cout << "  Neuron " << j << ": ";
+		const T *pRow = layer.getWeights() + j * layer.getInputCount();
+		for (int k = 0; k < layer.getInputCount(); k++) //iterate inputs to the current layer and output weight
+			cout << pRow[k] << ", ";
+		cout << layer.getBiasWeights()[j]; //output bias weight
+		cout << endl;
+	}
+}
+
+//Called between epochs, e.g. from an epoch callback, so the state is that of a whole number of epochs. Once the
+// buffers are sized, by the first call, copying allocates nothing.
+template <typename T>
+void SigmoidNetwork<T>::getTrainingState(SigmoidTrainingState<T> &state) const
+{
+	state.vecLayers.assign(m_pNetworkLayers, m_pNetworkLayers + m_nLayerCount);
+	state.dblLearningRate = m_dblLearningRate;
+	state.dblBias = m_dblBias;
+	state.nBatchSize = m_nBatchSize;
+	state.nEpochCount = m_nEpochCount;
+	state.optimizerType = m_Optimizer.getType();
+	state.dblMomentum = m_Optimizer.getMomentum();
+	state.dblBeta2 = m_Optimizer.getBeta2();
+	state.nOptimizerSteps = m_Optimizer.getStepCount();
+	state.vecParams.assign(m_pParams, m_pParams + m_nParamCount);
+	state.vecVelocity.assign(m_Optimizer.getVelocity().begin(), m_Optimizer.getVelocity().end());
+	state.vecSecondMoment.assign(m_Optimizer.getSecondMoment().begin(), m_Optimizer.getSecondMoment().end());
+}
+
+//The learning rate schedule, activation, thread count and callbacks are not part of the state; set them as they were
+// when the state was taken. The schedule is given the restored epoch count, so it carries on where it stopped.
+template <typename T>
+bool SigmoidNetwork<T>::setTrainingState(const SigmoidTrainingState<T> &state)
+{
+	if (state.vecLayers != vector<int>(m_pNetworkLayers, m_pNetworkLayers + m_nLayerCount) || state.dblBias != m_dblBias ||
+		state.vecParams.size() != (size_t)m_nParamCount)
+	{
+		cout << "ERROR: Training state does not match the network's topology or bias.\n";
+		return false;
+	}
+	setParams(state.vecParams.data());
+	m_dblLearningRate = state.dblLearningRate;
+	m_dblEpochLearningRate = state.dblLearningRate;
+	m_nEpochCount = state.nEpochCount;
+	setBatchSize(state.nBatchSize);
+	setOptimizer(state.optimizerType, state.dblMomentum, state.dblBeta2);
+	if (!m_Optimizer.setState(state.vecVelocity, state.vecSecondMoment, state.nOptimizerSteps))
+	{
+		cout << "ERROR: Training state's optimizer state does not match the network.\n";
+		return false;
+	}
+	return true;
+}
+
+///Accessors
+template <typename T>
+int SigmoidNetwork<T>::getLayerCount() const
+{
+	return m_nLayerCount;
+}
+template <typename T>
+const int *SigmoidNetwork<T>::getNetworkLayers() const
+{
+	return m_pNetworkLayers;
+}
+template <typename T>
+int SigmoidNetwork<T>::getParamCount() const
+{
+	return m_nParamCount;
+}
+template <typename T>
+double SigmoidNetwork<T>::getBias() const
+{
+	return m_dblBias;
+}
+template <typename T>
+int SigmoidNetwork<T>::getEpochCount() const
+{
+	return m_nEpochCount;
+}
+template <typename T>
+double SigmoidNetwork<T>::getLearningRate() const
+{
+	return m_dblLearningRate;
+}
+template <typename T>
+int SigmoidNetwork<T>::getBatchSize() const
+{
+	return m_nBatchSize;
+}
+template <typename T>
+SigmoidActivation SigmoidNetwork<T>::getActivation() const
+{
+	return m_vecLayers[0].getActivation();
+}
+template <typename T>
+void SigmoidNetwork<T>::setActivation(SigmoidActivation activation)
+{
+	for (unsigned int i = 0; i < m_vecLayers.size(); i++)
+		m_vecLayers[i].setActivation(activation);
+}
+template <typename T>
+const SigmoidOptimizer<T> &SigmoidNetwork<T>::getOptimizer() const
+{
+	return m_Optimizer;
+}
+template <typename T>
+void SigmoidNetwork<T>::getParams(T *params) const
+{
+	copy(m_pParams, m_pParams + m_nParamCount, params);
+}
+//The weights of a mapped network are written to its private (copy-on-write) mapping, never to the file itself.
+template <typename T>
+void SigmoidNetwork<T>::setParams(const T *params)
+{
+	copy(params, params + m_nParamCount, m_pParams);
+}
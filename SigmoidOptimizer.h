@@ -0,0 +1,205 @@
+///////////////////////////////////////////
+// The rule a SigmoidNetwork uses to turn weight gradients into weight updates, and learning rate schedules.
+//	OPTIMIZER_SGD subtracts the learning rate times each gradient. OPTIMIZER_MOMENTUM and OPTIMIZER_NESTEROV keep a
+//	velocity per weight (v = momentum * v + g), stepping by v or, for Nesterov, by g + momentum * v. OPTIMIZER_ADAM keeps
+//	running means of each weight's gradient and squared gradient, with decay rates momentum and beta2, and steps by their
+//	bias-corrected ratio. State is held in contiguous buffers laid out as the network's parameter buffer, so step() walks
+//	weights, gradients and state in lockstep. SGD has no state.
+//	A LearningRateSchedule gives the learning rate of each epoch from the network's base rate; doTraining() calls it at
+//	the start of every epoch. getStepSchedule() and getCosineSchedule() build the common ones.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <cmath>
+#include <atomic>
+#include <functional>
+#include "SigmoidKernels.h"
+
+using namespace std;
+
+enum OptimizerType
+{
+	OPTIMIZER_SGD,																	//w -= rate * g
+	OPTIMIZER_MOMENTUM,																//v = momentum * v + g, w -= rate * v
+	OPTIMIZER_NESTEROV,																//v = momentum * v + g, w -= rate * (g + momentum * v)
+	OPTIMIZER_ADAM																	//Adam, with beta1 = momentum
+};
+
+typedef function<double(int epoch, double learningrate)> LearningRateSchedule;	//Returns the learning rate of epoch (0 = first ever), given the base rate
+
+template <typename T>
+class SigmoidOptimizer
+{
+public:
+	SigmoidOptimizer();																//Constructor. Plain SGD.
+	void configure(OptimizerType type, double momentum, double beta2);				//Sets the update rule and zeroes its state. momentum is Adam's beta1.
+	void allocate(int paramcount);													//Sizes and zeroes the state for paramcount weights
+	void reset();																	//Zeroes the state
+	void step(T *params, const T *gradients, int n, double learningrate);			//Updates n weights from their (summed) gradients
+	OptimizerType getType() const;													//Returns m_Type
+	double getMomentum() const;														//Returns m_dblMomentum
+	double getBeta2() const;														//Returns m_dblBeta2
+	bool hasState() const;															//Returns true unless plain SGD
+	long long getStepCount() const;													//Returns m_nStepCount
+	const vector<T> &getVelocity() const;											//Returns m_vecVelocity
+	const vector<T> &getSecondMoment() const;										//Returns m_vecSecondMoment
+	bool setState(const vector<T> &velocity, const vector<T> &secondmoment,		//Restores state read from an optimizer of the same type and size, e.g. by a
+			long long stepcount);													//   checkpoint. Returns false if the sizes differ.
+
+private:
+	OptimizerType m_Type;															//Update rule
+	double m_dblMomentum;															//Velocity decay, or Adam's first moment decay (beta1)
+	double m_dblBeta2;																//Adam's second moment decay
+	int m_nParamCount;																//Weights the state was allocated for
+	atomic<long long> m_nStepCount;													//Adam steps taken, for bias correction. Atomic for Hogwild training.
+	vector<T> m_vecVelocity;														//Velocity, or Adam's first moment, of each weight
+	vector<T> m_vecSecondMoment;													//Adam's running mean of each weight's squared gradient
+
+	static const double ADAM_EPSILON;												//Added to Adam's denominator, so it is never 0
+};
+
+template <typename T>
+const double SigmoidOptimizer<T>::ADAM_EPSILON = 1e-8;
+
+LearningRateSchedule getStepSchedule(double factor, int stepepochs);				//Multiplies the rate by factor every stepepochs epochs
+LearningRateSchedule getCosineSchedule(int epochcount, double minrate);			//Anneals the rate to minrate along a half cosine over epochcount epochs
+
+//Constructor
+template <typename T>
+SigmoidOptimizer<T>::SigmoidOptimizer() : m_Type(OPTIMIZER_SGD), m_dblMomentum(0), m_dblBeta2(0), m_nParamCount(0), m_nStepCount(0)
+{}
+
+template <typename T>
+void SigmoidOptimizer<T>::configure(OptimizerType type, double momentum, double beta2)
+{
+	m_Type = type;
+	m_dblMomentum = momentum;
+	m_dblBeta2 = beta2;
+	allocate(m_nParamCount);
+}
+
+//SGD needs no state, so allocates none
+template <typename T>
+void SigmoidOptimizer<T>::allocate(int paramcount)
+{
+	m_nParamCount = paramcount;
+	m_vecVelocity.assign(m_Type == OPTIMIZER_SGD ? 0 : paramcount, 0);
+	m_vecSecondMoment.assign(m_Type == OPTIMIZER_ADAM ? paramcount : 0, 0);
+	m_nStepCount = 0;
+}
+
+template <typename T>
+void SigmoidOptimizer<T>::reset()
+{
+	fill(m_vecVelocity.begin(), m_vecVelocity.end(), (T)0);
+	fill(m_vecSecondMoment.begin(), m_vecSecondMoment.end(), (T)0);
+	m_nStepCount = 0;
+}
+
+//Applies one update to params[0..n). The state must have been allocated for at least n weights.
+template <typename T>
+void SigmoidOptimizer<T>::step(T *params, const T *gradients, int n, double learningrate)
+{
+	if (m_Type == OPTIMIZER_SGD)
+	{
+		SigmoidKernels::addScaledVector(params, (T)-learningrate, gradients, n);
+		return;
+	}
+
+	T *pVelocity = m_vecVelocity.data();
+	T momentum = (T)m_dblMomentum, rate = (T)learningrate;
+	if (m_Type == OPTIMIZER_MOMENTUM)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			pVelocity[i] = momentum * pVelocity[i] + gradients[i];
+			params[i] -= rate * pVelocity[i];
+		}
+	}
+	else if (m_Type == OPTIMIZER_NESTEROV)
+	{
+		for (int i = 0; i < n; i++)
+		{
+			pVelocity[i] = momentum * pVelocity[i] + gradients[i];
+			params[i] -= rate * (gradients[i] + momentum * pVelocity[i]);
+		}
+	}
+	else
+	{
+		//bias correction folds into the step size: rate * sqrt(1 - beta2^t) / (1 - beta1^t)
+		long long nStep = ++m_nStepCount;
+		T *pSecondMoment = m_vecSecondMoment.data();
+		T beta2 = (T)m_dblBeta2, epsilon = (T)ADAM_EPSILON;
+		T stepsize = (T)(learningrate * sqrt(1 - pow(m_dblBeta2, (double)nStep)) / (1 - pow(m_dblMomentum, (double)nStep)));
+		for (int i = 0; i < n; i++)
+		{
+			pVelocity[i] = momentum * pVelocity[i] + (1 - momentum) * gradients[i];
+			pSecondMoment[i] = beta2 * pSecondMoment[i] + (1 - beta2) * gradients[i] * gradients[i];
+			params[i] -= stepsize * pVelocity[i] / (sqrt(pSecondMoment[i]) + epsilon);
+		}
+	}
+}
+
+///Accessors
+template <typename T>
+OptimizerType SigmoidOptimizer<T>::getType() const
+{
+	return m_Type;
+}
+template <typename T>
+double SigmoidOptimizer<T>::getMomentum() const
+{
+	return m_dblMomentum;
+}
+template <typename T>
+double SigmoidOptimizer<T>::getBeta2() const
+{
+	return m_dblBeta2;
+}
+template <typename T>
+bool SigmoidOptimizer<T>::hasState() const
+{
+	return m_Type != OPTIMIZER_SGD;
+}
+template <typename T>
+long long SigmoidOptimizer<T>::getStepCount() const
+{
+	return m_nStepCount;
+}
+template <typename T>
+const vector<T> &SigmoidOptimizer<T>::getVelocity() const
+{
+	return m_vecVelocity;
+}
+template <typename T>
+const vector<T> &SigmoidOptimizer<T>::getSecondMoment() const
+{
+	return m_vecSecondMoment;
+}
+template <typename T>
+bool SigmoidOptimizer<T>::setState(const vector<T> &velocity, const vector<T> &secondmoment, long long stepcount)
+{
+	if (velocity.size() != m_vecVelocity.size() || secondmoment.size() != m_vecSecondMoment.size())
+		return false;
+	copy(velocity.begin(), velocity.end(), m_vecVelocity.begin());
+	copy(secondmoment.begin(), secondmoment.end(), m_vecSecondMoment.begin());
+	m_nStepCount = stepcount;
+	return true;
+}
+
+LearningRateSchedule getStepSchedule(double factor, int stepepochs)
+{
+	return [factor, stepepochs](int epoch, double learningrate) { return learningrate * pow(factor, epoch / max(stepepochs, 1)); };
+}
+
+//The rate falls from the base rate at epoch 0 to minrate at epoch epochcount, and stays there
+LearningRateSchedule getCosineSchedule(int epochcount, double minrate)
+{
+	return [epochcount, minrate](int epoch, double learningrate)
+	{
+		double dblProgress = min((double)epoch / max(epochcount, 1), 1.0);
+		return minrate + (learningrate - minrate) * (1 + cos(3.14159265358979323846 * dblProgress)) / 2;
+	};
+}
@@ -0,0 +1,169 @@
+///////////////////////////////////////////
+// Magnitude pruning of a trained sigmoid network (a SigmoidNetwork or FixedSigmoidNetwork).
+//	prune() zeroes the given fraction of a network's weights, choosing those of smallest magnitude either across the
+//	whole network (PRUNE_GLOBAL) or separately within each layer (PRUNE_LAYER). Bias weights are never pruned. The
+//	pruner remembers which weights it has zeroed, so later prunes only add to them, and fineTune() can train the network
+//	further while keeping them at zero: it re-zeroes them after every epoch, so the network stays exactly as sparse.
+//	Pruning a large fraction at once costs far more accuracy than fine-tuning wins back; pruneGradually() reaches it in
+//	steps instead, fine-tuning after each, which keeps much more.
+//	A pruned network classifies as before, with dense kernels. SparseSigmoidNetwork.h stores only its nonzero weights,
+//	and tools/prune_model.cpp reports validation accuracy, size and speed at each level of sparsity.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "SigmoidClassifier.h"
+
+using namespace std;
+
+enum PruneScope
+{
+	PRUNE_GLOBAL,																	//One magnitude threshold for every layer
+	PRUNE_LAYER																		//Each layer pruned to the sparsity on its own
+};
+
+template <typename T>
+class SigmoidPruner
+{
+public:
+	SigmoidPruner(SigmoidClassifier<T> &network);									//Constructor. network must outlive the pruner. Nothing is pruned yet.
+	void prune(double sparsity, PruneScope scope);									//Zeroes the smallest weights, until sparsity (0 to 1) of the prunable weights
+																					//   are pruned, across the network or in each layer
+	void fineTune(const SigmoidDataSet<T> &trainingset, int iterationcount);		//Trains the network iterationcount epochs, keeping pruned weights at 0
+	void pruneGradually(double sparsity, PruneScope scope, int stepcount,			//Prunes to sparsity in stepcount equal steps, fine-tuning iterationcount
+			const SigmoidDataSet<T> &trainingset, int iterationcount);				//   epochs on trainingset after each
+	void applyMask();																//Zeroes every pruned weight. Call after training the network directly.
+	bool isPruned(int index) const;													//Returns true if the weight at index (in parameter buffer order) is pruned
+	int getPrunableCount() const;													//Returns the number of weights, excluding bias weights
+	int getPrunedCount() const;														//Returns the number of weights pruned
+	double getSparsity() const;														//Returns getPrunedCount() / getPrunableCount()
+	double getLayerSparsity(int layerindex) const;									//Returns the fraction of layer layerindex's weights pruned (1 = first hidden layer)
+
+private:
+	SigmoidClassifier<T> &m_Network;												//The network being pruned
+	vector<uint8_t> m_vecPruned;													//1 for each weight pruned, in parameter buffer order. Bias weights are always 0.
+	vector<T> m_vecParams;															//The network's weights, while they are being pruned
+
+	void pruneSmallest(vector<int> &indices, double sparsity);						//Prunes the smallest sparsity of the weights at indices, as one group
+};
+
+//Constructor
+template <typename T>
+SigmoidPruner<T>::SigmoidPruner(SigmoidClassifier<T> &network) : m_Network(network), m_vecPruned(network.getParamCount(), 0),
+m_vecParams(network.getParamCount())
+{}
+
+//Weights already pruned count toward sparsity: they have the smallest magnitude of all, so are always chosen first
+template <typename T>
+void SigmoidPruner<T>::prune(double sparsity, PruneScope scope)
+{
+	sparsity = min(max(sparsity, 0.0), 1.0);
+	m_Network.getParams(m_vecParams.data());
+
+	//gather the indices of each layer's weight matrix, skipping its bias weights, into one group for the whole network
+	// or one per layer, and prune each group
+	const int *pLayers = m_Network.getNetworkLayers();
+	vector<int> vecIndices;
+	int nOffset = 0;
+	for (int i = 1; i < m_Network.getLayerCount(); i++)
+	{
+		int nWeights = pLayers[i - 1] * pLayers[i];
+		for (int k = 0; k < nWeights; k++)
+			vecIndices.push_back(nOffset + k);
+		nOffset += nWeights + pLayers[i];
+		if (scope == PRUNE_LAYER || i == m_Network.getLayerCount() - 1)
+		{
+			pruneSmallest(vecIndices, sparsity);
+			vecIndices.clear();
+		}
+	}
+	for (size_t k = 0; k < m_vecParams.size(); k++)
+		if (m_vecPruned[k])
+			m_vecParams[k] = 0;
+	m_Network.setParams(m_vecParams.data());
+}
+
+//Reorders indices, so the first sparsity of them index the weights of smallest magnitude, and prunes those
+template <typename T>
+void SigmoidPruner<T>::pruneSmallest(vector<int> &indices, double sparsity)
+{
+	size_t nPrune = (size_t)llround(sparsity * indices.size());
+	nth_element(indices.begin(), indices.begin() + nPrune, indices.end(),
+		[this](int a, int b) { return fabs(m_vecParams[a]) < fabs(m_vecParams[b]); });
+	for (size_t k = 0; k < nPrune; k++)
+		m_vecPruned[indices[k]] = 1;
+}
+
+//Trains an epoch at a time, zeroing the pruned weights after each, so the updates they received within the epoch
+// are discarded rather than carried forward
+template <typename T>
+void SigmoidPruner<T>::fineTune(const SigmoidDataSet<T> &trainingset, int iterationcount)
+{
+	for (int i = 0; i < iterationcount; i++)
+	{
+		m_Network.doTraining(trainingset, 1);
+		applyMask();
+	}
+}
+
+template <typename T>
+void SigmoidPruner<T>::pruneGradually(double sparsity, PruneScope scope, int stepcount, const SigmoidDataSet<T> &trainingset, int iterationcount)
+{
+	stepcount = max(stepcount, 1);
+	for (int s = 1; s <= stepcount; s++)
+	{
+		prune(sparsity * s / stepcount, scope);
+		fineTune(trainingset, iterationcount);
+	}
+}
+
+template <typename T>
+void SigmoidPruner<T>::applyMask()
+{
+	m_Network.getParams(m_vecParams.data());
+	for (size_t k = 0; k < m_vecParams.size(); k++)
+		if (m_vecPruned[k])
+			m_vecParams[k] = 0;
+	m_Network.setParams(m_vecParams.data());
+}
+
+///Accessors
+template <typename T>
+bool SigmoidPruner<T>::isPruned(int index) const
+{
+	return m_vecPruned[index] != 0;
+}
+template <typename T>
+int SigmoidPruner<T>::getPrunableCount() const
+{
+	const int *pLayers = m_Network.getNetworkLayers();
+	int nCount = 0;
+	for (int i = 1; i < m_Network.getLayerCount(); i++)
+		nCount += pLayers[i - 1] * pLayers[i];
+	return nCount;
+}
+template <typename T>
+int SigmoidPruner<T>::getPrunedCount() const
+{
+	return (int)count(m_vecPruned.begin(), m_vecPruned.end(), (uint8_t)1);
+}
+template <typename T>
+double SigmoidPruner<T>::getSparsity() const
+{
+	int nPrunable = getPrunableCount();
+	return nPrunable > 0 ? (double)getPrunedCount() / nPrunable : 0;
+}
+template <typename T>
+double SigmoidPruner<T>::getLayerSparsity(int layerindex) const
+{
+	const int *pLayers = m_Network.getNetworkLayers();
+	int nOffset = 0;
+	for (int i = 1; i < layerindex; i++)
+		nOffset += (pLayers[i - 1] + 1) * pLayers[i];
+	int nWeights = pLayers[layerindex - 1] * pLayers[layerindex];
+	return nWeights > 0 ? (double)count(m_vecPruned.begin() + nOffset, m_vecPruned.begin() + nOffset + nWeights, (uint8_t)1) / nWeights : 0;
+}
@@ -0,0 +1,274 @@
+///////////////////////////////////////////
+// A ring of processes that sum buffers across every member (allreduce), for data-parallel training.
+//	Each of rankcount processes joins the ring with connect(), giving its rank and the ring's address. Rank r listens
+//	on its own address (see getRankAddress()) and connects to rank r + 1, so each rank sends to its right neighbour and
+//	receives from its left, over local sockets (see SigmoidSocket.h).
+//	allreduce() is the bandwidth-optimal ring algorithm: the buffer is split into one segment per rank, and in
+//	rankcount - 1 steps each rank passes a segment to its right while adding the one arriving from its left, after which
+//	each rank holds one segment summed over every rank; in rankcount - 1 more steps the summed segments are passed around
+//	until every rank has all of them. Each rank sends and receives about twice the buffer's size, however many ranks
+//	there are. Every rank ends with exactly the same values, bit for bit, since each segment is summed once, by one
+//	rank, and copied to the rest.
+//	Used with SigmoidNetwork::setGradientReducer(), it sums every batch's gradients over replicas of one network, each
+//	training on its own shard (see tools/distributed_train.cpp). Every rank must make the same sequence of calls.
+//	Once a call fails, e.g. because another rank has exited, the ring has failed and every later call returns false.
+//	A ring of one rank needs no sockets, and every call returns at once. POSIX only.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <cstdint>
+#include <fcntl.h>
+#include "SigmoidSocket.h"
+#include "SigmoidKernels.h"
+
+using namespace std;
+
+class SigmoidRing
+{
+public:
+	SigmoidRing();																	//Constructor. Not connected.
+	~SigmoidRing();																	//Calls disconnect()
+	bool connect(const string &address, int rank, int rankcount,					//Joins the ring as rank, waiting up to timeoutseconds for the neighbours to join.
+			int timeoutseconds);													//   Returns false, with an error msg, on failure.
+	void disconnect();																//Leaves the ring
+	template <typename T>
+	bool allreduce(T *data, size_t count);											//Replaces data, on every rank, with its sum over every rank. Returns false, with an
+																					//   error msg, on failure.
+	template <typename T>
+	bool broadcast(T *data, size_t count, int root);								//Copies root's data to every rank. Returns false, with an error msg, on failure.
+	bool barrier();																	//Returns once every rank has called barrier(), or false on failure
+	int getRank() const;															//Returns m_nRank
+	int getRankCount() const;														//Returns m_nRankCount
+	bool hasFailed() const;															//Returns m_bFailed
+	static string getRankAddress(const string &address, int rank);				//Returns the address rank listens on: port address + rank, or path address.rank
+
+	static const int RING_TIMEOUT_MS;												//Longest a step may wait on a neighbour before the ring fails
+
+private:
+	int m_nRank;																	//This process's rank
+	int m_nRankCount;																//Ranks in the ring
+	int m_nListenSocket;															//Socket the left neighbour connected to, or -1
+	int m_nLeftSocket;																//Receives from rank - 1, or -1
+	int m_nRightSocket;																//Sends to rank + 1, or -1
+	string m_strListenAddress;														//Address this rank listens on, if a Unix domain socket path
+	bool m_bFailed;																	//True once a call has failed
+	vector<char> m_vecReceived;														//Segment arriving from the left, before it is added in
+
+	bool exchange(const void *send, size_t sendsize, void *receive,				//Sends sendsize bytes to the right while receiving receivesize bytes from the
+			size_t receivesize);													//   left, so neither neighbour waits on the other. Fails the ring on error.
+};
+
+const int SigmoidRing::RING_TIMEOUT_MS = 60000;
+
+//Constructor
+SigmoidRing::SigmoidRing() : m_nRank(0), m_nRankCount(1), m_nListenSocket(-1), m_nLeftSocket(-1), m_nRightSocket(-1), m_bFailed(false)
+{}
+
+SigmoidRing::~SigmoidRing()
+{
+	disconnect();
+}
+
+//Listens first, then connects to the right, retrying until that rank is listening, then accepts the left. Connecting
+// succeeds as soon as the right neighbour listens, before it accepts, so no order of startup deadlocks. Each rank then
+// sends its rank to the right, and checks the one arriving from the left.
+bool SigmoidRing::connect(const string &address, int rank, int rankcount, int timeoutseconds)
+{
+	disconnect();
+	if (rankcount < 1 || rank < 0 || rank >= rankcount)
+	{
+		cout << "ERROR: Invalid rank or rank count.\n";
+		return false;
+	}
+	m_nRank = rank;
+	m_nRankCount = rankcount;
+	m_bFailed = false;
+	if (rankcount == 1)
+		return true;
+
+	string strListenAddress = getRankAddress(address, rank);
+	m_nListenSocket = openLocalSocket(strListenAddress, true, true);
+	if (m_nListenSocket < 0)
+	{
+		m_bFailed = true;
+		return false;
+	}
+	m_strListenAddress = isTcpAddress(address) ? "" : strListenAddress;
+	chrono::steady_clock::time_point tDeadline = chrono::steady_clock::now() + chrono::seconds(timeoutseconds);
+	string strRightAddress = getRankAddress(address, (rank + 1) % rankcount);
+	while ((m_nRightSocket = openLocalSocket(strRightAddress, false, false)) < 0 && chrono::steady_clock::now() < tDeadline)
+		this_thread::sleep_for(chrono::milliseconds(50));
+	pollfd pfd;
+	pfd.fd = m_nListenSocket;
+	pfd.events = POLLIN;
+	int nWaitMs = (int)max((long long)0, (long long)chrono::duration_cast<chrono::milliseconds>(tDeadline - chrono::steady_clock::now()).count());
+	if (m_nRightSocket >= 0 && poll(&pfd, 1, nWaitMs) > 0)
+		m_nLeftSocket = accept(m_nListenSocket, NULL, NULL);
+	int32_t nLeftRank = -1;
+	int32_t nRank = rank;
+	if (m_nRightSocket < 0 || m_nLeftSocket < 0 || !writeFully(m_nRightSocket, &nRank, sizeof(nRank)) ||
+		!readFully(m_nLeftSocket, &nLeftRank, sizeof(nLeftRank)) || nLeftRank != (rank + rankcount - 1) % rankcount)
+	{
+		cout << "ERROR: Rank " << rank << " could not join the ring at " << address << ".\n";
+		disconnect();
+		m_bFailed = true;
+		return false;
+	}
+	int nFlag = 1;
+	setsockopt(m_nLeftSocket, IPPROTO_TCP, TCP_NODELAY, &nFlag, sizeof(nFlag));	//fails harmlessly on Unix domain sockets
+	fcntl(m_nLeftSocket, F_SETFL, fcntl(m_nLeftSocket, F_GETFL) | O_NONBLOCK);
+	fcntl(m_nRightSocket, F_SETFL, fcntl(m_nRightSocket, F_GETFL) | O_NONBLOCK);
+	return true;
+}
+
+void SigmoidRing::disconnect()
+{
+	if (m_nLeftSocket >= 0)
+		close(m_nLeftSocket);
+	if (m_nRightSocket >= 0)
+		close(m_nRightSocket);
+	if (m_nListenSocket >= 0)
+		close(m_nListenSocket);
+	if (m_strListenAddress != "")
+		unlink(m_strListenAddress.c_str());
+	m_nLeftSocket = m_nRightSocket = m_nListenSocket = -1;
+	m_strListenAddress = "";
+}
+
+//Segment i is data[i * count / ranks, (i + 1) * count / ranks). In reduce-scatter step s, rank r sends segment r - s
+// and adds in segment r - s - 1; after rankcount - 1 steps it holds segment r + 1 summed over every rank. In allgather
+// step s, it sends segment r + 1 - s and receives segment r - s in place.
+template <typename T>
+bool SigmoidRing::allreduce(T *data, size_t count)
+{
+	if (m_bFailed)
+		return false;
+	int n = m_nRankCount;
+	if (n == 1)
+		return true;
+	auto segmentStart = [&](int i) { i = (i % n + n) % n; return (size_t)i * count / n; };
+	auto segmentSize = [&](int i) { i = (i % n + n) % n; return (size_t)(i + 1) * count / n - (size_t)i * count / n; };
+	if (m_vecReceived.size() < (count / n + 1) * sizeof(T))
+		m_vecReceived.resize((count / n + 1) * sizeof(T));
+	T *pReceived = (T *)m_vecReceived.data();
+	for (int s = 0; s < n - 1; s++)
+	{
+		int nSend = m_nRank - s, nReceive = m_nRank - s - 1;
+		if (!exchange(data + segmentStart(nSend), segmentSize(nSend) * sizeof(T), pReceived, segmentSize(nReceive) * sizeof(T)))
+			return false;
+		SigmoidKernels::addScaledVector(data + segmentStart(nReceive), (T)1, pReceived, (int)segmentSize(nReceive));
+	}
+	for (int s = 0; s < n - 1; s++)
+	{
+		int nSend = m_nRank + 1 - s, nReceive = m_nRank - s;
+		if (!exchange(data + segmentStart(nSend), segmentSize(nSend) * sizeof(T), data + segmentStart(nReceive), segmentSize(nReceive) * sizeof(T)))
+			return false;
+	}
+	return true;
+}
+
+//Passed around the ring from root, each rank receiving from its left and forwarding to its right, but for the last
+template <typename T>
+bool SigmoidRing::broadcast(T *data, size_t count, int root)
+{
+	if (m_bFailed)
+		return false;
+	if (m_nRankCount == 1)
+		return true;
+	if (m_nRank != root && !exchange(NULL, 0, data, count * sizeof(T)))
+		return false;
+	if ((m_nRank + 1) % m_nRankCount != root && !exchange(data, count * sizeof(T), NULL, 0))
+		return false;
+	return true;
+}
+
+bool SigmoidRing::barrier()
+{
+	double dblToken = 1;
+	return allreduce(&dblToken, 1);
+}
+
+//Polls both sockets, sending and receiving whichever is ready. With blocking sends, two neighbours each sending more
+// than a socket buffer holds would wait on each other forever.
+bool SigmoidRing::exchange(const void *send, size_t sendsize, void *receive, size_t receivesize)
+{
+#ifdef MSG_NOSIGNAL
+	const int nFlags = MSG_NOSIGNAL;	//an exited neighbour must not raise SIGPIPE
+#else
+	const int nFlags = 0;
+#endif
+	const char *pSend = (const char *)send;
+	char *pReceive = (char *)receive;
+	while (sendsize > 0 || receivesize > 0)
+	{
+		pollfd pfds[2];
+		int nCount = 0;
+		if (sendsize > 0)
+		{
+			pfds[nCount].fd = m_nRightSocket;
+			pfds[nCount++].events = POLLOUT;
+		}
+		if (receivesize > 0)
+		{
+			pfds[nCount].fd = m_nLeftSocket;
+			pfds[nCount++].events = POLLIN;
+		}
+		bool bFailed = poll(pfds, nCount, RING_TIMEOUT_MS) <= 0;
+		for (int i = 0; i < nCount && !bFailed; i++)
+		{
+			if (pfds[i].revents == 0)
+				continue;
+			ssize_t nBytes;
+			if (pfds[i].fd == m_nRightSocket && sendsize > 0)
+			{
+				nBytes = ::send(m_nRightSocket, pSend, sendsize, nFlags);
+				if (nBytes > 0)
+				{
+					pSend += nBytes;
+					sendsize -= nBytes;
+				}
+			}
+			else
+			{
+				nBytes = recv(m_nLeftSocket, pReceive, receivesize, 0);
+				if (nBytes > 0)
+				{
+					pReceive += nBytes;
+					receivesize -= nBytes;
+				}
+			}
+			bFailed = nBytes == 0 || (nBytes < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+		}
+		if (bFailed)
+		{
+			cout << "ERROR: Rank " << m_nRank << " lost its connection to the ring.\n";
+			m_bFailed = true;
+			return false;
+		}
+	}
+	return true;
+}
+
+///Accessors
+int SigmoidRing::getRank() const
+{
+	return m_nRank;
+}
+int SigmoidRing::getRankCount() const
+{
+	return m_nRankCount;
+}
+bool SigmoidRing::hasFailed() const
+{
+	return m_bFailed;
+}
+string SigmoidRing::getRankAddress(const string &address, int rank)
+{
+	return isTcpAddress(address) ? to_string(atoi(address.c_str()) + rank) : address + "." + to_string(rank);
+}
@@ -0,0 +1,834 @@
+///////////////////////////////////////////
+// Vectorized versions of the innermost SigmoidKernels loops, with runtime CPU dispatch.
+//	Every kernel comes in double and float versions. Each has a scalar version and, on x86 with GCC or Clang, SSE2, AVX2
+//	(with FMA) and AVX-512 (F and BW) versions compiled with per-function target attributes, so no special compiler
+//	flags are needed. The widest version the CPU supports is selected once, at startup, and may be overridden with
+//	setKernelIsa().
+//
+//	Tolerance: vector versions sum in a different order than the scalar loops (and AVX2/AVX-512 use fused multiply-adds),
+//	so dot products and scaled vector sums agree with the scalar path to within about n * 2^-52 times the sum of the
+//	absolute values of the terms. The vectorized exp() used by calculateSigmoid() is accurate to a few ulp, so sigmoid
+//	outputs agree with the scalar path to within SIMD_SIGMOID_TOLERANCE (SIMD_SIGMOID_TOLERANCE_FLOAT for floats, whose
+//	vectorized exp() uses a shorter polynomial). Float kernels process twice as many elements per op.
+//	sigmoidRational() approximates the sigmoid as 0.5 + 0.5 * tanh(x / 2), with tanh a rational function of degree 13/6
+//	clamped outside +/- RATIONAL_ARG_LIMIT, so it needs no exp(). Its own error is documented with SigmoidActivation, in
+//	SigmoidKernels.h; its vector versions agree with its scalar version to within SIMD_SIGMOID_TOLERANCE(_FLOAT).
+//	dotRowsInt8() multiplies int8 weights by uint8 activations with 32-bit integer sums, so every version of it gives
+//	exactly the same result.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIGMOID_SIMD_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace SigmoidSimd
+{
+	enum KernelIsa { ISA_SCALAR, ISA_SSE2, ISA_AVX2, ISA_AVX512 };
+
+	const double SIMD_SIGMOID_TOLERANCE = 1e-14;							//Max absolute difference between vector and scalar sigmoid outputs
+	const double SIMD_SIGMOID_TOLERANCE_FLOAT = 1e-6;						//As above, for float kernels
+	const double EXP_ARG_LIMIT = 708.0;										//exp() args are clamped to +/- this so 2^n stays a normal double
+	const float EXP_ARG_LIMIT_FLOAT = 87.0f;								//As above, so 2^n stays a normal float
+	const double RATIONAL_ARG_LIMIT = 7.90531110763549805;					//tanh() args are clamped to +/- this, where the rational tanh() reaches +/- 1
+	const double RATIONAL_P[] = { -2.76076847742355e-16, 2.00018790482477e-13,	//Numerator of the rational tanh(y), a polynomial in y^2 (times y),
+		-8.60467152213735e-11, 5.12229709037114e-08, 1.48572235717979e-05,		//   highest power first
+		6.37261928875436e-04, 4.89352455891786e-03 };
+	const int RATIONAL_P_COUNT = 7;
+	const double RATIONAL_Q[] = { 1.19825839466702e-06, 1.18534705686654e-04,	//Denominator of the rational tanh(y), a polynomial in y^2
+		2.26843463243900e-03, 4.89352518554385e-03 };
+	const int RATIONAL_Q_COUNT = 4;
+
+	struct KernelTable														//The kernels selected for the running CPU
+	{
+		KernelIsa isa;
+		double (*dot)(const double *v1, const double *v2, int n);
+		void (*axpy)(double *y, double a, const double *x, int n);
+		void (*sigmoid)(double *v, int n);
+		float (*dotFloat)(const float *v1, const float *v2, int n);
+		void (*axpyFloat)(float *y, float a, const float *x, int n);
+		void (*sigmoidFloat)(float *v, int n);
+		void (*dotRowsInt8)(const int8_t *weights, const uint8_t *inputs,	//outputs[j] = weights row j . inputs, for rowcount rows of n weights
+				int32_t *outputs, int rowcount, int n);
+		void (*sigmoidRational)(double *v, int n);
+		void (*sigmoidRationalFloat)(float *v, int n);
+	};
+
+	KernelIsa getKernelIsa();												//Returns the instruction set the kernels currently run on
+	bool setKernelIsa(KernelIsa isa);										//Selects the kernels for isa. Returns false if the CPU does not support it
+	bool isKernelIsaSupported(KernelIsa isa);								//Returns true if the CPU supports isa
+	const char *getKernelIsaName(KernelIsa isa);							//Returns "scalar", "sse2", "avx2" or "avx512"
+	KernelIsa detectKernelIsa();											//Returns the widest instruction set the CPU supports
+	KernelTable getKernelTable(KernelIsa isa);								//Returns the kernels for isa
+
+	double dotScalar(const double *v1, const double *v2, int n);
+	void axpyScalar(double *y, double a, const double *x, int n);
+	void sigmoidScalar(double *v, int n);
+	float dotScalar(const float *v1, const float *v2, int n);
+	void axpyScalar(float *y, float a, const float *x, int n);
+	void sigmoidScalar(float *v, int n);
+	void dotRowsScalar(const int8_t *weights, const uint8_t *inputs, int32_t *outputs, int rowcount, int n);
+	void sigmoidRationalScalar(double *v, int n);
+	void sigmoidRationalScalar(float *v, int n);
+
+	KernelTable g_Kernels = getKernelTable(detectKernelIsa());				//Kernels in use. Called through by SigmoidKernels.
+}
+
+double SigmoidSimd::dotScalar(const double *v1, const double *v2, int n)
+{
+	double dblResult = 0;
+	for (int i = 0; i < n; i++)
+		dblResult += v1[i] * v2[i];
+	return dblResult;
+}
+
+void SigmoidSimd::axpyScalar(double *y, double a, const double *x, int n)
+{
+	for (int i = 0; i < n; i++)
+		y[i] += a * x[i];
+}
+
+void SigmoidSimd::sigmoidScalar(double *v, int n)
+{
+	for (int i = 0; i < n; i++)
+		v[i] = 1.f / (1.f + exp(-v[i]));
+}
+
+float SigmoidSimd::dotScalar(const float *v1, const float *v2, int n)
+{
+	float fResult = 0;
+	for (int i = 0; i < n; i++)
+		fResult += v1[i] * v2[i];
+	return fResult;
+}
+
+void SigmoidSimd::axpyScalar(float *y, float a, const float *x, int n)
+{
+	for (int i = 0; i < n; i++)
+		y[i] += a * x[i];
+}
+
+void SigmoidSimd::sigmoidScalar(float *v, int n)
+{
+	for (int i = 0; i < n; i++)
+		v[i] = 1.f / (1.f + exp(-v[i]));
+}
+
+void SigmoidSimd::dotRowsScalar(const int8_t *weights, const uint8_t *inputs, int32_t *outputs, int rowcount, int n)
+{
+	for (int j = 0; j < rowcount; j++)
+	{
+		const int8_t *pRow = weights + (size_t)j * n;
+		int32_t nSum = 0;
+		for (int i = 0; i < n; i++)
+			nSum += (int32_t)pRow[i] * (int32_t)inputs[i];
+		outputs[j] = nSum;
+	}
+}
+
+void SigmoidSimd::sigmoidRationalScalar(double *v, int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		double y = min(max(v[i] * 0.5, -RATIONAL_ARG_LIMIT), RATIONAL_ARG_LIMIT);
+		double y2 = y * y, p = RATIONAL_P[0], q = RATIONAL_Q[0];
+		for (int c = 1; c < RATIONAL_P_COUNT; c++)
+			p = p * y2 + RATIONAL_P[c];
+		for (int c = 1; c < RATIONAL_Q_COUNT; c++)
+			q = q * y2 + RATIONAL_Q[c];
+		v[i] = 0.5 + 0.5 * y * p / q;
+	}
+}
+
+void SigmoidSimd::sigmoidRationalScalar(float *v, int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		float y = min(max(v[i] * 0.5f, (float)-RATIONAL_ARG_LIMIT), (float)RATIONAL_ARG_LIMIT);
+		float y2 = y * y, p = (float)RATIONAL_P[0], q = (float)RATIONAL_Q[0];
+		for (int c = 1; c < RATIONAL_P_COUNT; c++)
+			p = p * y2 + (float)RATIONAL_P[c];
+		for (int c = 1; c < RATIONAL_Q_COUNT; c++)
+			q = q * y2 + (float)RATIONAL_Q[c];
+		v[i] = 0.5f + 0.5f * y * p / q;
+	}
+}
+
+#ifdef SIGMOID_SIMD_X86
+//exp(x) is evaluated as 2^n * exp(r), where n = round(x / ln2) and r = x - n * ln2, so |r| <= ln2 / 2. exp(r) is a
+// degree 13 Taylor polynomial, whose truncation error over that range is below 1e-17. Rounding to an integer and
+// building 2^n both use the 1.5 * 2^52 trick, which only needs SSE2 integer ops. The float version is the same with a
+// degree 7 polynomial (truncation error below 1e-8) and the 1.5 * 2^23 trick.
+namespace SigmoidSimd
+{
+	const double EXP_LOG2E = 1.4426950408889634;
+	const double EXP_LN2_HI = 0.693145751953125;							//ln2 split in two, so n * EXP_LN2_HI is exact
+	const double EXP_LN2_LO = 1.42860682030941723212e-6;
+	const double EXP_ROUND_MAGIC = 6755399441055744.0;						//1.5 * 2^52. Adding it rounds a double to an integer in its low bits
+	const double EXP_COEFFS[] = { 1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0,
+		1.0 / 362880.0, 1.0 / 40320.0, 1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0, 1.0 / 6.0, 0.5, 1.0, 1.0 };
+	const int EXP_COEFF_COUNT = 14;
+	const float EXP_LOG2E_FLOAT = 1.44269504f;
+	const float EXP_LN2_HI_FLOAT = 0.693359375f;
+	const float EXP_LN2_LO_FLOAT = -2.12194440e-4f;
+	const float EXP_ROUND_MAGIC_FLOAT = 12582912.0f;						//1.5 * 2^23
+	const float EXP_COEFFS_FLOAT[] = { 1.0f / 5040.0f, 1.0f / 720.0f, 1.0f / 120.0f, 1.0f / 24.0f, 1.0f / 6.0f, 0.5f, 1.0f, 1.0f };
+	const int EXP_COEFF_COUNT_FLOAT = 8;
+
+	__attribute__((target("sse2"))) double dotSse2(const double *v1, const double *v2, int n);
+	__attribute__((target("sse2"))) void axpySse2(double *y, double a, const double *x, int n);
+	__attribute__((target("sse2"))) void sigmoidSse2(double *v, int n);
+	__attribute__((target("avx2,fma"))) double dotAvx2(const double *v1, const double *v2, int n);
+	__attribute__((target("avx2,fma"))) void axpyAvx2(double *y, double a, const double *x, int n);
+	__attribute__((target("avx2,fma"))) void sigmoidAvx2(double *v, int n);
+	__attribute__((target("avx512f"))) double dotAvx512(const double *v1, const double *v2, int n);
+	__attribute__((target("avx512f"))) void axpyAvx512(double *y, double a, const double *x, int n);
+	__attribute__((target("avx512f"))) void sigmoidAvx512(double *v, int n);
+	__attribute__((target("sse2"))) float dotSse2(const float *v1, const float *v2, int n);
+	__attribute__((target("sse2"))) void axpySse2(float *y, float a, const float *x, int n);
+	__attribute__((target("sse2"))) void sigmoidSse2(float *v, int n);
+	__attribute__((target("avx2,fma"))) float dotAvx2(const float *v1, const float *v2, int n);
+	__attribute__((target("avx2,fma"))) void axpyAvx2(float *y, float a, const float *x, int n);
+	__attribute__((target("avx2,fma"))) void sigmoidAvx2(float *v, int n);
+	__attribute__((target("avx512f"))) float dotAvx512(const float *v1, const float *v2, int n);
+	__attribute__((target("avx512f"))) void axpyAvx512(float *y, float a, const float *x, int n);
+	__attribute__((target("avx512f"))) void sigmoidAvx512(float *v, int n);
+	__attribute__((target("sse2"))) void dotRowsSse2(const int8_t *weights, const uint8_t *inputs, int32_t *outputs, int rowcount, int n);
+	__attribute__((target("avx2,fma"))) void dotRowsAvx2(const int8_t *weights, const uint8_t *inputs, int32_t *outputs, int rowcount, int n);
+	__attribute__((target("avx512f,avx512bw"))) void dotRowsAvx512(const int8_t *weights, const uint8_t *inputs, int32_t *outputs, int rowcount, int n);
+	__attribute__((target("sse2"))) void sigmoidRationalSse2(double *v, int n);
+	__attribute__((target("sse2"))) void sigmoidRationalSse2(float *v, int n);
+	__attribute__((target("avx2,fma"))) void sigmoidRationalAvx2(double *v, int n);
+	__attribute__((target("avx2,fma"))) void sigmoidRationalAvx2(float *v, int n);
+	__attribute__((target("avx512f"))) void sigmoidRationalAvx512(double *v, int n);
+	__attribute__((target("avx512f"))) void sigmoidRationalAvx512(float *v, int n);
+}
+
+///SSE2: 2 doubles per op
+__attribute__((target("sse2"))) double SigmoidSimd::dotSse2(const double *v1, const double *v2, int n)
+{
+	__m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		sum0 = _mm_add_pd(sum0, _mm_mul_pd(_mm_loadu_pd(v1 + i), _mm_loadu_pd(v2 + i)));
+		sum1 = _mm_add_pd(sum1, _mm_mul_pd(_mm_loadu_pd(v1 + i + 2), _mm_loadu_pd(v2 + i + 2)));
+	}
+	sum0 = _mm_add_pd(sum0, sum1);
+	double dblResult = _mm_cvtsd_f64(_mm_add_sd(sum0, _mm_unpackhi_pd(sum0, sum0)));
+	for (; i < n; i++)
+		dblResult += v1[i] * v2[i];
+	return dblResult;
+}
+
+__attribute__((target("sse2"))) void SigmoidSimd::axpySse2(double *y, double a, const double *x, int n)
+{
+	__m128d va = _mm_set1_pd(a);
+	int i = 0;
+	for (; i + 2 <= n; i += 2)
+		_mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(va, _mm_loadu_pd(x + i))));
+	for (; i < n; i++)
+		y[i] += a * x[i];
+}
+
+__attribute__((target("sse2"))) void SigmoidSimd::sigmoidSse2(double *v, int n)
+{
+	const __m128d one = _mm_set1_pd(1.0), magic = _mm_set1_pd(EXP_ROUND_MAGIC);
+	const __m128i bias = _mm_set1_epi64x(1023);
+	int i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		__m128d x = _mm_sub_pd(_mm_setzero_pd(), _mm_loadu_pd(v + i));		//exp(-v)
+		x = _mm_min_pd(_mm_max_pd(x, _mm_set1_pd(-EXP_ARG_LIMIT)), _mm_set1_pd(EXP_ARG_LIMIT));
+		__m128d t = _mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(EXP_LOG2E)), magic);
+		__m128d fn = _mm_sub_pd(t, magic);
+		__m128d r = _mm_sub_pd(_mm_sub_pd(x, _mm_mul_pd(fn, _mm_set1_pd(EXP_LN2_HI))), _mm_mul_pd(fn, _mm_set1_pd(EXP_LN2_LO)));
+		__m128d p = _mm_set1_pd(EXP_COEFFS[0]);
+		for (int c = 1; c < EXP_COEFF_COUNT; c++)
+			p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(EXP_COEFFS[c]));
+		__m128i ni = _mm_sub_epi64(_mm_castpd_si128(t), _mm_castpd_si128(magic));
+		__m128d pow2n = _mm_castsi128_pd(_mm_slli_epi64(_mm_add_epi64(ni, bias), 52));
+		_mm_storeu_pd(v + i, _mm_div_pd(one, _mm_add_pd(one, _mm_mul_pd(p, pow2n))));
+	}
+	sigmoidScalar(v + i, n - i);
+}
+
+///SSE2: 4 floats per op
+__attribute__((target("sse2"))) float SigmoidSimd::dotSse2(const float *v1, const float *v2, int n)
+{
+	__m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(v1 + i), _mm_loadu_ps(v2 + i)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(v1 + i + 4), _mm_loadu_ps(v2 + i + 4)));
+	}
+	sum0 = _mm_add_ps(sum0, sum1);
+	sum0 = _mm_add_ps(sum0, _mm_movehl_ps(sum0, sum0));
+	float fResult = _mm_cvtss_f32(_mm_add_ss(sum0, _mm_shuffle_ps(sum0, sum0, 1)));
+	for (; i < n; i++)
+		fResult += v1[i] * v2[i];
+	return fResult;
+}
+
+__attribute__((target("sse2"))) void SigmoidSimd::axpySse2(float *y, float a, const float *x, int n)
+{
+	__m128 va = _mm_set1_ps(a);
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+		_mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(va, _mm_loadu_ps(x + i))));
+	for (; i < n; i++)
+		y[i] += a * x[i];
+}
+
+__attribute__((target("sse2"))) void SigmoidSimd::sigmoidSse2(float *v, int n)
+{
+	const __m128 one = _mm_set1_ps(1.0f), magic = _mm_set1_ps(EXP_ROUND_MAGIC_FLOAT);
+	const __m128i bias = _mm_set1_epi32(127);
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 x = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(v + i));		//exp(-v)
+		x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-EXP_ARG_LIMIT_FLOAT)), _mm_set1_ps(EXP_ARG_LIMIT_FLOAT));
+		__m128 t = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(EXP_LOG2E_FLOAT)), magic);
+		__m128 fn = _mm_sub_ps(t, magic);
+		__m128 r = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(fn, _mm_set1_ps(EXP_LN2_HI_FLOAT))), _mm_mul_ps(fn, _mm_set1_ps(EXP_LN2_LO_FLOAT)));
+		__m128 p = _mm_set1_ps(EXP_COEFFS_FLOAT[0]);
+		for (int c = 1; c < EXP_COEFF_COUNT_FLOAT; c++)
+			p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(EXP_COEFFS_FLOAT[c]));
+		__m128i ni = _mm_sub_epi32(_mm_castps_si128(t), _mm_castps_si128(magic));
+		__m128 pow2n = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(ni, bias), 23));
+		_mm_storeu_ps(v + i, _mm_div_ps(one, _mm_add_ps(one, _mm_mul_ps(p, pow2n))));
+	}
+	sigmoidScalar(v + i, n - i);
+}
+
+///AVX2: 4 doubles per op
+__attribute__((target("avx2,fma"))) double SigmoidSimd::dotAvx2(const double *v1, const double *v2, int n)
+{
+	__m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(v1 + i), _mm256_loadu_pd(v2 + i), sum0);
+		sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(v1 + i + 4), _mm256_loadu_pd(v2 + i + 4), sum1);
+	}
+	if (i + 4 <= n)
+	{
+		sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(v1 + i), _mm256_loadu_pd(v2 + i), sum0);
+		i += 4;
+	}
+	sum0 = _mm256_add_pd(sum0, sum1);
+	__m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum0), _mm256_extractf128_pd(sum0, 1));
+	double dblResult = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+	for (; i < n; i++)
+		dblResult += v1[i] * v2[i];
+	return dblResult;
+}
+
+__attribute__((target("avx2,fma"))) void SigmoidSimd::axpyAvx2(double *y, double a, const double *x, int n)
+{
+	__m256d va = _mm256_set1_pd(a);
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+		_mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+	for (; i < n; i++)
+		y[i] += a * x[i];
+}
+
+__attribute__((target("avx2,fma"))) void SigmoidSimd::sigmoidAvx2(double *v, int n)
+{
+	const __m256d one = _mm256_set1_pd(1.0), magic = _mm256_set1_pd(EXP_ROUND_MAGIC);
+	const __m256i bias = _mm256_set1_epi64x(1023);
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256d x = _mm256_sub_pd(_mm256_setzero_pd(), _mm256_loadu_pd(v + i));	//exp(-v)
+		x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(-EXP_ARG_LIMIT)), _mm256_set1_pd(EXP_ARG_LIMIT));
+		__m256d t = _mm256_fmadd_pd(x, _mm256_set1_pd(EXP_LOG2E), magic);
+		__m256d fn = _mm256_sub_pd(t, magic);
+		__m256d r = _mm256_fnmadd_pd(fn, _mm256_set1_pd(EXP_LN2_LO), _mm256_fnmadd_pd(fn, _mm256_set1_pd(EXP_LN2_HI), x));
+		__m256d p = _mm256_set1_pd(EXP_COEFFS[0]);
+		for (int c = 1; c < EXP_COEFF_COUNT; c++)
+			p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(EXP_COEFFS[c]));
+		__m256i ni = _mm256_sub_epi64(_mm256_castpd_si256(t), _mm256_castpd_si256(magic));
+		__m256d pow2n = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(ni, bias), 52));
+		_mm256_storeu_pd(v + i, _mm256_div_pd(one, _mm256_fmadd_pd(p, pow2n, one)));
+	}
+	sigmoidScalar(v + i, n - i);
+}
+
+///AVX2: 8 floats per op
+__attribute__((target("avx2,fma"))) float SigmoidSimd::dotAvx2(const float *v1, const float *v2, int n)
+{
+	__m256 sum0 = _mm256_setzero_ps(), sum1 = _mm256_setzero_ps();
+	int i = 0;
+	for (; i + 16 <= n; i += 16)
+	{
+		sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(v1 + i), _mm256_loadu_ps(v2 + i), sum0);
+		sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(v1 + i + 8), _mm256_loadu_ps(v2 + i + 8), sum1);
+	}
+	if (i + 8 <= n)
+	{
+		sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(v1 + i), _mm256_loadu_ps(v2 + i), sum0);
+		i += 8;
+	}
+	sum0 = _mm256_add_ps(sum0, sum1);
+	__m128 half = _mm_add_ps(_mm256_castps256_ps128(sum0), _mm256_extractf128_ps(sum0, 1));
+	half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+	float fResult = _mm_cvtss_f32(_mm_add_ss(half, _mm_shuffle_ps(half, half, 1)));
+	for (; i < n; i++)
+		fResult += v1[i] * v2[i];
+	return fResult;
+}
+
+__attribute__((target("avx2,fma"))) void SigmoidSimd::axpyAvx2(float *y, float a, const float *x, int n)
+{
+	__m256 va = _mm256_set1_ps(a);
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+		_mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+	for (; i < n; i++)
+		y[i] += a * x[i];
+}
+
+__attribute__((target("avx2,fma"))) void SigmoidSimd::sigmoidAvx2(float *v, int n)
+{
+	const __m256 one = _mm256_set1_ps(1.0f), magic = _mm256_set1_ps(EXP_ROUND_MAGIC_FLOAT);
+	const __m256i bias = _mm256_set1_epi32(127);
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 x = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(v + i));	//exp(-v)
+		x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-EXP_ARG_LIMIT_FLOAT)), _mm256_set1_ps(EXP_ARG_LIMIT_FLOAT));
+		__m256 t = _mm256_fmadd_ps(x, _mm256_set1_ps(EXP_LOG2E_FLOAT), magic);
+		__m256 fn = _mm256_sub_ps(t, magic);
+		__m256 r = _mm256_fnmadd_ps(fn, _mm256_set1_ps(EXP_LN2_LO_FLOAT), _mm256_fnmadd_ps(fn, _mm256_set1_ps(EXP_LN2_HI_FLOAT), x));
+		__m256 p = _mm256_set1_ps(EXP_COEFFS_FLOAT[0]);
+		for (int c = 1; c < EXP_COEFF_COUNT_FLOAT; c++)
+			p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP_COEFFS_FLOAT[c]));
+		__m256i ni = _mm256_sub_epi32(_mm256_castps_si256(t), _mm256_castps_si256(magic));
+		__m256 pow2n = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(ni, bias), 23));
+		_mm256_storeu_ps(v + i, _mm256_div_ps(one, _mm256_fmadd_ps(p, pow2n, one)));
+	}
+	sigmoidScalar(v + i, n - i);
+}
+
+///AVX-512: 8 doubles (or 16 floats) per op. Remainders are handled with masked loads and stores.
+// (GCC's AVX-512 intrinsics trip -Wuninitialized on their own _mm512_undefined_* placeholders when built with a target
+// attribute rather than -mavx512f, so those warnings are silenced here.)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f"))) double SigmoidSimd::dotAvx512(const double *v1, const double *v2, int n)
+{
+	__m512d sum = _mm512_setzero_pd();
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+		sum = _mm512_fmadd_pd(_mm512_loadu_pd(v1 + i), _mm512_loadu_pd(v2 + i), sum);
+	if (i < n)
+	{
+		__mmask8 mask = (__mmask8)((1u << (n - i)) - 1);
+		sum = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, v1 + i), _mm512_maskz_loadu_pd(mask, v2 + i), sum);
+	}
+	return _mm512_reduce_add_pd(sum);
+}
+
+__attribute__((target("avx512f"))) void SigmoidSimd::axpyAvx512(double *y, double a, const double *x, int n)
+{
+	__m512d va = _mm512_set1_pd(a);
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+		_mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+	if (i < n)
+	{
+		__mmask8 mask = (__mmask8)((1u << (n - i)) - 1);
+		_mm512_mask_storeu_pd(y + i, mask, _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i)));
+	}
+}
+
+__attribute__((target("avx512f"))) void SigmoidSimd::sigmoidAvx512(double *v, int n)
+{
+	const __m512d one = _mm512_set1_pd(1.0), magic = _mm512_set1_pd(EXP_ROUND_MAGIC);
+	const __m512i bias = _mm512_set1_epi64(1023);
+	for (int i = 0; i < n; i += 8)
+	{
+		__mmask8 mask = (n - i >= 8) ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+		__m512d x = _mm512_sub_pd(_mm512_setzero_pd(), _mm512_maskz_loadu_pd(mask, v + i));	//exp(-v)
+		x = _mm512_min_pd(_mm512_max_pd(x, _mm512_set1_pd(-EXP_ARG_LIMIT)), _mm512_set1_pd(EXP_ARG_LIMIT));
+		__m512d t = _mm512_fmadd_pd(x, _mm512_set1_pd(EXP_LOG2E), magic);
+		__m512d fn = _mm512_sub_pd(t, magic);
+		__m512d r = _mm512_fnmadd_pd(fn, _mm512_set1_pd(EXP_LN2_LO), _mm512_fnmadd_pd(fn, _mm512_set1_pd(EXP_LN2_HI), x));
+		__m512d p = _mm512_set1_pd(EXP_COEFFS[0]);
+		for (int c = 1; c < EXP_COEFF_COUNT; c++)
+			p = _mm512_fmadd_pd(p, r, _mm512_set1_pd(EXP_COEFFS[c]));
+		__m512i ni = _mm512_sub_epi64(_mm512_castpd_si512(t), _mm512_castpd_si512(magic));
+		__m512d pow2n = _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_add_epi64(ni, bias), 52));
+		_mm512_mask_storeu_pd(v + i, mask, _mm512_div_pd(one, _mm512_fmadd_pd(p, pow2n, one)));
+	}
+}
+//16 floats per op
+__attribute__((target("avx512f"))) float SigmoidSimd::dotAvx512(const float *v1, const float *v2, int n)
+{
+	__m512 sum = _mm512_setzero_ps();
+	int i = 0;
+	for (; i + 16 <= n; i += 16)
+		sum = _mm512_fmadd_ps(_mm512_loadu_ps(v1 + i), _mm512_loadu_ps(v2 + i), sum);
+	if (i < n)
+	{
+		__mmask16 mask = (__mmask16)((1u << (n - i)) - 1);
+		sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, v1 + i), _mm512_maskz_loadu_ps(mask, v2 + i), sum);
+	}
+	return _mm512_reduce_add_ps(sum);
+}
+
+__attribute__((target("avx512f"))) void SigmoidSimd::axpyAvx512(float *y, float a, const float *x, int n)
+{
+	__m512 va = _mm512_set1_ps(a);
+	int i = 0;
+	for (; i + 16 <= n; i += 16)
+		_mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+	if (i < n)
+	{
+		__mmask16 mask = (__mmask16)((1u << (n - i)) - 1);
+		_mm512_mask_storeu_ps(y + i, mask, _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(mask, x + i), _mm512_maskz_loadu_ps(mask, y + i)));
+	}
+}
+
+__attribute__((target("avx512f"))) void SigmoidSimd::sigmoidAvx512(float *v, int n)
+{
+	const __m512 one = _mm512_set1_ps(1.0f), magic = _mm512_set1_ps(EXP_ROUND_MAGIC_FLOAT);
+	const __m512i bias = _mm512_set1_epi32(127);
+	for (int i = 0; i < n; i += 16)
+	{
+		__mmask16 mask = (n - i >= 16) ? (__mmask16)0xFFFF : (__mmask16)((1u << (n - i)) - 1);
+		__m512 x = _mm512_sub_ps(_mm512_setzero_ps(), _mm512_maskz_loadu_ps(mask, v + i));	//exp(-v)
+		x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(-EXP_ARG_LIMIT_FLOAT)), _mm512_set1_ps(EXP_ARG_LIMIT_FLOAT));
+		__m512 t = _mm512_fmadd_ps(x, _mm512_set1_ps(EXP_LOG2E_FLOAT), magic);
+		__m512 fn = _mm512_sub_ps(t, magic);
+		__m512 r = _mm512_fnmadd_ps(fn, _mm512_set1_ps(EXP_LN2_LO_FLOAT), _mm512_fnmadd_ps(fn, _mm512_set1_ps(EXP_LN2_HI_FLOAT), x));
+		__m512 p = _mm512_set1_ps(EXP_COEFFS_FLOAT[0]);
+		for (int c = 1; c < EXP_COEFF_COUNT_FLOAT; c++)
+			p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(EXP_COEFFS_FLOAT[c]));
+		__m512i ni = _mm512_sub_epi32(_mm512_castps_si512(t), _mm512_castps_si512(magic));
+		__m512 pow2n = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(ni, bias), 23));
+		_mm512_mask_storeu_ps(v + i, mask, _mm512_div_ps(one, _mm512_fmadd_ps(p, pow2n, one)));
+	}
+}
+#pragma GCC diagnostic pop
+
+///int8 x uint8 dot products. Both operands are widened to 16 bits and multiplied pairwise into 32-bit sums
+// (pmaddwd), which cannot overflow: each pair sums to at most 2 * 128 * 255. Rows are taken four at a time, sharing
+// each widened load of inputs, and their four sums are reduced together. A short last block repeats its last row.
+//16 weights per op
+__attribute__((target("sse2"))) void SigmoidSimd::dotRowsSse2(const int8_t *weights, const uint8_t *inputs, int32_t *outputs, int rowcount, int n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	int nVectorEnd = n / 16 * 16;
+	for (int j = 0; j < rowcount; j += 4)
+	{
+		int nRows = min(4, rowcount - j);
+		const int8_t *pRows[4] = { weights + (size_t)j * n, weights + (size_t)(j + min(1, nRows - 1)) * n,
+			weights + (size_t)(j + min(2, nRows - 1)) * n, weights + (size_t)(j + nRows - 1) * n };
+		__m128i sum0 = zero, sum1 = zero, sum2 = zero, sum3 = zero;
+		for (int i = 0; i < nVectorEnd; i += 16)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i *)(inputs + i));
+			__m128i aLo = _mm_unpacklo_epi8(a, zero);
+			__m128i aHi = _mm_unpackhi_epi8(a, zero);
+			__m128i w0 = _mm_loadu_si128((const __m128i *)(pRows[0] + i));
+			__m128i w1 = _mm_loadu_si128((const __m128i *)(pRows[1] + i));
+			__m128i w2 = _mm_loadu_si128((const __m128i *)(pRows[2] + i));
+			__m128i w3 = _mm_loadu_si128((const __m128i *)(pRows[3] + i));
+			//sign extend by unpacking each byte into the high half of a word and shifting it down
+			sum0 = _mm_add_epi32(sum0, _mm_add_epi32(_mm_madd_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(w0, w0), 8), aLo),
+				_mm_madd_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(w0, w0), 8), aHi)));
+			sum1 = _mm_add_epi32(sum1, _mm_add_epi32(_mm_madd_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(w1, w1), 8), aLo),
+				_mm_madd_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(w1, w1), 8), aHi)));
+			sum2 = _mm_add_epi32(sum2, _mm_add_epi32(_mm_madd_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(w2, w2), 8), aLo),
+				_mm_madd_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(w2, w2), 8), aHi)));
+			sum3 = _mm_add_epi32(sum3, _mm_add_epi32(_mm_madd_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(w3, w3), 8), aLo),
+				_mm_madd_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(w3, w3), 8), aHi)));
+		}
+		//transpose-and-add, leaving row r's total in lane r
+		__m128i s01 = _mm_add_epi32(_mm_unpacklo_epi32(sum0, sum1), _mm_unpackhi_epi32(sum0, sum1));
+		__m128i s23 = _mm_add_epi32(_mm_unpacklo_epi32(sum2, sum3), _mm_unpackhi_epi32(sum2, sum3));
+		int32_t nSums[4];
+		_mm_storeu_si128((__m128i *)nSums, _mm_add_epi32(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23)));
+		for (int r = 0; r < nRows; r++)
+		{
+			for (int i = nVectorEnd; i < n; i++)
+				nSums[r] += (int32_t)pRows[r][i] * (int32_t)inputs[i];
+			outputs[j + r] = nSums[r];
+		}
+	}
+}
+
+//16 weights per op
+__attribute__((target("avx2,fma"))) void SigmoidSimd::dotRowsAvx2(const int8_t *weights, const uint8_t *inputs, int32_t *outputs, int rowcount, int n)
+{
+	int nVectorEnd = n / 16 * 16;
+	for (int j = 0; j < rowcount; j += 4)
+	{
+		int nRows = min(4, rowcount - j);
+		const int8_t *pRows[4] = { weights + (size_t)j * n, weights + (size_t)(j + min(1, nRows - 1)) * n,
+			weights + (size_t)(j + min(2, nRows - 1)) * n, weights + (size_t)(j + nRows - 1) * n };
+		__m256i sum0 = _mm256_setzero_si256(), sum1 = sum0, sum2 = sum0, sum3 = sum0;
+		for (int i = 0; i < nVectorEnd; i += 16)
+		{
+			__m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(inputs + i)));
+			sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(pRows[0] + i))), a));
+			sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(pRows[1] + i))), a));
+			sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(pRows[2] + i))), a));
+			sum3 = _mm256_add_epi32(sum3, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(pRows[3] + i))), a));
+		}
+		//hadd within each 128-bit lane leaves row r's partial totals in lane r of both halves
+		__m256i s = _mm256_hadd_epi32(_mm256_hadd_epi32(sum0, sum1), _mm256_hadd_epi32(sum2, sum3));
+		int32_t nSums[4];
+		_mm_storeu_si128((__m128i *)nSums, _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1)));
+		for (int r = 0; r < nRows; r++)
+		{
+			for (int i = nVectorEnd; i < n; i++)
+				nSums[r] += (int32_t)pRows[r][i] * (int32_t)inputs[i];
+			outputs[j + r] = nSums[r];
+		}
+	}
+}
+
+//32 weights per op, folded to 256 bits for a last 16 and reduced as for AVX2. Warnings silenced as for the AVX-512
+// kernels above.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f,avx512bw"))) void SigmoidSimd::dotRowsAvx512(const int8_t *weights, const uint8_t *inputs, int32_t *outputs, int rowcount, int n)
+{
+	int nWideEnd = n / 32 * 32;
+	int nVectorEnd = n / 16 * 16;
+	for (int j = 0; j < rowcount; j += 4)
+	{
+		int nRows = min(4, rowcount - j);
+		const int8_t *pRows[4] = { weights + (size_t)j * n, weights + (size_t)(j + min(1, nRows - 1)) * n,
+			weights + (size_t)(j + min(2, nRows - 1)) * n, weights + (size_t)(j + nRows - 1) * n };
+		__m512i wide0 = _mm512_setzero_si512(), wide1 = wide0, wide2 = wide0, wide3 = wide0;
+		for (int i = 0; i < nWideEnd; i += 32)
+		{
+			__m512i a = _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(inputs + i)));
+			wide0 = _mm512_add_epi32(wide0, _mm512_madd_epi16(_mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i *)(pRows[0] + i))), a));
+			wide1 = _mm512_add_epi32(wide1, _mm512_madd_epi16(_mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i *)(pRows[1] + i))), a));
+			wide2 = _mm512_add_epi32(wide2, _mm512_madd_epi16(_mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i *)(pRows[2] + i))), a));
+			wide3 = _mm512_add_epi32(wide3, _mm512_madd_epi16(_mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i *)(pRows[3] + i))), a));
+		}
+		__m256i sum0 = _mm256_add_epi32(_mm512_castsi512_si256(wide0), _mm512_extracti64x4_epi64(wide0, 1));
+		__m256i sum1 = _mm256_add_epi32(_mm512_castsi512_si256(wide1), _mm512_extracti64x4_epi64(wide1, 1));
+		__m256i sum2 = _mm256_add_epi32(_mm512_castsi512_si256(wide2), _mm512_extracti64x4_epi64(wide2, 1));
+		__m256i sum3 = _mm256_add_epi32(_mm512_castsi512_si256(wide3), _mm512_extracti64x4_epi64(wide3, 1));
+		if (nWideEnd < nVectorEnd)
+		{
+			__m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(inputs + nWideEnd)));
+			sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(pRows[0] + nWideEnd))), a));
+			sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(pRows[1] + nWideEnd))), a));
+			sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(pRows[2] + nWideEnd))), a));
+			sum3 = _mm256_add_epi32(sum3, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(pRows[3] + nWideEnd))), a));
+		}
+		__m256i s = _mm256_hadd_epi32(_mm256_hadd_epi32(sum0, sum1), _mm256_hadd_epi32(sum2, sum3));
+		int32_t nSums[4];
+		_mm_storeu_si128((__m128i *)nSums, _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1)));
+		for (int r = 0; r < nRows; r++)
+		{
+			for (int i = nVectorEnd; i < n; i++)
+				nSums[r] += (int32_t)pRows[r][i] * (int32_t)inputs[i];
+			outputs[j + r] = nSums[r];
+		}
+	}
+}
+#pragma GCC diagnostic pop
+
+///Rational sigmoid approximations. Each lane is clamped, then the numerator and denominator polynomials are evaluated
+// side by side with Horner's rule, leaving one division per lane.
+__attribute__((target("sse2"))) void SigmoidSimd::sigmoidRationalSse2(double *v, int n)
+{
+	const __m128d half = _mm_set1_pd(0.5);
+	int i = 0;
+	for (; i + 2 <= n; i += 2)
+	{
+		__m128d y = _mm_mul_pd(_mm_loadu_pd(v + i), half);
+		y = _mm_min_pd(_mm_max_pd(y, _mm_set1_pd(-RATIONAL_ARG_LIMIT)), _mm_set1_pd(RATIONAL_ARG_LIMIT));
+		__m128d y2 = _mm_mul_pd(y, y), p = _mm_set1_pd(RATIONAL_P[0]), q = _mm_set1_pd(RATIONAL_Q[0]);
+		for (int c = 1; c < RATIONAL_P_COUNT; c++)
+			p = _mm_add_pd(_mm_mul_pd(p, y2), _mm_set1_pd(RATIONAL_P[c]));
+		for (int c = 1; c < RATIONAL_Q_COUNT; c++)
+			q = _mm_add_pd(_mm_mul_pd(q, y2), _mm_set1_pd(RATIONAL_Q[c]));
+		_mm_storeu_pd(v + i, _mm_add_pd(half, _mm_div_pd(_mm_mul_pd(_mm_mul_pd(half, y), p), q)));
+	}
+	sigmoidRationalScalar(v + i, n - i);
+}
+
+__attribute__((target("sse2"))) void SigmoidSimd::sigmoidRationalSse2(float *v, int n)
+{
+	const __m128 half = _mm_set1_ps(0.5f);
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 y = _mm_mul_ps(_mm_loadu_ps(v + i), half);
+		y = _mm_min_ps(_mm_max_ps(y, _mm_set1_ps((float)-RATIONAL_ARG_LIMIT)), _mm_set1_ps((float)RATIONAL_ARG_LIMIT));
+		__m128 y2 = _mm_mul_ps(y, y), p = _mm_set1_ps((float)RATIONAL_P[0]), q = _mm_set1_ps((float)RATIONAL_Q[0]);
+		for (int c = 1; c < RATIONAL_P_COUNT; c++)
+			p = _mm_add_ps(_mm_mul_ps(p, y2), _mm_set1_ps((float)RATIONAL_P[c]));
+		for (int c = 1; c < RATIONAL_Q_COUNT; c++)
+			q = _mm_add_ps(_mm_mul_ps(q, y2), _mm_set1_ps((float)RATIONAL_Q[c]));
+		_mm_storeu_ps(v + i, _mm_add_ps(half, _mm_div_ps(_mm_mul_ps(_mm_mul_ps(half, y), p), q)));
+	}
+	sigmoidRationalScalar(v + i, n - i);
+}
+
+__attribute__((target("avx2,fma"))) void SigmoidSimd::sigmoidRationalAvx2(double *v, int n)
+{
+	const __m256d half = _mm256_set1_pd(0.5);
+	int i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256d y = _mm256_mul_pd(_mm256_loadu_pd(v + i), half);
+		y = _mm256_min_pd(_mm256_max_pd(y, _mm256_set1_pd(-RATIONAL_ARG_LIMIT)), _mm256_set1_pd(RATIONAL_ARG_LIMIT));
+		__m256d y2 = _mm256_mul_pd(y, y), p = _mm256_set1_pd(RATIONAL_P[0]), q = _mm256_set1_pd(RATIONAL_Q[0]);
+		for (int c = 1; c < RATIONAL_P_COUNT; c++)
+			p = _mm256_fmadd_pd(p, y2, _mm256_set1_pd(RATIONAL_P[c]));
+		for (int c = 1; c < RATIONAL_Q_COUNT; c++)
+			q = _mm256_fmadd_pd(q, y2, _mm256_set1_pd(RATIONAL_Q[c]));
+		_mm256_storeu_pd(v + i, _mm256_add_pd(half, _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(half, y), p), q)));
+	}
+	sigmoidRationalScalar(v + i, n - i);
+}
+
+__attribute__((target("avx2,fma"))) void SigmoidSimd::sigmoidRationalAvx2(float *v, int n)
+{
+	const __m256 half = _mm256_set1_ps(0.5f);
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 y = _mm256_mul_ps(_mm256_loadu_ps(v + i), half);
+		y = _mm256_min_ps(_mm256_max_ps(y, _mm256_set1_ps((float)-RATIONAL_ARG_LIMIT)), _mm256_set1_ps((float)RATIONAL_ARG_LIMIT));
+		__m256 y2 = _mm256_mul_ps(y, y), p = _mm256_set1_ps((float)RATIONAL_P[0]), q = _mm256_set1_ps((float)RATIONAL_Q[0]);
+		for (int c = 1; c < RATIONAL_P_COUNT; c++)
+			p = _mm256_fmadd_ps(p, y2, _mm256_set1_ps((float)RATIONAL_P[c]));
+		for (int c = 1; c < RATIONAL_Q_COUNT; c++)
+			q = _mm256_fmadd_ps(q, y2, _mm256_set1_ps((float)RATIONAL_Q[c]));
+		_mm256_storeu_ps(v + i, _mm256_add_ps(half, _mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(half, y), p), q)));
+	}
+	sigmoidRationalScalar(v + i, n - i);
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f"))) void SigmoidSimd::sigmoidRationalAvx512(double *v, int n)
+{
+	const __m512d half = _mm512_set1_pd(0.5);
+	for (int i = 0; i < n; i += 8)
+	{
+		__mmask8 mask = (n - i >= 8) ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+		__m512d y = _mm512_mul_pd(_mm512_maskz_loadu_pd(mask, v + i), half);
+		y = _mm512_min_pd(_mm512_max_pd(y, _mm512_set1_pd(-RATIONAL_ARG_LIMIT)), _mm512_set1_pd(RATIONAL_ARG_LIMIT));
+		__m512d y2 = _mm512_mul_pd(y, y), p = _mm512_set1_pd(RATIONAL_P[0]), q = _mm512_set1_pd(RATIONAL_Q[0]);
+		for (int c = 1; c < RATIONAL_P_COUNT; c++)
+			p = _mm512_fmadd_pd(p, y2, _mm512_set1_pd(RATIONAL_P[c]));
+		for (int c = 1; c < RATIONAL_Q_COUNT; c++)
+			q = _mm512_fmadd_pd(q, y2, _mm512_set1_pd(RATIONAL_Q[c]));
+		_mm512_mask_storeu_pd(v + i, mask, _mm512_add_pd(half, _mm512_div_pd(_mm512_mul_pd(_mm512_mul_pd(half, y), p), q)));
+	}
+}
+
+__attribute__((target("avx512f"))) void SigmoidSimd::sigmoidRationalAvx512(float *v, int n)
+{
+	const __m512 half = _mm512_set1_ps(0.5f);
+	for (int i = 0; i < n; i += 16)
+	{
+		__mmask16 mask = (n - i >= 16) ? (__mmask16)0xFFFF : (__mmask16)((1u << (n - i)) - 1);
+		__m512 y = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, v + i), half);
+		y = _mm512_min_ps(_mm512_max_ps(y, _mm512_set1_ps((float)-RATIONAL_ARG_LIMIT)), _mm512_set1_ps((float)RATIONAL_ARG_LIMIT));
+		__m512 y2 = _mm512_mul_ps(y, y), p = _mm512_set1_ps((float)RATIONAL_P[0]), q = _mm512_set1_ps((float)RATIONAL_Q[0]);
+		for (int c = 1; c < RATIONAL_P_COUNT; c++)
+			p = _mm512_fmadd_ps(p, y2, _mm512_set1_ps((float)RATIONAL_P[c]));
+		for (int c = 1; c < RATIONAL_Q_COUNT; c++)
+			q = _mm512_fmadd_ps(q, y2, _mm512_set1_ps((float)RATIONAL_Q[c]));
+		_mm512_mask_storeu_ps(v + i, mask, _mm512_add_ps(half, _mm512_div_ps(_mm512_mul_ps(_mm512_mul_ps(half, y), p), q)));
+	}
+}
+#pragma GCC diagnostic pop
+#endif
+
+bool SigmoidSimd::isKernelIsaSupported(KernelIsa isa)
+{
+	if (isa == ISA_SCALAR)
+		return true;
+#ifdef SIGMOID_SIMD_X86
+	__builtin_cpu_init();
+	if (isa == ISA_SSE2)
+		return __builtin_cpu_supports("sse2");
+	if (isa == ISA_AVX2)
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	if (isa == ISA_AVX512)
+		return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+	return false;
+}
+
+SigmoidSimd::KernelIsa SigmoidSimd::detectKernelIsa()
+{
+	if (isKernelIsaSupported(ISA_AVX512))
+		return ISA_AVX512;
+	if (isKernelIsaSupported(ISA_AVX2))
+		return ISA_AVX2;
+	if (isKernelIsaSupported(ISA_SSE2))
+		return ISA_SSE2;
+	return ISA_SCALAR;
+}
+
+SigmoidSimd::KernelTable SigmoidSimd::getKernelTable(KernelIsa isa)
+{
+	KernelTable table = { ISA_SCALAR, dotScalar, axpyScalar, sigmoidScalar, dotScalar, axpyScalar, sigmoidScalar, dotRowsScalar, sigmoidRationalScalar, sigmoidRationalScalar };
+#ifdef SIGMOID_SIMD_X86
+	if (isa == ISA_SSE2)
+	{
+		KernelTable t = { ISA_SSE2, dotSse2, axpySse2, sigmoidSse2, dotSse2, axpySse2, sigmoidSse2, dotRowsSse2, sigmoidRationalSse2, sigmoidRationalSse2 };
+		table = t;
+	}
+	else if (isa == ISA_AVX2)
+	{
+		KernelTable t = { ISA_AVX2, dotAvx2, axpyAvx2, sigmoidAvx2, dotAvx2, axpyAvx2, sigmoidAvx2, dotRowsAvx2, sigmoidRationalAvx2, sigmoidRationalAvx2 };
+		table = t;
+	}
+	else if (isa == ISA_AVX512)
+	{
+		KernelTable t = { ISA_AVX512, dotAvx512, axpyAvx512, sigmoidAvx512, dotAvx512, axpyAvx512, sigmoidAvx512, dotRowsAvx512, sigmoidRationalAvx512, sigmoidRationalAvx512 };
+		table = t;
+	}
+#endif
+	return table;
+}
+
+SigmoidSimd::KernelIsa SigmoidSimd::getKernelIsa()
+{
+	return g_Kernels.isa;
+}
+
+bool SigmoidSimd::setKernelIsa(KernelIsa isa)
+{
+	if (!isKernelIsaSupported(isa))
+		return false;
+	g_Kernels = getKernelTable(isa);
+	return true;
+}
+
+const char *SigmoidSimd::getKernelIsaName(KernelIsa isa)
+{
+	const char *NAMES[] = { "scalar", "sse2", "avx2", "avx512" };
+	return NAMES[isa];
+}
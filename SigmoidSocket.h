@@ -0,0 +1,117 @@
+///////////////////////////////////////////
+// Socket utilities for talking between processes on one host: SigmoidInferenceServer and its clients, and the ranks of
+// a SigmoidRing. An address is a TCP port number on 127.0.0.1 if it is all digits, and a Unix domain socket path
+// otherwise. TCP sockets have Nagle's algorithm turned off, since every message here is latency-bound. POSIX only.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <string>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace std;
+
+bool isTcpAddress(const string &address);									//Returns true if address is a TCP port number
+int openLocalSocket(const string &address, bool listening, bool verbose);	//Returns a listening socket bound to address, or one connected to it. Returns -1,
+																			//   with an error msg if verbose, on failure.
+bool readFully(int fd, void *buffer, size_t size);							//Reads exactly size bytes. Returns false on error or end of stream.
+bool writeFully(int fd, const void *buffer, size_t size);					//Writes exactly size bytes. Returns false on error.
+
+bool isTcpAddress(const string &address)
+{
+	return !address.empty() && address.find_first_not_of("0123456789") == string::npos;
+}
+
+//Sets up a socket of the family address names, and binds and listens, or connects
+int openLocalSocket(const string &address, bool listening, bool verbose)
+{
+	bool bTcp = isTcpAddress(address);
+	int nSocket = socket(bTcp ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
+	if (nSocket < 0)
+	{
+		cout << "ERROR: Could not create a socket for " << address << ".\n";
+		return -1;
+	}
+	int nResult;
+	if (bTcp)
+	{
+		int nFlag = 1;
+		setsockopt(nSocket, IPPROTO_TCP, TCP_NODELAY, &nFlag, sizeof(nFlag));	//small requests and responses must not wait on Nagle's algorithm
+		if (listening)
+			setsockopt(nSocket, SOL_SOCKET, SO_REUSEADDR, &nFlag, sizeof(nFlag));
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons((uint16_t)atoi(address.c_str()));
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		nResult = listening ? ::bind(nSocket, (sockaddr *)&addr, sizeof(addr)) : ::connect(nSocket, (sockaddr *)&addr, sizeof(addr));
+	}
+	else
+	{
+		sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (address.size() >= sizeof(addr.sun_path))
+		{
+			cout << "ERROR: Socket path " << address << " is too long.\n";
+			close(nSocket);
+			return -1;
+		}
+		strcpy(addr.sun_path, address.c_str());
+		if (listening)
+			unlink(address.c_str());
+		nResult = listening ? ::bind(nSocket, (sockaddr *)&addr, sizeof(addr)) : ::connect(nSocket, (sockaddr *)&addr, sizeof(addr));
+	}
+	if (nResult == 0 && listening)
+		nResult = listen(nSocket, SOMAXCONN);
+	if (nResult != 0)
+	{
+		if (verbose)
+			cout << "ERROR: Could not " << (listening ? "listen on " : "connect to ") << address << ".\n";
+		close(nSocket);
+		return -1;
+	}
+	return nSocket;
+}
+
+bool readFully(int fd, void *buffer, size_t size)
+{
+	char *p = (char *)buffer;
+	while (size > 0)
+	{
+		ssize_t nRead = recv(fd, p, size, 0);
+		if (nRead <= 0)
+			return false;
+		p += nRead;
+		size -= nRead;
+	}
+	return true;
+}
+
+bool writeFully(int fd, const void *buffer, size_t size)
+{
+	const char *p = (const char *)buffer;
+#ifdef MSG_NOSIGNAL
+	const int nFlags = MSG_NOSIGNAL;	//a closed peer must not raise SIGPIPE
+#else
+	const int nFlags = 0;
+#endif
+	while (size > 0)
+	{
+		ssize_t nWritten = send(fd, p, size, nFlags);
+		if (nWritten <= 0)
+			return false;
+		p += nWritten;
+		size -= nWritten;
+	}
+	return true;
+}
@@ -0,0 +1,373 @@
+///////////////////////////////////////////
+// A hyperparameter sweep: trains and validates one SigmoidNetwork for every combination of the learning rates,
+//	iteration counts, topologies, biases, bias weights and batch sizes listed in a sweep file, and tabulates the results.
+//	Each combination is an independent job on a ThreadPool. Every job trains its own network, on one thread, against
+//	the same read-only training and validation sets, so the data is loaded once however many jobs run at once.
+//	Jobs are queued longest first (by iterations x weights), so no long job is left to run alone at the end.
+//	Each network's weights are drawn from rand() reseeded with the sweep's seed, under a lock, so every configuration
+//	starts from the same weights as it would in a serial run, and results do not depend on the thread count.
+//
+//	A sweep file holds one "key = value, value, ..." line per setting. Blank lines and lines starting with # are ignored.
+//	   training_data, validation_data	Data files, binary or CSV (see SigmoidDataSet.h)
+//	   learning_rates, iterations		Grid values. Every combination of every list is run.
+//	   topologies						Comma separated; each a space separated list of layer sizes. Ex: 16 14 26, 16 20 26
+//	   biases, bias_weights, batch_sizes
+//	   seed								rand() seed for initial weights. 0 = time(NULL). Default 1.
+//	   threads							Jobs run at once. 0 = one per core. Default 0.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include "SigmoidNetwork.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+struct SweepConfig
+{
+	vector<int> vecLayers;													//Network topology. Ex: {16, 14, 26}
+	double dblLearningRate;
+	int nIterations;														//Passes over the training set
+	double dblBias;															//Bias of every neuron
+	double dblBiasWeight;													//Initial bias weight of every neuron
+	int nBatchSize;															//Rows per weight update
+};
+
+struct SweepResult
+{
+	int nCorrect;															//Validation rows classified correctly
+	double dblAccuracy;														//nCorrect as a percentage of validation rows
+	double dblTrainingSeconds;												//Wall time of doTraining()
+	double dblSeconds;														//Wall time of the whole job: build, train and validate
+	double dblSamplesPerSecond;												//Training rows learned from per second
+};
+
+template <typename T>
+class SigmoidSweep
+{
+public:
+	SigmoidSweep();															//Constructor. Empty until loadSweepFile() is called.
+	bool loadSweepFile(const string &filename);								//Reads a sweep file. Returns false, with an error msg, on failure.
+	void run(const SigmoidDataSet<T> &trainingset,							//Runs every configuration, getThreadCount() at a time, reporting each to the
+			const SigmoidDataSet<T> &validationset, bool verbose);			//   console as it finishes if verbose
+	void outputResults(ostream &out) const;									//Outputs the results table as CSV, one row per configuration
+	int getConfigCount() const;												//Returns the number of configurations
+	const SweepConfig &getConfig(int index) const;							//Returns configuration index, in grid order
+	const SweepResult &getResult(int index) const;							//Returns the result of configuration index, once run() has returned
+	const string &getTrainingFile() const;									//Returns m_strTrainingFile
+	const string &getValidationFile() const;								//Returns m_strValidationFile
+	int getThreadCount() const;												//Returns the number of jobs run at once
+	double getSeconds() const;												//Returns the wall time of the last run()
+
+private:
+	vector<SweepConfig> m_vecConfigs;										//Every combination of the grid values
+	vector<SweepResult> m_vecResults;										//Result of each configuration. Same order as m_vecConfigs.
+	string m_strTrainingFile;												//training_data
+	string m_strValidationFile;												//validation_data
+	unsigned int m_nSeed;													//rand() seed for every network's initial weights
+	int m_nThreadCount;														//Jobs run at once. 0 = one per core.
+	double m_dblSeconds;													//Wall time of the last run()
+
+	void runConfig(int index, const SigmoidDataSet<T> &trainingset,		//Builds, trains and validates configuration index into m_vecResults[index]
+			const SigmoidDataSet<T> &validationset);
+	static bool parseNumbers(const string &text, vector<double> &values);	//Parses a comma or space separated list of numbers. Returns false if any is invalid.
+};
+
+//Constructor
+template <typename T>
+SigmoidSweep<T>::SigmoidSweep() : m_nSeed(1), m_nThreadCount(0), m_dblSeconds(0)
+{}
+
+//Reads filename and builds the grid: every combination of its topologies, batch sizes, biases, bias weights, iteration
+// counts and learning rates (varying fastest, in that order). Every grid key must be given at least one value.
+template <typename T>
+bool SigmoidSweep<T>::loadSweepFile(const string &filename)
+{
+	ifstream fsIn(filename.c_str());
+	if (fsIn.fail())
+	{
+		cout << "ERROR: Sweep file " << filename << " could not be opened.\n";
+		return false;
+	}
+
+	vector<double> vRates, vIterations, vBiases, vBiasWeights, vBatchSizes;
+	vector<vector<int>> vTopologies;
+	string strLine;
+	for (int nLine = 1; getline(fsIn, strLine); nLine++)
+	{
+		size_t nStart = strLine.find_first_not_of(" \t\r");
+		if (nStart == string::npos || strLine[nStart] == '#')
+			continue;
+		size_t nEquals = strLine.find('=');
+		if (nEquals == string::npos)
+		{
+			cout << "ERROR: " << filename << " line " << nLine << " is not of the form key = value.\n";
+			return false;
+		}
+		string strKey = strLine.substr(nStart, strLine.find_last_not_of(" \t", nEquals - 1) + 1 - nStart);
+		string strValue = strLine.substr(nEquals + 1);
+		size_t nValueStart = strValue.find_first_not_of(" \t");
+		strValue = (nValueStart == string::npos) ? "" : strValue.substr(nValueStart, strValue.find_last_not_of(" \t\r") + 1 - nValueStart);
+
+		bool bValid = true;
+		vector<double> vValues;
+		if (strKey == "training_data")
+			m_strTrainingFile = strValue;
+		else if (strKey == "validation_data")
+			m_strValidationFile = strValue;
+		else if (strKey == "topologies")
+		{
+			stringstream ssTopologies(strValue);
+			string strTopology;
+			while (bValid && getline(ssTopologies, strTopology, ','))
+			{
+				bValid = parseNumbers(strTopology, vValues) && vValues.size() >= 2;
+				vTopologies.push_back(vector<int>(vValues.begin(), vValues.end()));
+				for (unsigned int i = 0; i < vValues.size(); i++)
+					bValid = bValid && vValues[i] >= 1 && vValues[i] == (int)vValues[i];
+			}
+		}
+		else if (strKey == "learning_rates" || strKey == "iterations" || strKey == "biases" || strKey == "bias_weights" ||
+			strKey == "batch_sizes" || strKey == "seed" || strKey == "threads")
+		{
+			bValid = parseNumbers(strValue, vValues) && !vValues.empty();
+			if (strKey == "learning_rates")
+				vRates = vValues;
+			else if (strKey == "biases")
+				vBiases = vValues;
+			else if (strKey == "bias_weights")
+				vBiasWeights = vValues;
+			else
+			{
+				//the rest are counts: whole, and at least 1 (0 is allowed for seed and threads, meaning "choose for me")
+				double dblMin = (strKey == "seed" || strKey == "threads") ? 0 : 1;
+				for (unsigned int i = 0; i < vValues.size(); i++)
+					bValid = bValid && vValues[i] >= dblMin && vValues[i] == (long long)vValues[i];
+				if (strKey == "iterations")
+					vIterations = vValues;
+				else if (strKey == "batch_sizes")
+					vBatchSizes = vValues;
+				else if (strKey == "seed")
+					m_nSeed = bValid ? (unsigned int)vValues[0] : 0;
+				else
+					m_nThreadCount = bValid ? (int)vValues[0] : 0;
+			}
+		}
+		else
+		{
+			cout << "ERROR: " << filename << " line " << nLine << ": unknown key " << strKey << ".\n";
+			return false;
+		}
+		if (!bValid)
+		{
+			cout << "ERROR: " << filename << " line " << nLine << ": invalid value for " << strKey << ".\n";
+			return false;
+		}
+	}
+	if (m_strTrainingFile == "" || m_strValidationFile == "" || vRates.empty() || vIterations.empty() || vTopologies.empty() ||
+		vBiases.empty() || vBiasWeights.empty() || vBatchSizes.empty())
+	{
+		cout << "ERROR: " << filename << " must give training_data, validation_data, learning_rates, iterations, topologies, "
+			"biases, bias_weights and batch_sizes.\n";
+		return false;
+	}
+	if (m_nSeed == 0)
+		m_nSeed = (unsigned int)time(NULL);
+
+	m_vecConfigs.clear();
+	for (unsigned int t = 0; t < vTopologies.size(); t++)
+		for (unsigned int s = 0; s < vBatchSizes.size(); s++)
+			for (unsigned int b = 0; b < vBiases.size(); b++)
+				for (unsigned int w = 0; w < vBiasWeights.size(); w++)
+					for (unsigned int i = 0; i < vIterations.size(); i++)
+						for (unsigned int r = 0; r < vRates.size(); r++)
+						{
+							SweepConfig config;
+							config.vecLayers = vTopologies[t];
+							config.dblLearningRate = vRates[r];
+							config.nIterations = (int)vIterations[i];
+							config.dblBias = vBiases[b];
+							config.dblBiasWeight = vBiasWeights[w];
+							config.nBatchSize = (int)vBatchSizes[s];
+							m_vecConfigs.push_back(config);
+						}
+	m_vecResults.assign(m_vecConfigs.size(), SweepResult());
+	return true;
+}
+
+//Queues every configuration on a pool of getThreadCount() workers, longest job first, and waits for them all
+template <typename T>
+void SigmoidSweep<T>::run(const SigmoidDataSet<T> &trainingset, const SigmoidDataSet<T> &validationset, bool verbose)
+{
+	chrono::steady_clock::time_point tStart = chrono::steady_clock::now();
+	int nInputs = trainingset.getParamCount();
+	int nLabels = 0;	//one more than the highest label in either set
+	for (int i = 0; i < trainingset.getRowCount(); i++)
+		nLabels = max(nLabels, trainingset.getLabel(i) + 1);
+	for (int i = 0; i < validationset.getRowCount(); i++)
+		nLabels = max(nLabels, validationset.getLabel(i) + 1);
+	vector<int> vOrder;
+	for (int i = 0; i < getConfigCount(); i++)
+	{
+		const vector<int> &vLayers = m_vecConfigs[i].vecLayers;
+		if (vLayers[0] != nInputs || vLayers.back() < nLabels)
+			cout << "ERROR: Configuration " << i << " needs " << nInputs << " inputs and at least " << nLabels << " outputs. Skipped.\n";
+		else
+			vOrder.push_back(i);
+	}
+
+	//estimate each job's cost as iterations x weights (the work per row is proportional to the weight count)
+	vector<double> vCost(getConfigCount(), 0);
+	for (unsigned int j = 0; j < vOrder.size(); j++)
+	{
+		const SweepConfig &config = m_vecConfigs[vOrder[j]];
+		double dblWeights = 0;
+		for (unsigned int i = 1; i < config.vecLayers.size(); i++)
+			dblWeights += (config.vecLayers[i - 1] + 1.0) * config.vecLayers[i];
+		vCost[vOrder[j]] = config.nIterations * dblWeights;
+	}
+	stable_sort(vOrder.begin(), vOrder.end(), [&vCost](int a, int b) { return vCost[a] > vCost[b]; });
+
+	mutex mtxOutput;
+	int nFinished = 0;
+	{
+		ThreadPool pool(getThreadCount());
+		for (unsigned int j = 0; j < vOrder.size(); j++)
+		{
+			int nIndex = vOrder[j];
+			pool.enqueue([&, nIndex]
+			{
+				runConfig(nIndex, trainingset, validationset);
+				if (verbose)
+				{
+					lock_guard<mutex> lock(mtxOutput);
+					const SweepResult &result = m_vecResults[nIndex];
+					cout << "Finished " << ++nFinished << " of " << vOrder.size() << ": configuration " << nIndex << " (LR = " <<
+						m_vecConfigs[nIndex].dblLearningRate << " Iterations = " << m_vecConfigs[nIndex].nIterations << ") " <<
+						result.dblAccuracy << "% in " << result.dblSeconds << "s\n";
+				}
+			});
+		}
+		pool.wait();
+	}
+	m_dblSeconds = chrono::duration<double>(chrono::steady_clock::now() - tStart).count();
+}
+
+//Builds configuration index's network from the sweep's seed, trains it on the calling thread and validates it.
+// rand() is shared by every thread, so it is reseeded and drawn from under a lock.
+template <typename T>
+void SigmoidSweep<T>::runConfig(int index, const SigmoidDataSet<T> &trainingset, const SigmoidDataSet<T> &validationset)
+{
+	static mutex mtxRand;
+	const SweepConfig &config = m_vecConfigs[index];
+	SweepResult &result = m_vecResults[index];
+	chrono::steady_clock::time_point tStart = chrono::steady_clock::now();
+	unique_ptr<SigmoidNetwork<T>> pNetwork;
+	{
+		lock_guard<mutex> lock(mtxRand);
+		srand(m_nSeed);
+		pNetwork.reset(new SigmoidNetwork<T>(config.vecLayers.data(), (int)config.vecLayers.size(), config.dblLearningRate,
+			config.dblBias, config.dblBiasWeight, false));
+	}
+	pNetwork->setBatchSize(config.nBatchSize);
+
+	chrono::steady_clock::time_point tTrain = chrono::steady_clock::now();
+	pNetwork->doTraining(trainingset, config.nIterations);
+	result.dblTrainingSeconds = chrono::duration<double>(chrono::steady_clock::now() - tTrain).count();
+
+	vector<int> vClassifications(validationset.getRowCount());
+	pNetwork->classifyBatch(validationset.getFeatures(), validationset.getRowCount(), vClassifications.data(), NULL);
+	result.nCorrect = 0;
+	for (int i = 0; i < validationset.getRowCount(); i++)
+		result.nCorrect += vClassifications[i] == validationset.getLabel(i);
+	result.dblAccuracy = 100.0 * result.nCorrect / max(validationset.getRowCount(), 1);
+	result.dblSamplesPerSecond = (double)config.nIterations * trainingset.getRowCount() / max(result.dblTrainingSeconds, 1e-9);
+	result.dblSeconds = chrono::duration<double>(chrono::steady_clock::now() - tStart).count();
+}
+
+//Outputs one CSV row per configuration, in grid order. Layers are separated by spaces.
+template <typename T>
+void SigmoidSweep<T>::outputResults(ostream &out) const
+{
+	out << "Config,Layers,LR,Iterations,Bias,Bias Weight,Batch Size,Correct,Accuracy,Training Seconds,Seconds,Samples/sec\n";
+	for (int i = 0; i < getConfigCount(); i++)
+	{
+		const SweepConfig &config = m_vecConfigs[i];
+		const SweepResult &result = m_vecResults[i];
+		out << i << ",";
+		for (unsigned int l = 0; l < config.vecLayers.size(); l++)
+			out << (l ? " " : "") << config.vecLayers[l];
+		out << "," << config.dblLearningRate << "," << config.nIterations << "," << config.dblBias << "," << config.dblBiasWeight << "," <<
+			config.nBatchSize << "," << result.nCorrect << "," << result.dblAccuracy << "," << result.dblTrainingSeconds << "," <<
+			result.dblSeconds << "," << result.dblSamplesPerSecond << endl;
+	}
+}
+
+//Parses every number in text, separated by commas and/or whitespace, into values
+template <typename T>
+bool SigmoidSweep<T>::parseNumbers(const string &text, vector<double> &values)
+{
+	values.clear();
+	string strText = text;
+	replace(strText.begin(), strText.end(), ',', ' ');
+	stringstream ssText(strText);
+	string strNumber;
+	while (ssText >> strNumber)
+	{
+		char *pEnd = NULL;
+		double dblValue = strtod(strNumber.c_str(), &pEnd);
+		if (*pEnd != '\0')
+			return false;
+		values.push_back(dblValue);
+	}
+	return true;
+}
+
+///Accessors
+template <typename T>
+int SigmoidSweep<T>::getConfigCount() const
+{
+	return (int)m_vecConfigs.size();
+}
+template <typename T>
+const SweepConfig &SigmoidSweep<T>::getConfig(int index) const
+{
+	return m_vecConfigs[index];
+}
+template <typename T>
+const SweepResult &SigmoidSweep<T>::getResult(int index) const
+{
+	return m_vecResults[index];
+}
+template <typename T>
+const string &SigmoidSweep<T>::getTrainingFile() const
+{
+	return m_strTrainingFile;
+}
+template <typename T>
+const string &SigmoidSweep<T>::getValidationFile() const
+{
+	return m_strValidationFile;
+}
+template <typename T>
+int SigmoidSweep<T>::getThreadCount() const
+{
+	if (m_nThreadCount > 0)
+		return m_nThreadCount;
+	return max((int)thread::hardware_concurrency(), 1);
+}
+template <typename T>
+double SigmoidSweep<T>::getSeconds() const
+{
+	return m_dblSeconds;
+}
@@ -0,0 +1,180 @@
+///////////////////////////////////////////
+// Training telemetry: the metrics SigmoidNetwork reports after every training epoch, and an exporter for them.
+//	Every epoch reports its wall time, rows learned from per second and mean loss (output layer error per row), at the
+//	cost of two clock reads per epoch. Metrics reach the caller through the callback given to
+//	SigmoidNetwork::setEpochCallback(). SigmoidMetricsLog is one such callback: it keeps every epoch's metrics and
+//	writes them as CSV or JSON.
+//	Finer timing is compiled in only on request. With SIGMOID_TELEMETRY defined (to 1) before this file is first
+//	included, training also times its forward pass, backward pass and weight updates with SIGMOID_TIMED_SCOPE; defined
+//	to 2, it also times each layer's share of the forward and backward passes with SIGMOID_TIMED_LAYER_SCOPE. Otherwise
+//	both macros expand to nothing, so the hot paths compile exactly as they would without them, and those times are
+//	reported as 0. Timers accumulate into the SigmoidTrainingTimes of the workspace doing the work, so threads never
+//	share one; an epoch's times are the sum over every training thread, and may exceed its wall time.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <functional>
+#include <chrono>
+
+using namespace std;
+
+#define SIGMOID_CONCAT_INNER(a, b) a##b
+#define SIGMOID_CONCAT(a, b) SIGMOID_CONCAT_INNER(a, b)
+#if defined(SIGMOID_TELEMETRY) && SIGMOID_TELEMETRY >= 1
+#define SIGMOID_TIMED_SCOPE(seconds) SigmoidScopedTimer SIGMOID_CONCAT(sigmoidTimer, __LINE__)(seconds)	//Adds the time until the end of the enclosing scope to seconds
+#else
+#define SIGMOID_TIMED_SCOPE(seconds)
+#endif
+#if defined(SIGMOID_TELEMETRY) && SIGMOID_TELEMETRY >= 2
+#define SIGMOID_TIMED_LAYER_SCOPE(seconds) SigmoidScopedTimer SIGMOID_CONCAT(sigmoidTimer, __LINE__)(seconds)	//As above, for per-layer times
+#else
+#define SIGMOID_TIMED_LAYER_SCOPE(seconds)
+#endif
+
+//Adds the wall time of its own lifetime to a running total
+class SigmoidScopedTimer
+{
+public:
+	SigmoidScopedTimer(double &seconds) : m_dblSeconds(seconds), m_tStart(chrono::steady_clock::now()) {}
+	~SigmoidScopedTimer() { m_dblSeconds += chrono::duration<double>(chrono::steady_clock::now() - m_tStart).count(); }
+
+private:
+	double &m_dblSeconds;															//Running total
+	chrono::steady_clock::time_point m_tStart;										//Construction time
+};
+
+struct SigmoidTrainingTimes															//Time spent in each part of training, in seconds
+{
+	double dblForwardSeconds;														//Forward passes
+	double dblBackwardSeconds;														//Output and hidden layer deltas, and batch gradients
+	double dblUpdateSeconds;														//Weight updates
+	vector<double> vecLayerForwardSeconds;											//Forward pass, by layer. Index 0 (the input layer) is unused.
+	vector<double> vecLayerBackwardSeconds;											//Backward pass, by layer: deltas propagated into it and, in batches, its gradients
+
+	SigmoidTrainingTimes() : dblForwardSeconds(0), dblBackwardSeconds(0), dblUpdateSeconds(0) {}
+	void reset(int layercount)														//Zeroes every time, for a network of layercount layers
+	{
+		dblForwardSeconds = dblBackwardSeconds = dblUpdateSeconds = 0;
+		vecLayerForwardSeconds.assign(layercount, 0);
+		vecLayerBackwardSeconds.assign(layercount, 0);
+	}
+	void add(const SigmoidTrainingTimes &times)										//Adds times, which must be for the same layer count
+	{
+		dblForwardSeconds += times.dblForwardSeconds;
+		dblBackwardSeconds += times.dblBackwardSeconds;
+		dblUpdateSeconds += times.dblUpdateSeconds;
+		for (unsigned int i = 0; i < vecLayerForwardSeconds.size() && i < times.vecLayerForwardSeconds.size(); i++)
+		{
+			vecLayerForwardSeconds[i] += times.vecLayerForwardSeconds[i];
+			vecLayerBackwardSeconds[i] += times.vecLayerBackwardSeconds[i];
+		}
+	}
+};
+
+struct SigmoidEpochMetrics															//What SigmoidNetwork reports after each training epoch
+{
+	int nEpoch;																		//Epochs done, including those done before the network was saved
+	int nRows;																		//Rows learned from
+	double dblSeconds;																//Wall time of the epoch
+	double dblSamplesPerSecond;														//nRows / dblSeconds
+	double dblLoss;																	//Mean output layer error per row
+	double dblLastError;															//Error of the last row (or batch), as VERBOSE outputs
+	double dblLearningRate;															//Learning rate the epoch trained at
+	SigmoidTrainingTimes times;														//Time in each phase. All 0 unless SIGMOID_TELEMETRY is defined.
+};
+
+typedef function<void(const SigmoidEpochMetrics &)> SigmoidEpochCallback;		//Called on the training thread after each epoch
+
+class SigmoidMetricsLog
+{
+public:
+	void add(const SigmoidEpochMetrics &metrics);									//Appends one epoch's metrics
+	SigmoidEpochCallback getCallback();												//Returns a callback that add()s to this log, for SigmoidNetwork::setEpochCallback()
+	const vector<SigmoidEpochMetrics> &getEpochs() const;							//Returns every epoch added, in order
+	void clear();																	//Drops every epoch
+	void outputCsv(ostream &out) const;												//Outputs one CSV row per epoch. Layer times are space separated.
+	void outputJson(ostream &out) const;											//Outputs {"epochs": [...]}, one epoch per line
+	bool save(const string &filename) const;										//Writes the log as JSON if filename ends in .json, else as CSV.
+																					//   Returns false, with an error msg, on failure.
+
+private:
+	vector<SigmoidEpochMetrics> m_vecEpochs;										//Every epoch added
+};
+
+void SigmoidMetricsLog::add(const SigmoidEpochMetrics &metrics)
+{
+	m_vecEpochs.push_back(metrics);
+}
+
+SigmoidEpochCallback SigmoidMetricsLog::getCallback()
+{
+	return [this](const SigmoidEpochMetrics &metrics) { add(metrics); };
+}
+
+const vector<SigmoidEpochMetrics> &SigmoidMetricsLog::getEpochs() const
+{
+	return m_vecEpochs;
+}
+
+void SigmoidMetricsLog::clear()
+{
+	m_vecEpochs.clear();
+}
+
+void SigmoidMetricsLog::outputCsv(ostream &out) const
+{
+	out << "Epoch,Rows,Seconds,Samples/sec,Loss,Last Error,Learning Rate,Forward Seconds,Backward Seconds,Update Seconds,"
+		"Layer Forward Seconds,Layer Backward Seconds\n";
+	for (unsigned int e = 0; e < m_vecEpochs.size(); e++)
+	{
+		const SigmoidEpochMetrics &m = m_vecEpochs[e];
+		out << m.nEpoch << "," << m.nRows << "," << m.dblSeconds << "," << m.dblSamplesPerSecond << "," << m.dblLoss << "," <<
+			m.dblLastError << "," << m.dblLearningRate << "," << m.times.dblForwardSeconds << "," << m.times.dblBackwardSeconds << "," << m.times.dblUpdateSeconds << ",";
+		for (unsigned int i = 1; i < m.times.vecLayerForwardSeconds.size(); i++)
+			out << (i > 1 ? " " : "") << m.times.vecLayerForwardSeconds[i];
+		out << ",";
+		for (unsigned int i = 1; i < m.times.vecLayerBackwardSeconds.size(); i++)
+			out << (i > 1 ? " " : "") << m.times.vecLayerBackwardSeconds[i];
+		out << "\n";
+	}
+}
+
+void SigmoidMetricsLog::outputJson(ostream &out) const
+{
+	out << "{\"epochs\": [\n";
+	for (unsigned int e = 0; e < m_vecEpochs.size(); e++)
+	{
+		const SigmoidEpochMetrics &m = m_vecEpochs[e];
+		out << "  {\"epoch\": " << m.nEpoch << ", \"rows\": " << m.nRows << ", \"seconds\": " << m.dblSeconds << ", \"samples_per_sec\": " <<
+			m.dblSamplesPerSecond << ", \"loss\": " << m.dblLoss << ", \"last_error\": " << m.dblLastError << ", \"learning_rate\": " <<
+			m.dblLearningRate << ", \"forward_seconds\": " << m.times.dblForwardSeconds << ", \"backward_seconds\": " <<
+			m.times.dblBackwardSeconds << ", \"update_seconds\": " << m.times.dblUpdateSeconds << ", \"layer_forward_seconds\": [";
+		for (unsigned int i = 1; i < m.times.vecLayerForwardSeconds.size(); i++)
+			out << (i > 1 ? ", " : "") << m.times.vecLayerForwardSeconds[i];
+		out << "], \"layer_backward_seconds\": [";
+		for (unsigned int i = 1; i < m.times.vecLayerBackwardSeconds.size(); i++)
+			out << (i > 1 ? ", " : "") << m.times.vecLayerBackwardSeconds[i];
+		out << "]}" << (e + 1 < m_vecEpochs.size() ? "," : "") << "\n";
+	}
+	out << "]}\n";
+}
+
+bool SigmoidMetricsLog::save(const string &filename) const
+{
+	ofstream fsOut(filename.c_str());
+	if (filename.size() >= 5 && filename.compare(filename.size() - 5, 5, ".json") == 0)
+		outputJson(fsOut);
+	else
+		outputCsv(fsOut);
+	if (fsOut.fail())
+	{
+		cout << "ERROR: Metrics file " << filename << " could not be written.\n";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,250 @@
+///////////////////////////////////////////
+// Validates a SigmoidNetwork while it trains, and stops training once validation accuracy stops improving.
+//	Every getInterval() epochs, onEpoch() copies the network's weights into a snapshot and hands it to a background
+//	thread, which classifies the validation set with it and fills a ConfusionMatrix while training goes on. If the
+//	thread is still busy when the next snapshot is taken, the newer snapshot replaces the one waiting, so training never
+//	waits on validation; validation just runs less often.
+//	A snapshot more accurate than every one before it becomes the best. Once the best is patience or more epochs older
+//	than the latest snapshot validated, the validator calls SigmoidNetwork::stopTraining(). Since validation runs behind
+//	training, a few more epochs may be trained before the network stops. finish() waits for the last snapshot, and with
+//	keepbest, puts the best snapshot's weights back into the network.
+//	Connect a validator to its network with setEpochCallback(validator.getCallback()), or call onEpoch() from a callback
+//	of your own. The network must not be resized (e.g. by setTrainingThreads()) while the validator exists.
+//	With setValidationThreads(), each snapshot is classified on several threads, each taking an equal share of the
+//	validation set and counting into a ConfusionMatrix shard of its own, which are merged only when read.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "SigmoidNetwork.h"
+#include "ConfusionMatrix.h"
+
+using namespace std;
+
+struct SigmoidValidation															//The result of validating one snapshot
+{
+	int nEpoch;																		//Epoch the snapshot was taken after
+	int nCorrect;																	//Validation rows classified correctly
+	double dblAccuracy;																//nCorrect / validation rows
+};
+
+template <typename T>
+class SigmoidValidator
+{
+public:
+	SigmoidValidator(SigmoidNetwork<T> &network,									//Constructor. Validates snapshots of network against validationset, whose labels
+			const SigmoidDataSet<T> &validationset, const string &labels,			//   index labels, every interval epochs. patience = 0 never stops training.
+			int interval, int patience, bool keepbest);								//   Both network and validationset must outlive the validator.
+	~SigmoidValidator();															//Stops the validation thread, abandoning any snapshot not yet validated
+	void onEpoch(const SigmoidEpochMetrics &metrics);								//Takes a snapshot, if metrics.nEpoch is due one. Call on the training thread.
+	SigmoidEpochCallback getCallback();												//Returns a callback that calls onEpoch(), for SigmoidNetwork::setEpochCallback()
+	void finish();																	//Waits for the snapshot in progress, and any waiting, to be validated. Then, if
+																					//   keepbest and a snapshot was validated, restores the best one's weights.
+	bool hasStopped() const;														//Returns true if the validator has called stopTraining()
+	int getBestEpoch() const;														//Returns the epoch of the best snapshot, or 0 if none has been validated
+	double getBestAccuracy() const;													//Returns the accuracy of the best snapshot
+	ConfusionMatrix getBestMatrix() const;											//Returns the confusion matrix of the best snapshot
+	vector<SigmoidValidation> getValidations() const;								//Returns every snapshot validated, in order
+	int getInterval() const;														//Returns m_nInterval
+	void setValidationThreads(int threadcount);										//Classifies each snapshot on threadcount threads. Call before the first snapshot.
+
+private:
+	SigmoidNetwork<T> &m_Network;													//The network being trained
+	const SigmoidDataSet<T> &m_ValidationSet;										//Rows to validate against
+	string m_strLabels;																//Confusion matrix labels
+	int m_nInterval;																//Epochs between snapshots
+	int m_nPatience;																//Epochs without improvement before training stops. 0 = never stop.
+	bool m_bKeepBest;																//finish() restores the best snapshot's weights
+	unique_ptr<SigmoidNetwork<T>> m_pSnapshot;										//Network the validation thread classifies with
+	vector<T> m_vecPendingParams;													//Weights of the snapshot waiting to be validated
+	vector<T> m_vecBestParams;														//Weights of the best snapshot
+	vector<int> m_vecClassifications;												//Classification of each validation row
+	int m_nThreadCount;																//Threads each snapshot is classified on
+	unique_ptr<ThreadPool> m_pThreadPool;											//Validation threads, if m_nThreadCount > 1
+	vector<SigmoidValidation> m_vecValidations;										//Every snapshot validated, in order
+	ConfusionMatrix m_BestMatrix;													//Confusion matrix of the best snapshot
+	int m_nPendingEpoch;															//Epoch of the waiting snapshot. 0 = none waiting.
+	int m_nBestEpoch;																//Epoch of the best snapshot. 0 = none validated.
+	double m_dblBestAccuracy;														//Accuracy of the best snapshot
+	bool m_bBusy;																	//True while the validation thread is validating a snapshot
+	bool m_bStopped;																//True once the validator has called stopTraining()
+	bool m_bStopping;																//True once the validation thread should exit
+	thread m_Worker;																//Validation thread
+	mutable mutex m_Mutex;															//Guards every member the validation thread touches, but m_pSnapshot
+	condition_variable m_SnapshotReady;												//Signalled when a snapshot is waiting, or the thread should exit
+	condition_variable m_SnapshotDone;												//Signalled when the thread finishes a snapshot
+
+	void runWorker();																//Validation thread loop. Validates snapshots until m_bStopping.
+	SigmoidValidation validate(ConfusionMatrix &matrix);							//Classifies the validation set with m_pSnapshot, filling matrix
+};
+
+//Constructor. Starts the validation thread.
+template <typename T>
+SigmoidValidator<T>::SigmoidValidator(SigmoidNetwork<T> &network, const SigmoidDataSet<T> &validationset, const string &labels,
+	int interval, int patience, bool keepbest) : m_Network(network), m_ValidationSet(validationset), m_strLabels(labels),
+	m_nInterval(interval < 1 ? 1 : interval), m_nPatience(patience), m_bKeepBest(keepbest), m_pSnapshot(network.clone()),
+	m_vecPendingParams(network.getParamCount()), m_vecClassifications(validationset.getRowCount()), m_nThreadCount(1),
+	m_BestMatrix((int)labels.size(), labels), m_nPendingEpoch(0), m_nBestEpoch(0), m_dblBestAccuracy(0), m_bBusy(false),
+	m_bStopped(false), m_bStopping(false)
+{
+	m_Worker = thread(&SigmoidValidator<T>::runWorker, this);
+}
+
+template <typename T>
+SigmoidValidator<T>::~SigmoidValidator()
+{
+	{
+		lock_guard<mutex> lock(m_Mutex);
+		m_bStopping = true;
+	}
+	m_SnapshotReady.notify_all();
+	m_Worker.join();
+}
+
+//Copies the network's weights into the waiting snapshot, replacing any snapshot still waiting from an earlier epoch
+template <typename T>
+void SigmoidValidator<T>::onEpoch(const SigmoidEpochMetrics &metrics)
+{
+	if (metrics.nEpoch % m_nInterval != 0)
+		return;
+	{
+		lock_guard<mutex> lock(m_Mutex);
+		m_Network.getParams(m_vecPendingParams.data());
+		m_nPendingEpoch = metrics.nEpoch;
+	}
+	m_SnapshotReady.notify_one();
+}
+
+template <typename T>
+SigmoidEpochCallback SigmoidValidator<T>::getCallback()
+{
+	return [this](const SigmoidEpochMetrics &metrics) { onEpoch(metrics); };
+}
+
+template <typename T>
+void SigmoidValidator<T>::finish()
+{
+	unique_lock<mutex> lock(m_Mutex);
+	m_SnapshotDone.wait(lock, [this] { return m_nPendingEpoch == 0 && !m_bBusy; });
+	if (m_bKeepBest && m_nBestEpoch > 0)
+		m_Network.setParams(m_vecBestParams.data());
+}
+
+//Takes each waiting snapshot in turn and validates it, outside the lock, so onEpoch() can queue the next meanwhile
+template <typename T>
+void SigmoidValidator<T>::runWorker()
+{
+	unique_lock<mutex> lock(m_Mutex);
+	while (true)
+	{
+		m_SnapshotReady.wait(lock, [this] { return m_nPendingEpoch != 0 || m_bStopping; });
+		if (m_bStopping)
+			return;
+		int nEpoch = m_nPendingEpoch;
+		m_pSnapshot->setParams(m_vecPendingParams.data());
+		m_nPendingEpoch = 0;
+		m_bBusy = true;
+		lock.unlock();
+
+		ConfusionMatrix matrix((int)m_strLabels.size(), m_strLabels, m_nThreadCount);
+		SigmoidValidation validation = validate(matrix);
+		validation.nEpoch = nEpoch;
+
+		lock.lock();
+		m_vecValidations.push_back(validation);
+		if (m_nBestEpoch == 0 || validation.dblAccuracy > m_dblBestAccuracy)
+		{
+			m_nBestEpoch = nEpoch;
+			m_dblBestAccuracy = validation.dblAccuracy;
+			m_BestMatrix = matrix;
+			m_vecBestParams.resize(m_pSnapshot->getParamCount());
+			m_pSnapshot->getParams(m_vecBestParams.data());
+		}
+		else if (m_nPatience > 0 && nEpoch - m_nBestEpoch >= m_nPatience && !m_bStopped)
+		{
+			m_bStopped = true;
+			m_Network.stopTraining();
+		}
+		m_bBusy = false;
+		m_SnapshotDone.notify_all();
+	}
+}
+
+//Splits the validation set into one contiguous share per shard of matrix. Each share is classified, with the
+// snapshot's const inference path, and counted into its own shard, on a thread of its own if there are several.
+template <typename T>
+SigmoidValidation SigmoidValidator<T>::validate(ConfusionMatrix &matrix)
+{
+	int nRows = m_ValidationSet.getRowCount();
+	int nShards = matrix.getShardCount();
+	int nShareRows = (nRows + nShards - 1) / nShards;
+	auto validateShare = [&](int t)
+	{
+		int nStart = t * nShareRows;
+		int nCount = min(nShareRows, nRows - nStart);
+		if (nCount <= 0)
+			return;
+		m_pSnapshot->classifyBatch(m_ValidationSet.getParams(nStart), nCount, m_vecClassifications.data() + nStart, NULL);
+		matrix.addClassifications(m_ValidationSet.getLabels() + nStart, m_vecClassifications.data() + nStart, nCount, t);
+	};
+	if (m_pThreadPool)
+		m_pThreadPool->parallelFor(nShards, validateShare);
+	else
+		validateShare(0);
+
+	SigmoidValidation validation;
+	ConfusionMetrics metrics = matrix.getMetrics();
+	validation.nCorrect = metrics.nCorrect;
+	validation.dblAccuracy = metrics.dblAccuracy;
+	return validation;
+}
+
+///Accessors
+template <typename T>
+bool SigmoidValidator<T>::hasStopped() const
+{
+	lock_guard<mutex> lock(m_Mutex);
+	return m_bStopped;
+}
+template <typename T>
+int SigmoidValidator<T>::getBestEpoch() const
+{
+	lock_guard<mutex> lock(m_Mutex);
+	return m_nBestEpoch;
+}
+template <typename T>
+double SigmoidValidator<T>::getBestAccuracy() const
+{
+	lock_guard<mutex> lock(m_Mutex);
+	return m_dblBestAccuracy;
+}
+template <typename T>
+ConfusionMatrix SigmoidValidator<T>::getBestMatrix() const
+{
+	lock_guard<mutex> lock(m_Mutex);
+	return m_BestMatrix;
+}
+template <typename T>
+vector<SigmoidValidation> SigmoidValidator<T>::getValidations() const
+{
+	lock_guard<mutex> lock(m_Mutex);
+	return m_vecValidations;
+}
+template <typename T>
+int SigmoidValidator<T>::getInterval() const
+{
+	return m_nInterval;
+}
+template <typename T>
+void SigmoidValidator<T>::setValidationThreads(int threadcount)
+{
+	lock_guard<mutex> lock(m_Mutex);
+	m_nThreadCount = threadcount < 1 ? 1 : threadcount;
+	m_pThreadPool.reset(m_nThreadCount > 1 ? new ThreadPool(m_nThreadCount) : NULL);
+}
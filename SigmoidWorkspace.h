@@ -0,0 +1,109 @@
+///////////////////////////////////////////
+// Scratch buffers for running rows through a SigmoidNetwork: neuron outputs and deltas for every layer, a staging
+//	buffer for a batch of inputs, and a weight gradient buffer laid out as the network's parameters.
+//	Each buffer holds up to getRowCapacity() rows. Keeping these out of the network lets several threads work on one
+//	network at once, each with its own workspace. T is the network's scalar type: float or double.
+//	Training timers (see SigmoidTelemetry.h) accumulate into the workspace they time, so threads never share one.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "SigmoidTelemetry.h"
+
+using namespace std;
+
+template <typename T>
+class SigmoidWorkspace
+{
+public:
+	SigmoidWorkspace();																//Constructor. Call allocate() before use.
+	void allocate(const int *networklayers, int layercount, int paramcount,			//Sizes the buffers for rowcapacity rows of a network with the given topology.
+			int rowcapacity);														//   paramcount = 0 skips the gradient buffer.
+	int getRowCapacity() const;														//Returns the number of rows each buffer holds
+	bool isAllocatedFor(const int *networklayers, int layercount) const;			//Returns true if allocate() was last called for the given topology
+	T *getLayerOutputs(int layerindex);												//Returns layer layerindex's outputs (layerindex > 0), one row per sample
+	const T *getLayerOutputs(int layerindex) const;
+	T *getLayerDeltas(int layerindex);												//Returns layer layerindex's deltas (layerindex > 0), one row per sample
+	T *getInputs();																	//Returns the input staging buffer, one row per sample
+	T *getGradients();																//Returns the gradient buffer, laid out as the network's parameters
+	SigmoidTrainingTimes &getTrainingTimes();										//Returns the time spent training in this workspace since allocate() or its last reset
+
+private:
+	int m_nRowCapacity;																//Rows each buffer holds
+	vector<int> m_vecNetworkLayers;													//Topology the buffers were sized for
+	vector<int> m_vecLayerOffsets;													//m_vecLayerOffsets[i] * m_nRowCapacity is the index of layer i's first output in m_vecActivations
+	vector<T> m_vecActivations;														//Outputs of every neuron, layer by layer, excluding the input layer
+	vector<T> m_vecDeltas;															//Deltas of every neuron, laid out as m_vecActivations
+	vector<T> m_vecInputs;															//Input params of a batch
+	vector<T> m_vecGradients;														//Summed weight gradients of a batch
+	SigmoidTrainingTimes m_TrainingTimes;											//Training time spent in this workspace, by phase and layer
+};
+
+//Constructor
+template <typename T>
+SigmoidWorkspace<T>::SigmoidWorkspace() : m_nRowCapacity(0)
+{}
+
+template <typename T>
+void SigmoidWorkspace<T>::allocate(const int *networklayers, int layercount, int paramcount, int rowcapacity)
+{
+	m_nRowCapacity = rowcapacity;
+	m_vecNetworkLayers.assign(networklayers, networklayers + layercount);
+	m_vecLayerOffsets.assign(layercount + 1, 0);
+	int nNeuronCount = 0;
+	for (int i = 1; i < layercount; i++)
+	{
+		m_vecLayerOffsets[i] = nNeuronCount;
+		nNeuronCount += networklayers[i];
+	}
+	m_vecLayerOffsets[layercount] = nNeuronCount;
+	m_vecActivations.assign(nNeuronCount * rowcapacity, 0);
+	m_vecDeltas.assign(nNeuronCount * rowcapacity, 0);
+	m_vecInputs.assign(networklayers[0] * rowcapacity, 0);
+	m_vecGradients.assign(paramcount, 0);
+	m_TrainingTimes.reset(layercount);
+}
+
+///Accessors
+template <typename T>
+int SigmoidWorkspace<T>::getRowCapacity() const
+{
+	return m_nRowCapacity;
+}
+template <typename T>
+bool SigmoidWorkspace<T>::isAllocatedFor(const int *networklayers, int layercount) const
+{
+	return m_vecNetworkLayers.size() == (size_t)layercount && equal(m_vecNetworkLayers.begin(), m_vecNetworkLayers.end(), networklayers);
+}
+template <typename T>
+T *SigmoidWorkspace<T>::getLayerOutputs(int layerindex)
+{
+	return m_vecActivations.data() + m_vecLayerOffsets[layerindex] * m_nRowCapacity;
+}
+template <typename T>
+const T *SigmoidWorkspace<T>::getLayerOutputs(int layerindex) const
+{
+	return m_vecActivations.data() + m_vecLayerOffsets[layerindex] * m_nRowCapacity;
+}
+template <typename T>
+T *SigmoidWorkspace<T>::getLayerDeltas(int layerindex)
+{
+	return m_vecDeltas.data() + m_vecLayerOffsets[layerindex] * m_nRowCapacity;
+}
+template <typename T>
+T *SigmoidWorkspace<T>::getInputs()
+{
+	return m_vecInputs.data();
+}
+template <typename T>
+T *SigmoidWorkspace<T>::getGradients()
+{
+	return m_vecGradients.data();
+}
+template <typename T>
+SigmoidTrainingTimes &SigmoidWorkspace<T>::getTrainingTimes()
+{
+	return m_TrainingTimes;
+}
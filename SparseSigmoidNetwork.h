@@ -0,0 +1,235 @@
+///////////////////////////////////////////
+// An inference-only version of a trained, pruned sigmoid network (see SigmoidPruner.h) that stores only its nonzero
+// weights.
+//	sparsify() converts any SigmoidClassifier (a SigmoidNetwork or FixedSigmoidNetwork). Each layer's weight matrix is
+//	kept in compressed sparse row (CSR) form: the nonzero weights of every neuron in turn, each with the 16-bit index of
+//	the input it weighs, and the offset of each neuron's first weight. Each neuron's bias term (bias * bias weight) is
+//	kept alongside. A weight then costs its own size plus 2 bytes, so the model is smaller than the dense one once more
+//	than a fifth (doubles) or a third (floats) of its weights are pruned, and shrinks in proportion from there.
+//	Rows are classified SPARSE_BLOCK_ROWS at a time. Activations are held input-major (all of a block's values of one
+//	neuron together), so each nonzero weight is applied to the whole block with one vector multiply-add, and time
+//	falls in proportion to the number of weights kept. As in QuantizedSigmoidNetwork, the output layer is classified by
+//	its highest pre-sigmoid sum.
+//	Classification is const and runs in buffers local to the calling thread, so any number of threads may classify with
+//	one network at once. tools/prune_model.cpp reports accuracy, size and speed against the dense network.
+// See inline documentation for more info.
+//
+//	T is the scalar type of the weights and the features classified: float or double.
+//
+
+#pragma once
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include "SigmoidClassifier.h"
+#include "SigmoidKernels.h"
+
+using namespace std;
+
+template <typename T>
+class SparseSigmoidNetwork
+{
+public:
+	SparseSigmoidNetwork();																	//Constructor. Empty until sparsify() is called.
+
+	bool sparsify(const SigmoidClassifier<T> &network);									//Replaces this network with a copy of network's nonzero weights. Returns false,
+																							//   with an error msg, if a layer has more than MAX_INPUT_COUNT inputs.
+	int getClassification(const T *params) const;											//Returns the index of the output neuron having the highest output. Thread-safe.
+	void classifyBatch(const T *features, int rowcount,									//Classifies rowcount rows of features (rowcount x input count, row-major), writing
+			int *classifications, T *scores) const;											//   class indices to classifications and, if not NULL, outputs to scores. Thread-safe.
+	int getLayerCount() const;																//Returns m_nLayerCount
+	const int *getNetworkLayers() const;													//Returns m_vecNetworkLayers
+	SigmoidActivation getActivation() const;												//Returns m_Activation
+	void setActivation(SigmoidActivation activation);										//Sets the sigmoid implementation every layer uses. sparsify() copies the network's.
+	size_t getNonZeroCount() const;															//Returns the number of weights stored, excluding bias terms
+	size_t getModelSize() const;															//Returns the bytes taken by weights, input indices, row offsets and bias terms
+
+	static const int SPARSE_BLOCK_ROWS;														//Rows per forward pass
+	static const int MAX_INPUT_COUNT;														//Most inputs a layer may have, so input indices fit 16 bits
+
+private:
+	void propagateForward(const T *features, int rowcount, T *outputs) const;				//Runs rowcount rows through the network, leaving the output layer's sums in
+																							//   outputs, output-major (outputs[j * rowcount + b] is row b's output j)
+
+	int m_nLayerCount;																		//Number of layers in network, including input layer
+	vector<int> m_vecNetworkLayers;															//Neuron count of each layer
+	int m_nMaxLayerSize;																	//Most neurons in any layer, including the input layer
+	SigmoidActivation m_Activation;															//Sigmoid implementation of every hidden layer
+	vector<int> m_vecLayerNeurons;															//m_vecLayerNeurons[i] is the index of layer i's first neuron, over every layer
+																							//   but the input layer
+	vector<uint32_t> m_vecRowStarts;														//Index of each neuron's first weight in m_vecWeights. One more entry than neurons.
+	vector<uint16_t> m_vecInputIndices;														//Input weighed by each weight
+	vector<T> m_vecWeights;																	//Every neuron's nonzero weights, in neuron order
+	vector<T> m_vecBiasTerms;																//Per neuron: bias * bias weight
+};
+
+template <typename T>
+const int SparseSigmoidNetwork<T>::SPARSE_BLOCK_ROWS = 64;
+template <typename T>
+const int SparseSigmoidNetwork<T>::MAX_INPUT_COUNT = 65536;
+
+//Constructor
+template <typename T>
+SparseSigmoidNetwork<T>::SparseSigmoidNetwork() : m_nLayerCount(0), m_nMaxLayerSize(0), m_Activation(ACTIVATION_EXACT)
+{}
+
+//Copies every nonzero weight of network, layer by layer, neuron by neuron, in input order
+template <typename T>
+bool SparseSigmoidNetwork<T>::sparsify(const SigmoidClassifier<T> &network)
+{
+	const int *pLayers = network.getNetworkLayers();
+	for (int i = 0; i < network.getLayerCount() - 1; i++)
+	{
+		if (pLayers[i] > MAX_INPUT_COUNT)
+		{
+			cout << "ERROR: A sparse network's layers may have at most " << MAX_INPUT_COUNT << " inputs.\n";
+			return false;
+		}
+	}
+	vector<T> vecParams(network.getParamCount());
+	network.getParams(vecParams.data());
+	m_nLayerCount = network.getLayerCount();
+	m_vecNetworkLayers.assign(pLayers, pLayers + m_nLayerCount);
+	m_nMaxLayerSize = *max_element(m_vecNetworkLayers.begin(), m_vecNetworkLayers.end());
+	m_Activation = network.getActivation();
+	m_vecLayerNeurons.assign(1, 0);
+	m_vecRowStarts.assign(1, 0);
+	m_vecInputIndices.clear();
+	m_vecWeights.clear();
+	m_vecBiasTerms.clear();
+
+	const T *pLayerParams = vecParams.data();
+	for (int i = 1; i < m_nLayerCount; i++)
+	{
+		int nInputs = pLayers[i - 1];
+		int nNeurons = pLayers[i];
+		const T *pBiasWeights = pLayerParams + nInputs * nNeurons;
+		for (int j = 0; j < nNeurons; j++)
+		{
+			const T *pRow = pLayerParams + j * nInputs;
+			for (int k = 0; k < nInputs; k++)
+			{
+				if (pRow[k] != 0)
+				{
+					m_vecInputIndices.push_back((uint16_t)k);
+					m_vecWeights.push_back(pRow[k]);
+				}
+			}
+			m_vecRowStarts.push_back((uint32_t)m_vecWeights.size());
+			m_vecBiasTerms.push_back((T)(network.getBias() * pBiasWeights[j]));
+		}
+		m_vecLayerNeurons.push_back(m_vecLayerNeurons.back() + nNeurons);
+		pLayerParams += (nInputs + 1) * nNeurons;
+	}
+	return true;
+}
+
+//Transposes the block's features to input-major, then, for each layer, starts every neuron's sums at its bias term,
+// adds each nonzero weight times its input's values across the block and, but for the output layer, takes the sigmoid.
+// Buffers are local to the calling thread, and are only reallocated when they are used with a wider network.
+template <typename T>
+void SparseSigmoidNetwork<T>::propagateForward(const T *features, int rowcount, T *outputs) const
+{
+	static thread_local vector<T> vecActivations[2];
+	for (int a = 0; a < 2; a++)
+		if (vecActivations[a].size() < (size_t)m_nMaxLayerSize * SPARSE_BLOCK_ROWS)
+			vecActivations[a].resize((size_t)m_nMaxLayerSize * SPARSE_BLOCK_ROWS);
+
+	int nInputs = m_vecNetworkLayers[0];
+	T *pInputs = vecActivations[0].data();
+	for (int b = 0; b < rowcount; b++)
+		for (int k = 0; k < nInputs; k++)
+			pInputs[k * rowcount + b] = features[(size_t)b * nInputs + k];
+
+	for (int i = 1; i < m_nLayerCount; i++)
+	{
+		int nNeurons = m_vecNetworkLayers[i];
+		T *pOutputs = (i == m_nLayerCount - 1) ? outputs : vecActivations[i % 2].data();
+		for (int j = 0; j < nNeurons; j++)
+		{
+			int nNeuron = m_vecLayerNeurons[i - 1] + j;
+			T *pSums = pOutputs + j * rowcount;
+			fill(pSums, pSums + rowcount, m_vecBiasTerms[nNeuron]);
+			for (uint32_t w = m_vecRowStarts[nNeuron]; w < m_vecRowStarts[nNeuron + 1]; w++)
+				SigmoidKernels::addScaledVector(pSums, m_vecWeights[w], pInputs + m_vecInputIndices[w] * rowcount, rowcount);
+		}
+		if (i < m_nLayerCount - 1)
+			SigmoidKernels::calculateSigmoid(pOutputs, nNeurons * rowcount, m_Activation);
+		pInputs = pOutputs;
+	}
+}
+
+template <typename T>
+int SparseSigmoidNetwork<T>::getClassification(const T *params) const
+{
+	int nResult;
+	classifyBatch(params, 1, &nResult, NULL);
+	return nResult;
+}
+
+//Classifies rowcount rows of features, SPARSE_BLOCK_ROWS at a time. Scores, when wanted, are the sigmoid of each
+// output's sum.
+template <typename T>
+void SparseSigmoidNetwork<T>::classifyBatch(const T *features, int rowcount, int *classifications, T *scores) const
+{
+	static thread_local vector<T> vecOutputs;
+	int nInputs = m_vecNetworkLayers[0];
+	int nOutputs = m_vecNetworkLayers[m_nLayerCount - 1];
+	if (vecOutputs.size() < (size_t)nOutputs * SPARSE_BLOCK_ROWS)
+		vecOutputs.resize((size_t)nOutputs * SPARSE_BLOCK_ROWS);
+	for (int j = 0; j < rowcount; j += SPARSE_BLOCK_ROWS)
+	{
+		int nRows = min(SPARSE_BLOCK_ROWS, rowcount - j);
+		propagateForward(features + (size_t)j * nInputs, nRows, vecOutputs.data());
+		const T *pSums = vecOutputs.data();
+		for (int b = 0; b < nRows; b++)
+		{
+			int nResult = 0;
+			for (int o = 1; o < nOutputs; o++)
+				if (pSums[o * nRows + b] > pSums[nResult * nRows + b])
+					nResult = o;
+			classifications[j + b] = nResult;
+		}
+		if (scores != NULL)
+		{
+			T *pScores = scores + (size_t)j * nOutputs;
+			for (int b = 0; b < nRows; b++)
+				for (int o = 0; o < nOutputs; o++)
+					pScores[b * nOutputs + o] = pSums[o * nRows + b];
+			SigmoidKernels::calculateSigmoid(pScores, nRows * nOutputs, m_Activation);
+		}
+	}
+}
+
+///Accessors
+template <typename T>
+int SparseSigmoidNetwork<T>::getLayerCount() const
+{
+	return m_nLayerCount;
+}
+template <typename T>
+const int *SparseSigmoidNetwork<T>::getNetworkLayers() const
+{
+	return m_vecNetworkLayers.data();
+}
+template <typename T>
+SigmoidActivation SparseSigmoidNetwork<T>::getActivation() const
+{
+	return m_Activation;
+}
+template <typename T>
+void SparseSigmoidNetwork<T>::setActivation(SigmoidActivation activation)
+{
+	m_Activation = activation;
+}
+template <typename T>
+size_t SparseSigmoidNetwork<T>::getNonZeroCount() const
+{
+	return m_vecWeights.size();
+}
+template <typename T>
+size_t SparseSigmoidNetwork<T>::getModelSize() const
+{
+	return m_vecWeights.size() * (sizeof(T) + sizeof(uint16_t)) + m_vecRowStarts.size() * sizeof(uint32_t) + m_vecBiasTerms.size() * sizeof(T);
+}
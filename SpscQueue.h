@@ -0,0 +1,87 @@
+///////////////////////////////////////////
+// A bounded, lock-free queue for exactly one producer thread and one consumer thread.
+//	Elements live in a ring of slots. The producer only writes the tail index and the consumer only writes the head
+//	index, each on a cache line of its own, so push() and pop() are a few loads and one release store, with no locks
+//	and no allocations. Neither blocks: push() fails when the queue is full and pop() when it is empty, and the caller
+//	decides how to wait (see SigmoidDataStream.h).
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+using namespace std;
+
+template <typename E>
+class SpscQueue
+{
+public:
+	SpscQueue();															//Constructor. Holds nothing until reset().
+	void reset(int capacity);												//Empties the queue, and makes room for at least capacity elements. Only call
+																			//   while neither thread is using the queue.
+	bool push(const E &element);											//Producer only. Appends element. Returns false if the queue is full.
+	bool pop(E &element);													//Consumer only. Removes the oldest element into element. Returns false if empty.
+	int getCapacity() const;												//Returns the number of elements the queue can hold
+
+private:
+	SpscQueue(const SpscQueue &);											//Not copyable
+	SpscQueue &operator=(const SpscQueue &);
+
+	static const size_t CACHE_LINE_BYTES = 64;								//Keeps the two indices from sharing a cache line
+
+	vector<E> m_vecSlots;													//Ring of elements. Its size is a power of 2.
+	size_t m_nMask;															//m_vecSlots.size() - 1. Maps an index to its slot.
+	alignas(CACHE_LINE_BYTES) atomic<size_t> m_nHead;						//Index of the next element to pop. Written only by the consumer.
+	alignas(CACHE_LINE_BYTES) atomic<size_t> m_nTail;						//Index of the next element to push. Written only by the producer.
+};
+
+//Constructor
+template <typename E>
+SpscQueue<E>::SpscQueue() : m_nMask(0), m_nHead(0), m_nTail(0)
+{}
+
+//Rounds capacity up to a power of 2, so an ever-increasing index maps to its slot with a mask
+template <typename E>
+void SpscQueue<E>::reset(int capacity)
+{
+	size_t nSlots = 1;
+	while (nSlots < (size_t)capacity)
+		nSlots *= 2;
+	m_vecSlots.assign(nSlots, E());
+	m_nMask = nSlots - 1;
+	m_nHead.store(0, memory_order_relaxed);
+	m_nTail.store(0, memory_order_relaxed);
+}
+
+//The release store of the tail publishes the element's slot to the consumer
+template <typename E>
+bool SpscQueue<E>::push(const E &element)
+{
+	size_t nTail = m_nTail.load(memory_order_relaxed);
+	if (nTail - m_nHead.load(memory_order_acquire) == m_vecSlots.size())
+		return false;
+	m_vecSlots[nTail & m_nMask] = element;
+	m_nTail.store(nTail + 1, memory_order_release);
+	return true;
+}
+
+//The release store of the head hands the element's slot back to the producer
+template <typename E>
+bool SpscQueue<E>::pop(E &element)
+{
+	size_t nHead = m_nHead.load(memory_order_relaxed);
+	if (nHead == m_nTail.load(memory_order_acquire))
+		return false;
+	element = m_vecSlots[nHead & m_nMask];
+	m_nHead.store(nHead + 1, memory_order_release);
+	return true;
+}
+
+///Accessors
+template <typename E>
+int SpscQueue<E>::getCapacity() const
+{
+	return (int)m_vecSlots.size();
+}
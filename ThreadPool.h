@@ -0,0 +1,148 @@
+///////////////////////////////////////////
+// A fixed-size pool of worker threads.
+//	Jobs are queued with enqueue() and run in FIFO order by whichever worker is free. wait() blocks until every queued
+//	job has finished. parallelFor() runs one task per index across the workers and waits for all of them. It queues
+//	nothing: workers take indices straight from a counter, so once the pool is running it never allocates.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+class ThreadPool
+{
+public:
+	ThreadPool(int threadcount);											//Constructor. Starts threadcount workers.
+	~ThreadPool();															//Waits for queued jobs, then stops the workers
+	void enqueue(const function<void()> &job);								//Queues job to run on the next free worker
+	void wait();															//Blocks until every queued job has finished
+	template <typename F>
+	void parallelFor(int taskcount, const F &task);							//Runs task(i) for each i in [0, taskcount) across the pool and waits for all of them
+	int getThreadCount() const;												//Returns the number of workers
+
+private:
+	vector<thread> m_vecThreads;											//Workers
+	queue<function<void()>> m_Jobs;											//Jobs not yet started
+	mutex m_Mutex;															//Guards m_Jobs, m_nActiveJobs, m_bStopping and the parallelFor() state
+	condition_variable m_JobAvailable;										//Signalled when a job is queued or the pool is stopping
+	condition_variable m_JobsDone;											//Signalled when the last running job finishes
+	int m_nActiveJobs;														//Jobs queued or running, including parallelFor() tasks
+	bool m_bStopping;														//True once the destructor has been called
+	const function<void(int)> *m_pForTask;									//Task of the parallelFor() in progress, or NULL
+	int m_nForTaskCount;													//Indices of m_pForTask to run
+	int m_nNextForIndex;													//Next index of m_pForTask for a worker to take
+
+	void runFor(int taskcount, const function<void(int)> &task);			//Runs parallelFor()'s tasks and waits for them
+	void runWorker();														//Worker loop. Runs jobs until the pool is stopping.
+};
+
+//Constructor
+ThreadPool::ThreadPool(int threadcount) : m_nActiveJobs(0), m_bStopping(false), m_pForTask(NULL), m_nForTaskCount(0), m_nNextForIndex(0)
+{
+	if (threadcount < 1)
+		threadcount = 1;
+	for (int i = 0; i < threadcount; i++)
+		m_vecThreads.push_back(thread(&ThreadPool::runWorker, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+	wait();
+	{
+		lock_guard<mutex> lock(m_Mutex);
+		m_bStopping = true;
+	}
+	m_JobAvailable.notify_all();
+	for (unsigned int i = 0; i < m_vecThreads.size(); i++)
+		m_vecThreads[i].join();
+}
+
+void ThreadPool::enqueue(const function<void()> &job)
+{
+	{
+		lock_guard<mutex> lock(m_Mutex);
+		m_Jobs.push(job);
+		m_nActiveJobs++;
+	}
+	m_JobAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	unique_lock<mutex> lock(m_Mutex);
+	m_JobsDone.wait(lock, [this] { return m_nActiveJobs == 0; });
+}
+
+//Runs task(0) ... task(taskcount - 1) on the pool and returns once all have finished. Tasks must not call back into
+// the pool's wait() or parallelFor(), and only one thread may call parallelFor() at a time. task is wrapped by
+// reference, so however much it captures, no function object is allocated.
+template <typename F>
+void ThreadPool::parallelFor(int taskcount, const F &task)
+{
+	runFor(taskcount, function<void(int)>(cref(task)));
+}
+
+void ThreadPool::runFor(int taskcount, const function<void(int)> &task)
+{
+	if (taskcount < 1)
+		return;
+	{
+		lock_guard<mutex> lock(m_Mutex);
+		m_pForTask = &task;
+		m_nForTaskCount = taskcount;
+		m_nNextForIndex = 0;
+		m_nActiveJobs += taskcount;
+	}
+	m_JobAvailable.notify_all();
+	wait();
+	lock_guard<mutex> lock(m_Mutex);
+	m_pForTask = NULL;
+}
+
+int ThreadPool::getThreadCount() const
+{
+	return (int)m_vecThreads.size();
+}
+
+void ThreadPool::runWorker()
+{
+	while (true)
+	{
+		function<void()> job;
+		const function<void(int)> *pTask = NULL;
+		int nIndex = 0;
+		{
+			unique_lock<mutex> lock(m_Mutex);
+			m_JobAvailable.wait(lock, [this] { return m_bStopping || !m_Jobs.empty() || m_nNextForIndex < m_nForTaskCount; });
+			if (m_nNextForIndex < m_nForTaskCount)
+			{
+				pTask = m_pForTask;
+				nIndex = m_nNextForIndex++;
+			}
+			else if (!m_Jobs.empty())
+			{
+				job = move(m_Jobs.front());
+				m_Jobs.pop();
+			}
+			else
+				return; //stopping, and nothing left to do
+		}
+		if (pTask)
+			(*pTask)(nIndex);
+		else
+			job();
+		{
+			lock_guard<mutex> lock(m_Mutex);
+			m_nActiveJobs--;
+			if (m_nActiveJobs == 0)
+				m_JobsDone.notify_all();
+		}
+	}
+}
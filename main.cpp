@@ -15,13 +15,17 @@
 #include <fstream>
 #include <string>
 #include <ctime>
+#include <cstdio>
 #include "SigmoidNetwork.h"
+#include "FixedSigmoidNetwork.h"
 #include "ConfusionMatrix.h"
+#include "SigmoidValidator.h"
+#include "SigmoidPruner.h"
+#include "SigmoidCheckpointer.h"
 
 	using namespace std;
 
-vector<vector<string>> populateVectorFromDataFile(string filename, char delimeter); //Utility function to populate a vector from a char delimited data file.
-double rescaleFeature(double x, double minx, double maxx); //Utility function to rescale a feature variable x as x' = (x-min(x))/max(x)-min(x)
+typedef double Scalar;	//Precision of weights, activations and data: float or double
 
 const string WELCOME_MSG = "\nSigmoid\n-------------------------------------------------------------------\n"
 "This tool trains a multi-layer sigmpoid network from pre-specified training data, learning rate (LR), and\n "
@@ -37,9 +41,35 @@ const double BIAS = -1;													//Bias of each neuron
 const double BIAS_WEIGHT = 0.5;											//Initial bias Weight of each neuron
 const int NETWORK_LAYERS[] = { 16, 14, 26 };							//Network Structure. Ex: {3, 4, 2} denotes 3 input layers, 1 hidden layer of 4 neuerons, and 2 output neurons
 const int NETWORK_LAYER_COUNT = 3;										//Total number of network layers. Ex {3, 4, 2] = 3 layers. Will be size of NETWORK LAYERS
+typedef FixedSigmoidNetwork<Scalar, 16, 14, 26> FixedNetwork;			//NETWORK_LAYERS, fixed at compile time. Used for validation if FIXED_INFERENCE
+const SigmoidActivation ACTIVATION = ACTIVATION_EXACT;					//Sigmoid implementation: ACTIVATION_EXACT, ACTIVATION_TABLE or ACTIVATION_RATIONAL
+const bool FIXED_INFERENCE = false;										//Validate with a FixedNetwork holding the trained weights, for the lowest latency
+const OptimizerType OPTIMIZER = OPTIMIZER_SGD;							//Weight update rule: OPTIMIZER_SGD, OPTIMIZER_MOMENTUM, OPTIMIZER_NESTEROV or OPTIMIZER_ADAM
+const double MOMENTUM = 0.9;											//Velocity decay of OPTIMIZER_MOMENTUM/NESTEROV, and Adam's beta1
+const double ADAM_BETA2 = 0.999;										//Adam's second moment decay
+const bool COSINE_SCHEDULE = false;										//Anneal the learning rate to 0 along a half cosine over each network's iterations
+const int BATCH_SIZE = 1;												//Training rows per weight update. 1 = update after every row
+const int TRAINING_THREADS = 1;											//Threads to train on. Above 1, see PARALLEL_MODE
+const ParallelMode PARALLEL_MODE = PARALLEL_SYNCHRONOUS;				//How training threads share work. PARALLEL_SYNCHRONOUS or PARALLEL_HOGWILD (a data race; see SigmoidNetwork.h)
 const bool VERBOSE = true;												//Verbose mode outputs the error per training iteration to the console
 const string TRAINING_DATAFILE = "dataset/letter-recognition.train.data";
 const string VALIDATION_DATAFILE = "dataset/letter-recognition.val.data";
+const int STREAM_CHUNK_ROWS = 0;										//Above 0, training data is streamed from file this many rows at a time, rather than loaded whole
+const bool STREAM_SHUFFLE = true;										//When streaming, shuffle training rows within each chunk, differently every iteration
+const int STREAM_QUEUE_DEPTH = 3;										//When streaming, chunks held at once: one being trained on, the rest read and parsed ahead of it
+const string MODEL_FILE = "sigmoid.model";								//Each trained network is saved here (overwriting the last). Blank = don't save
+const string CHECKPOINT_FILE = "";										//Training state is checkpointed here, suffixed .<iterations index>.<rate index>, and an interrupted run resumes from it. Blank = don't checkpoint
+const int CHECKPOINT_INTERVAL = 1;										//Epochs between checkpoints. Each is written on a background thread
+const int VALIDATION_INTERVAL = 0;										//Above 0, the network is validated on a background thread every this many epochs while it trains
+const int VALIDATION_PATIENCE = 5;										//Training stops once validation accuracy has not improved for this many epochs. 0 = never stop early
+const bool KEEP_BEST_SNAPSHOT = true;									//After training, restore the weights of the most accurate snapshot validated
+const int VALIDATION_THREADS = 1;										//Threads each background validation classifies on
+const double PRUNE_SPARSITY = 0;										//Above 0, this fraction of each trained network's weights are pruned (zeroed), smallest first
+const PruneScope PRUNE_SCOPE = PRUNE_GLOBAL;							//Prune by one threshold for the whole network (PRUNE_GLOBAL) or each layer on its own (PRUNE_LAYER)
+const int PRUNE_STEPS = 4;												//Steps to prune in, each followed by PRUNE_FINE_TUNE_ITERATIONS of training
+const int PRUNE_FINE_TUNE_ITERATIONS = 1;								//Training iterations after each pruning step, with pruned weights held at 0. Not done when streaming
+const string METRICS_FILE = "";											//Each network's per-epoch training metrics are written here, as CSV (JSON if named *.json). Blank = don't write
+const string VALIDATION_METRICS_FILE = "";								//Each network's validation precision, recall, F1 and top-k accuracy are written here, as above
 
 int main()
 {
@@ -61,90 +91,68 @@ int main()
 			cout << "   " << LEARNING_ITERATIONS[i_iters];
 		cout << "\nThese processes will take some time to complete.\n\n";
 
-		//Read data from file into vectors. Vectors won't be in correct format, we do that in the 'converting' step
+		//Read both data sets. A binary data file (see tools/convert_dataset.cpp) is mapped straight into memory, already
+		// rescaled. A CSV file is parsed, then its features are rescaled using the min/max of each column across both sets.
 		//////////////////////////////////////
-		vector<vector<string>> vPreDataTrain;		//Training data set, 
-		vector<vector<string>> vPreDataValidate;	//Validation data set
+		string strAlphaIndex = LETTER_LABELS; 						//used for geting the index of the expected alphabetic character
+																	//  also used for labeling confusion matrix rows/cols
+		SigmoidDataSet<Scalar> dsTrain;								//Training data set, unless streaming
+		SigmoidDataStream<Scalar> dsTrainStream;					//Training data stream, if STREAM_CHUNK_ROWS > 0
+		SigmoidDataSet<Scalar> dsValidate;							//Validation data set
 		cout << "Reading Training Data...\n";
-		vPreDataTrain = populateVectorFromDataFile(TRAINING_DATAFILE, ',');
-		if (vPreDataTrain.size() <= 0)
+		if (STREAM_CHUNK_ROWS > 0)
+		{
+			if (!dsTrainStream.open(TRAINING_DATAFILE, strAlphaIndex, STREAM_CHUNK_ROWS))
+				continue;
+			dsTrainStream.setShuffle(STREAM_SHUFFLE, (unsigned int)time(NULL));
+			dsTrainStream.setQueueDepth(STREAM_QUEUE_DEPTH);
+		}
+		else if (!dsTrain.load(TRAINING_DATAFILE, strAlphaIndex))
 			continue;
 		cout << "Done.\nReading Validation Data...\n";
-		vPreDataValidate = populateVectorFromDataFile(VALIDATION_DATAFILE, ',');
-		if (vPreDataValidate.size() <= 0)
+		if (!dsValidate.load(VALIDATION_DATAFILE, strAlphaIndex))
 			continue;
 		cout << "Done.\n";
-
-		//Convert data to sigmoid data for both data sets, rescaling the features as we go.
-		////////////////////////
-		string strAlphaIndex = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"; 		//used for geting the index of the expected alphabetic character
-																	//  also used for labeling confusion matrix rows/cols		
-		unsigned int nRowsTrain = vPreDataTrain.size(), nRowsValidate = vPreDataValidate.size();			//Number of rows of data
-		unsigned int nParamsTrain = vPreDataTrain[0].size(), nParamsValidate = vPreDataValidate[0].size();	//Size of vector containg data row, including expected result at index 0
-		vector<double> vMinx(nParamsTrain - 1, 99999);				//min x values of all params, by column, excluding label
-		vector<double> vMaxx(nParamsTrain - 1, -1);					//max x values of all params, by column, excluding label
-		vector<SigmoidDataRow> vDataTrain;  						//Training Data in form sigmoid wants: (y, vector<double>)
-		vector<SigmoidDataRow> vDataValidate; 						//Validation data in form sigmoid wants (y, vector<double>)
-
-		cout << "Determining paramerter ranges...\n";
-		//Get min and max feature values from training set to be used for feature rescaling. 
-		for (unsigned int i = 1; i < nParamsTrain; i++) //iterate parameter, excluding label at index 0
-		{
-			for (unsigned int j = 0; j < nRowsTrain; j++) //iterate each row
-			{
-				double d = stod(vPreDataTrain[j][i]);
-				if (d > vMaxx[i - 1])			//store maxx to maxx vector. Index is one less than the index of the corresponding parameter in vDataTrain/vDataVal
-					vMaxx[i - 1] = d;
-				if (d < vMinx[i - 1])			//store minx to minx vector
-					vMinx[i - 1] = d;
-			}
-		}
-		//Also check validation set for min/max
-		for (unsigned int i = 1; i < nParamsValidate; i++) //iterate parameter, excluding expected value param at index 0
+		int nParamsTrain = (STREAM_CHUNK_ROWS > 0) ? dsTrainStream.getParamCount() : dsTrain.getParamCount();
+		if (nParamsTrain != dsValidate.getParamCount())
 		{
-			for (unsigned int j = 0; j < nRowsValidate; j++) //iterate each row
-			{
-				double d = stod(vPreDataValidate[j][i]);
-				if (d > vMaxx[i - 1])			//store maxx to maxx vector. Index is one less than the index of the corresponding parameter in vDataTrain/vDataVal
-					vMaxx[i - 1] = d;
-				if (d < vMinx[i - 1])			//store minx to minx vector
-					vMinx[i - 1] = d;
-			}
+			cout << "ERROR: Differing parameter counts between training and validation sets.\n";
+			continue;
 		}
-		cout << "Done.\n";
-		cout << "Converting Training Vector to Sigmoid Data...\n";
 
-		for (unsigned int i = 0; i < nRowsTrain; i++)
+		//Rescale features as x' = (x-min(x))/max(x)-min(x), so both sets share one scale. Binary data files were rescaled
+		// when they were written, and one set's stored ranges are used for the other (see SigmoidDataSet::rescaleSets()).
+		// Only when neither set has ranges are they found from the min and max of each column across both sets. A streamed
+		// CSV training set takes an extra pass over the file to find its ranges, and its rows are then rescaled as they
+		// are streamed.
+		if (STREAM_CHUNK_ROWS == 0)
 		{
-			//Push data to vector as a row in needed format of (y, vector<double>)
-			//First item is expected result. We do not rescale it, but convert it to an index in strAlphaIndex.
-			//  i.e. our label is now a number value from 0-25, each corresponding to the OutputLayerNode index
-			//  ex: Letter C is converted to 2, and 2 is the index of the output layer node that will be high when
-			//  a given feature set is evaluated to be C.
-			double y = strAlphaIndex.find_first_of(vPreDataTrain[i][0]);
-			vector<double> t;
-			for (unsigned int j = 1; j < nParamsTrain; j++) //next items are parameters. Rescale and add to feature vector
-				t.push_back(rescaleFeature(stod(vPreDataTrain[i][j]), vMinx[j - 1], vMaxx[j - 1]));
-			SigmoidDataRow dTemp(y, t); //Create sigmoid data row from label and feature vector
-			vDataTrain.push_back(dTemp); //add the row to our finalized training data vector
+			if (!SigmoidDataSet<Scalar>::rescaleSets({ &dsTrain, &dsValidate }))
+				continue;
 		}
-		cout << "Done.\n";
-		cout << "Converting Validation Vector to Sigmoid Data...\n";
-		for (unsigned int i = 0; i < nRowsValidate; i++)
+		else if (!dsTrainStream.isBinary() || dsValidate.getRangeMin().empty())
 		{
-			//push data to vector as a row in needed format described above.
-			double y = strAlphaIndex.find_first_of(vPreDataValidate[i][0]);  //first item is expected result
-			vector<double> t;
-			for (unsigned int j = 1; j < nParamsValidate; j++) //next items are parameters
-				t.push_back(rescaleFeature(stod(vPreDataValidate[i][j]), vMinx[j - 1], vMaxx[j - 1]));
-			SigmoidDataRow dTemp(y, t);
-			vDataValidate.push_back(dTemp);
-		}
-		cout << "Done.\n";
-		if (nParamsTrain != nParamsValidate)
-		{
-			cout << "ERROR: Differing parameter counts between training and validation sets.\n";
-			continue;
+			cout << "Rescaling parameters...\n";
+			vector<double> vMinx = dsTrainStream.getRangeMin();		//min x values of all params, by column
+			vector<double> vMaxx = dsTrainStream.getRangeMax();		//max x values of all params, by column
+			if (vMinx.empty())
+			{
+				vMinx = dsValidate.getRangeMin();
+				vMaxx = dsValidate.getRangeMax();
+			}
+			if (vMinx.empty())
+			{
+				vMinx.assign(nParamsTrain, numeric_limits<double>::max());
+				vMaxx.assign(nParamsTrain, numeric_limits<double>::lowest());
+				if (!dsTrainStream.getColumnRanges(vMinx, vMaxx))
+					continue;
+				dsValidate.getColumnRanges(vMinx, vMaxx);
+			}
+			if (!dsTrainStream.isBinary())
+				dsTrainStream.setRescale(vMinx, vMaxx);
+			if (dsValidate.getRangeMin().empty())
+				dsValidate.rescale(vMinx, vMaxx);
+			cout << "Done.\n";
 		}
 
 		//Train and validate with the given constants LEARNING_RATE and LEARNING_ITERATIONS
@@ -155,13 +163,45 @@ int main()
 				//Build Sigmoid Network
 				cout << "Operating on Sigmoid Network with " << NETWORK_LAYERS[0] << " inputs " << NETWORK_LAYER_COUNT - 2 << " hidden layer(s), and " << NETWORK_LAYERS[NETWORK_LAYER_COUNT - 1] << " outputs.\n";
 				srand(time(NULL));
-				SigmoidNetwork sNetwork(NETWORK_LAYERS, NETWORK_LAYER_COUNT, LEARNING_RATE[i_rate], BIAS, BIAS_WEIGHT, VERBOSE);
+				SigmoidNetwork<Scalar> sNetwork(NETWORK_LAYERS, NETWORK_LAYER_COUNT, LEARNING_RATE[i_rate], BIAS, BIAS_WEIGHT, VERBOSE);
+				sNetwork.setBatchSize(BATCH_SIZE);
+				sNetwork.setActivation(ACTIVATION);
+				sNetwork.setOptimizer(OPTIMIZER, MOMENTUM, ADAM_BETA2);
+				if (COSINE_SCHEDULE)
+					sNetwork.setLearningRateSchedule(getCosineSchedule(LEARNING_ITERATIONS[i_iters], 0));
+				sNetwork.setTrainingThreads(TRAINING_THREADS, PARALLEL_MODE);
+				SigmoidMetricsLog metricsLog;
+				unique_ptr<SigmoidValidator<Scalar>> pValidator;
+				if (VALIDATION_INTERVAL > 0)
+				{
+					pValidator.reset(new SigmoidValidator<Scalar>(sNetwork, dsValidate, strAlphaIndex, VALIDATION_INTERVAL, VALIDATION_PATIENCE, KEEP_BEST_SNAPSHOT));
+					pValidator->setValidationThreads(VALIDATION_THREADS);
+				}
+				unique_ptr<SigmoidCheckpointer<Scalar>> pCheckpointer;
+				string strCheckpointFile = (CHECKPOINT_FILE == "") ? "" : CHECKPOINT_FILE + "." + to_string(i_iters) + "." + to_string(i_rate);	//one per grid cell
+				if (strCheckpointFile != "")
+				{
+					pCheckpointer.reset(new SigmoidCheckpointer<Scalar>(sNetwork, strCheckpointFile, CHECKPOINT_INTERVAL));
+					if (STREAM_CHUNK_ROWS > 0)
+						pCheckpointer->setDataStream(&dsTrainStream);
+					if (pCheckpointer->resume(STREAM_CHUNK_ROWS > 0 ? &dsTrainStream : NULL))
+						cout << "Resumed from checkpoint " << strCheckpointFile << " at epoch " << sNetwork.getEpochCount() << ".\n";
+				}
+				sNetwork.setEpochCallback([&](const SigmoidEpochMetrics &metrics)
+				{
+					if (METRICS_FILE != "")
+						metricsLog.add(metrics);
+					if (pValidator)
+						pValidator->onEpoch(metrics);
+					if (pCheckpointer)
+						pCheckpointer->onEpoch(metrics);
+				});
 
 				//Pre-Validate Sigmoid, to see success rate before training
 				//cout << "Pre-Validating Sigmoid...\n";
 				//ConfusionMatrix m(26, strAlphaIndex);
-				//for (unsigned int i = 0; i < vDataValidate.size(); i++)
-				//	m.cellPlusOne((int)vDataValidate[i].getExpectedResult(), sNetwork.getClassification(vDataValidate[i].getParams()));
+				//for (int i = 0; i < dsValidate.getRowCount(); i++)
+				//	m.cellPlusOne(dsValidate.getLabel(i), sNetwork.getClassification(vector<double>(dsValidate.getParams(i), dsValidate.getParams(i + 1))));
 				//cout << "Results: (LR = " << LEARNING_RATE[i_rate] << " Iterations = " << LEARNING_ITERATIONS[i_iters] << "),\n";
 				//m.outputMatrix();
 				//cout << "\nAccuracy: (LR = " << LEARNING_RATE[i_rate] << " Iterations = " << LEARNING_ITERATIONS[i_iters] << ")\n";
@@ -173,8 +213,46 @@ int main()
 
 				//Train Sigmoid Network
 				cout << "Training Sigmoid Network (LR = " << LEARNING_RATE[i_rate] << " Iterations = " << LEARNING_ITERATIONS[i_iters] << ")...\n";
-				sNetwork.doTraining(vDataTrain, LEARNING_ITERATIONS[i_iters]);
+				int nRemainingIterations = LEARNING_ITERATIONS[i_iters] - sNetwork.getEpochCount();	//fewer if resumed from a checkpoint
+				if (nRemainingIterations > 0 && STREAM_CHUNK_ROWS > 0)
+					sNetwork.doTraining(dsTrainStream, nRemainingIterations);
+				else if (nRemainingIterations > 0)
+					sNetwork.doTraining(dsTrain, nRemainingIterations);
 				cout << "Done.\n";
+				if (pCheckpointer)
+				{
+					if (pCheckpointer->finish() && pCheckpointer->getWriteCount() > 0)
+						cout << "Checkpointed " << pCheckpointer->getWriteCount() << " time(s), last at epoch " << pCheckpointer->getLastEpoch() << ".\n";
+					pCheckpointer.reset();
+				}
+				if (STREAM_CHUNK_ROWS > 0)
+				{
+					SigmoidStreamStats streamStats = dsTrainStream.getStats();
+					cout << "Last pass: first chunk ready after " << streamStats.dblFirstChunkSeconds * 1000 << " ms, training waited " <<
+						streamStats.dblTrainerWaitSeconds * 1000 << " ms for data, parsing waited " << streamStats.dblParserBlockedSeconds * 1000 << " ms for training.\n";
+				}
+				if (pValidator)
+				{
+					pValidator->finish();
+					if (pValidator->hasStopped())
+						cout << "Stopped early: validation accuracy stopped improving.\n";
+					cout << "Best snapshot: epoch " << pValidator->getBestEpoch() << ", " << pValidator->getBestAccuracy() * 100 << "% accurate" <<
+						(KEEP_BEST_SNAPSHOT ? " (kept).\n" : ".\n");
+					pValidator.reset();
+				}
+				if (PRUNE_SPARSITY > 0)
+				{
+					cout << "Pruning Sigmoid Network...\n";
+					SigmoidPruner<Scalar> pruner(sNetwork);
+					pruner.pruneGradually(PRUNE_SPARSITY, PRUNE_SCOPE, PRUNE_STEPS, dsTrain, STREAM_CHUNK_ROWS > 0 ? 0 : PRUNE_FINE_TUNE_ITERATIONS);
+					cout << "Done. " << pruner.getSparsity() * 100 << "% of weights pruned.\n";
+				}
+				if (METRICS_FILE != "" && metricsLog.save(METRICS_FILE))
+					cout << "Saved training metrics to " << METRICS_FILE << ".\n";
+				if (MODEL_FILE != "" && sNetwork.save(MODEL_FILE))
+					cout << "Saved model to " << MODEL_FILE << ".\n";
+				if (strCheckpointFile != "")
+					remove(strCheckpointFile.c_str());	//training is done, so a later run of this cell starts afresh
 				//cout << endl;
 				//sNetwork.printNeuronWeights();
 				cout << endl << endl;
@@ -185,12 +263,29 @@ int main()
 														//Here we update the confusion matrix with our classifications. We do this by incrementing m_Matrix[ExpectedResult][ActualResult].
 														// ex: If A is expected but C is output of classifier, m_Matrix[0][2] is incremented by 1, counting an incorrect guess. 
 														//     if C is expected and C is output of classified, m_Matrix[2][2] is incremented, counting a correct guess.
-				for (unsigned int i = 0; i < vDataValidate.size(); i++)
-					m.cellPlusOne((int)vDataValidate[i].getExpectedResult(), sNetwork.getClassification(vDataValidate[i].getParams()));
+				const SigmoidClassifier<Scalar> *pClassifier = &sNetwork;
+				unique_ptr<FixedNetwork> pFixedNetwork;	//built only when used: its constructor draws from rand()
+				if (FIXED_INFERENCE)
+				{
+					pFixedNetwork.reset(new FixedNetwork(LEARNING_RATE[i_rate], BIAS, BIAS_WEIGHT, false));
+					if (pFixedNetwork->copyParams(sNetwork))
+						pClassifier = pFixedNetwork.get();
+				}
+				vector<int> vClassifications(dsValidate.getRowCount());
+				vector<Scalar> vScores((size_t)dsValidate.getRowCount() * NETWORK_LAYERS[NETWORK_LAYER_COUNT - 1]);
+				pClassifier->classifyBatch(dsValidate.getFeatures(), dsValidate.getRowCount(), vClassifications.data(), vScores.data());
+				m.addScores(dsValidate.getLabels(), vScores.data(), dsValidate.getRowCount());
 				cout << "Results: (LR = " << LEARNING_RATE[i_rate] << " Iterations = " << LEARNING_ITERATIONS[i_iters] << ")\n";
 				m.outputMatrix();
 				cout << "\nAccuracy: (LR = " << LEARNING_RATE[i_rate] << " Iterations = " << LEARNING_ITERATIONS[i_iters] << ")\n";
 				m.outputAccuracy();
+				ConfusionMetrics metrics = m.getMetrics();
+				cout << "\nOverall: " << metrics.dblAccuracy * 100 << "% accurate, macro F1 " << metrics.dblMacroF1;
+				if (metrics.vecTopKAccuracy.size() >= 3)
+					cout << ", top-3 " << metrics.vecTopKAccuracy[2] * 100 << "% accurate";
+				cout << "\n";
+				if (VALIDATION_METRICS_FILE != "" && m.saveMetrics(VALIDATION_METRICS_FILE))
+					cout << "Saved validation metrics to " << VALIDATION_METRICS_FILE << ".\n";
 				//cout << endl;						//debug
 				//sNetwork.printNeuronWeights();	//debug
 				cout << endl << endl;
@@ -203,66 +298,3 @@ int main()
 	return 0;
 }
 
-
-//Utility function to populate a vector<vector<string>> from a char delimeted data file
-// Accepts: strFilename = data file to be opened.
-//          chDelimeter = char to use as delimter. Ex CSV would have chDelimeter = ','
-// Returns: A populated vector<vector<string>>
-vector<vector<string>> populateVectorFromDataFile(string filename, char delimeter)
-{
-	vector<vector<string>> vData;
-
-	//Open data file
-	ifstream fsIn;
-	fsIn.open(filename);
-	if (fsIn.fail())
-	{
-		cout << "Error: File could not be opened.\n";
-		return vData;
-	}
-
-	//Populate vector array with data
-	string strTemp;
-	while (getline(fsIn, strTemp, '\n')) //iterate file by line
-	{
-		//create new vector "row"
-		vector<string> v;
-		vData.push_back(v);
-
-		//explode strTemp on chDelimeter and push values to new vector "row"
-		string str = "";
-		for (unsigned int i = 0; i < strTemp.length(); i++)
-		{
-			if (strTemp[i] != delimeter)
-				str = str + strTemp[i];
-			else
-			{
-				try
-				{
-					vData[vData.size() - 1].push_back(str);
-				}
-				catch (const invalid_argument& e)
-				{
-					cout << "ERROR: Data file contains an invalid data type.\n";
-					return vData;
-				}
-				str = "";
-			}
-		}
-		vData[vData.size() - 1].push_back(str);
-	}
-
-	//validate file size
-	if (vData.size() <= 0)
-		cout << "ERROR: File contained no data.\n\n";
-	return vData;
-}
-
-//Utility function to rescale a feature variable x as x' = (x-min(x))/max(x)-min(x)
-double rescaleFeature(double x, double minx, double maxx)
-{
-	if (maxx == minx) //if there is only one data row
-		return x;
-	else
-		return (x - minx) / (maxx - minx);
-}
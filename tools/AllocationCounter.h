@@ -0,0 +1,48 @@
+///////////////////////////////////////////
+// Counts every heap allocation in the process, for the tools that report allocations (benchmark.cpp and
+//	allocation_check.cpp). Including this header replaces the global operator new and delete with versions that add
+//	each allocation to g_nAllocations and its size to g_nAllocatedBytes. Read them before and after the code being
+//	measured and take the difference.
+//	Replacement operators cannot be inline, so include this header in exactly one translation unit of a program.
+// See inline documentation for more info.
+//
+
+#pragma once
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+
+using namespace std;
+
+inline atomic<long long> g_nAllocatedBytes(0);		//Bytes requested from operator new since startup
+inline atomic<long long> g_nAllocations(0);			//Calls to operator new since startup
+
+//Every allocation in the process goes through these. (GCC cannot tell that these deletes pair with these news, so
+// its new/delete mismatch warning is silenced here.)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void *operator new(size_t size)
+{
+	g_nAllocatedBytes += size;
+	g_nAllocations++;
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw bad_alloc();
+	return p;
+}
+void *operator new(size_t size, align_val_t alignment)
+{
+	g_nAllocatedBytes += size;
+	g_nAllocations++;
+	size_t nAlignment = max((size_t)alignment, sizeof(void *));
+	void *p = aligned_alloc(nAlignment, (size + nAlignment - 1) / nAlignment * nAlignment);
+	if (!p)
+		throw bad_alloc();
+	return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, align_val_t) noexcept { free(p); }
+void operator delete(void *p, size_t, align_val_t) noexcept { free(p); }
+#pragma GCC diagnostic pop
@@ -0,0 +1,131 @@
+///////////////////////////////////////////
+// Checks each sigmoid implementation (see SigmoidActivation in SigmoidKernels.h) against its documented error bound
+// and against the validation accuracy of the exact sigmoid.
+//	First, every implementation is run on every ISA the CPU supports, in float and double, over a dense grid of inputs,
+//	and its largest absolute error against 1 / (1 + exp(-x)) is compared to SigmoidKernels::getSigmoidMaxError().
+//	Then a network is trained from the same seed with each implementation, and each is validated, both with its own
+//	implementation and with the network trained on the exact sigmoid. Each accuracy must be within ACCURACY_TOLERANCE
+//	of the exact network's. Outputs CSV tables of both checks. The exit code is 1 if any check fails.
+//
+// Usage: activation_check training_data validation_data [iterations]
+//	training_data, validation_data = binary (see convert_dataset.cpp) or CSV data files. CSV files are rescaled as
+//	                                 main.cpp does (see SigmoidDataSet::rescaleSets()).
+//	iterations = training epochs per network. Default 5.
+// Compile from the repo root with: g++ -std=c++17 -O2 -pthread tools/activation_check.cpp -o activation_check
+//
+
+#include <vector>
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include "../SigmoidNetwork.h"
+
+using namespace std;
+
+const int NETWORK_LAYERS[] = { 16, 14, 26 };		//Network trained with each implementation
+const int NETWORK_LAYER_COUNT = 3;					//Size of NETWORK_LAYERS
+const double LEARNING_RATE = 0.05;
+const double ACCURACY_TOLERANCE = 0.005;			//Max difference from the exact sigmoid's validation accuracy
+const double GRID_RANGE = 40;						//The error grid covers -GRID_RANGE <= x <= GRID_RANGE
+const int GRID_STEPS = 4096;						//Grid points per unit of x
+const int ACTIVATION_COUNT = 3;						//Number of SigmoidActivations
+
+template <typename T>
+double getMaxError(SigmoidActivation activation);	//Returns the largest error of activation over the grid
+int getCorrectCount(const SigmoidNetwork<double> &network, const SigmoidDataSet<double> &dataset);	//Returns the rows network classifies correctly
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3 || argc > 4)
+	{
+		cout << "Usage: activation_check training_data validation_data [iterations]\n";
+		return 1;
+	}
+	int nIterations = (argc == 4) ? atoi(argv[3]) : 5;
+	SigmoidDataSet<double> dsTrain, dsValidate;
+	if (!SigmoidDataSet<double>::loadPair(dsTrain, dsValidate, argv[1], argv[2], LETTER_LABELS))
+		return 1;
+	if (dsTrain.getParamCount() != NETWORK_LAYERS[0])
+	{
+		cout << "ERROR: Data files must have one parameter per network input.\n";
+		return 1;
+	}
+
+	//Error against the exact sigmoid, on every ISA
+	int nFailures = 0;
+	SigmoidSimd::KernelIsa isaDefault = SigmoidSimd::getKernelIsa();
+	cout << "ISA,Activation,Double Max Error,Float Max Error,Double Bound,Float Bound,Status\n";
+	for (int isa = SigmoidSimd::ISA_SCALAR; isa <= SigmoidSimd::ISA_AVX512; isa++)
+	{
+		if (!SigmoidSimd::setKernelIsa((SigmoidSimd::KernelIsa)isa))
+			continue;
+		for (int a = 0; a < ACTIVATION_COUNT; a++)
+		{
+			SigmoidActivation activation = (SigmoidActivation)a;
+			double dblError = getMaxError<double>(activation), fError = getMaxError<float>(activation);
+			bool bPassed = dblError <= SigmoidKernels::getSigmoidMaxError<double>(activation) &&
+				fError <= SigmoidKernels::getSigmoidMaxError<float>(activation);
+			nFailures += !bPassed;
+			cout << SigmoidSimd::getKernelIsaName((SigmoidSimd::KernelIsa)isa) << "," << SigmoidKernels::getActivationName(activation) << "," <<
+				dblError << "," << fError << "," << SigmoidKernels::getSigmoidMaxError<double>(activation) << "," <<
+				SigmoidKernels::getSigmoidMaxError<float>(activation) << "," << (bPassed ? "ok" : "FAILED") << "\n";
+		}
+	}
+	SigmoidSimd::setKernelIsa(isaDefault);
+
+	//Validation accuracy, training with each implementation, then classifying the exact network with each
+	cout << "\nActivation,Trained Correct,Trained Accuracy,Exact-Trained Correct,Exact-Trained Accuracy,Status\n";
+	int nRows = dsValidate.getRowCount();
+	vector<unique_ptr<SigmoidNetwork<double>>> vNetworks;
+	for (int a = 0; a < ACTIVATION_COUNT; a++)
+	{
+		srand(1);
+		vNetworks.push_back(unique_ptr<SigmoidNetwork<double>>(new SigmoidNetwork<double>(NETWORK_LAYERS, NETWORK_LAYER_COUNT,
+			LEARNING_RATE, -1, 0.5, false)));
+		vNetworks[a]->setActivation((SigmoidActivation)a);
+		vNetworks[a]->doTraining(dsTrain, nIterations);
+	}
+	int nExactCorrect = getCorrectCount(*vNetworks[ACTIVATION_EXACT], dsValidate);
+	for (int a = 0; a < ACTIVATION_COUNT; a++)
+	{
+		SigmoidActivation activation = (SigmoidActivation)a;
+		int nTrainedCorrect = getCorrectCount(*vNetworks[a], dsValidate);
+		vNetworks[ACTIVATION_EXACT]->setActivation(activation);
+		int nSwappedCorrect = getCorrectCount(*vNetworks[ACTIVATION_EXACT], dsValidate);
+		vNetworks[ACTIVATION_EXACT]->setActivation(ACTIVATION_EXACT);
+		bool bPassed = fabs((double)(nTrainedCorrect - nExactCorrect) / nRows) <= ACCURACY_TOLERANCE &&
+			fabs((double)(nSwappedCorrect - nExactCorrect) / nRows) <= ACCURACY_TOLERANCE;
+		nFailures += !bPassed;
+		cout << SigmoidKernels::getActivationName(activation) << "," << nTrainedCorrect << "," << 100.0 * nTrainedCorrect / nRows << "," <<
+			nSwappedCorrect << "," << 100.0 * nSwappedCorrect / nRows << "," << (bPassed ? "ok" : "FAILED") << "\n";
+	}
+	cout << nFailures << " check(s) failed.\n";
+	return nFailures == 0 ? 0 : 1;
+}
+
+//Errors are measured against the exact sigmoid of each input as rounded to T
+template <typename T>
+double getMaxError(SigmoidActivation activation)
+{
+	int nCount = (int)(2 * GRID_RANGE * GRID_STEPS) + 1;
+	vector<T> vValues(nCount);
+	for (int i = 0; i < nCount; i++)
+		vValues[i] = (T)(-GRID_RANGE + (double)i / GRID_STEPS);
+	vector<T> vOutputs = vValues;
+	SigmoidKernels::calculateSigmoid(vOutputs.data(), nCount, activation);
+	double dblMaxError = 0;
+	for (int i = 0; i < nCount; i++)
+		dblMaxError = max(dblMaxError, fabs(vOutputs[i] - 1 / (1 + exp(-(double)vValues[i]))));
+	return dblMaxError;
+}
+
+int getCorrectCount(const SigmoidNetwork<double> &network, const SigmoidDataSet<double> &dataset)
+{
+	vector<int> vClassifications(dataset.getRowCount());
+	network.classifyBatch(dataset.getFeatures(), dataset.getRowCount(), vClassifications.data(), NULL);
+	int nCorrect = 0;
+	for (int i = 0; i < dataset.getRowCount(); i++)
+		nCorrect += dataset.getLabel(i) == vClassifications[i];
+	return nCorrect;
+}
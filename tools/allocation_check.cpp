@@ -0,0 +1,132 @@
+///////////////////////////////////////////
+// Checks that training and inference make no heap allocations once warmed up.
+//	Every allocation in the process is counted by replacing operator new (see AllocationCounter.h). Each scenario
+//	below (training at several batch sizes, thread counts and optimizers, and each classification path) is run once to
+//	warm up, which sizes its workspaces, thread-local buffers and thread pool, then RUN_COUNT more times, and every
+//	allocation made during those runs is reported. Data is synthetic, as in benchmark.cpp. Outputs a CSV table. The
+//	exit code is 1 if any scenario allocates after warm-up.
+//	Not covered, by design: training on a vector of SigmoidDataRows (copied into a SigmoidDataSet on every call),
+//	streaming training (SigmoidDataStream starts reader and parser threads for each pass), the background validation
+//	thread (SigmoidValidator), and anything an epoch callback does itself.
+//
+// Usage: allocation_check
+// Compile from the repo root with: g++ -std=c++17 -O2 -pthread tools/allocation_check.cpp -o allocation_check
+//
+
+#include <vector>
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <functional>
+#include "../SigmoidNetwork.h"
+#include "../FixedSigmoidNetwork.h"
+#include "../SparseSigmoidNetwork.h"
+#include "AllocationCounter.h"
+
+using namespace std;
+
+typedef double Scalar;								//Precision of weights, activations and data: float or double
+typedef FixedSigmoidNetwork<Scalar, 16, 14, 26> FixedNetwork;	//NETWORK_LAYERS, fixed at compile time
+
+const int FEATURE_COUNT = 16;						//Features per synthetic row, as in the letter data
+const int LABEL_COUNT = 26;							//Labels per synthetic row
+const int NETWORK_LAYERS[] = { 16, 14, 26 };		//Network checked
+const int NETWORK_LAYER_COUNT = 3;					//Size of NETWORK_LAYERS
+const int ROW_COUNT = 1000;							//Synthetic data set size
+const int RUN_COUNT = 3;							//Runs of each scenario after warm-up
+
+
+struct Scenario
+{
+	string strName;									//What is run. Ex: training_batch16
+	function<void()> fn;							//Runs it once
+};
+
+void generateDataSet(SigmoidDataSet<Scalar> &dataset, int rowcount);	//Fills dataset with synthetic rows
+
+int main()
+{
+	SigmoidDataSet<Scalar> dsData;
+	generateDataSet(dsData, ROW_COUNT);
+	vector<SigmoidDataRow<Scalar>> vRows;
+	for (int i = 0; i < ROW_COUNT; i++)
+		vRows.push_back(SigmoidDataRow<Scalar>(dsData.getLabel(i), vector<Scalar>(dsData.getParams(i), dsData.getParams(i + 1))));
+	vector<Scalar> vFirstRow(dsData.getParams(0), dsData.getParams(1));
+	vector<int> vClassifications(ROW_COUNT);
+	vector<Scalar> vScores((size_t)ROW_COUNT * NETWORK_LAYERS[NETWORK_LAYER_COUNT - 1]);
+
+	//One network per training configuration
+	vector<unique_ptr<SigmoidNetwork<Scalar>>> vNetworks;
+	auto addNetwork = [&](int batchsize, int threadcount, ParallelMode mode, OptimizerType optimizer)
+	{
+		srand(1);
+		vNetworks.push_back(unique_ptr<SigmoidNetwork<Scalar>>(new SigmoidNetwork<Scalar>(NETWORK_LAYERS, NETWORK_LAYER_COUNT,
+			optimizer == OPTIMIZER_ADAM ? 0.001 : 0.01, -1, 0.5, false)));
+		vNetworks.back()->setBatchSize(batchsize);
+		vNetworks.back()->setTrainingThreads(threadcount, mode);
+		vNetworks.back()->setOptimizer(optimizer, 0.9, 0.999);
+		return vNetworks.back().get();
+	};
+	SigmoidNetwork<Scalar> *pSgd = addNetwork(1, 1, PARALLEL_SYNCHRONOUS, OPTIMIZER_SGD);
+	SigmoidNetwork<Scalar> *pBatch = addNetwork(16, 1, PARALLEL_SYNCHRONOUS, OPTIMIZER_SGD);
+	SigmoidNetwork<Scalar> *pSynchronous = addNetwork(16, 2, PARALLEL_SYNCHRONOUS, OPTIMIZER_SGD);
+	SigmoidNetwork<Scalar> *pHogwild = addNetwork(1, 2, PARALLEL_HOGWILD, OPTIMIZER_SGD);
+	SigmoidNetwork<Scalar> *pNesterov = addNetwork(1, 1, PARALLEL_SYNCHRONOUS, OPTIMIZER_NESTEROV);
+	SigmoidNetwork<Scalar> *pAdam = addNetwork(16, 1, PARALLEL_SYNCHRONOUS, OPTIMIZER_ADAM);
+	SigmoidNetwork<Scalar> *pScheduled = addNetwork(1, 1, PARALLEL_SYNCHRONOUS, OPTIMIZER_MOMENTUM);
+	double dblLossTotal = 0;
+	pScheduled->setLearningRateSchedule(getCosineSchedule(10, 0));
+	pScheduled->setEpochCallback([&dblLossTotal](const SigmoidEpochMetrics &metrics) { dblLossTotal += metrics.dblLoss; });
+	SigmoidWorkspace<Scalar> ws = pSgd->createWorkspace(64);
+	FixedNetwork fixedNetwork(0.01, -1, 0.5, false);
+	SparseSigmoidNetwork<Scalar> sparseNetwork;
+	sparseNetwork.sparsify(*pSgd);
+
+	vector<Scenario> vScenarios = {
+		{ "training_batch1", [&] { pSgd->doTraining(dsData, 1); } },
+		{ "training_batch16", [&] { pBatch->doTraining(dsData, 1); } },
+		{ "training_synchronous_2_threads", [&] { pSynchronous->doTraining(dsData, 1); } },
+		{ "training_hogwild_2_threads", [&] { pHogwild->doTraining(dsData, 1); } },
+		{ "training_nesterov", [&] { pNesterov->doTraining(dsData, 1); } },
+		{ "training_adam_batch16", [&] { pAdam->doTraining(dsData, 1); } },
+		{ "training_scheduled_with_callback", [&] { pScheduled->doTraining(dsData, 1); } },
+		{ "training_fixed", [&] { fixedNetwork.doTraining(dsData, 1); } },
+		{ "get_classification_vector", [&] { pSgd->getClassification(vFirstRow); } },
+		{ "get_classification", [&] { vClassifications[0] = static_cast<const SigmoidNetwork<Scalar> *>(pSgd)->getClassification(dsData.getParams(0)); } },
+		{ "classify_batch", [&] { pSgd->classifyBatch(dsData.getFeatures(), ROW_COUNT, vClassifications.data(), vScores.data()); } },
+		{ "classify_batch_workspace", [&] { pSgd->classifyBatch(dsData.getFeatures(), ROW_COUNT, vClassifications.data(), NULL, ws); } },
+		{ "classify_batch_rows", [&] { pSgd->classifyBatch(vRows.data(), ROW_COUNT, vClassifications.data(), NULL); } },
+		{ "classify_batch_fixed", [&] { fixedNetwork.classifyBatch(dsData.getFeatures(), ROW_COUNT, vClassifications.data(), NULL); } },
+		{ "classify_batch_sparse", [&] { sparseNetwork.classifyBatch(dsData.getFeatures(), ROW_COUNT, vClassifications.data(), vScores.data()); } }
+	};
+
+	int nFailures = 0;
+	cout << "Scenario,Allocations,Bytes,Status\n";
+	for (unsigned int i = 0; i < vScenarios.size(); i++)
+	{
+		vScenarios[i].fn();
+		long long nAllocations = g_nAllocations, nBytes = g_nAllocatedBytes;
+		for (int r = 0; r < RUN_COUNT; r++)
+			vScenarios[i].fn();
+		nAllocations = g_nAllocations - nAllocations;
+		nBytes = g_nAllocatedBytes - nBytes;
+		nFailures += nAllocations != 0;
+		cout << vScenarios[i].strName << "," << nAllocations << "," << nBytes << "," << (nAllocations == 0 ? "ok" : "FAILED") << "\n";
+	}
+	cout << nFailures << " scenario(s) allocated after warm-up.\n";
+	return nFailures == 0 ? 0 : 1;
+}
+
+//Random letter-like rows, as benchmark.cpp generates
+void generateDataSet(SigmoidDataSet<Scalar> &dataset, int rowcount)
+{
+	srand(1);
+	vector<Scalar> vParams(FEATURE_COUNT);
+	for (int i = 0; i < rowcount; i++)
+	{
+		for (int k = 0; k < FEATURE_COUNT; k++)
+			vParams[k] = (Scalar)(rand() % 16);
+		dataset.addRow(rand() % LABEL_COUNT, vParams.data(), FEATURE_COUNT);
+	}
+	dataset.rescale(vector<double>(FEATURE_COUNT, 0), vector<double>(FEATURE_COUNT, 15));
+}
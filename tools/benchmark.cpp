@@ -0,0 +1,363 @@
+///////////////////////////////////////////
+// Micro- and macro-benchmarks of the library, output as JSON for comparison against a saved baseline.
+//	Covers CSV and binary data ingestion, each sigmoid implementation (see SigmoidActivation), SigmoidNetwork::
+//	propagateForward, a single row of learning (doLearn, through doTraining on a one-row set), a full training epoch
+//	and batched classification (classifyBatch, with each sigmoid implementation), across several topologies and data
+//	set sizes. Data is synthetic: random letter-like rows of 16 integer features in [0, 15], generated from a fixed
+//	seed, so every run measures the same work.
+//	Each benchmark is run enough times per sample to take at least MIN_SAMPLE_SECONDS, and the fastest of
+//	SAMPLE_COUNT samples is reported, which is far more stable than the mean on a shared machine. Every result gives
+//	ns per op, samples (rows) per second, and bytes and allocations per op, counted by replacing operator new (see
+//	AllocationCounter.h).
+//	With --baseline, each result is compared to the same benchmark in a JSON file written by an earlier run, and the
+//	exit code is 2 if any is more than --tolerance slower.
+//
+// Usage: benchmark [--quick] [--out results.json] [--baseline baseline.json] [--tolerance 0.1]
+//	--quick = fewer and shorter samples, and only the smallest data set
+//	--out = also write the JSON to this file (it is always output to the console)
+// Compile from the repo root with: g++ -std=c++17 -O2 -pthread tools/benchmark.cpp -o benchmark
+//
+
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include "../SigmoidNetwork.h"
+#include "AllocationCounter.h"
+
+using namespace std;
+
+typedef double Scalar;								//Precision of weights, activations and data: float or double
+
+const int FEATURE_COUNT = 16;						//Features per synthetic row, as in the letter data
+const int TOPOLOGIES[][4] = { { 16, 14, 26 }, { 16, 64, 26 }, { 16, 128, 128, 26 } };	//Networks benchmarked
+const int TOPOLOGY_SIZES[] = { 3, 3, 4 };			//Layer count of each of TOPOLOGIES
+const int TOPOLOGY_COUNT = 3;						//Size of TOPOLOGIES
+const int DATASET_ROWS[] = { 1000, 20000 };			//Synthetic data set sizes
+const int DATASET_COUNT = 2;						//Size of DATASET_ROWS
+const int TRAINING_BATCH_SIZES[] = { 1, 64 };		//Batch sizes the training epoch is benchmarked at
+const int BATCH_SIZE_COUNT = 2;						//Size of TRAINING_BATCH_SIZES
+const int SIGMOID_VALUE_COUNT = 4096;				//Values per run of the sigmoid benchmarks, evenly spaced over [-8, 8]
+const int ACTIVATION_COUNT = 3;						//Number of SigmoidActivations
+
+double MIN_SAMPLE_SECONDS = 0.05;					//Each sample repeats the benchmark for at least this long
+int SAMPLE_COUNT = 7;								//Samples per benchmark. The fastest is reported.
+
+struct BenchmarkResult
+{
+	string strName;									//What was measured. Ex: training_epoch
+	string strTopology;								//Layer sizes, dash separated, or "" if not a network benchmark
+	int nRows;										//Data set rows, or 0 if not a data set benchmark
+	int nBatchSize;									//Training batch size, or 0 if not a training benchmark
+	double dblNsPerOp;								//Wall time per op, fastest sample
+	double dblSamplesPerSecond;						//Rows processed per second, fastest sample
+	double dblBytesPerOp;							//Bytes allocated per op
+	double dblAllocationsPerOp;						//Allocations per op
+};
+
+template <typename F>
+BenchmarkResult runBenchmark(const string &name, const string &topology, int rows, int batchsize, int opsperrun, int samplesperrun, F fn);	//Times fn
+void generateDataSet(SigmoidDataSet<Scalar> &dataset, int rowcount);			//Fills dataset with synthetic rows
+bool writeCsv(const SigmoidDataSet<Scalar> &dataset, const string &filename);	//Writes dataset as a CSV data file
+string getTopologyName(const int *layers, int layercount);						//Returns layers as a dash separated string. Ex: 16-14-26
+string getJson(const vector<BenchmarkResult> &results);							//Returns results, with context, as JSON. One benchmark per line.
+int compareToBaseline(const vector<BenchmarkResult> &results, const string &filename, double tolerance);	//Outputs a comparison. Returns the regression count, or -1.
+
+int main(int argc, char *argv[])
+{
+	bool bQuick = false;
+	string strOutFile, strBaselineFile;
+	double dblTolerance = 0.1;
+	for (int i = 1; i < argc; i++)
+	{
+		string strArg = argv[i];
+		if (strArg == "--quick")
+			bQuick = true;
+		else if (strArg == "--out" && i + 1 < argc)
+			strOutFile = argv[++i];
+		else if (strArg == "--baseline" && i + 1 < argc)
+			strBaselineFile = argv[++i];
+		else if (strArg == "--tolerance" && i + 1 < argc)
+			dblTolerance = atof(argv[++i]);
+		else
+		{
+			cout << "Usage: benchmark [--quick] [--out results.json] [--baseline baseline.json] [--tolerance 0.1]\n";
+			return 1;
+		}
+	}
+	if (bQuick)
+	{
+		MIN_SAMPLE_SECONDS = 0.01;
+		SAMPLE_COUNT = 3;
+	}
+	int nDatasetCount = bQuick ? 1 : DATASET_COUNT;
+	vector<BenchmarkResult> vResults;
+
+	//Sigmoid implementations, one value per op
+	{
+		vector<Scalar> vValues(SIGMOID_VALUE_COUNT), vOutputs(SIGMOID_VALUE_COUNT);
+		for (int i = 0; i < SIGMOID_VALUE_COUNT; i++)
+			vValues[i] = (Scalar)(16.0 * i / SIGMOID_VALUE_COUNT - 8);
+		for (int a = 0; a < ACTIVATION_COUNT; a++)
+		{
+			SigmoidActivation activation = (SigmoidActivation)a;
+			vResults.push_back(runBenchmark(string("calculate_sigmoid_") + SigmoidKernels::getActivationName(activation), "", 0, 0,
+				SIGMOID_VALUE_COUNT, SIGMOID_VALUE_COUNT, [&] {
+				copy(vValues.begin(), vValues.end(), vOutputs.begin());
+				SigmoidKernels::calculateSigmoid(vOutputs.data(), SIGMOID_VALUE_COUNT, activation);
+			}));
+		}
+	}
+
+	for (int d = 0; d < nDatasetCount; d++)
+	{
+		int nRows = DATASET_ROWS[d];
+		SigmoidDataSet<Scalar> dsData;
+		generateDataSet(dsData, nRows);
+
+		//Ingestion, from temporary files
+		string strCsvFile = "benchmark_" + to_string(nRows) + ".tmp.csv";
+		string strBinFile = "benchmark_" + to_string(nRows) + ".tmp.bin";
+		if (!writeCsv(dsData, strCsvFile) || !dsData.saveBinary(strBinFile, false))
+			return 1;
+		vResults.push_back(runBenchmark("ingest_csv", "", nRows, 0, nRows, nRows, [&] {
+			SigmoidDataSet<Scalar> ds;
+			ds.loadCsv(strCsvFile, LETTER_LABELS);
+		}));
+		vResults.push_back(runBenchmark("ingest_binary", "", nRows, 0, nRows, nRows, [&] {
+			SigmoidDataSet<Scalar> ds;
+			ds.loadBinary(strBinFile, LETTER_LABELS);
+		}));
+		remove(strCsvFile.c_str());
+		remove(strBinFile.c_str());
+
+		for (int t = 0; t < TOPOLOGY_COUNT; t++)
+		{
+			string strTopology = getTopologyName(TOPOLOGIES[t], TOPOLOGY_SIZES[t]);
+			srand(1);
+			SigmoidNetwork<Scalar> network(TOPOLOGIES[t], TOPOLOGY_SIZES[t], 0.1, -1, 0.5, false);
+
+			//Per-row benchmarks only depend on the topology, so are run against the first data set only
+			if (d == 0)
+			{
+				int nRow = 0;
+				vector<vector<Scalar>> vRows(nRows);
+				for (int i = 0; i < nRows; i++)
+					vRows[i].assign(dsData.getParams(i), dsData.getParams(i) + FEATURE_COUNT);
+				vResults.push_back(runBenchmark("propagate_forward", strTopology, 0, 0, 1, 1, [&] {
+					network.propagateForward(vRows[nRow]);
+					nRow = (nRow + 1) % nRows;
+				}));
+				SigmoidDataSet<Scalar> dsRow;
+				dsRow.addRow(dsData.getLabel(0), dsData.getParams(0), FEATURE_COUNT);
+				vResults.push_back(runBenchmark("do_learn", strTopology, 0, 1, 1, 1, [&] { network.doTraining(dsRow, 1); }));
+			}
+
+			for (int b = 0; b < BATCH_SIZE_COUNT; b++)
+			{
+				network.setBatchSize(TRAINING_BATCH_SIZES[b]);
+				vResults.push_back(runBenchmark("training_epoch", strTopology, nRows, TRAINING_BATCH_SIZES[b], 1, nRows, [&] {
+					network.doTraining(dsData, 1);
+				}));
+			}
+
+			//Exact sigmoid first, keeping the benchmark's original name
+			vector<int> vClassifications(nRows);
+			for (int a = 0; a < ACTIVATION_COUNT; a++)
+			{
+				SigmoidActivation activation = (SigmoidActivation)a;
+				network.setActivation(activation);
+				vResults.push_back(runBenchmark(string("classify_batch") + (a == ACTIVATION_EXACT ? "" : string("_") +
+					SigmoidKernels::getActivationName(activation)), strTopology, nRows, 0, nRows, nRows, [&] {
+					network.classifyBatch(dsData.getFeatures(), nRows, vClassifications.data(), NULL);
+				}));
+			}
+			network.setActivation(ACTIVATION_EXACT);
+		}
+	}
+
+	string strJson = getJson(vResults);
+	cout << strJson;
+	if (strOutFile != "")
+	{
+		ofstream fsOut(strOutFile.c_str());
+		fsOut << strJson;
+		if (fsOut.fail())
+		{
+			cout << "ERROR: " << strOutFile << " could not be written.\n";
+			return 1;
+		}
+	}
+	if (strBaselineFile != "")
+	{
+		int nRegressions = compareToBaseline(vResults, strBaselineFile, dblTolerance);
+		if (nRegressions != 0)
+			return (nRegressions > 0) ? 2 : 1;
+	}
+	return 0;
+}
+
+//Runs fn once to warm up, then finds how many runs take MIN_SAMPLE_SECONDS and times SAMPLE_COUNT samples of that many.
+// Each run of fn is opsperrun ops and processes samplesperrun rows. Allocations are counted over every sample.
+template <typename F>
+BenchmarkResult runBenchmark(const string &name, const string &topology, int rows, int batchsize, int opsperrun, int samplesperrun, F fn)
+{
+	fn();
+	long long nRuns = 1;
+	while (true)
+	{
+		chrono::steady_clock::time_point tStart = chrono::steady_clock::now();
+		for (long long i = 0; i < nRuns; i++)
+			fn();
+		if (chrono::duration<double>(chrono::steady_clock::now() - tStart).count() >= MIN_SAMPLE_SECONDS)
+			break;
+		nRuns *= 2;
+	}
+
+	double dblBest = 1e300;
+	long long nBytes = g_nAllocatedBytes, nAllocations = g_nAllocations;
+	for (int s = 0; s < SAMPLE_COUNT; s++)
+	{
+		chrono::steady_clock::time_point tStart = chrono::steady_clock::now();
+		for (long long i = 0; i < nRuns; i++)
+			fn();
+		dblBest = min(dblBest, chrono::duration<double>(chrono::steady_clock::now() - tStart).count());
+	}
+	nBytes = g_nAllocatedBytes - nBytes;
+	nAllocations = g_nAllocations - nAllocations;
+	double dblOps = (double)nRuns * SAMPLE_COUNT * opsperrun;
+
+	BenchmarkResult result;
+	result.strName = name;
+	result.strTopology = topology;
+	result.nRows = rows;
+	result.nBatchSize = batchsize;
+	result.dblNsPerOp = dblBest * 1e9 / ((double)nRuns * opsperrun);
+	result.dblSamplesPerSecond = (double)nRuns * samplesperrun / dblBest;
+	result.dblBytesPerOp = nBytes / dblOps;
+	result.dblAllocationsPerOp = nAllocations / dblOps;
+	cerr << name << " " << topology << " " << rows << " " << batchsize << ": " << result.dblNsPerOp << " ns/op\n";
+	return result;
+}
+
+//Fills dataset with rowcount rows of FEATURE_COUNT random integer features in [0, 15] and a random label, rescaled
+// to [0, 1] as main.cpp would
+void generateDataSet(SigmoidDataSet<Scalar> &dataset, int rowcount)
+{
+	srand(1);
+	vector<Scalar> vParams(FEATURE_COUNT);
+	for (int i = 0; i < rowcount; i++)
+	{
+		for (int k = 0; k < FEATURE_COUNT; k++)
+			vParams[k] = (Scalar)(rand() % 16);
+		dataset.addRow(rand() % (int)LETTER_LABELS.size(), vParams.data(), FEATURE_COUNT);
+	}
+	dataset.rescale(vector<double>(FEATURE_COUNT, 0), vector<double>(FEATURE_COUNT, 15));
+}
+
+//Writes dataset's rows as label, param_1, ..., param_n, with features scaled back to the integers they were generated as
+bool writeCsv(const SigmoidDataSet<Scalar> &dataset, const string &filename)
+{
+	ofstream fsOut(filename.c_str());
+	for (int i = 0; i < dataset.getRowCount(); i++)
+	{
+		fsOut << LETTER_LABELS[dataset.getLabel(i)];
+		for (int k = 0; k < dataset.getParamCount(); k++)
+			fsOut << "," << (int)(dataset.getParams(i)[k] * 15 + 0.5);
+		fsOut << "\n";
+	}
+	if (fsOut.fail())
+	{
+		cout << "ERROR: " << filename << " could not be written.\n";
+		return false;
+	}
+	return true;
+}
+
+string getTopologyName(const int *layers, int layercount)
+{
+	string strName;
+	for (int i = 0; i < layercount; i++)
+		strName += (i ? "-" : "") + to_string(layers[i]);
+	return strName;
+}
+
+//Returns {"context": {...}, "benchmarks": [...]}, with each benchmark on a line of its own so files diff line by line
+string getJson(const vector<BenchmarkResult> &results)
+{
+	char szDate[32];
+	time_t tNow = time(NULL);
+	strftime(szDate, sizeof(szDate), "%Y-%m-%dT%H:%M:%SZ", gmtime(&tNow));
+	stringstream ss;
+	ss << "{\n  \"context\": {\"date\": \"" << szDate << "\", \"scalar\": \"" << (sizeof(Scalar) == 4 ? "float" : "double") <<
+		"\", \"isa\": \"" << SigmoidSimd::getKernelIsaName(SigmoidSimd::getKernelIsa()) << "\", \"compiler\": \"" << __VERSION__ <<
+		"\", \"min_sample_seconds\": " << MIN_SAMPLE_SECONDS << ", \"samples\": " << SAMPLE_COUNT << "},\n  \"benchmarks\": [\n";
+	for (unsigned int i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult &r = results[i];
+		ss << "    {\"name\": \"" << r.strName << "\", \"topology\": \"" << r.strTopology << "\", \"rows\": " << r.nRows <<
+			", \"batch_size\": " << r.nBatchSize << ", \"ns_per_op\": " << r.dblNsPerOp << ", \"samples_per_sec\": " <<
+			r.dblSamplesPerSecond << ", \"bytes_per_op\": " << r.dblBytesPerOp << ", \"allocations_per_op\": " <<
+			r.dblAllocationsPerOp << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	ss << "  ]\n}\n";
+	return ss.str();
+}
+
+//Returns the value of "key": in line, as text without quotes, or "" if line has no such key
+string getJsonField(const string &line, const string &key)
+{
+	size_t nPos = line.find("\"" + key + "\": ");
+	if (nPos == string::npos)
+		return "";
+	nPos += key.size() + 4;
+	if (line[nPos] == '"')
+		return line.substr(nPos + 1, line.find('"', nPos + 1) - nPos - 1);
+	return line.substr(nPos, line.find_first_of(",}", nPos) - nPos);
+}
+
+//Reads a JSON file written by getJson() and compares each of results to the benchmark of the same name, topology, rows
+// and batch size. A result more than tolerance (a fraction) slower is a regression.
+int compareToBaseline(const vector<BenchmarkResult> &results, const string &filename, double tolerance)
+{
+	ifstream fsIn(filename.c_str());
+	if (fsIn.fail())
+	{
+		cout << "ERROR: Baseline file " << filename << " could not be opened.\n";
+		return -1;
+	}
+	map<string, double> mapBaseline;	//ns per op, by benchmark key
+	string strLine;
+	while (getline(fsIn, strLine))
+	{
+		string strName = getJsonField(strLine, "name");
+		if (strName != "")
+			mapBaseline[strName + "|" + getJsonField(strLine, "topology") + "|" + getJsonField(strLine, "rows") + "|" +
+				getJsonField(strLine, "batch_size")] = atof(getJsonField(strLine, "ns_per_op").c_str());
+	}
+
+	int nRegressions = 0;
+	cout << "\nBenchmark,Topology,Rows,Batch Size,Baseline ns/op,ns/op,Change %,Status\n";
+	for (unsigned int i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult &r = results[i];
+		cout << r.strName << "," << r.strTopology << "," << r.nRows << "," << r.nBatchSize << ",";
+		map<string, double>::const_iterator it = mapBaseline.find(r.strName + "|" + r.strTopology + "|" + to_string(r.nRows) + "|" + to_string(r.nBatchSize));
+		if (it == mapBaseline.end() || it->second <= 0)
+		{
+			cout << "," << r.dblNsPerOp << ",,new\n";
+			continue;
+		}
+		double dblChange = r.dblNsPerOp / it->second - 1;
+		bool bRegressed = dblChange > tolerance;
+		nRegressions += bRegressed;
+		cout << it->second << "," << r.dblNsPerOp << "," << 100 * dblChange << "," << (bRegressed ? "REGRESSION" : "ok") << "\n";
+	}
+	cout << nRegressions << " regression(s) beyond " << 100 * tolerance << "%.\n";
+	return nRegressions;
+}
@@ -0,0 +1,60 @@
+///////////////////////////////////////////
+// Converts CSV data files (label, param_1, ..., param_n per line) to the binary data format SigmoidDataSet reads
+// (see SigmoidDataFile.h). Every input's features are rescaled using the min/max of each column across all inputs, as
+// main.cpp does for its training and validation sets, so files converted together can be used together.
+//
+// Usage: convert_dataset [--float] in1.csv out1.bin [in2.csv out2.bin ...]
+//	--float = store features as 32-bit floats (half the size, converted to the network's precision when loaded)
+// Compile from the repo root with: g++ -std=c++17 -pthread tools/convert_dataset.cpp -o convert_dataset
+//
+
+#include <vector>
+#include <iostream>
+#include <string>
+#include "../SigmoidDataSet.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+	bool bSinglePrecision = false;
+	vector<string> vecFiles;
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) == "--float")
+			bSinglePrecision = true;
+		else
+			vecFiles.push_back(argv[i]);
+	}
+	if (vecFiles.empty() || vecFiles.size() % 2 != 0)
+	{
+		cout << "Usage: convert_dataset [--float] in1.csv out1.bin [in2.csv out2.bin ...]\n";
+		return 1;
+	}
+
+	//Read every input, then rescale them all by the min and max of each column across all of them
+	vector<SigmoidDataSet<double> > vecSets(vecFiles.size() / 2);
+	vector<SigmoidDataSet<double> *> vecSetPointers;
+	for (size_t i = 0; i < vecSets.size(); i++)
+	{
+		cout << "Reading " << vecFiles[i * 2] << "...\n";
+		if (!vecSets[i].loadCsv(vecFiles[i * 2], LETTER_LABELS))
+			return 1;
+		if (vecSets[i].getParamCount() != vecSets[0].getParamCount())
+		{
+			cout << "ERROR: Differing parameter counts between " << vecFiles[0] << " and " << vecFiles[i * 2] << ".\n";
+			return 1;
+		}
+		vecSetPointers.push_back(&vecSets[i]);
+	}
+	SigmoidDataSet<double>::rescaleSets(vecSetPointers);
+
+	//Write each set
+	for (size_t i = 0; i < vecSets.size(); i++)
+	{
+		if (!vecSets[i].saveBinary(vecFiles[i * 2 + 1], bSinglePrecision))
+			return 1;
+		cout << "Wrote " << vecSets[i].getRowCount() << " rows to " << vecFiles[i * 2 + 1] << ".\n";
+	}
+	return 0;
+}
@@ -0,0 +1,236 @@
+///////////////////////////////////////////
+// Trains one network across several processes, data-parallel: each process (rank) holds a replica of the network and
+// trains it on its own shard of the training set, and every batch's gradients are summed across the replicas over a
+// ring (see SigmoidRing.h) before each replica applies the same update. So the replicas stay identical, and together
+// train as one network would with a batch of ranks x batch rows.
+// Run without --rank, it launches --ranks processes of itself, one per rank, on this host, and waits for them. Rank 0
+// reports each epoch's loss across every shard, then validates and saves the trained network.
+//
+// Usage: distributed_train training_data validation_data --ranks N [--epochs E] [--batch B] [--rate LR] [--hidden H]
+//                          [--address address] [--model model_file] [--rank r]
+//	training_data, validation_data = binary (see convert_dataset.cpp) or CSV data files. CSV data is rescaled as
+//	                                 main.cpp does (see SigmoidDataSet::rescaleSets()). Each rank trains on rows / N
+//	                                 of training_data; the rest are unused.
+//	--epochs = passes over each shard. Default 10.
+//	--batch = rows per batch, per rank. Default 32.
+//	--rate = learning rate. Default 0.01.
+//	--hidden = neurons in the hidden layer. Default 14.
+//	--address = ring address: a TCP port (rank r listens on port + r) or a Unix domain socket path prefix. Default
+//	            /tmp/sigmoid-ring-<pid of the launcher>.
+//	--model = rank 0 saves the trained network here
+//	--rank = runs as rank r of the ring at --address, rather than launching the ranks
+// Compile from the repo root with: g++ -std=c++17 -O2 -pthread tools/distributed_train.cpp -o distributed_train
+//
+
+#include <vector>
+#include <iostream>
+#include <string>
+#include <ctime>
+#include <cstdlib>
+#include <cstdio>
+#include <sys/wait.h>
+#include "../SigmoidNetwork.h"
+#include "../SigmoidRing.h"
+#include "../ConfusionMatrix.h"
+
+using namespace std;
+
+typedef double Scalar;								//Precision of weights, activations and data: float or double
+
+const double BIAS = -1;								//Bias of each neuron
+const double BIAS_WEIGHT = 0.5;						//Initial bias Weight of each neuron
+const int CONNECT_TIMEOUT_SECONDS = 30;				//Longest a rank waits for its neighbours to join the ring
+
+struct TrainingOptions								//Command line options
+{
+	string strTrainingFile;
+	string strValidationFile;
+	int nRanks = 0;
+	int nRank = -1;
+	int nEpochs = 10;
+	int nBatchSize = 32;
+	double dblLearningRate = 0.01;
+	int nHidden = 14;
+	string strAddress;
+	string strModelFile;
+};
+
+int launchRanks(char *argv[], const TrainingOptions &options);				//Runs a process per rank and waits for them. Returns the exit code.
+int runRank(const TrainingOptions &options);								//Trains as one rank of the ring. Returns the exit code.
+
+int main(int argc, char *argv[])
+{
+	TrainingOptions options;
+	vector<string> vecFiles;
+	for (int i = 1; i < argc; i++)
+	{
+		string strArg = argv[i];
+		bool bHasValue = i + 1 < argc;
+		if (strArg == "--ranks" && bHasValue)
+			options.nRanks = atoi(argv[++i]);
+		else if (strArg == "--rank" && bHasValue)
+			options.nRank = atoi(argv[++i]);
+		else if (strArg == "--epochs" && bHasValue)
+			options.nEpochs = atoi(argv[++i]);
+		else if (strArg == "--batch" && bHasValue)
+			options.nBatchSize = atoi(argv[++i]);
+		else if (strArg == "--rate" && bHasValue)
+			options.dblLearningRate = atof(argv[++i]);
+		else if (strArg == "--hidden" && bHasValue)
+			options.nHidden = atoi(argv[++i]);
+		else if (strArg == "--address" && bHasValue)
+			options.strAddress = argv[++i];
+		else if (strArg == "--model" && bHasValue)
+			options.strModelFile = argv[++i];
+		else
+			vecFiles.push_back(strArg);
+	}
+	if (vecFiles.size() != 2 || options.nRanks < 1 || options.nEpochs < 1 || options.nBatchSize < 1 || options.nHidden < 1 ||
+		(options.nRank >= 0 && (options.nRank >= options.nRanks || options.strAddress == "")))
+	{
+		cout << "Usage: distributed_train training_data validation_data --ranks N [--epochs E] [--batch B] [--rate LR] [--hidden H]\n";
+		cout << "                         [--address address] [--model model_file] [--rank r]\n";
+		return 1;
+	}
+	options.strTrainingFile = vecFiles[0];
+	options.strValidationFile = vecFiles[1];
+	if (options.nRank >= 0)
+		return runRank(options);
+	if (options.strAddress == "")
+		options.strAddress = "/tmp/sigmoid-ring-" + to_string(getpid());
+	return launchRanks(argv, options);
+}
+
+//Re-runs this executable once per rank, with the same options plus --address and --rank. Output of every rank goes to
+// this process's stdout, so it is flushed first.
+int launchRanks(char *argv[], const TrainingOptions &options)
+{
+	cout << "Launching " << options.nRanks << " ranks at " << options.strAddress << "...\n";
+	cout.flush();
+	vector<pid_t> vecPids;
+	char szRate[32];
+	snprintf(szRate, sizeof(szRate), "%.17g", options.dblLearningRate);	//round-trips exactly. to_string() keeps 6 decimals.
+	for (int r = 0; r < options.nRanks; r++)
+	{
+		vector<string> vecArgs = { argv[0], options.strTrainingFile, options.strValidationFile, "--ranks", to_string(options.nRanks),
+			"--epochs", to_string(options.nEpochs), "--batch", to_string(options.nBatchSize), "--rate", szRate,
+			"--hidden", to_string(options.nHidden), "--address", options.strAddress, "--rank", to_string(r) };
+		if (options.strModelFile != "")
+		{
+			vecArgs.push_back("--model");
+			vecArgs.push_back(options.strModelFile);
+		}
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			vector<char *> vecArgv;
+			for (size_t i = 0; i < vecArgs.size(); i++)
+				vecArgv.push_back((char *)vecArgs[i].c_str());
+			vecArgv.push_back(NULL);
+			execv(argv[0], vecArgv.data());
+			cout << "ERROR: Rank " << r << " could not be started.\n";
+			_exit(1);
+		}
+		if (pid < 0)
+		{
+			cout << "ERROR: Rank " << r << " could not be started.\n";
+			break;
+		}
+		vecPids.push_back(pid);
+	}
+
+	//A rank that fails brings down its neighbours when their next exchange with it fails, so every rank exits
+	int nFailed = options.nRanks - (int)vecPids.size();
+	for (size_t i = 0; i < vecPids.size(); i++)
+	{
+		int nStatus = 0;
+		if (waitpid(vecPids[i], &nStatus, 0) < 0 || !WIFEXITED(nStatus) || WEXITSTATUS(nStatus) != 0)
+			nFailed++;
+	}
+	if (nFailed > 0)
+	{
+		cout << "ERROR: " << nFailed << " of " << options.nRanks << " ranks failed.\n";
+		return 1;
+	}
+	return 0;
+}
+
+int runRank(const TrainingOptions &options)
+{
+	int nRank = options.nRank;
+	int nRanks = options.nRanks;
+	SigmoidRing ring;
+	if (!ring.connect(options.strAddress, nRank, nRanks, CONNECT_TIMEOUT_SECONDS))
+		return 1;
+
+	SigmoidDataSet<Scalar> dsTrain, dsValidate;
+	if (!SigmoidDataSet<Scalar>::loadPair(dsTrain, dsValidate, options.strTrainingFile, options.strValidationFile, LETTER_LABELS))
+		return 1;
+
+	//Every shard has the same number of rows, so every rank trains the same number of batches, and no rank waits on a
+	// reduction the others never make
+	int nShardRows = dsTrain.getRowCount() / nRanks;
+	if (nShardRows < 1)
+	{
+		cout << "ERROR: Fewer training rows than ranks.\n";
+		return 1;
+	}
+	dsTrain.selectRows(nRank * nShardRows, nShardRows);
+
+	//Rank 0's initial weights are copied to every replica, so they start, and stay, identical
+	srand((unsigned)time(NULL) + nRank);
+	int aLayers[] = { dsTrain.getParamCount(), options.nHidden, (int)LETTER_LABELS.size() };
+	SigmoidNetwork<Scalar> network(aLayers, 3, options.dblLearningRate, BIAS, BIAS_WEIGHT, false);
+	vector<Scalar> vecParams(network.getParamCount());
+	network.getParams(vecParams.data());
+	if (!ring.broadcast(vecParams.data(), vecParams.size(), 0))
+		return 1;
+	network.setParams(vecParams.data());
+	network.setBatchSize(options.nBatchSize);
+	if (nRanks > 1)
+		network.setGradientReducer([&ring](Scalar *gradients, int count) { return ring.allreduce(gradients, (size_t)count); });
+
+	//Each epoch's loss is summed over every shard, so rank 0 reports the loss over the whole training set
+	network.setEpochCallback([&](const SigmoidEpochMetrics &metrics)
+	{
+		double aLoss[2] = { metrics.dblLoss * metrics.nRows, (double)metrics.nRows };
+		if (ring.allreduce(aLoss, 2) && nRank == 0)
+			cout << "Epoch " << metrics.nEpoch << ": loss " << aLoss[0] / aLoss[1] << ", " << metrics.dblSamplesPerSecond * nRanks << " samples/sec\n";
+	});
+	if (nRank == 0)
+		cout << "Training " << aLayers[0] << "-" << aLayers[1] << "-" << aLayers[2] << " on " << nRanks << " ranks of " << nShardRows
+			<< " rows, " << options.nBatchSize * nRanks << " rows per update...\n";
+	network.doTraining(dsTrain, options.nEpochs);
+	if (ring.hasFailed())
+		return 1;
+
+	//Confirm the replicas are still identical, by comparing each to rank 0's weights
+	network.getParams(vecParams.data());
+	vector<Scalar> vecRootParams = vecParams;
+	if (!ring.broadcast(vecRootParams.data(), vecRootParams.size(), 0))
+		return 1;
+	double dblMismatches = (vecRootParams != vecParams) ? 1 : 0;
+	if (!ring.allreduce(&dblMismatches, 1))
+		return 1;
+	if (nRank != 0)
+		return dblMismatches == 0 ? 0 : 1;
+	if (dblMismatches != 0)
+	{
+		cout << "ERROR: " << dblMismatches << " replicas differ from rank 0.\n";
+		return 1;
+	}
+
+	vector<int> vecClassifications(dsValidate.getRowCount());
+	network.classifyBatch(dsValidate.getParams(0), dsValidate.getRowCount(), vecClassifications.data(), NULL);
+	ConfusionMatrix matrix((int)LETTER_LABELS.size(), LETTER_LABELS);
+	matrix.addClassifications(dsValidate.getLabels(), vecClassifications.data(), dsValidate.getRowCount());
+	ConfusionMetrics metrics = matrix.getMetrics();
+	cout << "Replicas identical. Validation: " << metrics.dblAccuracy * 100 << "% accurate, macro F1 " << metrics.dblMacroF1 << ".\n";
+	if (options.strModelFile != "")
+	{
+		if (!network.save(options.strModelFile))
+			return 1;
+		cout << "Saved model to " << options.strModelFile << ".\n";
+	}
+	return 0;
+}
@@ -0,0 +1,151 @@
+///////////////////////////////////////////
+// Generates load against an inference server (see inference_server.cpp) and reports its throughput and latency.
+//	Each of several connections, on a thread of its own, sends requests of the given number of rows, taken in turn
+//	from a data file, and waits for each response before sending the next, for the given number of seconds. Every
+//	request's round trip is timed. Outputs requests and rows per second, mean and p50/p90/p99/p99.9 latency, and the
+//	accuracy of the classifications returned.
+//	The data file's features must be scaled as the model's training data was: use a binary data file (see
+//	convert_dataset.cpp), or a CSV file, which is rescaled by its own min/max of each column.
+//
+// Usage: inference_client address data_file [--connections count] [--rows count] [--seconds seconds]
+//	address = the server's TCP port number on 127.0.0.1, or its Unix domain socket path
+//	--connections = concurrent connections, each with one request outstanding at a time. Default 8.
+//	--rows = rows per request. Default 1.
+//	--seconds = how long to send requests for. Default 5.
+// Compile from the repo root with: g++ -std=c++17 -O2 -pthread tools/inference_client.cpp -o inference_client
+//
+
+#include <vector>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include "../SigmoidDataSet.h"
+#include "../SigmoidInferenceServer.h"
+
+using namespace std;
+
+struct ConnectionResult
+{
+	vector<double> vecLatencies;					//Round trip of each request, in microseconds
+	long long nRows;								//Rows classified
+	long long nCorrect;								//Rows classified as labelled
+	bool bFailed;									//True if the connection failed
+};
+
+double getPercentile(const vector<double> &sorted, double percentile);	//Returns the given percentile of sorted values
+
+int main(int argc, char *argv[])
+{
+	int nConnections = 8;
+	int nRowsPerRequest = 1;
+	double dblSeconds = 5;
+	vector<string> vecArgs;
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) == "--connections" && i + 1 < argc)
+			nConnections = atoi(argv[++i]);
+		else if (string(argv[i]) == "--rows" && i + 1 < argc)
+			nRowsPerRequest = atoi(argv[++i]);
+		else if (string(argv[i]) == "--seconds" && i + 1 < argc)
+			dblSeconds = atof(argv[++i]);
+		else
+			vecArgs.push_back(argv[i]);
+	}
+	if (vecArgs.size() != 2 || nConnections < 1 || nRowsPerRequest < 1)
+	{
+		cout << "Usage: inference_client address data_file [--connections count] [--rows count] [--seconds seconds]\n";
+		return 1;
+	}
+
+	SigmoidDataSet<float> dsData;
+	if (!dsData.load(vecArgs[1], LETTER_LABELS) || !SigmoidDataSet<float>::rescaleSets({ &dsData }))
+		return 1;
+	if (dsData.getRowCount() < nRowsPerRequest)
+	{
+		cout << "ERROR: " << vecArgs[1] << " has fewer rows than a request.\n";
+		return 1;
+	}
+
+	//each connection starts at a different row and steps through the data set, wrapping at the end
+	vector<ConnectionResult> vecResults(nConnections);
+	vector<thread> vecThreads;
+	chrono::steady_clock::time_point tStart = chrono::steady_clock::now();
+	chrono::steady_clock::time_point tEnd = tStart + chrono::microseconds((long long)(dblSeconds * 1e6));
+	for (int c = 0; c < nConnections; c++)
+	{
+		vecThreads.push_back(thread([&, c]
+		{
+			ConnectionResult &result = vecResults[c];
+			result.nRows = result.nCorrect = 0;
+			result.bFailed = false;
+			SigmoidInferenceClient client;
+			if (!client.connect(vecArgs[0]))
+			{
+				result.bFailed = true;
+				return;
+			}
+			vector<int> vecClassifications(nRowsPerRequest);
+			int nRow = (int)((long long)c * dsData.getRowCount() / nConnections);
+			while (chrono::steady_clock::now() < tEnd)
+			{
+				if (nRow + nRowsPerRequest > dsData.getRowCount())
+					nRow = 0;
+				chrono::steady_clock::time_point tSent = chrono::steady_clock::now();
+				if (!client.classify(dsData.getParams(nRow), nRowsPerRequest, dsData.getParamCount(), vecClassifications.data()))
+				{
+					result.bFailed = true;
+					return;
+				}
+				result.vecLatencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - tSent).count());
+				for (int i = 0; i < nRowsPerRequest; i++)
+					result.nCorrect += vecClassifications[i] == dsData.getLabel(nRow + i);
+				result.nRows += nRowsPerRequest;
+				nRow += nRowsPerRequest;
+			}
+		}));
+	}
+	for (unsigned int c = 0; c < vecThreads.size(); c++)
+		vecThreads[c].join();
+	double dblElapsed = chrono::duration<double>(chrono::steady_clock::now() - tStart).count();
+
+	vector<double> vecLatencies;
+	long long nRows = 0, nCorrect = 0;
+	int nFailed = 0;
+	for (int c = 0; c < nConnections; c++)
+	{
+		vecLatencies.insert(vecLatencies.end(), vecResults[c].vecLatencies.begin(), vecResults[c].vecLatencies.end());
+		nRows += vecResults[c].nRows;
+		nCorrect += vecResults[c].nCorrect;
+		nFailed += vecResults[c].bFailed;
+	}
+	if (vecLatencies.empty())
+	{
+		cout << "ERROR: No request succeeded.\n";
+		return 1;
+	}
+	sort(vecLatencies.begin(), vecLatencies.end());
+	double dblTotal = 0;
+	for (unsigned int i = 0; i < vecLatencies.size(); i++)
+		dblTotal += vecLatencies[i];
+	cout << "Connections,Rows/Request,Requests,Requests/sec,Rows/sec,Mean us,p50 us,p90 us,p99 us,p99.9 us,Accuracy\n";
+	cout << nConnections << "," << nRowsPerRequest << "," << vecLatencies.size() << "," << vecLatencies.size() / dblElapsed << "," <<
+		nRows / dblElapsed << "," << dblTotal / vecLatencies.size() << "," << getPercentile(vecLatencies, 50) << "," <<
+		getPercentile(vecLatencies, 90) << "," << getPercentile(vecLatencies, 99) << "," << getPercentile(vecLatencies, 99.9) << "," <<
+		100.0 * nCorrect / nRows << "\n";
+	if (nFailed > 0)
+	{
+		cout << "ERROR: " << nFailed << " connection(s) failed.\n";
+		return 1;
+	}
+	return 0;
+}
+
+//Nearest-rank percentile
+double getPercentile(const vector<double> &sorted, double percentile)
+{
+	size_t nIndex = (size_t)(percentile / 100 * sorted.size());
+	return sorted[min(nIndex, sorted.size() - 1)];
+}
@@ -0,0 +1,76 @@
+///////////////////////////////////////////
+// Serves a trained model (see SigmoidNetwork::save()) over a Unix domain socket or a localhost TCP port, batching
+// concurrent requests together (see SigmoidInferenceServer.h), until interrupted (Ctrl-C) or terminated. Then outputs
+// the requests, rows and batches served.
+//	The model is classified in float, the precision features are sent in, whatever precision it was saved in.
+//
+// Usage: inference_server model_file address [--workers count] [--max-batch rows] [--max-delay microseconds]
+//	address = a TCP port number on 127.0.0.1, or a Unix domain socket path. Ex: 7070, /tmp/sigmoid.sock
+//	--workers = threads classifying batches. Default 2.
+//	--max-batch = most rows per batch. Default 256.
+//	--max-delay = longest a request waits for its batch to fill. Default 200.
+// Compile from the repo root with: g++ -std=c++17 -O2 -pthread tools/inference_server.cpp -o inference_server
+//
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include "../SigmoidNetwork.h"
+#include "../SigmoidInferenceServer.h"
+
+using namespace std;
+
+volatile sig_atomic_t g_bInterrupted = 0;			//Set by SIGINT or SIGTERM
+
+void onSignal(int)
+{
+	g_bInterrupted = 1;
+}
+
+int main(int argc, char *argv[])
+{
+	int nWorkers = 2;
+	int nMaxBatchRows = 256;
+	int nMaxDelay = 200;
+	vector<string> vecArgs;
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) == "--workers" && i + 1 < argc)
+			nWorkers = atoi(argv[++i]);
+		else if (string(argv[i]) == "--max-batch" && i + 1 < argc)
+			nMaxBatchRows = atoi(argv[++i]);
+		else if (string(argv[i]) == "--max-delay" && i + 1 < argc)
+			nMaxDelay = atoi(argv[++i]);
+		else
+			vecArgs.push_back(argv[i]);
+	}
+	if (vecArgs.size() != 2)
+	{
+		cout << "Usage: inference_server model_file address [--workers count] [--max-batch rows] [--max-delay microseconds]\n";
+		return 1;
+	}
+
+	unique_ptr<SigmoidNetwork<float>> pNetwork = SigmoidNetwork<float>::load(vecArgs[0], true, false);
+	if (!pNetwork)
+		return 1;
+	SigmoidInferenceServer<float> server(*pNetwork, nWorkers, nMaxBatchRows, nMaxDelay);
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+	if (!server.start(vecArgs[1]))
+		return 1;
+	cout << "Serving " << vecArgs[0] << " on " << vecArgs[1] << " (" << nWorkers << " workers, batches of up to " << nMaxBatchRows <<
+		" rows, " << nMaxDelay << " us max delay).\n";
+
+	while (!g_bInterrupted)
+		this_thread::sleep_for(chrono::milliseconds(100));
+	server.stop();
+	SigmoidServerStats stats = server.getStats();
+	cout << "Served " << stats.nRequests << " requests, " << stats.nRows << " rows, in " << stats.nBatches << " batches (" <<
+		(stats.nBatches > 0 ? (double)stats.nRows / stats.nBatches : 0) << " rows per batch), dropping " <<
+		stats.nDroppedConnections << " connections that stopped reading.\n";
+	return 0;
+}
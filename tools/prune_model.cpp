@@ -0,0 +1,120 @@
+///////////////////////////////////////////
+// Prunes a trained model (see SigmoidNetwork::save()) to each of a range of sparsities (see SigmoidPruner.h) and
+// reports what it costs and saves: for each, the validation accuracy of the pruned network, the size of its sparse
+// inference model (see SparseSigmoidNetwork.h) against the dense one, and the classification throughput of both.
+//	Every level starts from the model as saved. With --fine-tune, each pruned network is trained that many more epochs
+//	on training_data, with its pruned weights held at zero, before it is validated. With --steps too, each level is
+//	reached in that many equal steps, each followed by the fine-tuning epochs (see SigmoidPruner::pruneGradually()).
+//
+// Usage: prune_model model_file training_data validation_data [--per-layer] [--fine-tune epochs] [--steps steps]
+//	training_data, validation_data = binary (see convert_dataset.cpp) or CSV data files. CSV files are rescaled as
+//	                                 main.cpp does (see SigmoidDataSet::rescaleSets()).
+//	--per-layer = prune each layer to the sparsity on its own, rather than with one threshold for the whole network
+//	--fine-tune = epochs to train each pruned network for, after each step. Default 0.
+//	--steps = steps to prune each network in. Default 1.
+// Compile from the repo root with: g++ -std=c++17 -O2 -pthread tools/prune_model.cpp -o prune_model
+//
+
+#include <vector>
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include "../SigmoidNetwork.h"
+#include "../SigmoidPruner.h"
+#include "../SparseSigmoidNetwork.h"
+
+using namespace std;
+
+const double SPARSITY_LEVELS[] = { 0, 0.25, 0.5, 0.6, 0.7, 0.8, 0.9, 0.95 };	//Fractions of weights pruned
+const int SPARSITY_LEVEL_COUNT = 8;					//Size of SPARSITY_LEVELS
+const double BENCHMARK_SECONDS = 0.25;				//Each model classifies the validation set repeatedly for at least this long
+
+template <typename N>
+double getRowsPerSecond(const N &network, const SigmoidDataSet<double> &dataset, vector<int> &classifications);	//Times network.classifyBatch()
+int getCorrectCount(const vector<int> &classifications, const SigmoidDataSet<double> &dataset);	//Returns the rows classified correctly
+
+int main(int argc, char *argv[])
+{
+	vector<string> vecFiles;
+	PruneScope scope = PRUNE_GLOBAL;
+	int nFineTuneEpochs = 0;
+	int nSteps = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) == "--per-layer")
+			scope = PRUNE_LAYER;
+		else if (string(argv[i]) == "--fine-tune" && i + 1 < argc)
+			nFineTuneEpochs = atoi(argv[++i]);
+		else if (string(argv[i]) == "--steps" && i + 1 < argc)
+			nSteps = atoi(argv[++i]);
+		else
+			vecFiles.push_back(argv[i]);
+	}
+	if (vecFiles.size() != 3)
+	{
+		cout << "Usage: prune_model model_file training_data validation_data [--per-layer] [--fine-tune epochs] [--steps steps]\n";
+		return 1;
+	}
+
+	unique_ptr<SigmoidNetwork<double>> pModel = SigmoidNetwork<double>::load(vecFiles[0], false, false);
+	if (!pModel)
+		return 1;
+	SigmoidDataSet<double> dsTrain, dsValidate;
+	if (!SigmoidDataSet<double>::loadPair(dsTrain, dsValidate, vecFiles[1], vecFiles[2], LETTER_LABELS))
+		return 1;
+	if (dsTrain.getParamCount() != pModel->getNetworkLayers()[0])
+	{
+		cout << "ERROR: Data files must have one parameter per network input.\n";
+		return 1;
+	}
+
+	int nRows = dsValidate.getRowCount();
+	vector<int> vDenseClassifications(nRows), vSparseClassifications(nRows);
+	size_t nDenseSize = pModel->getParamCount() * sizeof(double);
+	cout << "Sparsity,Weights Kept,Correct,Accuracy,Sparse Disagreements,Dense Bytes,Sparse Bytes,Dense Rows/sec,Sparse Rows/sec\n";
+	for (int s = 0; s < SPARSITY_LEVEL_COUNT; s++)
+	{
+		unique_ptr<SigmoidNetwork<double>> pNetwork = pModel->clone();
+		SigmoidPruner<double> pruner(*pNetwork);
+		pruner.pruneGradually(SPARSITY_LEVELS[s], scope, nSteps, dsTrain, nFineTuneEpochs);
+		SparseSigmoidNetwork<double> sparseNetwork;
+		if (!sparseNetwork.sparsify(*pNetwork))
+			return 1;
+
+		double dblDenseRate = getRowsPerSecond(*pNetwork, dsValidate, vDenseClassifications);
+		double dblSparseRate = getRowsPerSecond(sparseNetwork, dsValidate, vSparseClassifications);
+		int nCorrect = getCorrectCount(vDenseClassifications, dsValidate);
+		int nDisagreements = 0;
+		for (int i = 0; i < nRows; i++)
+			nDisagreements += vDenseClassifications[i] != vSparseClassifications[i];
+		cout << 100 * pruner.getSparsity() << "," << sparseNetwork.getNonZeroCount() << "," << nCorrect << "," << 100.0 * nCorrect / nRows << "," <<
+			nDisagreements << "," << nDenseSize << "," << sparseNetwork.getModelSize() << "," << dblDenseRate << "," << dblSparseRate << "\n";
+	}
+	return 0;
+}
+
+//Classifies the whole of dataset into classifications, over and over for at least BENCHMARK_SECONDS, and returns the
+// rows classified per second
+template <typename N>
+double getRowsPerSecond(const N &network, const SigmoidDataSet<double> &dataset, vector<int> &classifications)
+{
+	chrono::steady_clock::time_point tStart = chrono::steady_clock::now();
+	double dblSeconds = 0;
+	long long nRows = 0;
+	while (dblSeconds < BENCHMARK_SECONDS)
+	{
+		network.classifyBatch(dataset.getFeatures(), dataset.getRowCount(), classifications.data(), NULL);
+		nRows += dataset.getRowCount();
+		dblSeconds = chrono::duration<double>(chrono::steady_clock::now() - tStart).count();
+	}
+	return nRows / dblSeconds;
+}
+
+int getCorrectCount(const vector<int> &classifications, const SigmoidDataSet<double> &dataset)
+{
+	int nCorrect = 0;
+	for (int i = 0; i < dataset.getRowCount(); i++)
+		nCorrect += dataset.getLabel(i) == classifications[i];
+	return nCorrect;
+}
@@ -0,0 +1,112 @@
+///////////////////////////////////////////
+// Quantizes a trained model (see SigmoidNetwork::save()) to int8 weights (see QuantizedSigmoidNetwork.h) and reports
+// what it costs: the accuracy of both models on a validation set, as confusion matrix accuracies by label and overall,
+// how often they disagree, their sizes and their classification throughput.
+//
+// Usage: quantize_model model_file validation_data [training_data] [--save quantized_model_file]
+//	validation_data = binary (see convert_dataset.cpp) or CSV data file. A CSV file is rescaled as main.cpp does (see
+//	                  SigmoidDataSet::rescaleSets()), with training_data, which should then be given too.
+//	--save = writes the quantized model to quantized_model_file
+// Compile from the repo root with: g++ -std=c++17 -O2 -pthread tools/quantize_model.cpp -o quantize_model
+//
+
+#include <vector>
+#include <iostream>
+#include <string>
+#include <chrono>
+#include "../SigmoidNetwork.h"
+#include "../QuantizedSigmoidNetwork.h"
+#include "../ConfusionMatrix.h"
+
+using namespace std;
+
+const double BENCHMARK_SECONDS = 0.5;				//Each model classifies the validation set repeatedly for at least this long
+
+template <typename N>
+double getRowsPerSecond(const N &network, const SigmoidDataSet<double> &dataset, vector<int> &classifications);	//Times network.classifyBatch()
+int reportAccuracy(const vector<int> &classifications, const SigmoidDataSet<double> &dataset);	//Outputs a confusion matrix's accuracies. Returns the number correct.
+
+int main(int argc, char *argv[])
+{
+	vector<string> vecFiles;
+	string strSaveFile;
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) == "--save" && i + 1 < argc)
+			strSaveFile = argv[++i];
+		else
+			vecFiles.push_back(argv[i]);
+	}
+	if (vecFiles.size() < 2 || vecFiles.size() > 3)
+	{
+		cout << "Usage: quantize_model model_file validation_data [training_data] [--save quantized_model_file]\n";
+		return 1;
+	}
+
+	unique_ptr<SigmoidNetwork<double>> pNetwork = SigmoidNetwork<double>::load(vecFiles[0], false, false);
+	if (!pNetwork)
+		return 1;
+	SigmoidDataSet<double> dsValidate, dsTrain;
+	//training_data only lends validation_data its ranges, as main.cpp does. Binary data files were rescaled when they
+	// were written.
+	if (vecFiles.size() == 3 && !SigmoidDataSet<double>::loadPair(dsTrain, dsValidate, vecFiles[2], vecFiles[1], LETTER_LABELS))
+		return 1;
+	if (vecFiles.size() == 2 && (!dsValidate.load(vecFiles[1], LETTER_LABELS) || !SigmoidDataSet<double>::rescaleSets({ &dsValidate })))
+		return 1;
+	if (dsValidate.getParamCount() != pNetwork->getNetworkLayers()[0])
+	{
+		cout << "ERROR: " << vecFiles[1] << " does not have one parameter per network input.\n";
+		return 1;
+	}
+
+	QuantizedSigmoidNetwork<double> qNetwork;
+	qNetwork.quantize(*pNetwork);
+	if (strSaveFile != "" && qNetwork.save(strSaveFile))
+		cout << "Saved quantized model to " << strSaveFile << ".\n";
+
+	int nRows = dsValidate.getRowCount();
+	vector<int> vFloatClassifications(nRows), vQuantizedClassifications(nRows);
+	double dblFloatRate = getRowsPerSecond(*pNetwork, dsValidate, vFloatClassifications);
+	double dblQuantizedRate = getRowsPerSecond(qNetwork, dsValidate, vQuantizedClassifications);
+	int nDisagreements = 0;
+	for (int i = 0; i < nRows; i++)
+		nDisagreements += vFloatClassifications[i] != vQuantizedClassifications[i];
+
+	cout << "\nFloat model accuracy:\n";
+	int nFloatCorrect = reportAccuracy(vFloatClassifications, dsValidate);
+	cout << "\nQuantized model accuracy:\n";
+	int nQuantizedCorrect = reportAccuracy(vQuantizedClassifications, dsValidate);
+	size_t nFloatSize = pNetwork->getParamCount() * sizeof(double);
+	cout << "\nModel,Correct,Accuracy,Bytes,Rows/sec\n";
+	cout << "float," << nFloatCorrect << "," << 100.0 * nFloatCorrect / nRows << "," << nFloatSize << "," << dblFloatRate << endl;
+	cout << "int8," << nQuantizedCorrect << "," << 100.0 * nQuantizedCorrect / nRows << "," << qNetwork.getModelSize() << "," << dblQuantizedRate << endl;
+	cout << "\nAccuracy delta: " << 100.0 * (nQuantizedCorrect - nFloatCorrect) / nRows << " points. ";
+	cout << "Classifications differ on " << nDisagreements << " of " << nRows << " rows. ";
+	cout << "Size ratio: " << (double)nFloatSize / qNetwork.getModelSize() << "x. Speedup: " << dblQuantizedRate / dblFloatRate << "x.\n";
+	return 0;
+}
+
+//Classifies the whole of dataset into classifications, over and over for at least BENCHMARK_SECONDS, and returns the
+// rows classified per second
+template <typename N>
+double getRowsPerSecond(const N &network, const SigmoidDataSet<double> &dataset, vector<int> &classifications)
+{
+	chrono::steady_clock::time_point tStart = chrono::steady_clock::now();
+	double dblSeconds = 0;
+	long long nRows = 0;
+	while (dblSeconds < BENCHMARK_SECONDS)
+	{
+		network.classifyBatch(dataset.getFeatures(), dataset.getRowCount(), classifications.data(), NULL);
+		nRows += dataset.getRowCount();
+		dblSeconds = chrono::duration<double>(chrono::steady_clock::now() - tStart).count();
+	}
+	return nRows / dblSeconds;
+}
+
+int reportAccuracy(const vector<int> &classifications, const SigmoidDataSet<double> &dataset)
+{
+	ConfusionMatrix m((int)LETTER_LABELS.size(), LETTER_LABELS);
+	m.addClassifications(dataset.getLabels(), classifications.data(), dataset.getRowCount());
+	m.outputAccuracy();
+	return m.getMetrics().nCorrect;
+}
@@ -0,0 +1,221 @@
+///////////////////////////////////////////
+// Checks every vector kernel (see SigmoidSimd.h) against its scalar version, on every ISA the CPU supports.
+//	Each kernel runs on random inputs of every length from 0 to MAX_SHORT_LENGTH, which covers every vector width and
+//	remainder, and on a few long ones, each starting one element past an aligned address, so unaligned loads are
+//	exercised. Its results are compared with the scalar kernel's against the bounds documented in SigmoidSimd.h:
+//	  dot, axpy: the difference is within n * epsilon times the sum of the absolute values of the terms, where
+//	             epsilon is 2^-52 for double and 2^-23 for float, and axpy sums two terms per element
+//	  sigmoid, sigmoidRational: the difference is within SIMD_SIGMOID_TOLERANCE (SIMD_SIGMOID_TOLERANCE_FLOAT for float)
+//	  dotRowsInt8: exactly equal
+//	Outputs a CSV table of each kernel's worst difference as a fraction of its bound. The exit code is 1 if any differs
+//	by more than its bound.
+//
+// Usage: simd_check
+// Compile from the repo root with: g++ -std=c++17 -O2 -pthread tools/simd_check.cpp -o simd_check
+//
+
+#include <vector>
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include "../SigmoidSimd.h"
+
+using namespace std;
+using namespace SigmoidSimd;
+
+const int MAX_SHORT_LENGTH = 130;					//Every length up to this is checked
+const int LONG_LENGTHS[] = { 1000, 4099, 65537 };	//Longer lengths checked
+const int LONG_LENGTH_COUNT = 3;					//Size of LONG_LENGTHS
+const double SIGMOID_INPUT_RANGE = 50;				//Sigmoid inputs are drawn from +/- this, plus the values in SIGMOID_EDGES
+const double SIGMOID_EDGES[] = { 0, -1e-300, 708, -708, 709.5, -709.5, 800, -800, 87, -87, 88.5, -88.5, 1e6, -1e6 };	//Clamp boundaries and beyond
+const int SIGMOID_EDGE_COUNT = 14;					//Size of SIGMOID_EDGES
+const int MAX_INT8_ROWS = 5;						//dotRowsInt8 is checked with every row count up to this
+
+struct KernelCheck									//Worst case of one kernel on one ISA
+{
+	double dblWorstRatio = 0;						//Largest difference from the scalar kernel, as a fraction of its bound
+	double dblWorstDifference = 0;					//That difference
+	int nCases = 0;									//Inputs checked
+	void add(double difference, double bound);		//Records one result
+	bool hasPassed() const;							//Returns true if no difference exceeded its bound
+};
+
+vector<int> getLengths();							//Returns every length to check
+double getRandom(double range);						//Returns a random value in [-range, range]
+template <typename T>
+T getEpsilon();										//Returns 2^-52 for double, 2^-23 for float
+template <typename T>
+void checkDot(T (*dot)(const T *, const T *, int), KernelCheck &check);
+template <typename T>
+void checkAxpy(void (*axpy)(T *, T, const T *, int), KernelCheck &check);
+template <typename T>
+void checkSigmoid(void (*sigmoid)(T *, int), void (*scalar)(T *, int), double tolerance, KernelCheck &check);
+void checkDotRowsInt8(const KernelTable &kernels, KernelCheck &check);
+
+int main()
+{
+	srand(1);
+	int nFailures = 0;
+	cout << "ISA,Kernel,Cases,Worst Difference,Worst Difference / Bound,Status\n";
+	for (int isa = ISA_SCALAR; isa <= ISA_AVX512; isa++)
+	{
+		if (!isKernelIsaSupported((KernelIsa)isa))
+		{
+			cout << getKernelIsaName((KernelIsa)isa) << ",all,0,,,not supported\n";
+			continue;
+		}
+		KernelTable kernels = getKernelTable((KernelIsa)isa);
+		const int KERNEL_COUNT = 9;
+		const char *aNames[KERNEL_COUNT] = { "dot", "axpy", "sigmoid", "sigmoidRational", "dotFloat", "axpyFloat", "sigmoidFloat",
+			"sigmoidRationalFloat", "dotRowsInt8" };
+		KernelCheck aChecks[KERNEL_COUNT];
+		checkDot<double>(kernels.dot, aChecks[0]);
+		checkAxpy<double>(kernels.axpy, aChecks[1]);
+		checkSigmoid<double>(kernels.sigmoid, sigmoidScalar, SIMD_SIGMOID_TOLERANCE, aChecks[2]);
+		checkSigmoid<double>(kernels.sigmoidRational, sigmoidRationalScalar, SIMD_SIGMOID_TOLERANCE, aChecks[3]);
+		checkDot<float>(kernels.dotFloat, aChecks[4]);
+		checkAxpy<float>(kernels.axpyFloat, aChecks[5]);
+		checkSigmoid<float>(kernels.sigmoidFloat, sigmoidScalar, SIMD_SIGMOID_TOLERANCE_FLOAT, aChecks[6]);
+		checkSigmoid<float>(kernels.sigmoidRationalFloat, sigmoidRationalScalar, SIMD_SIGMOID_TOLERANCE_FLOAT, aChecks[7]);
+		checkDotRowsInt8(kernels, aChecks[8]);
+		for (int k = 0; k < KERNEL_COUNT; k++)
+		{
+			nFailures += !aChecks[k].hasPassed();
+			cout << getKernelIsaName((KernelIsa)isa) << "," << aNames[k] << "," << aChecks[k].nCases << "," << aChecks[k].dblWorstDifference << "," <<
+				aChecks[k].dblWorstRatio << "," << (aChecks[k].hasPassed() ? "ok" : "FAILED") << "\n";
+		}
+	}
+	cout << nFailures << " check(s) failed.\n";
+	return nFailures == 0 ? 0 : 1;
+}
+
+//A zero bound, as for int8 and for sums of zeros, allows no difference at all
+void KernelCheck::add(double difference, double bound)
+{
+	nCases++;
+	double dblRatio = (difference == 0) ? 0 : (bound > 0 ? difference / bound : numeric_limits<double>::infinity());
+	if (!(dblRatio <= dblWorstRatio))	//also catches NaN
+	{
+		dblWorstRatio = dblRatio;
+		dblWorstDifference = difference;
+	}
+}
+
+bool KernelCheck::hasPassed() const
+{
+	return dblWorstRatio <= 1;
+}
+
+vector<int> getLengths()
+{
+	vector<int> vecLengths;
+	for (int n = 0; n <= MAX_SHORT_LENGTH; n++)
+		vecLengths.push_back(n);
+	vecLengths.insert(vecLengths.end(), LONG_LENGTHS, LONG_LENGTHS + LONG_LENGTH_COUNT);
+	return vecLengths;
+}
+
+double getRandom(double range)
+{
+	return range * (2.0 * rand() / RAND_MAX - 1);
+}
+
+template <>
+double getEpsilon<double>()
+{
+	return ldexp(1.0, -52);
+}
+template <>
+float getEpsilon<float>()
+{
+	return ldexpf(1.0f, -23);
+}
+
+//Inputs start one element into their buffers, so no vector load is aligned
+template <typename T>
+void checkDot(T (*dot)(const T *, const T *, int), KernelCheck &check)
+{
+	vector<int> vecLengths = getLengths();
+	for (size_t l = 0; l < vecLengths.size(); l++)
+	{
+		int n = vecLengths[l];
+		vector<T> v1(n + 1), v2(n + 1);
+		double dblAbsSum = 0;
+		for (int i = 1; i <= n; i++)
+		{
+			v1[i] = (T)getRandom(1);
+			v2[i] = (T)getRandom(1);
+			dblAbsSum += fabs((double)v1[i] * v2[i]);
+		}
+		double dblDifference = fabs((double)dot(v1.data() + 1, v2.data() + 1, n) - (double)dotScalar(v1.data() + 1, v2.data() + 1, n));
+		check.add(dblDifference, n * getEpsilon<T>() * dblAbsSum);
+	}
+}
+
+template <typename T>
+void checkAxpy(void (*axpy)(T *, T, const T *, int), KernelCheck &check)
+{
+	vector<int> vecLengths = getLengths();
+	for (size_t l = 0; l < vecLengths.size(); l++)
+	{
+		int n = vecLengths[l];
+		vector<T> x(n + 1), y(n + 1);
+		for (int i = 1; i <= n; i++)
+		{
+			x[i] = (T)getRandom(1);
+			y[i] = (T)getRandom(1);
+		}
+		T a = (T)getRandom(2);
+		vector<T> yInitial(y), yScalar(y);
+		axpy(y.data() + 1, a, x.data() + 1, n);
+		axpyScalar(yScalar.data() + 1, a, x.data() + 1, n);
+		for (int i = 1; i <= n; i++)
+		{
+			double dblAbsSum = fabs((double)yInitial[i]) + fabs((double)a * x[i]);
+			check.add(fabs((double)y[i] - (double)yScalar[i]), 2 * getEpsilon<T>() * dblAbsSum);
+		}
+	}
+}
+
+template <typename T>
+void checkSigmoid(void (*sigmoid)(T *, int), void (*scalar)(T *, int), double tolerance, KernelCheck &check)
+{
+	vector<int> vecLengths = getLengths();
+	for (size_t l = 0; l < vecLengths.size(); l++)
+	{
+		int n = vecLengths[l];
+		vector<T> v(n + 1);
+		for (int i = 1; i <= n; i++)
+			v[i] = (i - 1 < SIGMOID_EDGE_COUNT) ? (T)SIGMOID_EDGES[i - 1] : (T)getRandom(SIGMOID_INPUT_RANGE);
+		vector<T> vScalar(v);
+		sigmoid(v.data() + 1, n);
+		scalar(vScalar.data() + 1, n);
+		for (int i = 1; i <= n; i++)
+			check.add(fabs((double)v[i] - (double)vScalar[i]), tolerance);
+	}
+}
+
+void checkDotRowsInt8(const KernelTable &kernels, KernelCheck &check)
+{
+	vector<int> vecLengths = getLengths();
+	for (size_t l = 0; l < vecLengths.size(); l++)
+	{
+		int n = vecLengths[l];
+		for (int nRows = 1; nRows <= MAX_INT8_ROWS; nRows++)
+		{
+			vector<int8_t> vWeights((size_t)nRows * n + 1);
+			vector<uint8_t> vInputs(n + 1);
+			for (size_t i = 1; i < vWeights.size(); i++)
+				vWeights[i] = (int8_t)(rand() % 255 - 127);
+			for (int i = 1; i <= n; i++)
+				vInputs[i] = (uint8_t)(rand() % 256);
+			vector<int32_t> vOutputs(nRows), vScalarOutputs(nRows);
+			kernels.dotRowsInt8(vWeights.data() + 1, vInputs.data() + 1, vOutputs.data(), nRows, n);
+			dotRowsScalar(vWeights.data() + 1, vInputs.data() + 1, vScalarOutputs.data(), nRows, n);
+			for (int j = 0; j < nRows; j++)
+				check.add(fabs((double)vOutputs[j] - (double)vScalarOutputs[j]), 0);
+		}
+	}
+}
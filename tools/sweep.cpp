@@ -0,0 +1,61 @@
+///////////////////////////////////////////
+// Runs a hyperparameter sweep (see SigmoidSweep.h): trains and validates a network for every combination of the
+// learning rates, iteration counts, topologies, biases, bias weights and batch sizes in a sweep file, several at once,
+// and outputs a table of each configuration's accuracy, wall time and training samples/sec.
+//
+// Usage: sweep [sweep_file] [results_file]
+//	sweep_file = defaults to sweep.cfg
+//	results_file = the results table is also written here, as CSV
+// Compile from the repo root with: g++ -std=c++17 -O2 -pthread tools/sweep.cpp -o sweep
+//
+
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "../SigmoidSweep.h"
+
+using namespace std;
+
+typedef double Scalar;								//Precision of weights, activations and data: float or double
+
+int main(int argc, char *argv[])
+{
+	string strSweepFile = (argc > 1) ? argv[1] : "sweep.cfg";
+	string strResultsFile = (argc > 2) ? argv[2] : "";
+	if (argc > 3)
+	{
+		cout << "Usage: sweep [sweep_file] [results_file]\n";
+		return 1;
+	}
+	SigmoidSweep<Scalar> sweep;
+	if (!sweep.loadSweepFile(strSweepFile))
+		return 1;
+
+	//Both sets are loaded once and shared, read-only, by every job. CSV data is rescaled as main.cpp does.
+	SigmoidDataSet<Scalar> dsTrain, dsValidate;
+	cout << "Reading " << sweep.getTrainingFile() << " and " << sweep.getValidationFile() << "...\n";
+	if (!SigmoidDataSet<Scalar>::loadPair(dsTrain, dsValidate, sweep.getTrainingFile(), sweep.getValidationFile(), LETTER_LABELS))
+		return 1;
+
+	cout << "Running " << sweep.getConfigCount() << " configurations, " << sweep.getThreadCount() << " at a time...\n";
+	sweep.run(dsTrain, dsValidate, true);
+	double dblJobSeconds = 0;
+	for (int i = 0; i < sweep.getConfigCount(); i++)
+		dblJobSeconds += sweep.getResult(i).dblSeconds;
+	cout << "Done in " << sweep.getSeconds() << "s (" << dblJobSeconds << "s of jobs).\n\n";
+
+	sweep.outputResults(cout);
+	if (strResultsFile != "")
+	{
+		ofstream fsOut(strResultsFile.c_str());
+		sweep.outputResults(fsOut);
+		if (fsOut.fail())
+		{
+			cout << "ERROR: Results file " << strResultsFile << " could not be written.\n";
+			return 1;
+		}
+		cout << "\nSaved results to " << strResultsFile << ".\n";
+	}
+	return 0;
+}